@@ -1,23 +1,245 @@
+#include <algorithm>
 #include <android/log.h>
+#include <chrono>
+#include <format>
 #include <jni.h>
 #include <memory>
+#include <optional>
+#include <thread>
+#include <variant>
+#include <vector>
 
 #include "EyeAICore/DepthModel.hpp"
+#include "EyeAICore/depth/DepthCascade.hpp"
+#include "EyeAICore/depth/DepthPropagation.hpp"
+#include "EyeAICore/depth/DepthRegionIndex.hpp"
+#include "EyeAICore/depth/DropOffDetector.hpp"
+#include "EyeAICore/depth/FoveatedDepth.hpp"
+#include "EyeAICore/depth/GroundPlane.hpp"
+#include "EyeAICore/depth/GuidedUpsampling.hpp"
+#include "EyeAICore/depth/ObstacleBlobs.hpp"
+#include "EyeAICore/depth/ObstacleSectors.hpp"
+#include "EyeAICore/depth/ObstacleTracker.hpp"
+#include "EyeAICore/depth/OccupancyGrid.hpp"
+#include "EyeAICore/depth/PointCloud.hpp"
+#include "EyeAICore/depth/TimeToCollision.hpp"
+#include "EyeAICore/tflite/InferenceCancellation.hpp"
 #include "EyeAICore/tflite/TfLiteRuntime.hpp"
 #include "EyeAICore/utils/DepthColormap.hpp"
+#include "EyeAICore/utils/FrameTracing.hpp"
 #include "EyeAICore/utils/MutexGuard.hpp"
+#include "EyeAICore/utils/PipelineWatchdog.hpp"
+#include "EyeAICore/utils/QualityGovernor.hpp"
 #include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/SceneChangeDetector.hpp"
+#include "EyeAICore/utils/SessionRecording.hpp"
 #include "ImageUtils.hpp"
 #include "Log.hpp"
 #include "NativeJavaScopes.hpp"
 
+/// threads of the full resolution pass of the guided depth upsampling
+constexpr int MAX_GUIDED_UPSAMPLING_THREADS = 4;
+
+/// azimuth, elevation, nearest, coverage and confidence of every sector
+constexpr size_t FLOATS_PER_OBSTACLE_SECTOR = 5;
+
+/// azimuth, nearness, jump and confidence of every drop-off hazard
+constexpr size_t FLOATS_PER_DROP_OFF_HAZARD = 4;
+
+/// id, centroid x and y, box width and height (all relative to the depth
+/// size), nearest and approach rate of every confirmed tracked obstacle
+constexpr size_t FLOATS_PER_TRACKED_OBSTACLE = 7;
+
+/// id, time to collision in seconds, centroid x relative to the depth width
+/// and nearest of the most urgent collision threat
+constexpr size_t FLOATS_PER_COLLISION_THREAT = 4;
+
+/// sector summary of the latest depth output, only this crosses jni per frame
+struct ObstacleSectorState {
+	std::optional<ObstacleSectorSummarizer> summarizer;
+	std::vector<ObstacleSector> sectors;
+};
+
+/// drop-offs in the walking path of the latest depth output
+struct DropOffState {
+	std::optional<DropOffDetector> detector;
+	std::vector<DropOffHazard> hazards;
+};
+
+/// near blobs of the depth output, tracked across frames with their time to
+/// collision
+struct ObstacleTrackingState {
+	std::optional<ObstacleBlobExtractor> extractor;
+	std::optional<ObstacleTracker> tracker;
+	std::optional<TimeToCollisionEstimator> time_to_collision;
+};
+
+/// the latest depth output back-projected into the floor occupancy grid,
+/// heights are measured from the estimated ground plane
+struct OccupancyGridState {
+	std::optional<DepthBackProjector> projector;
+	std::optional<GroundPlaneEstimator> ground;
+	std::optional<OccupancyGrid> grid;
+	PointCloud points;
+};
+
+/// skips the inference of frames that show the same scene as the last inferred
+/// one, they get its depth output instead
+struct SceneChangeState {
+	std::optional<SceneChangeDetector> detector;
+	std::vector<float> last_output;
+};
+
+/// foveated mode, the center crop is inferred separately and blended into the
+/// depth output
+struct FoveationState {
+	std::optional<FoveatedDepthBlender> blender;
+	std::vector<float> center_output;
+};
+
+/// debug recording of the depth model inputs and outputs, for replaying them
+/// with eyeai-session
+struct SessionRecordingState {
+	std::unique_ptr<SessionRecorder> recorder;
+	/// rgb 888 copy of the input, taken before the input operators modify it
+	std::vector<uint8_t> rgb_pixels;
+};
+
+/// stages of runDepthModelInference watched by the pipeline watchdog
+constexpr size_t DEPTH_MODEL_WATCHDOG_STAGE = 0;
+constexpr size_t OBSTACLE_ANALYSIS_WATCHDOG_STAGE = 1;
+
+static std::unique_ptr<PipelineWatchdog> create_pipeline_watchdog() {
+	PipelineWatchdogConfig config;
+	config.stages = {
+		PipelineStageConfig("depth model", std::chrono::milliseconds(1000)),
+		PipelineStageConfig("obstacle analysis", std::chrono::milliseconds(250))
+	};
+	config.result_deadline = std::chrono::milliseconds(1500);
+	config.check_interval = std::chrono::milliseconds(10);
+	auto watchdog = PipelineWatchdog::create(std::move(config));
+	if (!watchdog) {
+		LOG_ERROR("{}", watchdog.error().to_string());
+		return nullptr;
+	}
+	return std::move(*watchdog);
+}
+
+static std::unique_ptr<StaleInferenceCanceller> create_inference_canceller() {
+	InferenceCancellationConfig config;
+	config.max_result_age = std::chrono::milliseconds(400);
+	config.max_inference_time = std::chrono::milliseconds(2000);
+	auto canceller = StaleInferenceCanceller::create(config);
+	if (!canceller) {
+		LOG_ERROR("{}", canceller.error().to_string());
+		return nullptr;
+	}
+	return std::move(*canceller);
+}
+
 // the global variable is using MutexGuard, so they are thread-safe
 // NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
 static MutexGuard<std::unique_ptr<DepthModel>> depth_model{
 	std::unique_ptr<DepthModel>(nullptr)
 };
+// region queries of the latest depth output, sized for the depth model and
+// locked after it
+static MutexGuard<std::optional<DepthRegionIndex>> depth_region_index{
+	std::optional<DepthRegionIndex>()
+};
+static MutexGuard<ObstacleSectorState> obstacle_sectors{ObstacleSectorState()
+};
+static MutexGuard<DropOffState> drop_offs{DropOffState()};
+static MutexGuard<ObstacleTrackingState> obstacle_tracking{
+	ObstacleTrackingState()
+};
+static MutexGuard<OccupancyGridState> occupancy_grid{OccupancyGridState()};
+static MutexGuard<SceneChangeState> scene_change{SceneChangeState()};
+// locked after depth_model and before foveation, stopped when the depth model
+// is replaced since the frame sizes may change
+static MutexGuard<SessionRecordingState> session_recording{
+	SessionRecordingState()
+};
+// has to be locked before depth_propagation
+static MutexGuard<FoveationState> foveation{FoveationState()};
+// keyframe mode, the depth model only runs when the propagator requests it
+static MutexGuard<std::optional<DepthPropagator>> depth_propagation{
+	std::optional<DepthPropagator>()
+};
+// recreated when the depth or frame size changes
+static MutexGuard<std::optional<GuidedDepthUpsampler>> guided_upsampler{
+	std::optional<GuidedDepthUpsampler>()
+};
+// persists when the model is switched, switching to the quantized model is
+// one of its levels
+static MutexGuard<std::optional<QualityGovernor>> quality_governor{
+	std::optional<QualityGovernor>()
+};
+// FrameLatencyTracker is thread-safe by itself
+static FrameLatencyTracker depth_frame_latency_tracker;
+// PipelineWatchdog is thread-safe by itself and must not share a lock with
+// the pipeline it watches, its monitor thread runs while a model is loaded
+static const std::unique_ptr<PipelineWatchdog> pipeline_watchdog =
+	create_pipeline_watchdog();
+// StaleInferenceCanceller is thread-safe by itself, camera frames cancel the
+// inference of an outdated frame while it is running
+static const std::unique_ptr<StaleInferenceCanceller> inference_canceller =
+	create_inference_canceller();
 // NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
 
+static void log_tflite_warning(std::string msg) {
+	LOG_WARN("[TfLiteRuntime] {}", msg);
+}
+
+static void log_tflite_error(std::string msg) {
+	LOG_ERROR("[TfLiteRuntime] {}", msg);
+}
+
+/// finishes the recorded session, if one is running
+static void stop_session_recording(SessionRecordingState& state) {
+	if (!state.recorder)
+		return;
+	if (const auto error = state.recorder->finish())
+		LOG_ERROR("{}", error->to_string());
+	else
+		LOG_INFO(
+			"Recorded session with {} frames", state.recorder->get_frame_count()
+		);
+	state.recorder.reset();
+}
+
+/// replaces the current depth model, the state of the previous one is reset
+static void use_depth_model(std::unique_ptr<DepthModel>&& model) {
+	// [batch, height, width] or [batch, height, width, 1]
+	const auto output_shape = model->get_runtime().get_output_shape();
+	{
+		auto depth_model_scope = depth_model.lock();
+		depth_model_scope->swap(model);
+		auto depth_region_index_scope = depth_region_index.lock();
+		if (output_shape.size() >= 3)
+			depth_region_index_scope->emplace(output_shape[2], output_shape[1]);
+		else
+			depth_region_index_scope->reset();
+		stop_session_recording(*session_recording.lock());
+	}
+	if (pipeline_watchdog) {
+		pipeline_watchdog->start([](const PipelineWatchdogStatus& status) {
+			const auto formatted =
+				status.formatted(pipeline_watchdog->get_config());
+			if (status.health == PipelineHealth::Healthy)
+				LOG_INFO("{}", formatted);
+			else
+				LOG_WARN("{}", formatted);
+		});
+	}
+	auto scene_change_scope = scene_change.lock();
+	if (scene_change_scope->detector)
+		scene_change_scope->detector->reset();
+	auto depth_propagation_scope = depth_propagation.lock();
+	if (*depth_propagation_scope)
+		(*depth_propagation_scope)->reset();
+}
+
 // NOLINTBEGIN(readability-identifier-naming,
 // bugprone-easily-swappable-parameters)
 
@@ -36,59 +258,1000 @@ Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_initDepthModel(
 	);
 	const NativeStringScope model_token_string(env, model_token);
 
-	const auto log_warning_callback = [](std::string msg) {
-		LOG_WARN("[TfLiteRuntime] {}", msg);
-	};
-
-	const auto log_error_callback = [](std::string msg) {
-		LOG_ERROR("[TfLiteRuntime] {}", msg);
-	};
-
 	auto result = DepthModel::create(
 		model_data.to_vector(), gpu_delegate_serialization_dir_string,
-		model_token_string, log_warning_callback, log_error_callback
+		model_token_string, log_tflite_warning, log_tflite_error
 	);
-	if (result) {
-		depth_model.lock()->swap(*result);
-	} else
+	if (result)
+		use_depth_model(std::move(*result));
+	else
 		LOG_ERROR(
 			"[TfLiteRuntime] Failed to create depth model: {}",
 			result.error().to_string()
 		);
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_initCascadeDepthModel(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jbyteArray fast_model,
+	jbyteArray refined_model,
+	jstring gpu_delegate_serialization_dir,
+	jstring fast_model_token,
+	jstring refined_model_token,
+	jint refine_interval
+) {
+	NativeByteArrayScope fast_model_data(env, fast_model);
+	NativeByteArrayScope refined_model_data(env, refined_model);
+	const NativeStringScope gpu_delegate_serialization_dir_string(
+		env, gpu_delegate_serialization_dir
+	);
+	const NativeStringScope fast_model_token_string(env, fast_model_token);
+	const NativeStringScope refined_model_token_string(
+		env, refined_model_token
+	);
+
+	DepthCascadeConfig config;
+	config.refine_interval = refine_interval;
+	auto cascade = DepthCascade::create(config);
+	if (!cascade) {
+		LOG_ERROR("{}", cascade.error().to_string());
+		return;
+	}
+
+	auto result = DepthModel::create_cascade(
+		fast_model_data.to_vector(), refined_model_data.to_vector(),
+		gpu_delegate_serialization_dir_string, fast_model_token_string,
+		refined_model_token_string, std::move(*cascade), log_tflite_warning,
+		log_tflite_error
+	);
+	if (result)
+		use_depth_model(std::move(*result));
+	else
+		LOG_ERROR(
+			"[TfLiteRuntime] Failed to create cascade depth model: {}",
+			result.error().to_string()
+		);
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_shutdownDepthModel(
 	JNIEnv* /*env*/,
 	jobject /*thiz*/
 ) {
-	depth_model.lock()->reset(nullptr);
+	if (pipeline_watchdog)
+		pipeline_watchdog->stop();
+	auto depth_model_scope = depth_model.lock();
+	depth_model_scope->reset(nullptr);
+	depth_region_index.lock()->reset();
+	stop_session_recording(*session_recording.lock());
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_startSessionRecording(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jstring path,
+	jstring model_token
+) {
+	const NativeStringScope path_string(env, path);
+	const NativeStringScope model_token_string(env, model_token);
+
+	auto depth_model_scope = depth_model.lock();
+	if (*depth_model_scope == nullptr) {
+		LOG_ERROR("depth model not initialized!");
+		return JNI_FALSE;
+	}
+	// [batch, height, width, 3] and [batch, height, width] or
+	// [batch, height, width, 1]
+	const auto& runtime = (*depth_model_scope)->get_runtime();
+	const auto input_shape = runtime.get_input_shape();
+	const auto output_shape = runtime.get_output_shape();
+	if (input_shape.size() != 4 || output_shape.size() < 3) {
+		LOG_ERROR("Can not record a depth model without image tensors");
+		return JNI_FALSE;
+	}
+
+	SessionInfo info;
+	info.model_token = model_token_string;
+	info.input_width = input_shape[2];
+	info.input_height = input_shape[1];
+	info.depth_width = output_shape[2];
+	info.depth_height = output_shape[1];
+
+	auto session_recording_scope = session_recording.lock();
+	stop_session_recording(*session_recording_scope);
+	auto recorder =
+		SessionRecorder::create(std::string(path_string), std::move(info));
+	if (!recorder) {
+		LOG_ERROR("{}", recorder.error().to_string());
+		return JNI_FALSE;
+	}
+	session_recording_scope->recorder = std::move(*recorder);
+	return JNI_TRUE;
 }
 
 extern "C" JNIEXPORT void JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_stopSessionRecording(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/
+) {
+	stop_session_recording(*session_recording.lock());
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_submitCameraFrame(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jlong capture_timestamp_nanos
+) {
+	if (pipeline_watchdog)
+		pipeline_watchdog->frame_submitted();
+	// the capture timestamp may be implausible, the frame is newer anyway
+	if (inference_canceller)
+		inference_canceller->frame_available(frame_clock::now());
+	{
+		// sampled on every camera frame, also the ones that are skipped or
+		// dropped, so the time until the next result counts too
+		auto quality_governor_scope = quality_governor.lock();
+		if (*quality_governor_scope) {
+			auto& governor = **quality_governor_scope;
+			if (const auto decision =
+					governor.observe(depth_frame_latency_tracker))
+				LOG_INFO("{}", decision->formatted(governor.get_config()));
+		}
+	}
+	return static_cast<jlong>(depth_frame_latency_tracker.submit_frame(
+		frame_time_from_nanos(capture_timestamp_nanos)
+	));
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
 Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_runDepthModelInference(
 	JNIEnv* env,
 	jobject /*thiz*/,
 	jfloatArray input,
-	jfloatArray output
+	jfloatArray center_input,
+	jfloatArray output,
+	jlong frame_id,
+	jlong dequeue_timestamp_nanos
 ) {
+	auto trace = depth_frame_latency_tracker.begin_processing(
+		static_cast<uint64_t>(frame_id),
+		frame_time_from_nanos(dequeue_timestamp_nanos)
+	);
+	PipelineStageScope depth_model_stage(
+		pipeline_watchdog.get(), DEPTH_MODEL_WATCHDOG_STAGE
+	);
+
 	auto depth_model_scope = depth_model.lock();
 
 	if (*depth_model_scope == nullptr) {
 		LOG_ERROR("depth model not initialized!");
-		return;
+		return JNI_FALSE;
 	}
 
 	NativeFloatArrayScope input_array(env, input);
 	NativeFloatArrayScope output_array(env, output);
 
-	if (const auto error =
-			(*depth_model_scope)->run(input_array, output_array)) {
-		LOG_ERROR(
-			"[TfLiteRuntime] Failed to run depth model inference: {}",
-			error->to_string()
+	auto session_recording_scope = session_recording.lock();
+	if (session_recording_scope->recorder) {
+		// the input is rgb in [0, 255], copied before the input operators
+		// normalize it in place
+		const std::span<const float> input_values = input_array;
+		auto& rgb_pixels = session_recording_scope->rgb_pixels;
+		rgb_pixels.resize(input_values.size());
+		std::ranges::transform(
+			input_values, rgb_pixels.begin(),
+			[](float value) {
+				return static_cast<uint8_t>(
+					std::clamp(value, 0.0f, 255.0f) + 0.5f
+				);
+			}
+		);
+	}
+
+	auto foveation_scope = foveation.lock();
+	auto scene_change_scope = scene_change.lock();
+	if (scene_change_scope->detector) {
+		// has to run before the input operators modify the input
+		const auto change = scene_change_scope->detector->check(
+			input_array, trace.capture_time
+		);
+		if (!change) {
+			LOG_ERROR(
+				"Failed to detect scene change: {}", change.error().to_string()
+			);
+		} else if (!change->run_inference &&
+				   scene_change_scope->last_output.size() ==
+					   output_array.size()) {
+			// skipped frames are not finished, the latency stats only cover
+			// real results and the obstacle sectors are still up to date
+			std::ranges::copy(
+				scene_change_scope->last_output,
+				std::span<float>(output_array).begin()
+			);
+			if (foveation_scope->blender)
+				foveation_scope->blender->record_frame(0);
+			if (pipeline_watchdog)
+				pipeline_watchdog->result_ready();
+			return JNI_TRUE;
+		}
+	}
+
+	auto depth_propagation_scope = depth_propagation.lock();
+	DepthPropagator* propagator = depth_propagation_scope->has_value()
+									  ? &**depth_propagation_scope
+									  : nullptr;
+	if (propagator != nullptr) {
+		if (const auto error = propagator->begin_frame(input_array)) {
+			LOG_ERROR("Failed to propagate depth: {}", error->to_string());
+			propagator->reset();
+			propagator = nullptr;
+		}
+	}
+
+	int model_runs = 0;
+	if (propagator != nullptr && !propagator->needs_keyframe()) {
+		if (const auto error = propagator->propagate(output_array)) {
+			LOG_ERROR("Failed to propagate depth: {}", error->to_string());
+			return JNI_FALSE;
+		}
+		// the depth model is skipped, so all stages end at once
+		const auto now = frame_clock::now();
+		trace.preprocess_end_time = now;
+		trace.inference_end_time = now;
+		trace.postprocess_end_time = now;
+	} else {
+		// every model invoke (also the refined one of a cascade) is reported
+		// to the canceller
+		const auto error = (*depth_model_scope)->run(
+			input_array, output_array, trace, inference_canceller.get()
+		);
+		// a newer frame is waiting, it is inferred instead
+		if (error &&
+			std::holds_alternative<TfLiteInferenceCancelledError>(*error))
+			return JNI_FALSE;
+		if (error) {
+			LOG_ERROR(
+				"[TfLiteRuntime] Failed to run depth model inference: {}",
+				error->to_string()
+			);
+			return JNI_FALSE;
+		}
+		model_runs = 1;
+
+		if (center_input != nullptr && foveation_scope->blender) {
+			NativeFloatArrayScope center_input_array(env, center_input);
+			auto& center_output = foveation_scope->center_output;
+			center_output.resize(output_array.size());
+			if (const auto error =
+					(*depth_model_scope)
+						->run_without_temporal_state(
+							center_input_array, center_output
+						)) {
+				LOG_ERROR(
+					"[TfLiteRuntime] Failed to run center inference: {}",
+					error->to_string()
+				);
+			} else {
+				model_runs = 2;
+				const auto blend = foveation_scope->blender->blend(
+					output_array, center_output
+				);
+				if (!blend)
+					LOG_ERROR(
+						"Failed to blend center depth: {}",
+						blend.error().to_string()
+					);
+				trace.postprocess_end_time = frame_clock::now();
+			}
+		}
+
+		if (propagator != nullptr) {
+			if (const auto error = propagator->set_keyframe(output_array)) {
+				LOG_ERROR(
+					"Failed to set depth keyframe: {}", error->to_string()
+				);
+			}
+		}
+	}
+
+	if (foveation_scope->blender)
+		foveation_scope->blender->record_frame(model_runs);
+
+	// propagated frames count as inferred, they have a fresh output
+	if (scene_change_scope->detector) {
+		scene_change_scope->detector->mark_inferred();
+		const std::span<const float> output_values = output_array;
+		scene_change_scope->last_output.assign(
+			output_values.begin(), output_values.end()
+		);
+	}
+
+	depth_frame_latency_tracker.finish_processing(trace);
+	if (session_recording_scope->recorder) {
+		if (const auto error = session_recording_scope->recorder->write_frame(
+				frame_time_to_nanos(trace.capture_time),
+				session_recording_scope->rgb_pixels, output_array
+			)) {
+			LOG_ERROR("{}", error->to_string());
+			stop_session_recording(*session_recording_scope);
+		}
+	}
+	depth_model_stage.end();
+	if (pipeline_watchdog)
+		pipeline_watchdog->result_ready();
+	const PipelineStageScope obstacle_analysis_stage(
+		pipeline_watchdog.get(), OBSTACLE_ANALYSIS_WATCHDOG_STAGE
+	);
+
+	auto obstacle_sectors_scope = obstacle_sectors.lock();
+	if (obstacle_sectors_scope->summarizer) {
+		if (const auto error = obstacle_sectors_scope->summarizer->summarize(
+				output_array, obstacle_sectors_scope->sectors
+			))
+			LOG_ERROR(
+				"Failed to summarize obstacle sectors: {}", error->to_string()
+			);
+	}
+
+	auto depth_region_index_scope = depth_region_index.lock();
+	const DepthRegionIndex* region_index = nullptr;
+	if (*depth_region_index_scope) {
+		if (const auto error =
+				(*depth_region_index_scope)->update(output_array))
+			LOG_ERROR("Failed to index depth regions: {}", error->to_string());
+		else
+			region_index = &**depth_region_index_scope;
+	}
+
+	auto drop_offs_scope = drop_offs.lock();
+	if (drop_offs_scope->detector && region_index != nullptr) {
+		const auto hazards =
+			drop_offs_scope->detector->detect(output_array, *region_index);
+		if (!hazards)
+			LOG_ERROR(
+				"Failed to detect drop-offs: {}", hazards.error().to_string()
+			);
+		else
+			drop_offs_scope->hazards.assign(hazards->begin(), hazards->end());
+	}
+
+	auto obstacle_tracking_scope = obstacle_tracking.lock();
+	auto& tracking = *obstacle_tracking_scope;
+	if (tracking.extractor && tracking.tracker && tracking.time_to_collision) {
+		const auto blobs = tracking.extractor->extract(output_array);
+		if (!blobs) {
+			LOG_ERROR(
+				"Failed to extract obstacle blobs: {}",
+				blobs.error().to_string()
+			);
+		} else {
+			tracking.tracker->update(*blobs);
+			// capture time, so processing jitter does not distort the rates
+			tracking.time_to_collision->update(
+				tracking.tracker->get_tracks(), trace.capture_time
+			);
+		}
+	}
+
+	auto occupancy_grid_scope = occupancy_grid.lock();
+	auto& occupancy = *occupancy_grid_scope;
+	if (occupancy.projector && occupancy.ground && occupancy.grid) {
+		if (const auto error =
+				occupancy.projector->project(output_array, occupancy.points)) {
+			LOG_ERROR("Failed to back-project depth: {}", error->to_string());
+			return JNI_TRUE;
+		}
+		// a single thread, one estimate is too short to amortize spawning more
+		const auto ground = occupancy.ground->estimate(occupancy.points);
+		if (!ground) {
+			LOG_ERROR(
+				"Failed to estimate ground plane: {}",
+				ground.error().to_string()
+			);
+		}
+		// while the floor is occluded the last found plane is kept, the level
+		// floor at the camera height is only used before the first fit
+		if (occupancy.ground->has_plane()) {
+			occupancy.grid->integrate(
+				occupancy.points, occupancy.ground->get_latest().plane
+			);
+		} else {
+			occupancy.grid->integrate(occupancy.points);
+		}
+	}
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_configureObstacleSectors(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jint depth_width,
+	jint depth_height,
+	jint columns,
+	jint rows,
+	jboolean polar,
+	jfloat horizontal_fov_degrees,
+	jfloat roll_degrees,
+	jfloat pitch_degrees
+) {
+	SectorLayoutConfig config;
+	config.layout = polar ? SectorLayout::Polar : SectorLayout::Grid;
+	config.columns = columns;
+	config.rows = rows;
+	config.horizontal_fov_degrees = horizontal_fov_degrees;
+	config.roll_degrees = roll_degrees;
+	config.pitch_degrees = pitch_degrees;
+
+	auto summarizer =
+		ObstacleSectorSummarizer::create(config, depth_width, depth_height);
+	auto obstacle_sectors_scope = obstacle_sectors.lock();
+	if (!summarizer) {
+		LOG_ERROR("{}", summarizer.error().to_string());
+		obstacle_sectors_scope->summarizer.reset();
+		obstacle_sectors_scope->sectors.clear();
+		return JNI_FALSE;
+	}
+	obstacle_sectors_scope->sectors.assign(
+		summarizer->get_sector_count(), ObstacleSector()
+	);
+	obstacle_sectors_scope->summarizer.emplace(std::move(*summarizer));
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_getObstacleSectors(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray out_sector_values
+) {
+	NativeFloatArrayScope out_sector_value_array(env, out_sector_values);
+	const std::span<float> out_values = out_sector_value_array;
+
+	auto obstacle_sectors_scope = obstacle_sectors.lock();
+	if (!obstacle_sectors_scope->summarizer)
+		return 0;
+	const auto& directions =
+		obstacle_sectors_scope->summarizer->get_sector_directions();
+	const auto& sectors = obstacle_sectors_scope->sectors;
+
+	const size_t sector_count = std::min(
+		sectors.size(), out_values.size() / FLOATS_PER_OBSTACLE_SECTOR
+	);
+	for (size_t i = 0; i < sector_count; i++) {
+		auto values = out_values.subspan(
+			i * FLOATS_PER_OBSTACLE_SECTOR, FLOATS_PER_OBSTACLE_SECTOR
 		);
+		values[0] = directions[i].azimuth_degrees;
+		values[1] = directions[i].elevation_degrees;
+		values[2] = sectors[i].nearest;
+		values[3] = sectors[i].coverage;
+		values[4] = sectors[i].confidence;
 	}
+	return static_cast<jint>(sector_count);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_configureDropOffDetector(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jint depth_width,
+	jint depth_height,
+	jfloat horizontal_fov_degrees
+) {
+	DropOffConfig config;
+	config.horizontal_fov_degrees = horizontal_fov_degrees;
+
+	auto detector = DropOffDetector::create(config, depth_width, depth_height);
+	auto drop_offs_scope = drop_offs.lock();
+	drop_offs_scope->hazards.clear();
+	if (!detector) {
+		LOG_ERROR("{}", detector.error().to_string());
+		drop_offs_scope->detector.reset();
+		return JNI_FALSE;
+	}
+	drop_offs_scope->detector.emplace(std::move(*detector));
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_getDropOffHazards(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray out_hazard_values
+) {
+	NativeFloatArrayScope out_hazard_value_array(env, out_hazard_values);
+	const std::span<float> out_values = out_hazard_value_array;
+
+	auto drop_offs_scope = drop_offs.lock();
+	const auto& hazards = drop_offs_scope->hazards;
+	const size_t hazard_count = std::min(
+		hazards.size(), out_values.size() / FLOATS_PER_DROP_OFF_HAZARD
+	);
+	for (size_t i = 0; i < hazard_count; i++) {
+		auto values = out_values.subspan(
+			i * FLOATS_PER_DROP_OFF_HAZARD, FLOATS_PER_DROP_OFF_HAZARD
+		);
+		values[0] = hazards[i].azimuth_degrees;
+		values[1] = hazards[i].nearness;
+		values[2] = hazards[i].jump;
+		values[3] = hazards[i].confidence;
+	}
+	return static_cast<jint>(hazard_count);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_configureObstacleTracking(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jint depth_width,
+	jint depth_height,
+	jfloat near_threshold
+) {
+	ObstacleBlobConfig blob_config;
+	blob_config.near_threshold = near_threshold;
+
+	auto extractor =
+		ObstacleBlobExtractor::create(blob_config, depth_width, depth_height);
+	const ObstacleTrackerConfig tracker_config;
+	auto tracker =
+		ObstacleTracker::create(tracker_config, blob_config.max_blobs);
+	TimeToCollisionConfig time_to_collision_config;
+	time_to_collision_config.max_tracks = tracker_config.max_tracks;
+	auto time_to_collision =
+		TimeToCollisionEstimator::create(time_to_collision_config);
+	auto obstacle_tracking_scope = obstacle_tracking.lock();
+	obstacle_tracking_scope->extractor.reset();
+	obstacle_tracking_scope->tracker.reset();
+	obstacle_tracking_scope->time_to_collision.reset();
+	if (!extractor) {
+		LOG_ERROR("{}", extractor.error().to_string());
+		return JNI_FALSE;
+	}
+	if (!tracker) {
+		LOG_ERROR("{}", tracker.error().to_string());
+		return JNI_FALSE;
+	}
+	if (!time_to_collision) {
+		LOG_ERROR("{}", time_to_collision.error().to_string());
+		return JNI_FALSE;
+	}
+	obstacle_tracking_scope->extractor.emplace(std::move(*extractor));
+	obstacle_tracking_scope->tracker.emplace(std::move(*tracker));
+	obstacle_tracking_scope->time_to_collision.emplace(
+		std::move(*time_to_collision)
+	);
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_getTrackedObstacles(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray out_obstacle_values
+) {
+	NativeFloatArrayScope out_obstacle_value_array(env, out_obstacle_values);
+	const std::span<float> out_values = out_obstacle_value_array;
+
+	auto obstacle_tracking_scope = obstacle_tracking.lock();
+	if (!obstacle_tracking_scope->extractor ||
+		!obstacle_tracking_scope->tracker)
+		return 0;
+	const auto width =
+		static_cast<float>(obstacle_tracking_scope->extractor->get_width());
+	const auto height =
+		static_cast<float>(obstacle_tracking_scope->extractor->get_height());
+
+	size_t obstacle_count = 0;
+	for (const auto& track : obstacle_tracking_scope->tracker->get_tracks()) {
+		if (!track.confirmed)
+			continue;
+		if ((obstacle_count + 1) * FLOATS_PER_TRACKED_OBSTACLE >
+			out_values.size())
+			break;
+		auto values = out_values.subspan(
+			obstacle_count * FLOATS_PER_TRACKED_OBSTACLE,
+			FLOATS_PER_TRACKED_OBSTACLE
+		);
+		const ObstacleBlob& blob = track.blob;
+		values[0] = static_cast<float>(track.id);
+		values[1] = blob.centroid_x / width;
+		values[2] = blob.centroid_y / height;
+		values[3] = static_cast<float>(blob.max_x - blob.min_x + 1) / width;
+		values[4] = static_cast<float>(blob.max_y - blob.min_y + 1) / height;
+		values[5] = blob.nearest;
+		values[6] = track.approach_rate;
+		obstacle_count++;
+	}
+	return static_cast<jint>(obstacle_count);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_getMostUrgentCollision(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray out_threat_values
+) {
+	NativeFloatArrayScope out_threat_value_array(env, out_threat_values);
+	const std::span<float> out_values = out_threat_value_array;
+	if (out_values.size() < FLOATS_PER_COLLISION_THREAT)
+		return JNI_FALSE;
+
+	auto obstacle_tracking_scope = obstacle_tracking.lock();
+	if (!obstacle_tracking_scope->extractor ||
+		!obstacle_tracking_scope->time_to_collision)
+		return JNI_FALSE;
+	const auto threat =
+		obstacle_tracking_scope->time_to_collision->get_most_urgent();
+	if (!threat)
+		return JNI_FALSE;
+
+	const auto width =
+		static_cast<float>(obstacle_tracking_scope->extractor->get_width());
+	out_values[0] = static_cast<float>(threat->id);
+	out_values[1] = *threat->time_to_collision;
+	out_values[2] = threat->blob.centroid_x / width;
+	out_values[3] = threat->blob.nearest;
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_configureOccupancyGrid(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jint depth_width,
+	jint depth_height,
+	jfloat horizontal_fov_degrees,
+	jfloat pitch_degrees,
+	jfloat camera_height
+) {
+	BackProjectionConfig projection_config;
+	projection_config.horizontal_fov_degrees = horizontal_fov_degrees;
+	projection_config.pitch_degrees = pitch_degrees;
+	OccupancyGridConfig grid_config;
+	grid_config.camera_height = camera_height;
+
+	auto projector = DepthBackProjector::create(
+		projection_config, depth_width, depth_height
+	);
+	auto ground = GroundPlaneEstimator::create(
+		GroundPlaneConfig(), depth_width, depth_height
+	);
+	auto grid = OccupancyGrid::create(grid_config);
+	auto occupancy_grid_scope = occupancy_grid.lock();
+	if (!projector || !ground || !grid) {
+		if (!projector)
+			LOG_ERROR("{}", projector.error().to_string());
+		if (!ground)
+			LOG_ERROR("{}", ground.error().to_string());
+		if (!grid)
+			LOG_ERROR("{}", grid.error().to_string());
+		occupancy_grid_scope->projector.reset();
+		occupancy_grid_scope->ground.reset();
+		occupancy_grid_scope->grid.reset();
+		return JNI_FALSE;
+	}
+	occupancy_grid_scope->projector.emplace(std::move(*projector));
+	occupancy_grid_scope->ground.emplace(std::move(*ground));
+	occupancy_grid_scope->grid.emplace(std::move(*grid));
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_getOccupancyGrid(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray out_occupancy
+) {
+	NativeFloatArrayScope out_occupancy_array(env, out_occupancy);
+	const std::span<float> out_values = out_occupancy_array;
+
+	auto occupancy_grid_scope = occupancy_grid.lock();
+	if (!occupancy_grid_scope->grid)
+		return 0;
+	const auto occupancy = occupancy_grid_scope->grid->get_occupancy();
+	if (out_values.size() < occupancy.size())
+		return 0;
+	std::ranges::copy(occupancy, out_values.begin());
+	return static_cast<jint>(occupancy.size());
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_formatGroundPlane(
+	JNIEnv* env,
+	jobject /*thiz*/
+) {
+	auto occupancy_grid_scope = occupancy_grid.lock();
+	if (!occupancy_grid_scope->ground)
+		return env->NewStringUTF("Ground plane: -");
+	return env->NewStringUTF(
+		occupancy_grid_scope->ground->get_latest().formatted().c_str()
+	);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_configureSceneChangeDetector(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jint input_width,
+	jint input_height,
+	jfloat change_threshold,
+	jlong max_result_age_millis
+) {
+	SceneChangeConfig config;
+	config.change_threshold = change_threshold;
+	config.max_result_age = std::chrono::milliseconds(max_result_age_millis);
+
+	auto detector =
+		SceneChangeDetector::create(config, input_width, input_height);
+	auto scene_change_scope = scene_change.lock();
+	scene_change_scope->last_output.clear();
+	if (!detector) {
+		LOG_ERROR("{}", detector.error().to_string());
+		scene_change_scope->detector.reset();
+		return JNI_FALSE;
+	}
+	scene_change_scope->detector.emplace(std::move(*detector));
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_formatSceneChangeStats(
+	JNIEnv* env,
+	jobject /*this*/
+) {
+	auto scene_change_scope = scene_change.lock();
+	if (!scene_change_scope->detector)
+		return env->NewStringUTF("Static frames skipped: -");
+	return env->NewStringUTF(
+		scene_change_scope->detector->get_stats().formatted().c_str()
+	);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_configureDepthPropagation(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jint input_width,
+	jint input_height,
+	jint depth_width,
+	jint depth_height,
+	jint max_propagated_frames
+) {
+	auto depth_propagation_scope = depth_propagation.lock();
+	if (max_propagated_frames <= 0) {
+		depth_propagation_scope->reset();
+		return JNI_TRUE;
+	}
+
+	DepthPropagationConfig config;
+	config.max_propagated_frames = max_propagated_frames;
+	auto propagator = DepthPropagator::create(
+		config, input_width, input_height, depth_width, depth_height
+	);
+	if (!propagator) {
+		LOG_ERROR("{}", propagator.error().to_string());
+		depth_propagation_scope->reset();
+		return JNI_FALSE;
+	}
+	depth_propagation_scope->emplace(std::move(*propagator));
+	return JNI_TRUE;
+}
+
+constexpr size_t FLOATS_PER_QUALITY_LEVEL = 3;
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_configureQualityGovernor(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jlong target_result_age_millis,
+	jfloatArray level_values
+) {
+	auto quality_governor_scope = quality_governor.lock();
+	NativeFloatArrayScope level_value_array(env, level_values);
+	const std::span<const float> values = level_value_array;
+	if (values.empty()) {
+		quality_governor_scope->reset();
+		return JNI_TRUE;
+	}
+
+	QualityGovernorConfig config;
+	config.target_result_age =
+		std::chrono::milliseconds(target_result_age_millis);
+	for (size_t offset = 0; offset + FLOATS_PER_QUALITY_LEVEL <= values.size();
+		 offset += FLOATS_PER_QUALITY_LEVEL) {
+		QualityLevel level;
+		level.input_scale = values[offset];
+		level.inference_interval = static_cast<int>(values[offset + 1]);
+		level.quantized = values[offset + 2] != 0.0f;
+		level.name = std::format(
+			"{:.0f}% frame, 1/{} frames, {}", level.input_scale * 100.0f,
+			level.inference_interval, level.quantized ? "quantized" : "float"
+		);
+		config.levels.push_back(std::move(level));
+	}
+	auto governor = QualityGovernor::create(std::move(config));
+	if (!governor) {
+		LOG_ERROR("{}", governor.error().to_string());
+		quality_governor_scope->reset();
+		return JNI_FALSE;
+	}
+	quality_governor_scope->emplace(std::move(*governor));
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_getQualityLevel(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/
+) {
+	auto quality_governor_scope = quality_governor.lock();
+	if (!*quality_governor_scope)
+		return -1;
+	return static_cast<jint>((*quality_governor_scope)->get_level_index());
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_formatQualityGovernor(
+	JNIEnv* env,
+	jobject /*this*/
+) {
+	auto quality_governor_scope = quality_governor.lock();
+	if (!*quality_governor_scope)
+		return env->NewStringUTF("Quality: fixed");
+	const auto& governor = **quality_governor_scope;
+	const auto& decisions = governor.get_decisions();
+	if (decisions.empty())
+		return env->NewStringUTF(governor.formatted().c_str());
+	const auto formatted = std::format(
+		"{}\nLast change: {}", governor.formatted(),
+		decisions.back().formatted(governor.get_config())
+	);
+	return env->NewStringUTF(formatted.c_str());
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_formatDepthPropagationStats(
+	JNIEnv* env,
+	jobject /*this*/
+) {
+	auto depth_propagation_scope = depth_propagation.lock();
+	if (!*depth_propagation_scope)
+		return env->NewStringUTF("Keyframes: every frame");
+	return env->NewStringUTF(
+		(*depth_propagation_scope)->get_stats().formatted().c_str()
+	);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_configureFoveation(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/,
+	jint depth_width,
+	jint depth_height,
+	jfloat crop_fraction,
+	jfloat inference_budget
+) {
+	auto foveation_scope = foveation.lock();
+	if (inference_budget <= 1.0f) {
+		foveation_scope->blender.reset();
+		return JNI_TRUE;
+	}
+
+	FoveationConfig config;
+	config.crop_fraction = crop_fraction;
+	config.inference_budget = inference_budget;
+	auto blender = FoveatedDepthBlender::create(
+		config, depth_width, depth_height, depth_width, depth_height
+	);
+	if (!blender) {
+		LOG_ERROR("{}", blender.error().to_string());
+		foveation_scope->blender.reset();
+		return JNI_FALSE;
+	}
+	foveation_scope->blender.emplace(std::move(*blender));
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_shouldInferFoveaCenter(
+	JNIEnv* /*env*/,
+	jobject /*thiz*/
+) {
+	auto foveation_scope = foveation.lock();
+	if (!foveation_scope->blender ||
+		!foveation_scope->blender->can_afford_center())
+		return JNI_FALSE;
+
+	// propagated frames do not run the model at all
+	auto depth_propagation_scope = depth_propagation.lock();
+	if (*depth_propagation_scope &&
+		!(*depth_propagation_scope)->needs_keyframe())
+		return JNI_FALSE;
+	return JNI_TRUE;
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_formatFrameLatency(
+	JNIEnv* env,
+	jobject /*this*/
+) {
+	return env->NewStringUTF(
+		depth_frame_latency_tracker.stats().formatted().c_str()
+	);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_getPipelineHealth(
+	JNIEnv* /*env*/,
+	jobject /*this*/
+) {
+	if (!pipeline_watchdog)
+		return static_cast<jint>(PipelineHealth::Healthy);
+	return static_cast<jint>(pipeline_watchdog->get_status().health);
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_formatPipelineWatchdog(
+	JNIEnv* env,
+	jobject /*this*/
+) {
+	if (!pipeline_watchdog)
+		return env->NewStringUTF("Pipeline not watched");
+	const auto stats = pipeline_watchdog->get_stats();
+	const auto formatted = std::format(
+		"{} ({} stalls, {} lags)",
+		pipeline_watchdog->get_status().formatted(
+			pipeline_watchdog->get_config()
+		),
+		stats.stalled_events, stats.lagging_events
+	);
+	return env->NewStringUTF(formatted.c_str());
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_formatInferenceCancellation(
+	JNIEnv* env,
+	jobject /*this*/
+) {
+	if (!inference_canceller)
+		return env->NewStringUTF("Cancelled inferences: -");
+	return env->NewStringUTF(
+		inference_canceller->get_stats().formatted().c_str()
+	);
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_formatDepthCascade(
+	JNIEnv* env,
+	jobject /*this*/
+) {
+	auto depth_model_scope = depth_model.lock();
+	const DepthCascade* cascade = nullptr;
+	if (*depth_model_scope != nullptr)
+		cascade = (*depth_model_scope)->get_cascade();
+	return env->NewStringUTF(
+		cascade != nullptr ? cascade->get_stats().formatted().c_str()
+						   : "Depth cascade: -"
+	);
+}
+
+extern "C" JNIEXPORT jstring JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_formatDepthAlignment(
+	JNIEnv* env,
+	jobject /*this*/
+) {
+	auto depth_model_scope = depth_model.lock();
+	std::optional<ScaleShiftFit> fit;
+	if (*depth_model_scope != nullptr)
+		fit = (*depth_model_scope)->get_alignment_fit();
+	return env->NewStringUTF(
+		fit ? fit->formatted().c_str() : "Depth alignment: -"
+	);
 }
 
 extern "C" JNIEXPORT void JNICALL
@@ -114,6 +1277,51 @@ Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_depthColormap(
 	}
 }
 
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_upsampleDepth(
+	JNIEnv* env,
+	jobject /*thiz*/,
+	jfloatArray depth,
+	jint depth_width,
+	jint depth_height,
+	jintArray guide_pixels,
+	jint guide_width,
+	jint guide_height,
+	jfloatArray out_depth
+) {
+	auto guided_upsampler_scope = guided_upsampler.lock();
+	auto& upsampler = *guided_upsampler_scope;
+	if (!upsampler || upsampler->get_depth_width() != depth_width ||
+		upsampler->get_depth_height() != depth_height ||
+		upsampler->get_guide_width() != guide_width ||
+		upsampler->get_guide_height() != guide_height) {
+		const int threads = std::clamp(
+			static_cast<int>(std::thread::hardware_concurrency()), 1,
+			MAX_GUIDED_UPSAMPLING_THREADS
+		);
+		auto created = GuidedDepthUpsampler::create(
+			GuidedUpsamplingConfig(), depth_width, depth_height, guide_width,
+			guide_height, threads
+		);
+		if (!created) {
+			LOG_ERROR("{}", created.error().to_string());
+			upsampler.reset();
+			return JNI_FALSE;
+		}
+		upsampler.emplace(std::move(*created));
+	}
+
+	NativeFloatArrayScope depth_array(env, depth);
+	NativeIntArrayScope guide_array(env, guide_pixels);
+	NativeFloatArrayScope out_depth_array(env, out_depth);
+	if (const auto error =
+			upsampler->upsample(depth_array, guide_array, out_depth_array)) {
+		LOG_ERROR("upsampleDepth failed: {}", error->to_string());
+		return JNI_FALSE;
+	}
+	return JNI_TRUE;
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_algorithmic_1alliance_eyeaiapp_NativeLib_bitmapToRgbChwFloatArray(
 	JNIEnv* env,
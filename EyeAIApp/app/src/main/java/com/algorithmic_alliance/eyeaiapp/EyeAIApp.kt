@@ -5,9 +5,11 @@ import android.content.Context
 import android.util.Log
 import android.util.Size
 import com.algorithmic_alliance.eyeaiapp.camera.CameraManager
+import com.algorithmic_alliance.eyeaiapp.depth.AdaptiveQuality
 import com.algorithmic_alliance.eyeaiapp.depth.DepthModel
 import com.algorithmic_alliance.eyeaiapp.depth.DepthModelInfo
 import com.algorithmic_alliance.eyeaiapp.speech_recognition.VoskModel
+import java.io.File
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.launch
@@ -25,6 +27,9 @@ class EyeAIApp : Application() {
 		private set
 	var onDepthModelLoadedCallback: () -> Unit = {}
 
+	/** kept across depth model switches, switching to the quantized model is one of its levels */
+	val adaptiveQuality = AdaptiveQuality()
+
 	/** can be [null] if enableSpeechRecognition is disabled in settings */
 	var voskModel: VoskModel? = null
 		private set
@@ -33,6 +38,7 @@ class EyeAIApp : Application() {
 		const val APP_LOG_TAG = "Eye AI"
 
 		const val DEFAULT_DEPTH_MODEL_NAME = "MiDaS V2.1"
+		const val QUANTIZED_DEPTH_MODEL_NAME = "MiDaS V2.1 (quantized)"
 
 		val DEPTH_MODELS =
 			arrayOf(
@@ -42,9 +48,15 @@ class EyeAIApp : Application() {
 					Size(256, 256)
 				),
 				DepthModelInfo(
-					"MiDaS V2.1 (quantized)",
+					QUANTIZED_DEPTH_MODEL_NAME,
 					"midas_v2_1_256x256_quantized.tflite",
 					Size(256, 256)
+				),
+				DepthModelInfo(
+					"MiDaS V2.1 (cascade)",
+					"midas_v2_1_256x256_quantized.tflite",
+					Size(256, 256),
+					refinedFileName = "midas_v2_1_256x256.tflite"
 				)
 			)
 	}
@@ -55,6 +67,7 @@ class EyeAIApp : Application() {
 		settings = Settings(this)
 
 		switchDepthModel(settings.depthModel)
+		adaptiveQuality.configure(settings.adaptiveQuality)
 
 		if (settings.enableSpeechRecognition)
 			voskModel = VoskModel(this, "model-de")
@@ -67,6 +80,22 @@ class EyeAIApp : Application() {
 			switchDepthModel(newSettings.depthModel)
 		}
 
+		if (settings.keyframeDepth != newSettings.keyframeDepth) {
+			depthModel?.setKeyframeMode(newSettings.keyframeDepth)
+		}
+
+		if (settings.foveatedDepth != newSettings.foveatedDepth) {
+			depthModel?.setFoveatedMode(newSettings.foveatedDepth)
+		}
+
+		if (settings.adaptiveQuality != newSettings.adaptiveQuality) {
+			adaptiveQuality.configure(newSettings.adaptiveQuality)
+		}
+
+		if (settings.recordSession != newSettings.recordSession) {
+			depthModel?.setSessionRecording(sessionRecordingDirectory(newSettings))
+		}
+
 		if (settings.enableSpeechRecognition != newSettings.enableSpeechRecognition) {
 			val context = this as Context
 			CoroutineScope(Dispatchers.IO).launch {
@@ -82,6 +111,18 @@ class EyeAIApp : Application() {
 		settings = newSettings
 	}
 
+	/** @return the quantized model or the one from the settings */
+	fun depthModelName(quantized: Boolean): String =
+		findDepthModelInfo(if (quantized) QUANTIZED_DEPTH_MODEL_NAME else settings.depthModel).name
+
+	/**
+	 * switches between the quantized model and the one from the settings, has to be called on the
+	 * main thread
+	 */
+	fun useQuantizedModel(quantized: Boolean) {
+		switchDepthModel(depthModelName(quantized))
+	}
+
 	private fun switchDepthModel(modelName: String) {
 		if (depthModel?.name == modelName) return
 
@@ -92,6 +133,10 @@ class EyeAIApp : Application() {
 		CoroutineScope(Dispatchers.IO).launch {
 			depthModel = findDepthModelInfo(modelName)
 				.createDepthModel(context)
+			depthModel?.setKeyframeMode(settings.keyframeDepth)
+			depthModel?.setFoveatedMode(settings.foveatedDepth)
+			// every model gets its own session, their frame sizes may differ
+			depthModel?.setSessionRecording(sessionRecordingDirectory(settings))
 
 			if (depthModel != null) {
 				withContext(Dispatchers.Main) {
@@ -106,6 +151,10 @@ class EyeAIApp : Application() {
 		}
 	}
 
+	/** debug sessions are stored with the app files, null if recording is disabled */
+	private fun sessionRecordingDirectory(settings: Settings): File? =
+		if (settings.recordSession) File(getExternalFilesDir(null) ?: filesDir, "sessions") else null
+
 	private fun findDepthModelInfo(modelName: String): DepthModelInfo {
 		return DEPTH_MODELS.find { it.name == modelName }
 			?: (DEPTH_MODELS.find { it.name == DEFAULT_DEPTH_MODEL_NAME } ?: DEPTH_MODELS[0])
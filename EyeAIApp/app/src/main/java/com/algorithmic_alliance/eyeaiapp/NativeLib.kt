@@ -25,15 +25,259 @@ object NativeLib {
 		modelToken: String
 	)
 
+	/**
+	 * cascade of a fast model that runs on every frame and a refined model that runs on some
+	 * frames, the refined depth is aligned to the fast one and corrects the following frames
+	 * @param refineInterval the refined model runs at least on every n-th frame, more often while
+	 * the fast depth is inconsistent between frames
+	 */
+	external fun initCascadeDepthModel(
+		fastModel: ByteArray,
+		refinedModel: ByteArray,
+		gpuDelegateSerializationDir: String,
+		fastModelToken: String,
+		refinedModelToken: String,
+		refineInterval: Int
+	)
+
 	external fun shutdownDepthModel()
 
+	/**
+	 * debug recording of the inputs and outputs of [runDepthModelInference] into a session file
+	 * that can be replayed with eyeai-session, it stops when the depth model is replaced or shut
+	 * down
+	 * @param modelToken model file name without extension, like the eyeai-session tool uses it
+	 * @return false if there is no depth model or the file could not be created
+	 */
+	external fun startSessionRecording(path: String, modelToken: String): Boolean
+
+	external fun stopSessionRecording()
+
+	/**
+	 * registers a new camera frame for latency tracking
+	 * @param captureTimestampNanos in the System.nanoTime() timebase
+	 * @return frame id that should be passed to [runDepthModelInference]
+	 */
+	external fun submitCameraFrame(captureTimestampNanos: Long): Long
+
+	/**
+	 * @param centerInput center crop of the frame scaled to the model input size, only inferred
+	 * in foveated mode, see [shouldInferFoveaCenter]
+	 * @param frameId from [submitCameraFrame]
+	 * @param dequeueTimestampNanos System.nanoTime() when the frame was picked up for processing
+	 * @return false if no output was written, because the inference failed or was cancelled since
+	 * its frame became outdated while a newer one is waiting
+	 */
 	external fun runDepthModelInference(
 		input: FloatArray,
-		output: FloatArray
-	)
+		centerInput: FloatArray?,
+		output: FloatArray,
+		frameId: Long,
+		dequeueTimestampNanos: Long
+	): Boolean
+
+	external fun formatFrameLatency(): String
+
+	/** how many outdated inferences were cancelled in favor of newer frames */
+	external fun formatInferenceCancellation(): String
+
+	/**
+	 * health of [runDepthModelInference] checked by a native watchdog thread, so it is up to date
+	 * even while the inference is stuck
+	 * @return 0: healthy, 1: lagging (no new depth output), 2: stalled (a stage is stuck)
+	 */
+	external fun getPipelineHealth(): Int
+
+	external fun formatPipelineWatchdog(): String
+
+	/**
+	 * lets a native governor pick a quality level from the age of every depth output, it steps to
+	 * a cheaper level when outputs stay older than the target and back when they stay well below
+	 * @param targetResultAgeMillis outputs should not be older than this (capture to output)
+	 * @param levelValues 3 floats per level, from the best to the cheapest: input scale in (0, 1],
+	 * inference interval (every n-th frame) and 1.0f for the quantized model, empty disables it
+	 */
+	external fun configureQualityGovernor(
+		targetResultAgeMillis: Long,
+		levelValues: FloatArray
+	): Boolean
+
+	/** @return index of the current quality level, -1 if the governor is disabled */
+	external fun getQualityLevel(): Int
+
+	/** current quality level and the last change */
+	external fun formatQualityGovernor(): String
+
+	/** how often the refined model of a cascade ran, see [initCascadeDepthModel] */
+	external fun formatDepthCascade(): String
+
+	/** scale/shift of the latest depth output relative to the previous one */
+	external fun formatDepthAlignment(): String
+
+	/**
+	 * [runDepthModelInference] skips frames whose input barely differs from the last inferred
+	 * frame and returns the previous depth output for them instead
+	 * @param inputWidth width of the model input
+	 * @param changeThreshold mean absolute luma difference (0.0f to 1.0f) below which a frame is
+	 * skipped
+	 * @param maxResultAgeMillis the previous depth output is reused for at most this long
+	 * @return false if the configuration is invalid, no frames are skipped then
+	 */
+	external fun configureSceneChangeDetector(
+		inputWidth: Int,
+		inputHeight: Int,
+		changeThreshold: Float,
+		maxResultAgeMillis: Long
+	): Boolean
+
+	external fun formatSceneChangeStats(): String
+
+	/**
+	 * keyframe mode of [runDepthModelInference], the depth model only runs on keyframes and the
+	 * depth of the frames in between is warped from the last keyframe
+	 * @param maxPropagatedFrames frames in between keyframes at most, 0 disables keyframe mode
+	 * @return false if the configuration is invalid, every frame is inferred then
+	 */
+	external fun configureDepthPropagation(
+		inputWidth: Int,
+		inputHeight: Int,
+		depthWidth: Int,
+		depthHeight: Int,
+		maxPropagatedFrames: Int
+	): Boolean
+
+	external fun formatDepthPropagationStats(): String
+
+	/**
+	 * foveated mode of [runDepthModelInference], the model additionally runs on the center crop
+	 * of some frames and its depth is blended into the center of the depth output
+	 * @param cropFraction side length of the center crop relative to the frame
+	 * @param inferenceBudget average model runs per frame, 1.0f or less disables foveated mode
+	 * @return false if the configuration is invalid, foveated mode is disabled then
+	 */
+	external fun configureFoveation(
+		depthWidth: Int,
+		depthHeight: Int,
+		cropFraction: Float,
+		inferenceBudget: Float
+	): Boolean
+
+	/** if the next [runDepthModelInference] should get a center input within the budget */
+	external fun shouldInferFoveaCenter(): Boolean
+
+	/**
+	 * lays out the obstacle sectors that are summarized after every [runDepthModelInference]
+	 * @param polar azimuth/elevation bands instead of a grid of the image plane
+	 * @param rollDegrees camera rotation around its optical axis, positive is clockwise
+	 * @param pitchDegrees positive tilts the camera upwards
+	 * @return false if the layout is invalid, no sectors are summarized then
+	 */
+	external fun configureObstacleSectors(
+		depthWidth: Int,
+		depthHeight: Int,
+		columns: Int,
+		rows: Int,
+		polar: Boolean,
+		horizontalFovDegrees: Float,
+		rollDegrees: Float,
+		pitchDegrees: Float
+	): Boolean
+
+	/**
+	 * looks for drop-offs like stairs down or curbs in the walking path of every depth output of
+	 * [runDepthModelInference]
+	 * @return false if the configuration is invalid, no drop-offs are detected then
+	 */
+	external fun configureDropOffDetector(
+		depthWidth: Int,
+		depthHeight: Int,
+		horizontalFovDegrees: Float
+	): Boolean
+
+	/**
+	 * writes azimuth, nearness, jump and confidence of every drop-off of the latest depth output,
+	 * ordered from left to right
+	 * @return number of drop-offs written
+	 */
+	external fun getDropOffHazards(outHazardValues: FloatArray): Int
+
+	/**
+	 * extracts the connected regions of near pixels of every depth output of
+	 * [runDepthModelInference] and tracks them across frames with stable ids
+	 * @param nearThreshold relative inverse depth at which a pixel is near, 1.0f is nearest
+	 * @return false if the configuration is invalid, no obstacles are tracked then
+	 */
+	external fun configureObstacleTracking(
+		depthWidth: Int,
+		depthHeight: Int,
+		nearThreshold: Float
+	): Boolean
+
+	/**
+	 * writes id, centroid x and y, box width and height (relative to the depth size), nearest and
+	 * approach rate of every confirmed tracked obstacle, ordered by id
+	 * @return number of obstacles written
+	 */
+	external fun getTrackedObstacles(outObstacleValues: FloatArray): Int
+
+	/**
+	 * writes id, time to collision in seconds, centroid x relative to the depth width and nearest of
+	 * the tracked obstacle that will be reached first, see [configureObstacleTracking]
+	 * @return false if no tracked obstacle approaches
+	 */
+	external fun getMostUrgentCollision(outThreatValues: FloatArray): Boolean
+
+	/**
+	 * back-projects every depth output of [runDepthModelInference] into a 64 x 64 occupancy grid
+	 * of 10cm cells on the floor around the camera, the floor is estimated from the depth
+	 * @param pitchDegrees positive tilts the camera upwards
+	 * @param cameraHeight height of the camera above the floor in meters, used while no floor is
+	 * found
+	 * @return false if the configuration is invalid, no grid is updated then
+	 */
+	external fun configureOccupancyGrid(
+		depthWidth: Int,
+		depthHeight: Int,
+		horizontalFovDegrees: Float,
+		pitchDegrees: Float,
+		cameraHeight: Float
+	): Boolean
+
+	/**
+	 * writes the occupancy of every grid cell, row by row starting nearest to the camera
+	 * @return number of cells written, 0 if outOccupancy is too small or no grid is configured
+	 */
+	external fun getOccupancyGrid(outOccupancy: FloatArray): Int
+
+	/** ground plane the occupancy grid heights of the latest depth output are measured from */
+	external fun formatGroundPlane(): String
+
+	/**
+	 * writes azimuth, elevation, nearest, coverage and confidence of every sector of the latest
+	 * depth output, row by row starting at the top
+	 * @return number of sectors written
+	 */
+	external fun getObstacleSectors(outSectorValues: FloatArray): Int
 
 	external fun depthColormap(depthValues: FloatArray, colormappedPixels: IntArray)
 
+	/**
+	 * edge-aware upsampling of a depth output to the frame resolution, depth edges follow the
+	 * edges of the frame
+	 * @param guidePixels argb pixels of the frame the depth was estimated from
+	 * @param outDepth guideWidth * guideHeight values between 0.0f and 1.0f
+	 * @return false if the sizes are invalid, outDepth is unchanged then
+	 */
+	external fun upsampleDepth(
+		depth: FloatArray,
+		depthWidth: Int,
+		depthHeight: Int,
+		guidePixels: IntArray,
+		guideWidth: Int,
+		guideHeight: Int,
+		outDepth: FloatArray
+	): Boolean
+
 	external fun bitmapToRgbChwFloatArray(bitmap: Bitmap, outFloatArray: FloatArray)
 
 	external fun bitmapToRgbHwc255FloatArray(bitmap: Bitmap, outFloatArray: FloatArray)
@@ -12,6 +12,21 @@ class Settings(val context: Context) {
 	var showProfilingInfo: Boolean
 		private set
 
+	var keyframeDepth: Boolean
+		private set
+
+	var foveatedDepth: Boolean
+		private set
+
+	var guidedUpsampling: Boolean
+		private set
+
+	var adaptiveQuality: Boolean
+		private set
+
+	var recordSession: Boolean
+		private set
+
 	var enableSpeechRecognition: Boolean
 		private set
 
@@ -26,6 +41,31 @@ class Settings(val context: Context) {
 			false
 		)
 
+		keyframeDepth = sharedPreferences.getBoolean(
+			context.getString(R.string.keyframe_depth_setting),
+			false
+		)
+
+		foveatedDepth = sharedPreferences.getBoolean(
+			context.getString(R.string.foveated_depth_setting),
+			false
+		)
+
+		guidedUpsampling = sharedPreferences.getBoolean(
+			context.getString(R.string.guided_upsampling_setting),
+			false
+		)
+
+		adaptiveQuality = sharedPreferences.getBoolean(
+			context.getString(R.string.adaptive_quality_setting),
+			false
+		)
+
+		recordSession = sharedPreferences.getBoolean(
+			context.getString(R.string.record_session_setting),
+			false
+		)
+
 		enableSpeechRecognition = sharedPreferences.getBoolean(
 			context.getString(R.string.enable_speech_recognition_setting),
 			true
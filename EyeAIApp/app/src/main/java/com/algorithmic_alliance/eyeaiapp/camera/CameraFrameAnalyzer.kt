@@ -2,6 +2,7 @@ package com.algorithmic_alliance.eyeaiapp.camera
 
 import android.annotation.SuppressLint
 import android.graphics.Bitmap
+import android.util.Size
 import android.widget.ImageView
 import android.widget.TextView
 import androidx.annotation.OptIn
@@ -10,15 +11,23 @@ import androidx.camera.core.ImageAnalysis
 import androidx.camera.core.ImageProxy
 import com.algorithmic_alliance.eyeaiapp.EyeAIApp
 import com.algorithmic_alliance.eyeaiapp.NativeLib
+import com.algorithmic_alliance.eyeaiapp.depth.fastestApproaching
+import com.algorithmic_alliance.eyeaiapp.depth.nearestDropOff
+import com.algorithmic_alliance.eyeaiapp.depth.nearestObstacle
+import com.algorithmic_alliance.eyeaiapp.vibrate
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.asCoroutineDispatcher
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.isActive
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
 import java.util.concurrent.Executors
 import java.util.concurrent.atomic.AtomicReference
 
+/** camera frame together with its id from [NativeLib.submitCameraFrame] */
+class CameraFrame(val bitmap: Bitmap, val frameId: Long)
+
 /**
  * Helper class that analyses the camera feed images in realtime
  */
@@ -30,9 +39,28 @@ class CameraFrameAnalyzer(
 ) : ImageAnalysis.Analyzer {
 
 	private var processingExecutor = Executors.newSingleThreadExecutor()
-	private var latestCameraFrame = AtomicReference<Bitmap?>(null)
+	private var latestCameraFrame = AtomicReference<CameraFrame?>(null)
+	/** camera frames since the last one that was handed to the depth model */
+	private var framesSinceInference = 0
 
 	init {
+		// polled apart from the processing loop, so the warning still comes while it is stuck
+		CoroutineScope(Dispatchers.Default).launch {
+			var previousHealth = PIPELINE_HEALTHY
+			while (isActive) {
+				delay(WATCHDOG_POLL_MILLIS)
+				val health = NativeLib.getPipelineHealth()
+				if (health != previousHealth && health != PIPELINE_HEALTHY) {
+					vibrate(eyeAIApp, STALL_VIBRATION_MILLIS)
+					val warning = NativeLib.formatPipelineWatchdog()
+					withContext(Dispatchers.Main) {
+						performanceText.text = warning
+					}
+				}
+				previousHealth = health
+			}
+		}
+
 		CoroutineScope(processingExecutor.asCoroutineDispatcher()).launch {
 			while (isActive) {
 				val depthModel = eyeAIApp.depthModel
@@ -40,18 +68,63 @@ class CameraFrameAnalyzer(
 				val frame = latestCameraFrame.getAndSet(null)
 
 				if (frame != null && depthModel != null) {
+					val quality = eyeAIApp.adaptiveQuality.current()
+					// the depth model is null until the other variant is loaded
+					if (depthModel.name != eyeAIApp.depthModelName(quality.quantized)) {
+						withContext(Dispatchers.Main) {
+							eyeAIApp.useQuantizedModel(quality.quantized)
+						}
+						continue
+					}
+					if (++framesSinceInference < quality.inferenceInterval)
+						continue
+					framesSinceInference = 0
+
+					val dequeueTimestampNanos = System.nanoTime()
 					NativeLib.newDepthFrame()
 
-					val predictionOutput = depthModel.predictDepth(frame)
+					val inputBitmap = if (quality.inputScale < 1.0f) {
+						Bitmap.createScaledBitmap(
+							frame.bitmap,
+							maxOf(1, (frame.bitmap.width * quality.inputScale).toInt()),
+							maxOf(1, (frame.bitmap.height * quality.inputScale).toInt()),
+							true
+						)
+					} else {
+						frame.bitmap
+					}
+
+					// the previous depth stays visible when there is none for this frame
+					val predictionOutput =
+						depthModel.predictDepth(inputBitmap, frame.frameId, dequeueTimestampNanos)
+							?: continue
+
+					val nearestObstacle = depthModel.obstacleSectors.latest().nearestObstacle()
+					val nearestDropOff = depthModel.dropOffs.latest().nearestDropOff()
+					val trackedObstacles = depthModel.trackedObstacles.latest()
+					val mostUrgentCollision = depthModel.trackedObstacles.mostUrgentCollision()
 
-					val inputWidth = frame.width
-					val inputHeight = frame.height
+					val inputWidth = inputBitmap.width
+					val inputHeight = inputBitmap.height
+
+					val upsampledOutput = if (eyeAIApp.settings.guidedUpsampling) {
+						depthModel.upsampleToFrame(predictionOutput, inputBitmap)
+					} else {
+						null
+					}
 
 					withContext(Dispatchers.Main) {
-						val colorMappedImage = NativeLib.depthColorMap(
-							predictionOutput,
-							depthModel.inputDim
-						)
+						val colorMappedImage = if (upsampledOutput != null) {
+							NativeLib.depthColorMap(
+								upsampledOutput,
+								Size(inputWidth, inputHeight)
+							)
+						} else {
+							NativeLib.depthColorMap(
+								predictionOutput,
+								depthModel.inputDim
+							)
+						}
 						depthView.setImageBitmap(colorMappedImage)
 
 						if (eyeAIApp.settings.showProfilingInfo) {
@@ -60,8 +133,37 @@ class CameraFrameAnalyzer(
 							val modelInputSize = depthModel.inputDim
 							val formattedModelInputSize =
 								"${modelInputSize.width}x${modelInputSize.height}"
+							val formattedNearestObstacle = nearestObstacle?.let {
+								"%.0f° azimuth, %.0f° elevation (nearest: %.2f, confidence: %.2f)".format(
+									it.azimuthDegrees,
+									it.elevationDegrees,
+									it.nearest,
+									it.confidence
+								)
+							} ?: "none"
+							val formattedNearestDropOff = nearestDropOff?.let {
+								"%.0f° azimuth (nearness: %.2f, confidence: %.2f)".format(
+									it.azimuthDegrees,
+									it.nearness,
+									it.confidence
+								)
+							} ?: "none"
+							val formattedApproaching = trackedObstacles.fastestApproaching()?.let {
+								"#%d (nearest: %.2f, approach: %.3f/frame)".format(
+									it.id,
+									it.nearest,
+									it.approachRate
+								)
+							} ?: "none"
+							val formattedCollision = mostUrgentCollision?.let {
+								"#%d in %.1f s (nearest: %.2f)".format(
+									it.id,
+									it.timeToCollision,
+									it.nearest
+								)
+							} ?: "none"
 							performanceText.text =
-								"Model: $modelName\nCamera resolution: $formattedInputResolution --> Model input: $formattedModelInputSize\n\n${NativeLib.formatDepthFrame()}\n${NativeLib.formatCameraFrame()}"
+								"Model: $modelName\nCamera resolution: $formattedInputResolution --> Model input: $formattedModelInputSize\nNearest obstacle: $formattedNearestObstacle\nNearest drop-off: $formattedNearestDropOff\nTracked obstacles: ${trackedObstacles.size}, approaching: $formattedApproaching\nTime to collision: $formattedCollision\n\n${NativeLib.formatFrameLatency()}\n${NativeLib.formatInferenceCancellation()}\n${NativeLib.formatPipelineWatchdog()}\n${NativeLib.formatQualityGovernor()}\n${NativeLib.formatDepthCascade()}\n${NativeLib.formatDepthAlignment()}\n${NativeLib.formatSceneChangeStats()}\n${NativeLib.formatDepthPropagationStats()}\n${NativeLib.formatGroundPlane()}\n\n${NativeLib.formatDepthFrame()}\n${NativeLib.formatCameraFrame()}"
 						} else {
 							performanceText.text = ""
 						}
@@ -76,11 +178,22 @@ class CameraFrameAnalyzer(
 		if (image.image != null) {
 			NativeLib.newCameraFrame()
 
+			// CameraX timestamps use the monotonic clock of System.nanoTime() on most devices,
+			// implausible timestamps are replaced by the submit time in native code
+			val frameId = NativeLib.submitCameraFrame(image.imageInfo.timestamp)
+
 			val inputBitmap =
 				NativeLib.imageToBitmap(image.image!!, image.imageInfo.rotationDegrees.toFloat())
 
-			latestCameraFrame.set(inputBitmap)
+			latestCameraFrame.set(CameraFrame(inputBitmap, frameId))
 		}
 		image.close()
 	}
+
+	companion object {
+		/** same value as PipelineHealth::Healthy in native code */
+		private const val PIPELINE_HEALTHY = 0
+		private const val WATCHDOG_POLL_MILLIS = 50L
+		private const val STALL_VIBRATION_MILLIS = 300L
+	}
 }
@@ -0,0 +1,57 @@
+package com.algorithmic_alliance.eyeaiapp.depth
+
+import com.algorithmic_alliance.eyeaiapp.NativeLib
+
+/**
+ * One step between quality and speed of the depth pipeline
+ * @param inputScale resolution of the frames handed to the depth model relative to the camera
+ * frames, between 0.0f (exclusive) and 1.0f. The model input always has the size of the model, so
+ * this only makes the resizing and upsampling cheaper, not the inference
+ * @param inferenceInterval the depth model runs on every n-th camera frame
+ * @param quantized runs the quantized variant of the depth model
+ */
+class QualityLevel(
+	val inputScale: Float,
+	val inferenceInterval: Int,
+	val quantized: Boolean
+)
+
+/** Quality level picked by a native governor from the age of the newest depth output */
+class AdaptiveQuality(private val levels: List<QualityLevel> = DEFAULT_LEVELS) {
+	/** the best level is used while disabled */
+	fun configure(
+		enabled: Boolean,
+		targetResultAgeMillis: Long = DEFAULT_TARGET_RESULT_AGE_MILLIS
+	): Boolean {
+		if (!enabled)
+			return NativeLib.configureQualityGovernor(0, FloatArray(0))
+
+		val levelValues = FloatArray(levels.size * FLOATS_PER_LEVEL)
+		levels.forEachIndexed { i, level ->
+			val offset = i * FLOATS_PER_LEVEL
+			levelValues[offset] = level.inputScale
+			levelValues[offset + 1] = level.inferenceInterval.toFloat()
+			levelValues[offset + 2] = if (level.quantized) 1.0f else 0.0f
+		}
+		return NativeLib.configureQualityGovernor(targetResultAgeMillis, levelValues)
+	}
+
+	fun current(): QualityLevel = levels.getOrNull(NativeLib.getQualityLevel()) ?: levels[0]
+
+	companion object {
+		private const val FLOATS_PER_LEVEL = 3
+
+		const val DEFAULT_TARGET_RESULT_AGE_MILLIS = 200L
+
+		/**
+		 * from the best to the cheapest level. The governor watches the age of the newest depth
+		 * output, skipping frames only saves power and makes that age worse, so every step changes
+		 * the model or the input size instead of the cadence
+		 */
+		val DEFAULT_LEVELS = listOf(
+			QualityLevel(1.0f, 1, false),
+			QualityLevel(1.0f, 1, true),
+			QualityLevel(0.5f, 1, true)
+		)
+	}
+}
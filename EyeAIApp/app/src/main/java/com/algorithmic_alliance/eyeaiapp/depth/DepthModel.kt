@@ -11,11 +11,16 @@ import androidx.core.graphics.scale
 import com.algorithmic_alliance.eyeaiapp.EyeAIApp
 import com.algorithmic_alliance.eyeaiapp.NativeLib
 
-/** All needed information to create and use a depth model */
+/**
+ * All needed information to create and use a depth model
+ * @param refinedFileName model with the same input and output that refines the model of fileName
+ * in a cascade, see [NativeLib.initCascadeDepthModel]
+ */
 class DepthModelInfo(
 	val name: String,
 	val fileName: String,
-	val inputDim: Size
+	val inputDim: Size,
+	val refinedFileName: String? = null
 ) {
 	/** @return null if model type is not supported */
 	fun createDepthModel(context: Context): DepthModel {
@@ -23,7 +28,8 @@ class DepthModelInfo(
 			context,
 			name,
 			fileName,
-			inputDim
+			inputDim,
+			refinedFileName
 		)
 	}
 }
@@ -32,19 +38,38 @@ class DepthModel(
 	context: Context,
 	val name: String,
 	val fileName: String,
-	val inputDim: Size
+	val inputDim: Size,
+	val refinedFileName: String? = null
 ) : AutoCloseable {
+	/** summarized after every [predictDepth] */
+	val obstacleSectors = ObstacleSectors()
+
+	/** updated after every [predictDepth] */
+	val occupancyGrid = OccupancyGrid()
+
+	/** detected after every [predictDepth] */
+	val dropOffs = DropOffHazards()
+
+	/** tracked after every [predictDepth] */
+	val trackedObstacles = TrackedObstacles()
+
+	/** see [setFoveatedMode] */
+	private var foveated = false
+
 	init {
 		val modelData = context.assets.open(fileName).readBytes()
 
 		val gpuDelegateCacheDirectory =
 			createSerializedGpuDelegateCacheDirectory(context)
 		val modelToken = getModelToken(context, fileName)
+		val refinedModelToken = refinedFileName?.let { getModelToken(context, it) }
 
 		// cleanup old cached gpu delegate files
 		if (gpuDelegateCacheDirectory.exists()) {
 			for (file in gpuDelegateCacheDirectory.listFiles()!!) {
-				if (!file.name.contains(modelToken)) {
+				if (!file.name.contains(modelToken) &&
+					(refinedModelToken == null || !file.name.contains(refinedModelToken))
+				) {
 					try {
 						Log.i(
 							EyeAIApp.APP_LOG_TAG,
@@ -57,32 +82,161 @@ class DepthModel(
 			}
 		}
 
-		NativeLib.initDepthModel(
-			modelData,
-			gpuDelegateCacheDirectory.path,
-			modelToken
+		if (refinedFileName != null && refinedModelToken != null) {
+			NativeLib.initCascadeDepthModel(
+				modelData,
+				context.assets.open(refinedFileName).readBytes(),
+				gpuDelegateCacheDirectory.path,
+				modelToken,
+				refinedModelToken,
+				CASCADE_REFINE_INTERVAL
+			)
+		} else {
+			NativeLib.initDepthModel(
+				modelData,
+				gpuDelegateCacheDirectory.path,
+				modelToken
+			)
+		}
+		obstacleSectors.configure(inputDim.width, inputDim.height)
+		occupancyGrid.configure(inputDim.width, inputDim.height)
+		dropOffs.configure(inputDim.width, inputDim.height)
+		trackedObstacles.configure(inputDim.width, inputDim.height)
+		NativeLib.configureSceneChangeDetector(
+			inputDim.width,
+			inputDim.height,
+			SCENE_CHANGE_THRESHOLD,
+			MAX_RESULT_AGE_MILLIS
+		)
+	}
+
+	/**
+	 * in keyframe mode the model only runs on keyframes, the frames in between get the depth of
+	 * the last keyframe moved along with the camera motion
+	 */
+	fun setKeyframeMode(enabled: Boolean) {
+		NativeLib.configureDepthPropagation(
+			inputDim.width,
+			inputDim.height,
+			inputDim.width,
+			inputDim.height,
+			if (enabled) MAX_PROPAGATED_FRAMES else 0
+		)
+	}
+
+	/**
+	 * in foveated mode the model also runs on the center crop of the frame when the inference
+	 * budget allows it, which gives a more detailed depth where obstacles matter the most
+	 */
+	fun setFoveatedMode(enabled: Boolean) {
+		foveated = enabled
+		NativeLib.configureFoveation(
+			inputDim.width,
+			inputDim.height,
+			FOVEA_CROP_FRACTION,
+			if (enabled) FOVEA_INFERENCE_BUDGET else 0.0f
+		)
+	}
+
+	/**
+	 * records the frames of [predictDepth] into a new session file in directory for replaying them
+	 * on a desktop, null stops the recording
+	 */
+	fun setSessionRecording(directory: File?) {
+		if (directory == null) {
+			NativeLib.stopSessionRecording()
+			return
+		}
+		directory.mkdirs()
+		val modelToken = File(fileName).nameWithoutExtension
+		val session = File(directory, "${modelToken}_${System.currentTimeMillis()}.eyeaisession")
+		if (!NativeLib.startSessionRecording(session.absolutePath, modelToken))
+			Log.e(EyeAIApp.APP_LOG_TAG, "Failed to record session to ${session.absolutePath}")
+	}
+
+	/**
+	 * upsamples the output of [predictDepth] to the resolution of its input, edge-aware so thin
+	 * obstacles keep their outline
+	 * @return null if upsampling failed or the frame is smaller than the depth (e.g. with a reduced
+	 * input scale), the depth is then used at its own resolution
+	 */
+	fun upsampleToFrame(depth: FloatArray, frame: Bitmap): FloatArray? {
+		// there is nothing to upsample, the native upsampler rejects smaller guides
+		if (frame.width < inputDim.width || frame.height < inputDim.height)
+			return null
+		val guidePixels = IntArray(frame.width * frame.height)
+		frame.getPixels(guidePixels, 0, frame.width, 0, 0, frame.width, frame.height)
+		val output = FloatArray(frame.width * frame.height)
+		val upsampled = NativeLib.upsampleDepth(
+			depth,
+			inputDim.width,
+			inputDim.height,
+			guidePixels,
+			frame.width,
+			frame.height,
+			output
 		)
+		return if (upsampled) output else null
 	}
 
 	override fun close() {
 		NativeLib.shutdownDepthModel()
 	}
 
+	companion object {
+		/** frames that differ less from the last inferred frame reuse its depth output */
+		const val SCENE_CHANGE_THRESHOLD = 0.015f
+		const val MAX_RESULT_AGE_MILLIS = 500L
+
+		/** frames propagated from one keyframe at most, faster motion requests keyframes earlier */
+		const val MAX_PROPAGATED_FRAMES = 4
+
+		/** the refined model of a cascade runs at least on every n-th frame */
+		const val CASCADE_REFINE_INTERVAL = 8
+
+		/** side length of the center crop relative to the frame */
+		const val FOVEA_CROP_FRACTION = 0.5f
+		/** average model runs per frame in foveated mode */
+		const val FOVEA_INFERENCE_BUDGET = 1.5f
+	}
+
 	/**
 	 * @param input is not enforced to match [inputDim], but should be at least a bit larger
-	 * @return relative depth for each pixel between 0.0f and 1.0f
+	 * @param frameId from [NativeLib.submitCameraFrame]
+	 * @param dequeueTimestampNanos System.nanoTime() when the frame was picked up for processing
+	 * @return relative depth for each pixel between 0.0f and 1.0f, null if there is no depth for
+	 * this frame (e.g. it was cancelled for a newer frame)
 	 */
-	fun predictDepth(input: Bitmap): FloatArray {
+	fun predictDepth(input: Bitmap, frameId: Long, dequeueTimestampNanos: Long): FloatArray? {
+		var centerInput: FloatArray? = null
+		if (foveated && NativeLib.shouldInferFoveaCenter()) {
+			val centerWidth = (input.width * FOVEA_CROP_FRACTION).toInt()
+			val centerHeight = (input.height * FOVEA_CROP_FRACTION).toInt()
+			val center = Bitmap.createBitmap(
+				input,
+				(input.width - centerWidth) / 2,
+				(input.height - centerHeight) / 2,
+				centerWidth,
+				centerHeight
+			)
+			centerInput = NativeLib.bitmapToRgbHwc255FloatArray(
+				center.scale(inputDim.width, inputDim.height)
+			)
+		}
+
 		val scaled = input.scale(inputDim.width, inputDim.height)
 		val input = NativeLib.bitmapToRgbHwc255FloatArray(scaled)
 		var output = FloatArray(inputDim.width * inputDim.height)
 
-		NativeLib.runDepthModelInference(
+		val inferred = NativeLib.runDepthModelInference(
 			input,
+			centerInput,
 			output,
+			frameId,
+			dequeueTimestampNanos
 		)
 
-		return output
+		return if (inferred) output else null
 	}
 }
 
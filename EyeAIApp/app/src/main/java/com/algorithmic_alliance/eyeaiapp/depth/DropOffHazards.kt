@@ -0,0 +1,50 @@
+package com.algorithmic_alliance.eyeaiapp.depth
+
+import com.algorithmic_alliance.eyeaiapp.NativeLib
+
+/**
+ * Sudden depth increase in the walking path, like a stair down or a curb, see
+ * [NativeLib.configureDropOffDetector]
+ * @param nearness relative inverse depth of the floor right before the edge, 1.0f is nearest
+ * @param jump drop of relative inverse depth across the edge
+ * @param confidence how certain the edge is a drop-off, between 0.0f and 1.0f
+ */
+class DropOffHazard(
+	val azimuthDegrees: Float,
+	val nearness: Float,
+	val jump: Float,
+	val confidence: Float
+)
+
+/** Drop-off hazards of the latest depth output, detected in native code */
+class DropOffHazards(private val bands: Int = 5) {
+	private val hazardValues = FloatArray(bands * FLOATS_PER_HAZARD)
+
+	/** has to be called again when the depth size changes */
+	fun configure(
+		depthWidth: Int,
+		depthHeight: Int,
+		horizontalFovDegrees: Float = ObstacleSectors.DEFAULT_HORIZONTAL_FOV_DEGREES
+	): Boolean = NativeLib.configureDropOffDetector(depthWidth, depthHeight, horizontalFovDegrees)
+
+	fun latest(): List<DropOffHazard> {
+		val hazardCount = NativeLib.getDropOffHazards(hazardValues)
+		return List(hazardCount) { i ->
+			val offset = i * FLOATS_PER_HAZARD
+			DropOffHazard(
+				hazardValues[offset],
+				hazardValues[offset + 1],
+				hazardValues[offset + 2],
+				hazardValues[offset + 3]
+			)
+		}
+	}
+
+	companion object {
+		private const val FLOATS_PER_HAZARD = 4
+	}
+}
+
+/** @return the nearest drop-off, null if none is confident enough */
+fun List<DropOffHazard>.nearestDropOff(minConfidence: Float = 0.5f): DropOffHazard? =
+	filter { it.confidence >= minConfidence }.maxByOrNull { it.nearness }
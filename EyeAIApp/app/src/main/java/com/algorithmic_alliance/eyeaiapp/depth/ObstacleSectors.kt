@@ -0,0 +1,69 @@
+package com.algorithmic_alliance.eyeaiapp.depth
+
+import com.algorithmic_alliance.eyeaiapp.NativeLib
+
+/**
+ * Summary of a depth map region, see [NativeLib.configureObstacleSectors]
+ * @param nearest relative inverse depth between 0.0f and 1.0f, 1.0f is the nearest point
+ * @param coverage fraction of the sector that is covered by obstacles
+ * @param confidence how certain the sector contains an obstacle, between 0.0f and 1.0f
+ */
+class ObstacleSector(
+	val azimuthDegrees: Float,
+	val elevationDegrees: Float,
+	val nearest: Float,
+	val coverage: Float,
+	val confidence: Float
+)
+
+/** Obstacle sectors of the latest depth output, computed in native code */
+class ObstacleSectors(
+	private val columns: Int = 5,
+	private val rows: Int = 3
+) {
+	private val sectorValues = FloatArray(columns * rows * FLOATS_PER_SECTOR)
+
+	/** has to be called again when the depth size or camera rotation changes */
+	fun configure(
+		depthWidth: Int,
+		depthHeight: Int,
+		polar: Boolean = true,
+		horizontalFovDegrees: Float = DEFAULT_HORIZONTAL_FOV_DEGREES,
+		rollDegrees: Float = 0.0f,
+		pitchDegrees: Float = 0.0f
+	): Boolean = NativeLib.configureObstacleSectors(
+		depthWidth,
+		depthHeight,
+		columns,
+		rows,
+		polar,
+		horizontalFovDegrees,
+		rollDegrees,
+		pitchDegrees
+	)
+
+	fun latest(): List<ObstacleSector> {
+		val sectorCount = NativeLib.getObstacleSectors(sectorValues)
+		return List(sectorCount) { i ->
+			val offset = i * FLOATS_PER_SECTOR
+			ObstacleSector(
+				sectorValues[offset],
+				sectorValues[offset + 1],
+				sectorValues[offset + 2],
+				sectorValues[offset + 3],
+				sectorValues[offset + 4]
+			)
+		}
+	}
+
+	companion object {
+		private const val FLOATS_PER_SECTOR = 5
+
+		/** typical horizontal field of view of a phone main camera */
+		const val DEFAULT_HORIZONTAL_FOV_DEGREES = 65.0f
+	}
+}
+
+/** @return sector with the nearest obstacle, null if no sector is confident enough */
+fun List<ObstacleSector>.nearestObstacle(minConfidence: Float = 0.5f): ObstacleSector? =
+	filter { it.confidence >= minConfidence }.maxByOrNull { it.nearest }
@@ -0,0 +1,43 @@
+package com.algorithmic_alliance.eyeaiapp.depth
+
+import com.algorithmic_alliance.eyeaiapp.NativeLib
+
+/**
+ * Floor occupancy grid around the camera, updated in native code after every depth output,
+ * see [NativeLib.configureOccupancyGrid]
+ */
+class OccupancyGrid(
+	val columns: Int = 64,
+	val rows: Int = 64
+) {
+	private val occupancy = FloatArray(columns * rows)
+
+	/** has to be called again when the depth size or camera pitch changes */
+	fun configure(
+		depthWidth: Int,
+		depthHeight: Int,
+		horizontalFovDegrees: Float = ObstacleSectors.DEFAULT_HORIZONTAL_FOV_DEGREES,
+		pitchDegrees: Float = 0.0f,
+		cameraHeight: Float = DEFAULT_CAMERA_HEIGHT
+	): Boolean = NativeLib.configureOccupancyGrid(
+		depthWidth,
+		depthHeight,
+		horizontalFovDegrees,
+		pitchDegrees,
+		cameraHeight
+	)
+
+	/**
+	 * @return occupancy between 0.0f and 1.0f of every cell, row by row starting nearest to the
+	 * camera, empty if the grid is not configured
+	 */
+	fun latest(): FloatArray {
+		val cellCount = NativeLib.getOccupancyGrid(occupancy)
+		return if (cellCount == occupancy.size) occupancy.copyOf() else FloatArray(0)
+	}
+
+	companion object {
+		/** height in meters a phone is typically held at while walking */
+		const val DEFAULT_CAMERA_HEIGHT = 1.3f
+	}
+}
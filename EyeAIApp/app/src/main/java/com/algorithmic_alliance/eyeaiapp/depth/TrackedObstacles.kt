@@ -0,0 +1,84 @@
+package com.algorithmic_alliance.eyeaiapp.depth
+
+import com.algorithmic_alliance.eyeaiapp.NativeLib
+
+/**
+ * Near region of the depth output that keeps its [id] across frames, see
+ * [NativeLib.configureObstacleTracking]
+ * @param centerX centroid relative to the depth width, 0.0f is left
+ * @param centerY centroid relative to the depth height, 0.0f is top
+ * @param nearest relative inverse depth of the nearest pixel, 1.0f is nearest
+ * @param approachRate averaged change of [nearest] per frame, positive while it gets closer
+ */
+class TrackedObstacle(
+	val id: Int,
+	val centerX: Float,
+	val centerY: Float,
+	val width: Float,
+	val height: Float,
+	val nearest: Float,
+	val approachRate: Float
+)
+
+/**
+ * Tracked obstacle that approaches the camera
+ * @param timeToCollision in seconds, estimated from the growth of its size and inverse depth
+ */
+class CollisionThreat(
+	val id: Int,
+	val timeToCollision: Float,
+	val centerX: Float,
+	val nearest: Float
+)
+
+/** Obstacles of the latest depth output, tracked across frames in native code */
+class TrackedObstacles(private val maxObstacles: Int = 16) {
+	private val obstacleValues = FloatArray(maxObstacles * FLOATS_PER_OBSTACLE)
+	private val threatValues = FloatArray(FLOATS_PER_THREAT)
+
+	/** has to be called again when the depth size changes, restarts the tracking */
+	fun configure(
+		depthWidth: Int,
+		depthHeight: Int,
+		nearThreshold: Float = DEFAULT_NEAR_THRESHOLD
+	): Boolean = NativeLib.configureObstacleTracking(depthWidth, depthHeight, nearThreshold)
+
+	fun latest(): List<TrackedObstacle> {
+		val obstacleCount = NativeLib.getTrackedObstacles(obstacleValues)
+		return List(obstacleCount) { i ->
+			val offset = i * FLOATS_PER_OBSTACLE
+			TrackedObstacle(
+				obstacleValues[offset].toInt(),
+				obstacleValues[offset + 1],
+				obstacleValues[offset + 2],
+				obstacleValues[offset + 3],
+				obstacleValues[offset + 4],
+				obstacleValues[offset + 5],
+				obstacleValues[offset + 6]
+			)
+		}
+	}
+
+	/** @return the obstacle with the shortest time to collision, null if none approaches */
+	fun mostUrgentCollision(): CollisionThreat? {
+		if (!NativeLib.getMostUrgentCollision(threatValues)) {
+			return null
+		}
+		return CollisionThreat(
+			threatValues[0].toInt(),
+			threatValues[1],
+			threatValues[2],
+			threatValues[3]
+		)
+	}
+
+	companion object {
+		const val DEFAULT_NEAR_THRESHOLD = 0.6f
+		private const val FLOATS_PER_OBSTACLE = 7
+		private const val FLOATS_PER_THREAT = 4
+	}
+}
+
+/** @return the tracked obstacle approaching the fastest, null if none gets closer */
+fun List<TrackedObstacle>.fastestApproaching(): TrackedObstacle? =
+	filter { it.approachRate > 0.0f }.maxByOrNull { it.approachRate }
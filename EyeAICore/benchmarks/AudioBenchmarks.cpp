@@ -0,0 +1,37 @@
+#include "BenchmarkUtils.hpp"
+#include "EyeAICore/audio/SpatialAudio.hpp"
+#include <cmath>
+#include <vector>
+
+/// block size of a low latency android audio callback
+constexpr int AUDIO_BLOCK_FRAMES = 128;
+
+static void BM_SpatialAudioRender(benchmark::State& state) {
+	const auto voices = static_cast<int>(state.range(0));
+
+	SpatialAudioConfig config;
+	config.voices = voices;
+	config.max_block_frames = AUDIO_BLOCK_FRAMES;
+	auto synth = SpatialAudioSynth::create(config);
+	if (!synth) {
+		state.SkipWithError(synth.error().to_string().c_str());
+		return;
+	}
+	std::vector<AudioCue> cues;
+	for (int i = 0; i < voices; i++) {
+		const auto offset = static_cast<float>(i);
+		cues.push_back(AudioCue(
+			static_cast<uint32_t>(i + 1), 80.0f * std::sin(offset),
+			0.5f + 0.4f * std::cos(offset), 0.5f
+		));
+	}
+	synth->set_cues(cues);
+	std::vector<float> samples(static_cast<size_t>(AUDIO_BLOCK_FRAMES) * 2);
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(synth->render(samples));
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * AUDIO_BLOCK_FRAMES);
+}
+BENCHMARK(BM_SpatialAudioRender)->ArgName("voices")->Arg(1)->Arg(4)->Arg(8);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "EyeAICore/utils/Profiling.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+/// image side lengths of the benchmarks, square images from 256² to 1024²
+inline void add_image_sizes(benchmark::internal::Benchmark* benchmark) {
+	benchmark->ArgName("side")->RangeMultiplier(2)->Range(256, 1024);
+}
+
+[[nodiscard]] inline int64_t image_pixels(const benchmark::State& state) {
+	return state.range(0) * state.range(0);
+}
+
+/// reports pixels/s and bytes/s, bytes_per_pixel should count every byte that
+/// is read or written once per pixel
+inline void
+set_image_throughput(benchmark::State& state, int64_t bytes_per_pixel) {
+	const int64_t pixels =
+		static_cast<int64_t>(state.iterations()) * image_pixels(state);
+	state.counters["pixels/s"] =
+		benchmark::Counter(static_cast<double>(pixels), benchmark::Counter::kIsRate);
+	state.SetBytesProcessed(pixels * bytes_per_pixel);
+}
+
+/// deterministic uniformly distributed values in [min, max]
+[[nodiscard]] inline std::vector<float>
+random_floats(size_t count, float min, float max) {
+	std::mt19937 random_engine(42);
+	std::uniform_real_distribution<float> distribution(min, max);
+	std::vector<float> values(count);
+	for (float& value : values)
+		value = distribution(random_engine);
+	return values;
+}
+
+/// every profiled function leaves a record in the depth profiling frame, they
+/// have to be cleared regularly (like the app does every frame) so the queue
+/// does not grow for the whole benchmark
+inline void clear_profiling_records() {
+	(void)get_depth_profiling_frame().finish();
+}
@@ -0,0 +1,455 @@
+#include "BenchmarkUtils.hpp"
+#include "EyeAICore/depth/DepthCascade.hpp"
+#include "EyeAICore/depth/DepthPropagation.hpp"
+#include "EyeAICore/depth/DepthRegionIndex.hpp"
+#include "EyeAICore/depth/DropOffDetector.hpp"
+#include "EyeAICore/depth/FoveatedDepth.hpp"
+#include "EyeAICore/depth/GroundPlane.hpp"
+#include "EyeAICore/depth/GuidedUpsampling.hpp"
+#include "EyeAICore/depth/ObstacleBlobs.hpp"
+#include "EyeAICore/depth/ObstacleSectors.hpp"
+#include "EyeAICore/depth/OccupancyGrid.hpp"
+#include "EyeAICore/depth/PointCloud.hpp"
+#include "EyeAICore/depth/TimeToCollision.hpp"
+#include "EyeAICore/utils/ImageUtils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+static void BM_ObstacleSectorSummarize(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	const auto depth =
+		random_floats(static_cast<size_t>(image_pixels(state)), 0.0f, 1.0f);
+
+	SectorLayoutConfig config;
+	config.layout =
+		state.range(1) == 0 ? SectorLayout::Grid : SectorLayout::Polar;
+	config.roll_degrees = 15.0f;
+	const auto summarizer =
+		ObstacleSectorSummarizer::create(config, side, side);
+	if (!summarizer) {
+		state.SkipWithError(summarizer.error().to_string().c_str());
+		return;
+	}
+	std::vector<ObstacleSector> sectors(summarizer->get_sector_count());
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(summarizer->summarize(depth, sectors));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	// 1 float read per pixel
+	set_image_throughput(state, sizeof(float));
+}
+BENCHMARK(BM_ObstacleSectorSummarize)
+	->ArgNames({"side", "polar"})
+	->ArgsProduct({{256, 512, 1024}, {0, 1}});
+
+static void BM_DepthRegionIndexUpdate(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	const auto depth =
+		random_floats(static_cast<size_t>(image_pixels(state)), 0.0f, 1.0f);
+	DepthRegionIndex index(side, side);
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(index.update(depth));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	// 1 float read, summed-area table and pyramid written per pixel
+	set_image_throughput(state, 3 * sizeof(float));
+}
+BENCHMARK(BM_DepthRegionIndexUpdate)->Apply(add_image_sizes);
+
+/// mean and max of 1000 random regions with up to a quarter of the side length
+static void BM_DepthRegionIndexQueries(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	const auto depth =
+		random_floats(static_cast<size_t>(image_pixels(state)), 0.0f, 1.0f);
+	DepthRegionIndex index(side, side);
+	if (const auto error = index.update(depth)) {
+		state.SkipWithError(error->to_string().c_str());
+		return;
+	}
+	clear_profiling_records();
+
+	std::mt19937 random_engine(42);
+	std::uniform_int_distribution<int> position(0, side - 1);
+	std::uniform_int_distribution<int> size(1, side / 4);
+	std::vector<DepthRegion> regions(1000);
+	for (auto& region : regions) {
+		region = DepthRegion(
+			position(random_engine), position(random_engine),
+			size(random_engine), size(random_engine)
+		);
+	}
+
+	for (auto _ : state) {
+		for (const auto& region : regions) {
+			benchmark::DoNotOptimize(index.mean(region));
+			benchmark::DoNotOptimize(index.max(region));
+		}
+	}
+	state.SetItemsProcessed(
+		static_cast<int64_t>(state.iterations()) *
+		static_cast<int64_t>(regions.size())
+	);
+}
+BENCHMARK(BM_DepthRegionIndexQueries)->Apply(add_image_sizes);
+
+static void BM_DepthPropagate(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const auto depth = random_floats(pixels, 0.0f, 1.0f);
+	auto rgb = random_floats(pixels * 3, 0.0f, 255.0f);
+	std::vector<float> out_depth(pixels);
+
+	DepthPropagationConfig config;
+	config.max_propagated_frames = std::numeric_limits<int>::max();
+	config.max_mean_motion = std::numeric_limits<float>::max();
+	config.max_match_error = std::numeric_limits<float>::max();
+	auto propagator = DepthPropagator::create(config, side, side, side, side);
+	if (!propagator) {
+		state.SkipWithError(propagator.error().to_string().c_str());
+		return;
+	}
+	(void)propagator->begin_frame(rgb);
+	(void)propagator->set_keyframe(depth);
+	// shifts the frame by a few pixels, so the blocks actually move
+	std::rotate(rgb.begin(), rgb.begin() + 3 * 5, rgb.end());
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(propagator->begin_frame(rgb));
+		benchmark::DoNotOptimize(propagator->propagate(out_depth));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	// 3 rgb floats read, 1 keyframe depth float read and 1 written per pixel
+	set_image_throughput(state, 5 * sizeof(float));
+}
+BENCHMARK(BM_DepthPropagate)->Apply(add_image_sizes);
+
+static void BM_FoveatedBlend(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	// horizontal gradients, so the center depth has a usable fit
+	std::vector<float> depth(pixels);
+	std::vector<float> center_depth(pixels);
+	for (size_t i = 0; i < pixels; i++) {
+		const auto x = static_cast<float>(i % static_cast<size_t>(side));
+		depth[i] = x / static_cast<float>(side);
+		center_depth[i] = 0.5f * depth[i] + 0.2f;
+	}
+
+	auto blender =
+		FoveatedDepthBlender::create(FoveationConfig(), side, side, side, side);
+	if (!blender) {
+		state.SkipWithError(blender.error().to_string().c_str());
+		return;
+	}
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(blender->blend(depth, center_depth));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	// 1 center depth float read and resampled, 1 depth float read and written
+	set_image_throughput(state, 3 * sizeof(float));
+}
+BENCHMARK(BM_FoveatedBlend)->Apply(add_image_sizes);
+
+static void BM_DepthCascadeFuse(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const auto fast = random_floats(pixels, 0.0f, 1.0f);
+	std::vector<float> refined_output(pixels);
+	for (size_t i = 0; i < pixels; i++)
+		refined_output[i] = 3.0f * fast[i] + 2.0f;
+	std::vector<float> depth(pixels);
+
+	auto cascade = DepthCascade::create(DepthCascadeConfig());
+	if (!cascade) {
+		state.SkipWithError(cascade.error().to_string().c_str());
+		return;
+	}
+	const auto first_reason = (*cascade)->begin_frame(std::nullopt);
+	(*cascade)->set_refined(refined_output, *first_reason);
+	depth = fast;
+	(void)(*cascade)->fuse(depth);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		depth = fast;
+		(*cascade)->set_refined(refined_output, CascadeRefineReason::Scheduled);
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize((*cascade)->fuse(depth));
+		benchmark::ClobberMemory();
+	}
+	// refined frames (fast frames stay unchanged): aligned like
+	// ScaleShiftAlignOperator and copied into the depth
+	set_image_throughput(state, 5 * sizeof(float));
+}
+BENCHMARK(BM_DepthCascadeFuse)->Apply(add_image_sizes);
+
+static void BM_GuidedUpsample(benchmark::State& state) {
+	constexpr int DEPTH_SIDE = 256;
+	const auto guide_width = static_cast<int>(state.range(0));
+	const auto guide_height = static_cast<int>(state.range(1));
+	const auto threads = static_cast<int>(state.range(2));
+	const auto guide_pixels = static_cast<size_t>(guide_width) * guide_height;
+	const auto depth = random_floats(
+		static_cast<size_t>(DEPTH_SIDE) * DEPTH_SIDE, 0.0f, 1.0f
+	);
+	const auto guide_values = random_floats(guide_pixels, 0.0f, 255.0f);
+	std::vector<int> guide(guide_pixels);
+	for (size_t i = 0; i < guide_pixels; i++) {
+		const auto value = static_cast<uint8_t>(guide_values[i]);
+		guide[i] = color_rgb(value, value, value);
+	}
+	std::vector<float> out_depth(guide_pixels);
+
+	auto upsampler = GuidedDepthUpsampler::create(
+		GuidedUpsamplingConfig(), DEPTH_SIDE, DEPTH_SIDE, guide_width,
+		guide_height, threads
+	);
+	if (!upsampler) {
+		state.SkipWithError(upsampler.error().to_string().c_str());
+		return;
+	}
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(upsampler->upsample(depth, guide, out_depth));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	// pixels of the guide resolution
+	const auto pixels = static_cast<double>(state.iterations()) *
+						static_cast<double>(guide_pixels);
+	state.counters["pixels/s"] =
+		benchmark::Counter(pixels, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_GuidedUpsample)
+	->ArgNames({"width", "height", "threads"})
+	->Args({1280, 720, 1})
+	->Args({1280, 720, 4})
+	->Args({1920, 1080, 1})
+	->Args({1920, 1080, 4})
+	->UseRealTime();
+
+static void BM_OccupancyGridUpdate(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	const auto depth =
+		random_floats(static_cast<size_t>(image_pixels(state)), 0.0f, 1.0f);
+
+	BackProjectionConfig projection_config;
+	projection_config.pitch_degrees = -15.0f;
+	const auto projector =
+		DepthBackProjector::create(projection_config, side, side);
+	if (!projector) {
+		state.SkipWithError(projector.error().to_string().c_str());
+		return;
+	}
+	auto grid = OccupancyGrid::create(OccupancyGridConfig());
+	if (!grid) {
+		state.SkipWithError(grid.error().to_string().c_str());
+		return;
+	}
+	PointCloud points;
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(projector->project(depth, points));
+		grid->integrate(points);
+		benchmark::DoNotOptimize(grid->get_occupied_cells().data());
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	set_image_throughput(state, sizeof(float));
+}
+BENCHMARK(BM_OccupancyGridUpdate)->Apply(add_image_sizes);
+
+static void BM_GroundPlaneEstimate(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	const auto threads = static_cast<int>(state.range(1));
+	const bool seeded = state.range(2) != 0;
+
+	// level floor 1.3m below a camera pitched down by 20 degrees, with noise
+	// and a sky of far points in the upper rows
+	const auto noise = random_floats(
+		static_cast<size_t>(image_pixels(state)), -0.02f, 0.02f
+	);
+	const float degrees = std::numbers::pi_v<float> / 180.0f;
+	const float pitch = -20.0f * degrees;
+	const float focal =
+		static_cast<float>(side) / 2.0f / std::tan(65.0f / 2.0f * degrees);
+	PointCloud points;
+	points.resize(noise.size());
+	for (int y = 0; y < side; y++) {
+		for (int x = 0; x < side; x++) {
+			const float u = (static_cast<float>(x - side / 2) + 0.5f) / focal;
+			const float v = (static_cast<float>(side / 2 - y) - 0.5f) / focal;
+			const float ray_x = u;
+			const float ray_y = std::sin(pitch) + v * std::cos(pitch);
+			const float ray_z = std::cos(pitch) - v * std::sin(pitch);
+			const auto i = static_cast<size_t>(y) * side + x;
+			const float distance =
+				(ray_y < -0.01f ? -1.3f / ray_y : 20.0f) * (1.0f + noise[i]);
+			points.x[i] = distance * ray_x;
+			points.y[i] = distance * ray_y;
+			points.z[i] = distance * ray_z;
+		}
+	}
+
+	auto estimator =
+		GroundPlaneEstimator::create(GroundPlaneConfig(), side, side);
+	if (!estimator) {
+		state.SkipWithError(estimator.error().to_string().c_str());
+		return;
+	}
+	benchmark::DoNotOptimize(estimator->estimate(points, threads));
+
+	for (auto _ : state) {
+		if (!seeded) {
+			state.PauseTiming();
+			estimator->reset();
+			state.ResumeTiming();
+		}
+		benchmark::DoNotOptimize(estimator->estimate(points, threads));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+}
+BENCHMARK(BM_GroundPlaneEstimate)
+	->ArgNames({"side", "threads", "seeded"})
+	->Args({256, 1, 0})
+	->Args({256, 4, 0})
+	->Args({256, 1, 1})
+	->UseRealTime();
+
+static void BM_DropOffDetect(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	// floor like ramp, nearer towards the bottom, with noise
+	auto depth =
+		random_floats(static_cast<size_t>(image_pixels(state)), 0.0f, 0.01f);
+	for (int y = 0; y < side; y++) {
+		for (int x = 0; x < side; x++) {
+			depth[static_cast<size_t>(y) * side + x] +=
+				static_cast<float>(y) / static_cast<float>(side);
+		}
+	}
+
+	auto detector = DropOffDetector::create(DropOffConfig(), side, side);
+	if (!detector) {
+		state.SkipWithError(detector.error().to_string().c_str());
+		return;
+	}
+	// built once per frame and shared with other consumers, not measured
+	DepthRegionIndex region_index(side, side);
+	if (const auto error = region_index.update(depth)) {
+		state.SkipWithError(error->to_string().c_str());
+		return;
+	}
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(detector->detect(depth, region_index));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	set_image_throughput(state, sizeof(float));
+}
+BENCHMARK(BM_DropOffDetect)->Apply(add_image_sizes);
+
+static void BM_ObstacleBlobExtract(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	// noisy background with a few near blocks, so there are many short runs
+	// and some large blobs
+	auto depth =
+		random_floats(static_cast<size_t>(image_pixels(state)), 0.0f, 0.7f);
+	for (int block = 0; block < 4; block++) {
+		const int begin = side * block / 4 + side / 32;
+		const int end = begin + side / 6;
+		for (int y = side / 3; y < side * 2 / 3; y++) {
+			for (int x = begin; x < end; x++)
+				depth[static_cast<size_t>(y) * side + x] = 0.8f;
+		}
+	}
+
+	auto extractor =
+		ObstacleBlobExtractor::create(ObstacleBlobConfig(), side, side);
+	if (!extractor) {
+		state.SkipWithError(extractor.error().to_string().c_str());
+		return;
+	}
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(extractor->extract(depth));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	set_image_throughput(state, sizeof(float));
+}
+BENCHMARK(BM_ObstacleBlobExtract)->Apply(add_image_sizes);
+
+static void BM_TimeToCollisionUpdate(benchmark::State& state) {
+	const auto track_count = static_cast<int>(state.range(0));
+
+	TimeToCollisionConfig config;
+	config.max_tracks = track_count;
+	auto estimator = TimeToCollisionEstimator::create(config);
+	if (!estimator) {
+		state.SkipWithError(estimator.error().to_string().c_str());
+		return;
+	}
+	std::vector<TrackedObstacle> tracks(static_cast<size_t>(track_count));
+	for (int i = 0; i < track_count; i++)
+		tracks[static_cast<size_t>(i)].id = static_cast<uint32_t>(i + 1);
+
+	// approaching obstacles, one frame every 100ms
+	auto frame_time = frame_clock::time_point();
+	int frame = 0;
+	for (auto _ : state) {
+		state.PauseTiming();
+		const int step = frame % 500;
+		for (auto& track : tracks) {
+			track.blob.nearest = 0.2f + 0.001f * static_cast<float>(step);
+			track.blob.area = 100 + step;
+		}
+		frame_time += std::chrono::milliseconds(100);
+		frame++;
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		estimator->update(tracks, frame_time);
+		benchmark::DoNotOptimize(estimator->get_most_urgent());
+	}
+	state.SetItemsProcessed(state.iterations() * track_count);
+}
+BENCHMARK(BM_TimeToCollisionUpdate)->Arg(4)->Arg(16)->Arg(64);
@@ -0,0 +1,115 @@
+#include "BenchmarkUtils.hpp"
+#include "EyeAICore/Operators.hpp"
+#include "EyeAICore/utils/DepthColormap.hpp"
+
+#include <algorithm>
+
+static void BM_RgbNormalizeOperator(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const auto input = random_floats(pixels * 3, 0.0f, 255.0f);
+	std::vector<float> values(input.size());
+	const RgbNormalizeOperator rgb_normalize;
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		std::ranges::copy(input, values.begin());
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(rgb_normalize.execute(values));
+		benchmark::ClobberMemory();
+	}
+	// 3 floats read and written per pixel
+	set_image_throughput(state, 2 * 3 * sizeof(float));
+}
+BENCHMARK(BM_RgbNormalizeOperator)->Apply(add_image_sizes);
+
+static void BM_MinMaxOperator(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const auto input = random_floats(pixels, 0.0f, 100.0f);
+	std::vector<float> values(input.size());
+	const MinMaxOperator min_max;
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		std::ranges::copy(input, values.begin());
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(min_max.execute(values));
+		benchmark::ClobberMemory();
+	}
+	// 1 float read and written per pixel
+	set_image_throughput(state, 2 * sizeof(float));
+}
+BENCHMARK(BM_MinMaxOperator)->Apply(add_image_sizes);
+
+static void BM_DepthColormap(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const auto depth_values = random_floats(pixels, 0.0f, 1.0f);
+	std::vector<int> colormapped_pixels(pixels);
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(
+			depth_colormap(depth_values, colormapped_pixels)
+		);
+		benchmark::ClobberMemory();
+	}
+	// 1 float read and 1 int written per pixel
+	set_image_throughput(state, sizeof(float) + sizeof(int));
+}
+BENCHMARK(BM_DepthColormap)->Apply(add_image_sizes);
+
+static void BM_TemporalFilterOperator(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const auto input = random_floats(pixels, 0.0f, 1.0f);
+	std::vector<float> values(input.size());
+	const TemporalFilterOperator temporal_filter;
+	std::vector<float> filter_state(temporal_filter.get_state_size(pixels));
+	// initializes the history, so every iteration filters
+	values = input;
+	(void)temporal_filter.execute_with_state(values, filter_state);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		std::ranges::copy(input, values.begin());
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(
+			temporal_filter.execute_with_state(values, filter_state)
+		);
+		benchmark::ClobberMemory();
+	}
+	// 1 float read and written per pixel for the values and the history
+	set_image_throughput(state, 4 * sizeof(float));
+}
+BENCHMARK(BM_TemporalFilterOperator)->Apply(add_image_sizes);
+
+static void BM_ScaleShiftAlignOperator(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const auto previous = random_floats(pixels, 0.0f, 1.0f);
+	std::vector<float> input(pixels);
+	for (size_t i = 0; i < pixels; i++)
+		input[i] = 2.0f * previous[i] + 0.5f;
+	std::vector<float> values(pixels);
+	const ScaleShiftAlignOperator align;
+	std::vector<float> align_state(align.get_state_size(pixels));
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		// starts every iteration from the same previous frame
+		values = previous;
+		(void)align.execute_with_state(values, align_state);
+		std::ranges::copy(input, values.begin());
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(align.execute_with_state(values, align_state));
+		benchmark::ClobberMemory();
+	}
+	// the values are read and written once, the previous frame read and
+	// written once, the subsampled fits are negligible
+	set_image_throughput(state, 4 * sizeof(float));
+}
+BENCHMARK(BM_ScaleShiftAlignOperator)->Apply(add_image_sizes);
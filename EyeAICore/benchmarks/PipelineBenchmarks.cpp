@@ -0,0 +1,115 @@
+#include "BenchmarkUtils.hpp"
+#include "EyeAICore/tflite/ModelPipeline.hpp"
+#include "EyeAICore/utils/PipelineWatchdog.hpp"
+#include "EyeAICore/utils/SceneChangeDetector.hpp"
+#include <format>
+
+static void BM_SceneChangeCheck(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	const auto rgb = random_floats(
+		static_cast<size_t>(image_pixels(state)) * 3, 0.0f, 255.0f
+	);
+	auto detector = SceneChangeDetector::create({}, side, side);
+	if (!detector) {
+		state.SkipWithError(detector.error().to_string().c_str());
+		return;
+	}
+	// the reference thumbnail is set, so every check compares
+	(void)detector->check(rgb, frame_clock::now());
+	detector->mark_inferred();
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(detector->check(rgb, frame_clock::now()));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	// 3 floats read per pixel
+	set_image_throughput(state, 3 * sizeof(float));
+}
+BENCHMARK(BM_SceneChangeCheck)->Apply(add_image_sizes);
+
+static void BM_PipelineWatchdogCheck(benchmark::State& state) {
+	PipelineWatchdogConfig config;
+	for (int64_t i = 0; i < state.range(0); i++)
+		config.stages.emplace_back(std::format("stage {}", i));
+	auto watchdog = PipelineWatchdog::create(std::move(config));
+	if (!watchdog) {
+		state.SkipWithError(watchdog.error().to_string().c_str());
+		return;
+	}
+	// every stage busy, so all of them are compared against their deadline
+	for (size_t i = 0; i < (*watchdog)->get_config().stages.size(); i++)
+		(*watchdog)->begin_stage(i);
+	(*watchdog)->frame_submitted();
+
+	for (auto _ : state)
+		benchmark::DoNotOptimize((*watchdog)->check());
+}
+BENCHMARK(BM_PipelineWatchdogCheck)->ArgName("stages")->Arg(2)->Arg(8);
+
+static void BM_PipelineWatchdogHeartbeat(benchmark::State& state) {
+	PipelineWatchdogConfig config;
+	config.stages.emplace_back("stage");
+	auto watchdog = PipelineWatchdog::create(std::move(config));
+	if (!watchdog) {
+		state.SkipWithError(watchdog.error().to_string().c_str());
+		return;
+	}
+
+	// what a stage adds to every frame
+	for (auto _ : state) {
+		const PipelineStageScope scope(watchdog->get(), 0);
+		benchmark::ClobberMemory();
+	}
+}
+BENCHMARK(BM_PipelineWatchdogHeartbeat);
+
+static void BM_PreprocessCache(benchmark::State& state) {
+	const auto side = static_cast<int>(state.range(0));
+	const auto models = state.range(1);
+	const bool same_input = state.range(2) != 0;
+	constexpr int frame_width = 640;
+	constexpr int frame_height = 480;
+	const auto frame_values = random_floats(
+		static_cast<size_t>(frame_width) * frame_height * 3, 0.0f, 255.0f
+	);
+	const std::vector<uint8_t> rgb(frame_values.begin(), frame_values.end());
+
+	// the normalization of the depth models, the others differ in layout
+	std::vector<PreprocessParams> params(static_cast<size_t>(models));
+	for (size_t i = 0; i < params.size(); i++) {
+		params[i].width = side;
+		params[i].height = side;
+		params[i].mean = {123.675f, 116.28f, 103.53f};
+		params[i].stddev = {58.395f, 57.12f, 57.375f};
+		if (!same_input && i % 2 == 1)
+			params[i].layout = TensorLayout::Chw;
+	}
+	PreprocessCache cache;
+
+	// what every model adds to the preprocessing of a frame
+	for (auto _ : state) {
+		cache.begin_frame(rgb, frame_width, frame_height);
+		for (const auto& model_params : params)
+			benchmark::DoNotOptimize(cache.get(model_params));
+		benchmark::ClobberMemory();
+
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+	}
+	// 3 floats written per pixel of the model input and model
+	state.SetBytesProcessed(
+		static_cast<int64_t>(state.iterations()) * image_pixels(state) * 3 *
+		static_cast<int64_t>(sizeof(float)) * models
+	);
+}
+BENCHMARK(BM_PreprocessCache)
+	->ArgNames({"side", "models", "same_input"})
+	->Args({256, 1, 1})
+	->Args({256, 2, 1})
+	->Args({256, 2, 0})
+	->Args({256, 4, 0});
@@ -0,0 +1,59 @@
+#include "BenchmarkUtils.hpp"
+
+/// the app clears the profiling frame after every inference (a few dozen
+/// scopes), clearing that often here would mostly measure the timer pauses
+constexpr int64_t SCOPES_PER_CLEAR = 4096;
+
+static void BM_ProfileScope(benchmark::State& state) {
+	int64_t scopes = 0;
+	for (auto _ : state) {
+		{
+			PROFILE_DEPTH_SCOPE("BM_ProfileScope")
+		}
+		if (++scopes % SCOPES_PER_CLEAR == 0) {
+			state.PauseTiming();
+			clear_profiling_records();
+			state.ResumeTiming();
+		}
+	}
+	clear_profiling_records();
+}
+BENCHMARK(BM_ProfileScope);
+
+static void BM_NestedProfileScopes(benchmark::State& state) {
+	int64_t scopes = 0;
+	for (auto _ : state) {
+		{
+			PROFILE_DEPTH_SCOPE("outer")
+			{
+				PROFILE_DEPTH_SCOPE("inner")
+			}
+		}
+		scopes += 2;
+		if (scopes % SCOPES_PER_CLEAR == 0) {
+			state.PauseTiming();
+			clear_profiling_records();
+			state.ResumeTiming();
+		}
+	}
+	clear_profiling_records();
+}
+BENCHMARK(BM_NestedProfileScopes);
+
+/// cost of formatting a frame like the app does once per inference
+static void BM_ProfilingFrameFinish(benchmark::State& state) {
+	const auto scopes_per_frame = state.range(0);
+	for (auto _ : state) {
+		state.PauseTiming();
+		for (int64_t i = 0; i < scopes_per_frame; i++) {
+			PROFILE_DEPTH_SCOPE("scope")
+		}
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(get_depth_profiling_frame().finish());
+	}
+	state.SetItemsProcessed(
+		static_cast<int64_t>(state.iterations()) * scopes_per_frame
+	);
+}
+BENCHMARK(BM_ProfilingFrameFinish)->ArgName("scopes")->Arg(16)->Arg(64);
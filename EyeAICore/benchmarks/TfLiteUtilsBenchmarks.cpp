@@ -0,0 +1,143 @@
+#include "BenchmarkUtils.hpp"
+#include "EyeAICore/tflite/TfLiteUtils.hpp"
+
+#include <memory>
+
+/// standalone tensor that owns its data, stands in for the input/output
+/// tensors of an interpreter
+class BenchmarkTensor {
+  public:
+	BenchmarkTensor(size_t elements, bool quantized)
+		: data(elements * (quantized ? sizeof(uint8_t) : sizeof(float))) {
+		tensor.type = quantized ? kTfLiteUInt8 : kTfLiteFloat32;
+		tensor.data.raw = data.data();
+		tensor.bytes = data.size();
+		tensor.quantization.type = kTfLiteNoQuantization;
+
+		if (quantized) {
+			// same as the uint8 midas model: [0, 255] input, scale of 1
+			quantization.scale = TfLiteFloatArrayCreate(1);
+			quantization.scale->data[0] = 1.0f;
+			quantization.zero_point = TfLiteIntArrayCreate(1);
+			quantization.zero_point->data[0] = 0;
+			tensor.quantization.type = kTfLiteAffineQuantization;
+			tensor.quantization.params = &quantization;
+		}
+	}
+	BenchmarkTensor(const BenchmarkTensor&) = delete;
+	BenchmarkTensor(BenchmarkTensor&&) = delete;
+	BenchmarkTensor& operator=(const BenchmarkTensor&) = delete;
+	BenchmarkTensor& operator=(BenchmarkTensor&&) = delete;
+	~BenchmarkTensor() {
+		if (quantization.scale != nullptr)
+			TfLiteFloatArrayFree(quantization.scale);
+		if (quantization.zero_point != nullptr)
+			TfLiteIntArrayFree(quantization.zero_point);
+	}
+
+	[[nodiscard]] TfLiteTensor* get() { return &tensor; }
+
+	[[nodiscard]] const TfLiteAffineQuantization& get_quantization() const {
+		return quantization;
+	}
+
+  private:
+	std::vector<char> data;
+	TfLiteAffineQuantization quantization{};
+	TfLiteTensor tensor{};
+};
+
+static void BM_QuantizeFloats(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const auto values = random_floats(pixels * 3, 0.0f, 255.0f);
+	std::vector<std::byte> quantized_values(values.size());
+	const BenchmarkTensor tensor(0, true);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(quantize_floats(
+			values, quantized_values, kTfLiteUInt8, tensor.get_quantization()
+		));
+		benchmark::ClobberMemory();
+	}
+	// 3 floats read and 3 bytes written per pixel
+	set_image_throughput(state, 3 * (sizeof(float) + sizeof(uint8_t)));
+}
+BENCHMARK(BM_QuantizeFloats)->Apply(add_image_sizes);
+
+static void BM_DequantizeToFloats(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	std::vector<std::byte> quantized_values(pixels);
+	for (size_t i = 0; i < quantized_values.size(); i++)
+		quantized_values[i] = static_cast<std::byte>(i * 7);
+	std::vector<float> values(pixels);
+	const BenchmarkTensor tensor(0, true);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(dequantize_to_floats(
+			quantized_values, values, kTfLiteUInt8, tensor.get_quantization()
+		));
+		benchmark::ClobberMemory();
+	}
+	// 1 byte read and 1 float written per pixel
+	set_image_throughput(state, sizeof(uint8_t) + sizeof(float));
+}
+BENCHMARK(BM_DequantizeToFloats)->Apply(add_image_sizes);
+
+/// range(1) selects a float32 (0) or uint8 quantized (1) input tensor
+static void BM_LoadInputTensorWithFloats(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const bool quantized = state.range(1) != 0;
+	const auto values = random_floats(pixels * 3, 0.0f, 255.0f);
+	BenchmarkTensor tensor(values.size(), quantized);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(
+			load_input_tensor_with_floats(tensor.get(), values)
+		);
+		benchmark::ClobberMemory();
+	}
+	set_image_throughput(
+		state,
+		3 * (sizeof(float) + (quantized ? sizeof(uint8_t) : sizeof(float)))
+	);
+}
+BENCHMARK(BM_LoadInputTensorWithFloats)
+	->ArgNames({"side", "quantized"})
+	->ArgsProduct({benchmark::CreateRange(256, 1024, 2), {0, 1}});
+
+/// range(1) selects a float32 (0) or uint8 quantized (1) output tensor
+static void BM_ReadFloatsFromOutputTensor(benchmark::State& state) {
+	const auto pixels = static_cast<size_t>(image_pixels(state));
+	const bool quantized = state.range(1) != 0;
+	BenchmarkTensor tensor(pixels, quantized);
+	std::vector<float> values(pixels);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		clear_profiling_records();
+		state.ResumeTiming();
+
+		benchmark::DoNotOptimize(
+			read_floats_from_output_tensor(tensor.get(), values)
+		);
+		benchmark::ClobberMemory();
+	}
+	set_image_throughput(
+		state, sizeof(float) + (quantized ? sizeof(uint8_t) : sizeof(float))
+	);
+}
+BENCHMARK(BM_ReadFloatsFromOutputTensor)
+	->ArgNames({"side", "quantized"})
+	->ArgsProduct({benchmark::CreateRange(256, 1024, 2), {0, 1}});
@@ -1,7 +1,25 @@
 #pragma once
 
+#include "EyeAICore/depth/DepthCascade.hpp"
+#include "EyeAICore/tflite/InferenceCancellation.hpp"
 #include "EyeAICore/tflite/TfLiteRuntime.hpp"
 
+/// the models of a cascade have to have the same input and output sizes
+struct [[nodiscard]] CascadeModelMismatchError {
+	size_t fast_input_size;
+	size_t fast_output_size;
+	size_t refined_input_size;
+	size_t refined_output_size;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+COMBINED_ERROR(
+	CreateCascadeDepthModelError,
+	TfLiteCreateRuntimeError,
+	CascadeModelMismatchError
+);
+
 class DepthModel {
   public:
 	[[nodiscard]] static tl::
@@ -14,12 +32,80 @@ class DepthModel {
 			TfLiteLogErrorCallback log_error_callback
 		);
 
+	/// cascade of a fast model that runs on every frame and a refined model
+	/// that runs on some frames, see DepthCascade, the input is normalized once
+	/// for both models
+	[[nodiscard]] static tl::
+		expected<std::unique_ptr<DepthModel>, CreateCascadeDepthModelError>
+		create_cascade(
+			std::vector<int8_t>&& fast_model_data,
+			std::vector<int8_t>&& refined_model_data,
+			std::string_view gpu_delegate_serialization_dir,
+			std::string_view fast_model_token,
+			std::string_view refined_model_token,
+			std::unique_ptr<DepthCascade>&& cascade,
+			TfLiteLogWarningCallback log_warning_callback,
+			TfLiteLogErrorCallback log_error_callback
+		);
+
 	DepthModel(std::unique_ptr<TfLiteRuntime>&& runtime)
 		: runtime(std::move(runtime)) {}
 
+	/// runtime has to have no input operators and fuse with cascade
+	DepthModel(
+		std::unique_ptr<TfLiteRuntime>&& runtime,
+		std::unique_ptr<TfLiteRuntime>&& refined_runtime,
+		std::unique_ptr<DepthCascade>&& cascade
+	)
+		: runtime(std::move(runtime)),
+		  refined_runtime(std::move(refined_runtime)),
+		  cascade(std::move(cascade)) {}
+
 	[[nodiscard]] std::optional<TfLiteRunInferenceError>
 	run(std::span<float> input, std::span<float> output);
 
+	/// trace should come from FrameLatencyTracker::begin_processing, its stage
+	/// timestamps are filled in while running (a refined cascade run counts as
+	/// preprocessing), every model invoke is reported to canceller (if not
+	/// nullptr) with the capture time of trace, so the refined run of a
+	/// cascade can be cancelled as well, it is not fused then
+	[[nodiscard]] std::optional<TfLiteRunInferenceError> run(
+		std::span<float> input,
+		std::span<float> output,
+		FrameTrace& trace,
+		StaleInferenceCanceller* canceller = nullptr
+	);
+
+	/// for crops of the frame (e.g. foveated inference), the output is only
+	/// normalized and the temporal state of the frame sequence is untouched
+	[[nodiscard]] std::optional<TfLiteRunInferenceError>
+	run_without_temporal_state(std::span<float> input, std::span<float> output);
+
+	/// the output is aligned to the previous one and temporally filtered, the
+	/// next run starts without history
+	void reset_temporal_state();
+
+	/// scale and shift alignment of the latest output to the one before,
+	/// nullopt before the first run
+	[[nodiscard]] std::optional<ScaleShiftFit> get_alignment_fit() const;
+
+	/// created with cancellation enabled like the refined model of a cascade,
+	/// the fast model of a cascade
+	[[nodiscard]] const TfLiteRuntime& get_runtime() const { return *runtime; }
+
+	/// nullptr if this is not a cascade
+	[[nodiscard]] const DepthCascade* get_cascade() const {
+		return cascade.get();
+	}
+
   private:
+	static constexpr size_t ALIGN_OPERATOR_INDEX = 0;
+
 	std::unique_ptr<TfLiteRuntime> runtime;
+	/// only set for a cascade, the input operators of runtime run in
+	/// cascade_input_operator instead
+	std::unique_ptr<TfLiteRuntime> refined_runtime;
+	std::unique_ptr<DepthCascade> cascade;
+	RgbNormalizeOperator cascade_input_operator;
+	std::vector<float> refined_output;
 };
\ No newline at end of file
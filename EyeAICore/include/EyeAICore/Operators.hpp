@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <format>
 #include <optional>
 #include <span>
@@ -30,13 +32,123 @@ class Operator {
 
 	[[nodiscard]] virtual std::optional<OperatorError>
 	execute(std::span<float> input) const = 0;
+
+	/// number of floats of state that has to be kept between runs for
+	/// value_count values, TfLiteRuntime allocates zeroed buffers of this size
+	/// once and passes them to execute_with_state
+	[[nodiscard]] virtual size_t get_state_size(size_t /*value_count*/) const {
+		return 0;
+	}
+
+	/// used by TfLiteRuntime, stateless operators simply execute
+	[[nodiscard]] virtual std::optional<OperatorError>
+	execute_with_state(std::span<float> values, std::span<float> /*state*/)
+		const {
+		return execute(values);
+	}
 };
 
 /// rescales values from [min, max] to [0, 1]
 class MinMaxOperator : public Operator {
   public:
+	/// weight of the current range in a moving average of min and max over
+	/// runs, 1 normalizes every run by its own range, values outside of a
+	/// smoothed range are clamped
+	float range_alpha = 1.0f;
+
+	[[nodiscard]] std::optional<OperatorError>
+	execute(std::span<float> values) const override;
+
+	/// one flag whether the range is initialized and the smoothed min and max
+	[[nodiscard]] size_t get_state_size(size_t /*value_count*/) const override {
+		return range_alpha < 1.0f ? 3 : 0;
+	}
+
+	[[nodiscard]] std::optional<OperatorError> execute_with_state(
+		std::span<float> values,
+		std::span<float> state
+	) const override;
+};
+
+/// result of the latest ScaleShiftAlignOperator run
+struct ScaleShiftFit {
+	float scale = 1.0f;
+	float shift = 0.0f;
+	/// rms residual of the inliers relative to the standard deviation of the
+	/// previous frame
+	float relative_residual = 0.0f;
+	/// fraction of the samples that were used for the final fit
+	float inlier_fraction = 0.0f;
+	/// the fit was rejected and the alignment restarted from this frame
+	bool reset = true;
+
+	[[nodiscard]] std::string formatted() const {
+		if (reset)
+			return "Depth alignment: reset";
+		return std::format(
+			"Depth alignment: scale {:.3f}, shift {:.3f}, residual {:.1f}%, "
+			"inliers {:.0f}%",
+			scale, shift, relative_residual * 100.0f, inlier_fraction * 100.0f
+		);
+	}
+};
+
+/// aligns relative depth (e.g. the raw output of MiDaS, which has an
+/// arbitrary scale and shift per frame) to the previous aligned frame by a
+/// subsampled least squares fit of scale and shift, outliers (moving objects,
+/// new parts of the scene) are excluded by trimmed fits starting from a
+/// robust quantile based estimate, has to run before the normalization
+class ScaleShiftAlignOperator : public Operator {
+  public:
+	/// every sample_stride values 4 consecutive values are sampled
+	size_t sample_stride = 16;
+	/// samples with a residual above this multiple of the mean absolute
+	/// residual of the previous fit are excluded from the next one
+	float outlier_factor = 2.5f;
+	/// fits worse than this (see ScaleShiftFit::relative_residual) restart the
+	/// alignment instead of being applied
+	float max_relative_residual = 0.5f;
+
+	/// without state there is no previous frame, the values stay unchanged
 	[[nodiscard]] std::optional<OperatorError>
 	execute(std::span<float> values) const override;
+
+	/// fit of the latest run, the previous aligned frame and scratch space
+	/// for the robust initial fit
+	[[nodiscard]] size_t get_state_size(size_t value_count) const override {
+		const size_t initial_fit_spacing =
+			std::max<size_t>(sample_stride, 4) * INITIAL_FIT_BLOCK_SPACING;
+		const size_t initial_fit_samples =
+			(value_count + initial_fit_spacing - 1) / initial_fit_spacing;
+		return FIT_STATE_SIZE + value_count + 2 * initial_fit_samples;
+	}
+
+	[[nodiscard]] std::optional<OperatorError> execute_with_state(
+		std::span<float> values,
+		std::span<float> state
+	) const override;
+
+	/// aligns values to reference instead of the previous frame, e.g. the
+	/// output of another model for the same frame, state is a scratch state of
+	/// get_state_size() that is overwritten, the fit is stored in it, values
+	/// stay unchanged if it was rejected (ScaleShiftFit::reset)
+	[[nodiscard]] std::optional<OperatorError> align_to(
+		std::span<float> values,
+		std::span<const float> reference,
+		std::span<float> state
+	) const;
+
+	/// fit stored in the state of the latest execute_with_state run, nullopt
+	/// if it did not run yet
+	[[nodiscard]] static std::optional<ScaleShiftFit>
+	get_fit(std::span<const float> state);
+
+  private:
+	static constexpr size_t FIT_STATE_SIZE = 8;
+	/// refits that exclude the outliers of the previous fit
+	static constexpr int TRIM_ROUNDS = 3;
+	/// the robust initial fit uses a single value of every n-th sample block
+	static constexpr size_t INITIAL_FIT_BLOCK_SPACING = 4;
 };
 
 /// normalizes rgb input values (3 floats for r, g and b) based on their mean
@@ -48,4 +160,32 @@ class RgbNormalizeOperator : public Operator {
 
 	[[nodiscard]] std::optional<OperatorError>
 	execute(std::span<float> values) const override;
-};
\ No newline at end of file
+};
+
+/// per-value exponential moving average over consecutive runs (e.g. depth
+/// frames), values that change faster get a higher weight (one euro filter
+/// style) and large jumps (edges, moving objects) reset the value, so the
+/// output is stable without lagging behind real changes
+class TemporalFilterOperator : public Operator {
+  public:
+	/// weight of the new value if it did not change
+	float min_alpha = 0.2f;
+	/// increase of the weight per unit of change
+	float alpha_per_change = 4.0f;
+	/// changes at least this large take the new value as it is
+	float reset_threshold = 0.3f;
+
+	/// without state there is no history, the values stay unchanged
+	[[nodiscard]] std::optional<OperatorError>
+	execute(std::span<float> values) const override;
+
+	/// one flag whether the history is initialized and the filtered values
+	[[nodiscard]] size_t get_state_size(size_t value_count) const override {
+		return value_count + 1;
+	}
+
+	[[nodiscard]] std::optional<OperatorError> execute_with_state(
+		std::span<float> values,
+		std::span<float> state
+	) const override;
+};
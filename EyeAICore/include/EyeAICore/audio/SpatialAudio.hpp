@@ -0,0 +1,159 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/TripleBuffer.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct SpatialAudioConfig {
+	int sample_rate = 48000;
+	/// largest block render() is called with, in stereo frames
+	int max_block_frames = 512;
+	/// cues beyond this are not played, at most MAX_SPATIAL_AUDIO_VOICES
+	int voices = 8;
+	/// samples per wavetable period, has to be a power of 2
+	int wavetable_size = 1024;
+	/// tone of the farthest and the nearest cue, the pitch rises
+	/// exponentially with the nearness
+	float min_frequency = 220.0f;
+	float max_frequency = 880.0f;
+	/// pulses per second of the farthest and the nearest cue
+	float min_pulse_rate = 1.5f;
+	float max_pulse_rate = 8.0f;
+	/// time difference between the ears for a cue fully to one side, about
+	/// the size of a human head
+	float max_interaural_delay_seconds = 0.00066f;
+	/// parameter changes are smoothed over about this time, so the sound
+	/// does not click when the obstacles move
+	float smoothing_seconds = 0.03f;
+	float master_gain = 0.5f;
+};
+
+struct [[nodiscard]] InvalidSpatialAudioConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+struct [[nodiscard]] InvalidAudioBlock {
+	size_t max_frames;
+	size_t sample_count;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+/// sound of one obstacle
+struct AudioCue {
+	/// keeps the same voice while the cue moves (e.g. the tracked obstacle
+	/// id), cues with id 0 are ignored
+	uint32_t id = 0;
+	/// direction, positive to the right, panned fully to one side at 90
+	float azimuth_degrees = 0.0f;
+	/// relative inverse depth in [0, 1], 1 is nearest
+	float nearness = 0.0f;
+	/// loudness in [0, 1]
+	float gain = 1.0f;
+};
+
+constexpr int MAX_SPATIAL_AUDIO_VOICES = 16;
+
+/// all cues of one update, handed to the audio thread as a whole
+struct AudioCueSet {
+	std::array<AudioCue, MAX_SPATIAL_AUDIO_VOICES> cues{};
+	int count = 0;
+};
+
+/**
+ * Turns obstacle cues into stereo sound: every cue is a pulsing tone whose
+ * pitch and pulse rate rise with its nearness. It is placed with constant
+ * power panning and the interaural time difference, the ear facing away
+ * hears the wave and the pulse slightly later.
+ *
+ * Oscillators are 32 bit fixed point phases into precomputed wavetables, so
+ * the time difference is a phase offset instead of a delay line. The voices
+ * are looked up per sample into a scratch block, their gain ramps and the
+ * stereo mix use Float4.
+ *
+ * set_cues() is called by the vision thread and render() by the audio
+ * callback, the cues are passed through a TripleBuffer. render() does not
+ * allocate, lock or wait, all memory is allocated in create().
+ */
+class SpatialAudioSynth {
+  public:
+	[[nodiscard]] static tl::
+		expected<SpatialAudioSynth, InvalidSpatialAudioConfig>
+		create(const SpatialAudioConfig& config);
+
+	/// vision thread, replaces all cues, cues beyond the voice count are
+	/// dropped
+	void set_cues(std::span<const AudioCue> cues);
+
+	/// audio thread, renders interleaved stereo samples (left, right) in
+	/// [-1, 1] of at most max_block_frames frames
+	[[nodiscard]] std::optional<InvalidAudioBlock>
+	render(std::span<float> stereo_samples);
+
+	[[nodiscard]] const SpatialAudioConfig& get_config() const {
+		return config;
+	}
+
+  private:
+	/// sound parameters of a cue
+	struct VoiceTarget {
+		float left_gain = 0.0f;
+		float right_gain = 0.0f;
+		/// phase increments per sample in 1 / 2^32 of a period
+		uint32_t phase_step = 0;
+		uint32_t pulse_phase_step = 0;
+		/// phase of the ear facing away is behind by this many samples
+		float delay_samples = 0.0f;
+		/// true if the left ear faces away
+		bool left_delayed = false;
+	};
+
+	struct Voice {
+		uint32_t cue_id = 0;
+		VoiceTarget target;
+		/// smoothed towards the target once per block
+		float left_gain = 0.0f;
+		float right_gain = 0.0f;
+		float delay_samples = 0.0f;
+		uint32_t phase = 0;
+		uint32_t pulse_phase = 0;
+	};
+
+	explicit SpatialAudioSynth(const SpatialAudioConfig& config);
+
+	[[nodiscard]] VoiceTarget target_of(const AudioCue& cue) const;
+	/// assigns the cues of the latest set_cues() to voices
+	void apply_cues(const AudioCueSet& cue_set);
+	/// adds one voice to the mix buffers
+	void render_voice(Voice& voice, size_t frames);
+	/// linearly interpolated wavetable lookup
+	[[nodiscard]] float
+	lookup(const std::vector<float>& table, uint32_t phase) const;
+
+	SpatialAudioConfig config;
+	int wavetable_bits;
+
+	/// on the heap, so the synth can be moved before it is used
+	std::unique_ptr<TripleBuffer<AudioCueSet>> cue_buffer;
+
+	/// one period of the tone and of the pulse envelope, with the first
+	/// sample repeated at the end for the interpolation
+	std::vector<float> tone_table;
+	std::vector<float> pulse_table;
+
+	std::vector<Voice> voices;
+	/// samples of the current voice for the ear facing the cue and the ear
+	/// facing away
+	std::vector<float> near_ear_block;
+	std::vector<float> far_ear_block;
+	std::vector<float> left_mix;
+	std::vector<float> right_mix;
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "EyeAICore/Operators.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct DepthCascadeConfig {
+	/// the refined model runs at least on every n-th frame
+	int refine_interval = 8;
+	/// and at most on every n-th frame, also while the fast output is
+	/// uncertain
+	int min_refine_interval = 2;
+	/// the fast output is uncertain once its alignment to the previous output
+	/// fits worse than this (see ScaleShiftFit::relative_residual) or was
+	/// reset
+	float uncertainty_threshold = 0.2f;
+};
+
+struct [[nodiscard]] InvalidDepthCascadeConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+enum class CascadeRefineReason : uint8_t {
+	/// there is no refined output yet
+	FirstFrame,
+	/// refine_interval frames since the last refined one
+	Scheduled,
+	/// the fast output was uncertain
+	Uncertain,
+};
+
+struct DepthCascadeStats {
+	uint64_t fast_frames = 0;
+	uint64_t refined_frames = 0;
+	/// refined frames because the fast output was uncertain
+	uint64_t uncertain_refinements = 0;
+	/// refined outputs that could not be aligned to the fast output
+	uint64_t rejected_refinements = 0;
+	/// alignment of the latest refined output to the fast one
+	std::optional<ScaleShiftFit> refined_fit;
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/**
+ * Cascade of a fast (e.g. quantized) depth model that runs on every frame and
+ * a refined (e.g. float) model that runs on a schedule or when the fast output
+ * is uncertain. The refined output is aligned to the fast output of the same
+ * frame by its scale and shift and replaces it. Nothing is carried over to
+ * the following fast outputs: a per pixel correction would paint the edges of
+ * the refined frame into later frames once the camera or obstacles move, and
+ * the refined output is already in the scale and shift of the fast stream.
+ * The fusion runs as CascadeFuseOperator
+ * between the alignment and the normalization of the fast model, so it
+ * happens in the aligned depth of the fast stream. (not thread-safe)
+ */
+class DepthCascade {
+  public:
+	/// on the heap, CascadeFuseOperator refers to it
+	[[nodiscard]] static tl::expected<
+		std::unique_ptr<DepthCascade>,
+		InvalidDepthCascadeConfig>
+	create(const DepthCascadeConfig& config);
+
+	DepthCascade(const DepthCascade&) = delete;
+	DepthCascade& operator=(const DepthCascade&) = delete;
+
+	/// before the fast model runs on the next frame, fast_alignment is the
+	/// latest alignment fit of the fast output (DepthModel::get_alignment_fit)
+	/// returns why the refined model has to run on this frame, nullopt if it
+	/// does not
+	[[nodiscard]] std::optional<CascadeRefineReason>
+	begin_frame(const std::optional<ScaleShiftFit>& fast_alignment) const;
+
+	/// raw output of the refined model for the current frame, fused into the
+	/// output of the fast model by the next fuse()
+	void
+	set_refined(std::span<const float> refined, CascadeRefineReason reason);
+
+	/// aligned fast output of the current frame in, fused output out
+	[[nodiscard]] std::optional<OperatorError> fuse(std::span<float> depth);
+
+	/// the next frame is refined
+	void reset();
+
+	[[nodiscard]] const DepthCascadeStats& get_stats() const { return stats; }
+
+  private:
+	explicit DepthCascade(const DepthCascadeConfig& config) : config(config) {}
+
+	DepthCascadeConfig config;
+	ScaleShiftAlignOperator aligner;
+	/// scratch state of aligner
+	std::vector<float> align_state;
+
+	std::vector<float> pending_refined;
+	std::optional<CascadeRefineReason> pending_reason;
+	/// fast frames since the latest refined frame, nullopt before the first
+	std::optional<int> frames_since_refined;
+	DepthCascadeStats stats;
+};
+
+/// fuses the fast output with DepthCascade, stateless runs (e.g. crops of the
+/// frame) are not part of the stream and stay unchanged
+class CascadeFuseOperator : public Operator {
+  public:
+	/// cascade has to outlive the operator
+	explicit CascadeFuseOperator(DepthCascade& cascade) : cascade(&cascade) {}
+
+	[[nodiscard]] std::optional<OperatorError>
+	execute(std::span<float> /*values*/) const override {
+		return std::nullopt;
+	}
+
+	[[nodiscard]] std::optional<OperatorError> execute_with_state(
+		std::span<float> values,
+		std::span<float> /*state*/
+	) const override {
+		return cascade->fuse(values);
+	}
+
+  private:
+	DepthCascade* cascade;
+};
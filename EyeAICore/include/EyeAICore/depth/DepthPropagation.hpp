@@ -0,0 +1,150 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct DepthPropagationConfig {
+	/// the luma the motion is estimated on is downscaled by this factor
+	int luma_downscale = 4;
+	/// side length of the matched blocks in luma pixels
+	int block_size = 8;
+	/// offsets searched around the predicted motion of a block, in luma pixels
+	int search_radius = 2;
+	/// frames propagated from one keyframe at most
+	int max_propagated_frames = 4;
+	/// mean motion relative to the keyframe (in luma pixels) up to which
+	/// frames are propagated, the motion of the next frame is extrapolated
+	float max_mean_motion = 4.0f;
+	/// mean absolute luma difference of the matched blocks above which the
+	/// motion is not trusted (occlusions, lighting changes)
+	float max_match_error = 0.06f;
+};
+
+struct [[nodiscard]] InvalidDepthPropagationConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+struct DepthPropagationStats {
+	uint64_t keyframes = 0;
+	uint64_t propagated_frames = 0;
+	/// of the latest propagated frame relative to its keyframe, in luma
+	/// pixels
+	float mean_motion = 0.0f;
+	float match_error = 0.0f;
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/**
+ * Fills the frames between depth model keyframes by warping the depth of the
+ * last keyframe along a coarse motion field. The motion is estimated by block
+ * matching on downsampled luma against the keyframe, searching around the
+ * extrapolated motion of the previous frame. A new keyframe is requested once
+ * the motion is too large or the blocks do not match well anymore, so the
+ * keyframe cadence follows the motion of the camera.
+ */
+class DepthPropagator {
+  public:
+	/// input is the rgb model input, depth the model output
+	[[nodiscard]] static tl::
+		expected<DepthPropagator, InvalidDepthPropagationConfig>
+		create(
+			const DepthPropagationConfig& config,
+			int input_width,
+			int input_height,
+			int depth_width,
+			int depth_height
+		);
+
+	/// computes the luma of the next frame from rgb hwc floats in [0, 255],
+	/// has to be called before set_keyframe() or propagate()
+	[[nodiscard]] std::optional<ImageBufferSizeMismatch>
+	begin_frame(std::span<const float> rgb);
+
+	/// the current frame has to be inferred instead of propagated
+	[[nodiscard]] bool needs_keyframe() const;
+
+	/// depth of the current frame, which becomes the new keyframe
+	[[nodiscard]] std::optional<ImageBufferSizeMismatch>
+	set_keyframe(std::span<const float> depth);
+
+	/// warps the keyframe depth to the current frame, only valid while
+	/// needs_keyframe() is false
+	[[nodiscard]] std::optional<ImageBufferSizeMismatch>
+	propagate(std::span<float> out_depth);
+
+	/// the next frame will be a keyframe
+	void reset();
+
+	[[nodiscard]] const DepthPropagationStats& get_stats() const {
+		return stats;
+	}
+
+  private:
+	/// offset from a block of the current frame to its match in the
+	/// keyframe, in luma pixels
+	struct MotionVector {
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	/// position of a depth pixel in the block grid, for bilinear
+	/// interpolation of the motion field
+	struct BlockSample {
+		size_t index0;
+		size_t index1;
+		/// weight of index1, index0 has 1 - weight
+		float weight;
+	};
+
+	[[nodiscard]] static std::vector<BlockSample> compute_block_samples(
+		int depth_size,
+		int luma_size,
+		int block_size,
+		int block_count
+	);
+
+	DepthPropagator(
+		const DepthPropagationConfig& config,
+		int input_width,
+		int input_height,
+		int depth_width,
+		int depth_height
+	);
+
+	void estimate_motion();
+	void warp_keyframe_depth(std::span<float> out_depth);
+
+	DepthPropagationConfig config;
+	int input_width;
+	int input_height;
+	int depth_width;
+	int depth_height;
+	int luma_width;
+	int luma_height;
+	int block_columns;
+	int block_rows;
+
+	BoxDownsamplePlan luma_plan;
+	std::vector<float> luma;
+	std::vector<float> keyframe_luma;
+	std::vector<float> keyframe_depth;
+	std::vector<MotionVector> motion;
+	std::vector<BlockSample> column_samples;
+	std::vector<BlockSample> row_samples;
+	/// motion field of one depth row, interpolated between block rows
+	std::vector<float> row_motion_x;
+	std::vector<float> row_motion_y;
+	bool has_keyframe = false;
+	int frames_since_keyframe = 0;
+	float mean_motion = 0.0f;
+	float match_error = 0.0f;
+	DepthPropagationStats stats;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <optional>
+#include <span>
+#include <vector>
+
+/// pixel rectangle, parts outside of the depth map are ignored by queries
+struct DepthRegion {
+	int x = 0;
+	int y = 0;
+	int width = 0;
+	int height = 0;
+};
+
+/**
+ * Answers "mean / nearest / farthest depth in this rectangle" queries for one
+ * depth map (e.g. the MinMaxOperator output). update() builds a summed-area
+ * table for O(1) sum and mean queries and a min/max pyramid for min and max
+ * queries that scan the largest fitting cells and only resolve the thin
+ * borders around them at finer levels. The buffers are kept between
+ * updates, so rebuilding it every frame does not allocate.
+ */
+class DepthRegionIndex {
+  public:
+	DepthRegionIndex(int width, int height);
+
+	/// depth has to be width * height values, row-major
+	[[nodiscard]] std::optional<ImageBufferSizeMismatch>
+	update(std::span<const float> depth);
+
+	/// nullopt if the region does not overlap the depth map
+	[[nodiscard]] std::optional<float> sum(DepthRegion region) const;
+	[[nodiscard]] std::optional<float> mean(DepthRegion region) const;
+	[[nodiscard]] std::optional<float> min(DepthRegion region) const;
+	/// for relative inverse depth this is the nearest point of the region
+	[[nodiscard]] std::optional<float> max(DepthRegion region) const;
+
+	[[nodiscard]] int get_width() const { return width; }
+	[[nodiscard]] int get_height() const { return height; }
+
+  private:
+	struct PyramidLevel {
+		int width;
+		int height;
+		std::vector<float> min_values;
+		std::vector<float> max_values;
+	};
+
+	/// region clamped to the depth map, nullopt if it is empty then
+	[[nodiscard]] std::optional<DepthRegion> clamp_region(DepthRegion region
+	) const;
+
+	/// reduces the region (inside of the depth map) into result
+	template<bool IsMax>
+	[[nodiscard]] float
+	reduce_pyramid(const DepthRegion& region, float result) const;
+
+	template<bool IsMax>
+	[[nodiscard]] std::optional<float> query_pyramid(DepthRegion region) const;
+
+	int width;
+	int height;
+	/// values are stored relative to the frame mean, this keeps the sums
+	/// small and float precise enough even for large maps
+	float frame_mean = 0.0f;
+	/// (width + 1) * (height + 1), the first row and column are 0
+	std::vector<float> summed_area_table;
+	/// level 0 is the depth map itself (only min_values is used), every level
+	/// halves the size
+	std::vector<PyramidLevel> pyramid;
+	/// vertically reduced row pair while building the next pyramid level
+	std::vector<float> row_min_values;
+	std::vector<float> row_max_values;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "EyeAICore/depth/DepthRegionIndex.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <span>
+#include <string>
+#include <vector>
+
+struct DropOffConfig {
+	float horizontal_fov_degrees = 65.0f;
+	/// the walking path is the centered columns of this width fraction below
+	/// the start row fraction
+	float path_width_fraction = 0.5f;
+	float path_start_fraction = 0.4f;
+	/// the path is split into this many columns bands, each reports its
+	/// nearest drop-off
+	int bands = 5;
+	/// rows whose gradient is this many times the floor gradient of their
+	/// band are part of a depth jump
+	float jump_ratio = 3.0f;
+	/// smaller jumps in relative inverse depth are not reported
+	float min_jump = 0.03f;
+	/// jump in relative inverse depth at which the confidence reaches 1
+	float full_confidence_jump = 0.12f;
+	/// rows right below a jump that have to look like floor, so the top
+	/// edges of obstacles are not reported
+	int support_rows = 4;
+};
+
+struct [[nodiscard]] InvalidDropOffConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+/// sudden depth increase in the walking path, like a stair down or a curb
+struct DropOffHazard {
+	/// direction of the band, positive to the right
+	float azimuth_degrees = 0.0f;
+	/// relative inverse depth of the floor right before the edge, 1 is
+	/// nearest
+	float nearness = 0.0f;
+	/// drop of relative inverse depth across the edge
+	float jump = 0.0f;
+	/// how certain the edge is a drop-off, in [0, 1]
+	float confidence = 0.0f;
+};
+
+/**
+ * Finds drop-offs in the lower center of a depth map. On a flat floor the
+ * relative inverse depth changes linearly from row to row, so the vertical
+ * Scharr gradient of a column band is about constant. Rows where it jumps
+ * far above the median gradient of their band are a sudden depth increase,
+ * it is only reported if the rows below still look like floor, which the top
+ * edge of an obstacle does not. The gradient is computed with Float4 and only
+ * over the walking path, the row profiles are band sums. The floor depth
+ * before an edge is a region query of the shared DepthRegionIndex.
+ */
+class DropOffDetector {
+  public:
+	[[nodiscard]] static tl::expected<DropOffDetector, InvalidDropOffConfig>
+	create(const DropOffConfig& config, int width, int height);
+
+	/// depth is relative inverse depth in [0, 1] and region_index has to be
+	/// updated with it, returns at most one hazard per band ordered from left
+	/// to right, valid until the next detect()
+	[[nodiscard]] tl::
+		expected<std::span<const DropOffHazard>, ImageBufferSizeMismatch>
+		detect(
+			std::span<const float> depth,
+			const DepthRegionIndex& region_index
+		);
+
+	[[nodiscard]] const DropOffConfig& get_config() const { return config; }
+	[[nodiscard]] int get_width() const { return width; }
+	[[nodiscard]] int get_height() const { return height; }
+
+  private:
+	DropOffDetector(
+		const DropOffConfig& config,
+		int width,
+		int height,
+		int path_begin,
+		int path_end,
+		int first_row
+	);
+
+	/// vertical scharr gradient of one path row into row_gradients and its
+	/// band means into the band profiles
+	void compute_row_profile(std::span<const float> depth, int row);
+	/// nearest drop-off of a band, confidence 0 if there is none
+	[[nodiscard]] DropOffHazard
+	find_drop_off(const DepthRegionIndex& region_index, int band);
+
+	DropOffConfig config;
+	int width;
+	int height;
+	/// columns [path_begin, path_end) and rows [first_row, height - 1) are
+	/// analyzed, so every gradient has neighbours
+	int path_begin;
+	int path_end;
+	int first_row;
+	/// first column of every band, and path_end
+	std::vector<int> band_columns;
+	std::vector<float> band_azimuths;
+
+	std::vector<float> row_differences;
+	std::vector<float> row_gradients;
+	/// mean gradient per band and row, band major
+	std::vector<float> band_profiles;
+	std::vector<float> sorted_profile;
+	std::vector<DropOffHazard> hazards;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "EyeAICore/depth/DepthRegionIndex.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct FoveationConfig {
+	/// side length of the center crop relative to the full frame
+	float crop_fraction = 0.5f;
+	/// width of the blend ramp at the border of the crop, relative to the
+	/// crop side length
+	float blend_fraction = 0.25f;
+	/// average depth model runs per frame, 1 only runs the full frame and 2
+	/// also the center crop of every frame
+	float inference_budget = 1.5f;
+};
+
+struct [[nodiscard]] InvalidFoveationConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+/// how the center depth was fitted to the full depth map
+struct FoveaBlend {
+	float scale = 1.0f;
+	float shift = 0.0f;
+	/// false if no usable fit was found, the full depth map is unchanged then
+	bool applied = false;
+};
+
+/**
+ * Foveated inference: besides the downsampled full frame the depth model also
+ * runs on a center crop, where collisions happen, so the center is estimated
+ * from more input pixels. The center depth is fitted to the full depth map by
+ * least squares (relative depth has an arbitrary scale and shift per run) and
+ * blended in with a smooth ramp, so there is no seam at the crop border.
+ * Center runs are scheduled so the average number of model runs per frame
+ * stays within the inference budget.
+ */
+class FoveatedDepthBlender {
+  public:
+	/// depth is the full depth map, center_depth the output for the crop
+	[[nodiscard]] static tl::
+		expected<FoveatedDepthBlender, InvalidFoveationConfig>
+		create(
+			const FoveationConfig& config,
+			int depth_width,
+			int depth_height,
+			int center_depth_width,
+			int center_depth_height
+		);
+
+	/// if the budget allows running the model on the center crop of the next
+	/// frame
+	[[nodiscard]] bool can_afford_center() const;
+
+	/// accounts the model runs of a finished frame against the budget, 0 for
+	/// frames whose depth was reused or propagated
+	void record_frame(int model_runs);
+
+	/// part of the full depth map that the center crop covers
+	[[nodiscard]] const DepthRegion& get_center_region() const {
+		return center_region;
+	}
+
+	/// fits center_depth to depth (normalized to [0, 1]) in the center region
+	/// and blends it in
+	[[nodiscard]] tl::expected<FoveaBlend, ImageBufferSizeMismatch>
+	blend(std::span<float> depth, std::span<const float> center_depth);
+
+	[[nodiscard]] const FoveationConfig& get_config() const { return config; }
+
+  private:
+	FoveatedDepthBlender(
+		const FoveationConfig& config,
+		int depth_width,
+		int depth_height,
+		int center_depth_width,
+		int center_depth_height,
+		DepthRegion center_region
+	);
+
+	[[nodiscard]] std::optional<FoveaBlend>
+	fit_center(std::span<const float> depth) const;
+
+	FoveationConfig config;
+	int depth_width;
+	int depth_height;
+	int center_depth_width;
+	int center_depth_height;
+	DepthRegion center_region;
+	/// center depth resampled to the size of the center region
+	std::vector<float> resampled_center;
+	/// separable blend weights of the center region, 1 inside, smoothly
+	/// falling to 0 at the border
+	std::vector<float> column_weights;
+	std::vector<float> row_weights;
+	/// unused budget of previous frames, in model runs
+	float budget_credit = 0.0f;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "EyeAICore/depth/PointCloud.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+/// normal * point + offset is the height of a point above the plane, the
+/// normal has unit length and points upwards, so offset is the height of the
+/// camera
+struct GroundPlane {
+	float normal_x = 0.0f;
+	float normal_y = 1.0f;
+	float normal_z = 0.0f;
+	float offset = 0.0f;
+
+	/// horizontal floor in the level frame of DepthBackProjector
+	[[nodiscard]] static GroundPlane level(float camera_height) {
+		return {0.0f, 1.0f, 0.0f, camera_height};
+	}
+
+	[[nodiscard]] float height(float x, float y, float z) const {
+		return normal_x * x + normal_y * y + normal_z * z + offset;
+	}
+
+	/// angle between the normal and straight up
+	[[nodiscard]] float tilt_degrees() const;
+};
+
+struct GroundPlaneConfig {
+	/// rows below this fraction of the height are sampled, the floor is in
+	/// the lower part of the frame
+	float sample_start_fraction = 0.5f;
+	/// the sampled rows are strided to get about this many points
+	int max_samples = 1024;
+	/// further points are too noisy to be sampled, in meters
+	float max_sample_distance = 6.0f;
+	/// points closer to a plane than this are its inliers, in meters
+	float inlier_distance = 0.05f;
+	/// planes whose normal is tilted more than this from up are no floor
+	float max_tilt_degrees = 30.0f;
+	/// hypotheses when the previous plane does not fit anymore
+	int max_iterations = 128;
+	/// additional hypotheses when the previous plane still fits
+	int seeded_iterations = 8;
+	/// inlier ratio of the previous plane at which it still fits
+	float seed_inlier_ratio = 0.5f;
+	/// planes with fewer inliers (relative to the samples) are not accepted
+	float min_inlier_ratio = 0.2f;
+	/// points higher than this above the plane are above ground in the mask
+	float obstacle_height = 0.1f;
+	/// no more hypotheses are evaluated once this is exceeded
+	std::chrono::microseconds time_budget = std::chrono::microseconds(2000);
+};
+
+struct [[nodiscard]] InvalidGroundPlaneConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+struct GroundPlaneEstimate {
+	GroundPlane plane;
+	/// inliers of the plane relative to the sampled points
+	float inlier_ratio = 0.0f;
+	/// evaluated hypotheses, including the previous plane
+	int hypotheses = 0;
+	/// the previous plane still fit, only a few hypotheses were evaluated
+	bool seeded = false;
+	/// false if no plane had enough inliers, the previous plane is kept then
+	bool found = false;
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/**
+ * Estimates the floor as the dominant plane in the lower part of the point
+ * cloud with RANSAC. The previous plane is tried first and while it still
+ * fits only a few more hypotheses are evaluated, otherwise a batch of
+ * hypotheses is split between threads, each stopping once the inlier ratio
+ * found so far makes more hypotheses pointless or the time budget is spent.
+ * Inliers are counted with Float4 over the sampled points, which are stored
+ * as structure of arrays. The best plane is refined by least squares over its
+ * inliers.
+ */
+class GroundPlaneEstimator {
+  public:
+	/// width and height of the depth map the point clouds come from
+	[[nodiscard]] static tl::
+		expected<GroundPlaneEstimator, InvalidGroundPlaneConfig>
+		create(const GroundPlaneConfig& config, int width, int height);
+
+	/// points need one point per depth pixel in the level frame of
+	/// DepthBackProjector
+	[[nodiscard]] tl::expected<GroundPlaneEstimate, ImageBufferSizeMismatch>
+	estimate(const PointCloud& points, int threads = 1);
+
+	/// 1 for points higher than the obstacle height above the latest found
+	/// plane, 0 for the floor, all points are above ground without a plane
+	[[nodiscard]] std::optional<ImageBufferSizeMismatch>
+	compute_above_ground_mask(
+		const PointCloud& points,
+		std::span<uint8_t> out_mask
+	) const;
+
+	/// the next estimate() starts without the previous plane
+	void reset();
+
+	/// a plane was found since the creation or the last reset(), the plane of
+	/// get_latest() is then the latest found one even if the floor was not
+	/// found in the latest estimate
+	[[nodiscard]] bool has_plane() const { return previous_plane.has_value(); }
+
+	[[nodiscard]] const GroundPlaneEstimate& get_latest() const {
+		return latest;
+	}
+
+  private:
+	/// best hypothesis of one thread
+	struct HypothesisResult {
+		GroundPlane plane;
+		int inliers = -1;
+		int evaluated = 0;
+	};
+
+	GroundPlaneEstimator(
+		const GroundPlaneConfig& config,
+		int width,
+		int height
+	);
+
+	void sample_points(const PointCloud& points);
+	/// plane through three random samples, nullopt if it can not be the floor
+	[[nodiscard]] std::optional<GroundPlane> random_hypothesis();
+	[[nodiscard]] int count_inliers(const GroundPlane& plane) const;
+	/// evaluates the hypotheses [begin, end) until the time budget is spent
+	[[nodiscard]] HypothesisResult evaluate_hypotheses(
+		size_t begin,
+		size_t end,
+		std::chrono::steady_clock::time_point deadline
+	) const;
+	/// least squares fit of the floor through the inliers of plane
+	[[nodiscard]] GroundPlane refine(const GroundPlane& plane) const;
+
+	GroundPlaneConfig config;
+	int width;
+	int height;
+	/// cosine of the max tilt
+	float min_normal_y;
+	std::minstd_rand random;
+
+	std::vector<float> samples_x;
+	std::vector<float> samples_y;
+	std::vector<float> samples_z;
+	std::vector<GroundPlane> hypotheses;
+	std::optional<GroundPlane> previous_plane;
+	GroundPlaneEstimate latest;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct GuidedUpsamplingConfig {
+	/// radius of the box filter in depth pixels
+	int radius = 2;
+	/// regularization of the guided filter, the larger it is the weaker guide
+	/// edges (variance of luma in [0, 1]) are followed
+	float epsilon = 1e-3f;
+};
+
+struct [[nodiscard]] InvalidGuidedUpsamplingConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+/**
+ * Edge-aware upsampling of depth to the resolution of the camera frame with a
+ * fast guided filter: the depth is modeled as a locally linear function of
+ * the frame luma, the coefficients are fitted at the depth resolution
+ * (against the box filtered luma) and bilinearly upsampled, so depth edges
+ * snap to the edges of the frame and thin obstacles keep their outline. Only
+ * the final pass runs at the guide resolution, it is split into bands of rows
+ * that run on worker threads started in create(). All scratch buffers are
+ * allocated in create() as well, so upsample() does not allocate.
+ */
+class GuidedDepthUpsampler {
+  public:
+	/// the guide has to be at least as large as the depth, a smaller guide
+	/// (e.g. a frame with a reduced input scale) is an error since there is
+	/// nothing to upsample, threads are clamped to [1, guide_height], all but
+	/// one of them are started here
+	[[nodiscard]] static tl::
+		expected<GuidedDepthUpsampler, InvalidGuidedUpsamplingConfig>
+		create(
+			const GuidedUpsamplingConfig& config,
+			int depth_width,
+			int depth_height,
+			int guide_width,
+			int guide_height,
+			int threads = 1
+		);
+
+	GuidedDepthUpsampler(GuidedDepthUpsampler&&) noexcept;
+	GuidedDepthUpsampler& operator=(GuidedDepthUpsampler&&) noexcept;
+	~GuidedDepthUpsampler();
+
+	/// fits the filter coefficients, guide are argb 8888 pixels of the frame
+	/// the depth was estimated from
+	[[nodiscard]] std::optional<ImageBufferSizeMismatch>
+	fit(std::span<const float> depth, std::span<const int> guide);
+
+	/// fit() and the guide resolution pass, one band of rows per thread
+	[[nodiscard]] std::optional<ImageBufferSizeMismatch> upsample(
+		std::span<const float> depth,
+		std::span<const int> guide,
+		std::span<float> out_depth
+	);
+
+	[[nodiscard]] int get_depth_width() const { return depth_width; }
+	[[nodiscard]] int get_depth_height() const { return depth_height; }
+	[[nodiscard]] int get_guide_width() const { return guide_width; }
+	[[nodiscard]] int get_guide_height() const { return guide_height; }
+	[[nodiscard]] int get_threads() const {
+		return static_cast<int>(band_scratch.size());
+	}
+
+  private:
+	/// coefficient rows upsampled to the guide width and the luma of the
+	/// current row, one per band so the bands can run concurrently
+	struct RowScratch {
+		std::vector<float> upper_scales;
+		std::vector<float> upper_offsets;
+		std::vector<float> lower_scales;
+		std::vector<float> lower_offsets;
+		std::vector<float> row_luma;
+	};
+
+	/// threads of the bands after the first, defined in the source file
+	struct BandWorkers;
+
+	/// position of an output coordinate between two coefficients
+	struct CoefficientSample {
+		size_t index0;
+		size_t index1;
+		/// weight of index1, index0 has 1 - weight
+		float weight;
+	};
+
+	/// pixel centers are aligned, same as resize_floats
+	[[nodiscard]] static std::vector<CoefficientSample>
+	compute_coefficient_samples(int size, int out_size);
+
+	GuidedDepthUpsampler(
+		const GuidedUpsamplingConfig& config,
+		int depth_width,
+		int depth_height,
+		int guide_width,
+		int guide_height,
+		int threads
+	);
+
+	/// normalized box filter with the radius of the config, values and
+	/// out_values are at the depth resolution
+	void box_filter(std::span<const float> values, std::span<float> out_values);
+
+	/// coefficients of one depth row, horizontally upsampled to guide width
+	void upsample_coefficient_row(
+		size_t row,
+		std::span<float> out_scales,
+		std::span<float> out_offsets
+	) const;
+
+	/// writes the rows of band of the upsampled depth (guide resolution), only
+	/// reads the coefficients of the last fit() and writes the scratch of the
+	/// band, so different bands can run concurrently
+	void apply_band(
+		std::span<const int> guide,
+		std::span<float> out_depth,
+		size_t band
+	);
+
+	GuidedUpsamplingConfig config;
+	int depth_width;
+	int depth_height;
+	int guide_width;
+	int guide_height;
+	/// reduces the guide to luma at the depth resolution
+	BoxDownsamplePlan luma_plan;
+	std::vector<CoefficientSample> column_samples;
+	std::vector<CoefficientSample> row_samples;
+
+	std::vector<float> luma;
+	std::vector<float> products;
+	std::vector<float> mean_luma;
+	std::vector<float> mean_depth;
+	std::vector<float> luma_variance;
+	std::vector<float> luma_depth_covariance;
+	/// box filter intermediates
+	std::vector<float> column_sums;
+	std::vector<float> vertical_sums;
+	/// box filtered depth = scale * luma + offset
+	std::vector<float> scales;
+	std::vector<float> offsets;
+
+	std::vector<RowScratch> band_scratch;
+	/// nullptr for a single thread, on the heap so the upsampler stays
+	/// movable, the workers only refer to it during upsample()
+	std::unique_ptr<BandWorkers> band_workers;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+struct ObstacleBlobConfig {
+	/// relative inverse depth (1 is nearest) at which a pixel belongs to an
+	/// obstacle
+	float near_threshold = 0.6f;
+	/// smaller blobs are noise, in pixels
+	int min_area = 32;
+	/// only the nearest blobs are reported
+	int max_blobs = 16;
+};
+
+struct [[nodiscard]] InvalidObstacleBlobConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+/// 8-connected region of near pixels
+struct ObstacleBlob {
+	/// inclusive bounding box in depth pixels
+	int min_x = 0;
+	int min_y = 0;
+	int max_x = 0;
+	int max_y = 0;
+	/// in pixels
+	int area = 0;
+	float centroid_x = 0.0f;
+	float centroid_y = 0.0f;
+	/// mean and maximum relative inverse depth of the pixels
+	float mean_depth = 0.0f;
+	float nearest = 0.0f;
+};
+
+/**
+ * Connected-component labeling of the near pixels of a depth map. The pixels
+ * are collected as horizontal runs and overlapping runs of neighbouring rows
+ * are merged with union-find, so the work is per run instead of per pixel.
+ * The statistics of a blob are summed up from its runs. All buffers are
+ * allocated for the worst case in create(), a busy scene does not allocate.
+ */
+class ObstacleBlobExtractor {
+  public:
+	[[nodiscard]] static tl::
+		expected<ObstacleBlobExtractor, InvalidObstacleBlobConfig>
+		create(const ObstacleBlobConfig& config, int width, int height);
+
+	/// depth is relative inverse depth in [0, 1], returns at most max_blobs
+	/// blobs, nearest first, valid until the next extract()
+	[[nodiscard]] tl::
+		expected<std::span<const ObstacleBlob>, ImageBufferSizeMismatch>
+		extract(std::span<const float> depth);
+
+	[[nodiscard]] const ObstacleBlobConfig& get_config() const {
+		return config;
+	}
+	[[nodiscard]] int get_width() const { return width; }
+	[[nodiscard]] int get_height() const { return height; }
+
+  private:
+	/// pixels [begin, end) of a row at or above the near threshold
+	struct Run {
+		int row;
+		int begin;
+		int end;
+		float depth_sum;
+		float depth_max;
+	};
+
+	/// sums of a component while its runs are collected
+	struct Component {
+		int min_x;
+		int min_y;
+		int max_x;
+		int max_y;
+		int area;
+		double x_sum;
+		double y_sum;
+		double depth_sum;
+		float depth_max;
+	};
+
+	ObstacleBlobExtractor(
+		const ObstacleBlobConfig& config,
+		int width,
+		int height
+	);
+
+	/// appends the runs of a row, returns how many
+	size_t collect_runs(std::span<const float> depth, int row);
+	/// unions the runs of a row with the overlapping runs of the previous row
+	void merge_runs(
+		size_t previous_begin,
+		size_t previous_end,
+		size_t current_begin,
+		size_t current_end
+	);
+	[[nodiscard]] uint32_t find_root(uint32_t run);
+	void unite(uint32_t a, uint32_t b);
+	/// sums the runs into components and picks the nearest blobs
+	void collect_blobs();
+
+	ObstacleBlobConfig config;
+	int width;
+	int height;
+
+	std::vector<Run> runs;
+	/// union-find forest over the runs, a root is the smallest run index of
+	/// its component
+	std::vector<uint32_t> run_parents;
+	/// component index of every run
+	std::vector<uint32_t> run_components;
+	std::vector<Component> components;
+	std::vector<ObstacleBlob> blobs;
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+enum class SectorLayout : uint8_t {
+	/// columns x rows rectangles of the roll compensated image plane
+	Grid,
+	/// columns azimuth x rows elevation bands of equal angle, relative to the
+	/// horizon when pitch and roll are known
+	Polar,
+};
+
+struct SectorLayoutConfig {
+	SectorLayout layout = SectorLayout::Polar;
+	int columns = 5;
+	int rows = 3;
+	float horizontal_fov_degrees = 65.0f;
+	/// derived from the horizontal fov and the aspect ratio if not set
+	std::optional<float> vertical_fov_degrees;
+	/// rotation of the camera around its optical axis, positive is clockwise
+	float roll_degrees = 0.0f;
+	/// positive tilts the camera upwards, only used by the polar layout
+	float pitch_degrees = 0.0f;
+	/// relative inverse depth (1 is nearest) at which a pixel counts as
+	/// obstacle
+	float obstacle_threshold = 0.6f;
+	/// obstacle coverage of a sector at which its confidence reaches 1
+	float full_confidence_coverage = 0.1f;
+};
+
+struct [[nodiscard]] InvalidSectorLayout {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+struct [[nodiscard]] SectorDepthSizeMismatch {
+	size_t expected_size;
+	size_t actual_size;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+/// the output span has room for another number of sectors than the layout has
+struct [[nodiscard]] SectorCountMismatch {
+	size_t expected_count;
+	size_t actual_count;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+COMBINED_ERROR(
+	SummarizeObstacleSectorsError,
+	SectorDepthSizeMismatch,
+	SectorCountMismatch
+);
+
+/// summary of the depth values that fall into one sector, all zero if the
+/// sector has no pixels (e.g. outside of the rotated image)
+struct ObstacleSector {
+	/// maximum relative inverse depth, 1 is the nearest point of the frame
+	float nearest = 0.0f;
+	float mean = 0.0f;
+	/// fraction of the sector pixels that are above the obstacle threshold
+	float coverage = 0.0f;
+	/// how certain the sector contains an obstacle, in [0, 1]
+	float confidence = 0.0f;
+};
+
+/// center of a sector, azimuth is positive to the right, elevation positive
+/// upwards
+struct SectorDirection {
+	float azimuth_degrees = 0.0f;
+	float elevation_degrees = 0.0f;
+};
+
+/**
+ * Reduces a depth map to a few obstacle sectors, so only some dozen numbers
+ * have to be handed to the app instead of a full depth map. The pixel to
+ * sector mapping is computed once in create() and stored as horizontal runs,
+ * so summarize() only does vectorized reductions over contiguous memory.
+ * Recreate the summarizer when the layout or camera rotation changes.
+ */
+class ObstacleSectorSummarizer {
+  public:
+	[[nodiscard]] static tl::
+		expected<ObstacleSectorSummarizer, InvalidSectorLayout>
+		create(const SectorLayoutConfig& config, int width, int height);
+
+	/// out_sectors needs get_sector_count() elements, sector index is
+	/// row * columns + column, row 0 is the top
+	[[nodiscard]] std::optional<SummarizeObstacleSectorsError> summarize(
+		std::span<const float> depth,
+		std::span<ObstacleSector> out_sectors
+	) const;
+
+	[[nodiscard]] size_t get_sector_count() const {
+		return sector_directions.size();
+	}
+	[[nodiscard]] const std::vector<SectorDirection>&
+	get_sector_directions() const {
+		return sector_directions;
+	}
+	[[nodiscard]] const SectorLayoutConfig& get_config() const {
+		return config;
+	}
+	[[nodiscard]] int get_width() const { return width; }
+	[[nodiscard]] int get_height() const { return height; }
+
+  private:
+	/// contiguous pixels of one row that belong to the same sector
+	struct PixelRun {
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	ObstacleSectorSummarizer(
+		const SectorLayoutConfig& config,
+		int width,
+		int height,
+		std::vector<PixelRun>&& runs,
+		std::vector<uint32_t>&& sector_run_offsets,
+		std::vector<uint32_t>&& sector_pixel_counts,
+		std::vector<SectorDirection>&& sector_directions
+	);
+
+	SectorLayoutConfig config;
+	int width;
+	int height;
+	/// runs sorted by sector, the runs of sector i are
+	/// [sector_run_offsets[i], sector_run_offsets[i + 1])
+	std::vector<PixelRun> runs;
+	std::vector<uint32_t> sector_run_offsets;
+	std::vector<uint32_t> sector_pixel_counts;
+	std::vector<SectorDirection> sector_directions;
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "EyeAICore/depth/ObstacleBlobs.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+struct ObstacleTrackerConfig {
+	/// minimum bounding box intersection over union of a blob and a track to
+	/// be associated
+	float min_overlap = 0.2f;
+	/// a track is dropped after this many frames without a blob
+	int max_missed_frames = 3;
+	/// a track is confirmed once it was seen in this many frames
+	int min_confirmed_frames = 2;
+	int max_tracks = 16;
+	/// weight of the latest frame in the approach rate average
+	float approach_smoothing = 0.3f;
+};
+
+struct [[nodiscard]] InvalidObstacleTrackerConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+struct TrackedObstacle {
+	/// stable across frames, never reused
+	uint32_t id = 0;
+	/// blob of the latest frame it was seen in
+	ObstacleBlob blob;
+	/// frames since the track was created
+	int age = 0;
+	/// frames the blob was seen in
+	int seen_frames = 1;
+	/// frames since the blob was last seen
+	int missed_frames = 0;
+	/// averaged change of the nearest relative inverse depth per frame,
+	/// positive while the obstacle gets closer
+	float approach_rate = 0.0f;
+	bool confirmed = false;
+};
+
+/**
+ * Associates the blobs of ObstacleBlobExtractor across frames, so an obstacle
+ * keeps its id while it moves through the image. Blobs and tracks are matched
+ * greedily by descending bounding box overlap, unmatched blobs start new
+ * tracks and tracks are dropped after a few frames without a blob. With at
+ * most a few dozen blobs the greedy matching is cheaper and good enough
+ * compared to an optimal assignment. All buffers are allocated in create().
+ */
+class ObstacleTracker {
+  public:
+	[[nodiscard]] static tl::
+		expected<ObstacleTracker, InvalidObstacleTrackerConfig>
+		create(const ObstacleTrackerConfig& config, int max_blobs);
+
+	/// associates the blobs of a new frame, at most max_blobs are used
+	void update(std::span<const ObstacleBlob> blobs);
+
+	/// drops all tracks, ids keep counting
+	void reset();
+
+	/// includes unconfirmed and missed tracks, ordered by id
+	[[nodiscard]] std::span<const TrackedObstacle> get_tracks() const {
+		return tracks;
+	}
+
+	[[nodiscard]] const ObstacleTrackerConfig& get_config() const {
+		return config;
+	}
+
+  private:
+	struct Candidate {
+		float overlap;
+		uint32_t track;
+		uint32_t blob;
+	};
+
+	ObstacleTracker(const ObstacleTrackerConfig& config, int max_blobs);
+
+	ObstacleTrackerConfig config;
+	int max_blobs;
+	uint32_t next_id = 1;
+
+	std::vector<TrackedObstacle> tracks;
+	/// every track and blob pair above min_overlap
+	std::vector<Candidate> candidates;
+	std::vector<uint8_t> matched_tracks;
+	std::vector<uint8_t> matched_blobs;
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "EyeAICore/depth/GroundPlane.hpp"
+#include "EyeAICore/depth/PointCloud.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+struct OccupancyGridConfig {
+	/// side length of a cell in meters
+	float cell_size = 0.1f;
+	/// cells across, centered on the camera
+	int columns = 64;
+	/// cells ahead of the camera
+	int rows = 64;
+	/// height of the camera above the floor in meters, used when no floor
+	/// plane is passed to integrate()
+	float camera_height = 1.3f;
+	/// points up to this height above the floor are floor and ignored
+	float floor_clearance = 0.15f;
+	/// points more than this above the camera can be walked under
+	float head_clearance = 0.5f;
+	/// surface area in square meters that fully occupies a cell in one frame
+	float full_occupancy_area = 0.01f;
+	/// the occupancy of every cell is multiplied by this each frame
+	float decay = 0.8f;
+	/// cells whose occupancy decays below this are cleared
+	float min_occupancy = 0.05f;
+};
+
+struct [[nodiscard]] InvalidOccupancyGridConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+/**
+ * 2.5D occupancy grid on the floor around the camera: every cell is a solid
+ * block from the lowest to the highest obstacle point seen in it, with an
+ * occupancy that rises with the surface area observed in the cell and decays
+ * over the following frames. The grid moves with the camera, the decay
+ * clears what is left behind.
+ *
+ * All memory is allocated in create(). integrate() only visits the cells that
+ * got points in the frame and the cells that are still occupied, free cells
+ * are never touched, so updates stay cheap no matter how large the grid is.
+ */
+class OccupancyGrid {
+  public:
+	[[nodiscard]] static tl::expected<OccupancyGrid, InvalidOccupancyGridConfig>
+	create(const OccupancyGridConfig& config);
+
+	/// decays the grid and adds the points of a new frame, points need the
+	/// level frame of DepthBackProjector, heights are measured from a level
+	/// floor at the configured camera height
+	void integrate(const PointCloud& points);
+	/// heights are measured from an estimated floor instead
+	void integrate(const PointCloud& points, const GroundPlane& floor);
+
+	/// clears all cells
+	void reset();
+
+	/// cell index is row * columns + column, row 0 is nearest to the camera
+	/// and column 0 is on the left
+	[[nodiscard]] std::span<const float> get_occupancy() const {
+		return occupancy;
+	}
+	/// lowest and highest obstacle point of every cell in meters above the
+	/// floor, only valid for occupied cells
+	[[nodiscard]] std::span<const float> get_bottom_heights() const {
+		return bottom_heights;
+	}
+	[[nodiscard]] std::span<const float> get_top_heights() const {
+		return top_heights;
+	}
+	/// indices of the cells with an occupancy of at least min_occupancy, in
+	/// no particular order
+	[[nodiscard]] std::span<const uint32_t> get_occupied_cells() const {
+		return occupied_cells;
+	}
+	/// indices of the cells that got points in the latest frame
+	[[nodiscard]] std::span<const uint32_t> get_observed_cells() const {
+		return observed_cells;
+	}
+
+	[[nodiscard]] const OccupancyGridConfig& get_config() const {
+		return config;
+	}
+	[[nodiscard]] int get_columns() const { return config.columns; }
+	[[nodiscard]] int get_rows() const { return config.rows; }
+
+  private:
+	explicit OccupancyGrid(const OccupancyGridConfig& config);
+
+	/// sums the surface area and height range of the points per cell
+	void bin_points(const PointCloud& points, const GroundPlane& floor);
+
+	OccupancyGridConfig config;
+
+	std::vector<float> occupancy;
+	std::vector<float> bottom_heights;
+	std::vector<float> top_heights;
+	std::vector<uint32_t> occupied_cells;
+	/// 1 for cells in occupied_cells
+	std::vector<uint8_t> occupied_flags;
+
+	/// accumulated over the points of the current frame, only the
+	/// observed_cells are non zero
+	std::vector<float> frame_areas;
+	std::vector<float> frame_bottom_heights;
+	std::vector<float> frame_top_heights;
+	std::vector<uint32_t> observed_cells;
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <array>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+/// pinhole camera in pixels of the depth map
+struct CameraIntrinsics {
+	float focal_x;
+	float focal_y;
+	float center_x;
+	float center_y;
+
+	/// square pixels and the principal point in the center of the image
+	[[nodiscard]] static CameraIntrinsics
+	from_horizontal_fov(int width, int height, float horizontal_fov_degrees);
+};
+
+struct BackProjectionConfig {
+	/// derived from the horizontal fov if not set
+	std::optional<CameraIntrinsics> intrinsics;
+	float horizontal_fov_degrees = 65.0f;
+	/// rotation of the camera around its optical axis, positive is clockwise
+	float roll_degrees = 0.0f;
+	/// positive tilts the camera upwards
+	float pitch_degrees = 0.0f;
+	/// distances in meters that relative inverse depth 1 and 0 are mapped to,
+	/// inverse depth is interpolated linearly in between
+	float near_distance = 0.3f;
+	float far_distance = 10.0f;
+};
+
+struct [[nodiscard]] InvalidBackProjectionConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+/**
+ * Points in meters in a level frame centered at the camera: x to the right,
+ * y upwards and z forward along the horizon. Stored as structure of arrays,
+ * so transforms and binning run over contiguous floats.
+ */
+struct PointCloud {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	/// area a pixel covers on a surface facing the camera at distance 1, a
+	/// point at distance z stands for z * z times this area
+	float pixel_area = 0.0f;
+
+	[[nodiscard]] size_t size() const { return x.size(); }
+
+	/// only allocates if the cloud grows
+	void resize(size_t size) {
+		x.resize(size);
+		y.resize(size);
+		z.resize(size);
+	}
+};
+
+/**
+ * Back-projects every pixel of a depth map into a point cloud. The rays of
+ * the pixels are linear in the image coordinates, so the rotation into the
+ * level frame is folded into per column and per row terms in create() and
+ * project() only does vectorized multiply-adds and one reciprocal per pixel.
+ */
+class DepthBackProjector {
+  public:
+	[[nodiscard]] static tl::
+		expected<DepthBackProjector, InvalidBackProjectionConfig>
+		create(const BackProjectionConfig& config, int width, int height);
+
+	/// depth is relative inverse depth in [0, 1], out_points gets one point
+	/// per pixel (row-major)
+	[[nodiscard]] std::optional<ImageBufferSizeMismatch>
+	project(std::span<const float> depth, PointCloud& out_points) const;
+
+	[[nodiscard]] const CameraIntrinsics& get_intrinsics() const {
+		return intrinsics;
+	}
+	[[nodiscard]] int get_width() const { return width; }
+	[[nodiscard]] int get_height() const { return height; }
+
+  private:
+	DepthBackProjector(
+		const BackProjectionConfig& config,
+		const CameraIntrinsics& intrinsics,
+		int width,
+		int height
+	);
+
+	BackProjectionConfig config;
+	CameraIntrinsics intrinsics;
+	int width;
+	int height;
+	/// horizontal image plane coordinate of every column at distance 1
+	std::vector<float> column_u;
+	/// rotated ray of a pixel is column_u * u_axis + row_offsets[row]
+	std::array<float, 3> u_axis{};
+	/// x, y and z per row
+	std::vector<float> row_offsets;
+};
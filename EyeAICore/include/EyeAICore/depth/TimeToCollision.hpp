@@ -0,0 +1,128 @@
+#pragma once
+
+#include "EyeAICore/depth/ObstacleTracker.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/FrameTracing.hpp"
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct TimeToCollisionConfig {
+	/// samples per track the expansion rate is fitted over, at most
+	/// MAX_WINDOW_SAMPLES
+	int window_samples = 6;
+	/// samples older than this are dropped
+	float window_seconds = 1.0f;
+	/// tracks need this many samples before they get an estimate
+	int min_samples = 3;
+	/// weight of the bounding box growth against the nearest depth change,
+	/// box growth is independent of the per frame depth normalization. The
+	/// nearest depth of the blobs comes from the normalized output, whose
+	/// maximum is pinned near 1, so it barely changes for the nearest obstacle
+	/// and would overestimate the time to collision, only lower this once the
+	/// blobs carry depth that keeps its scale between frames
+	float looming_weight = 1.0f;
+	/// weight of the latest fit in the smoothed expansion rate
+	float smoothing = 0.4f;
+	/// longer times to collision are reported as not approaching
+	float max_time_to_collision = 10.0f;
+	int max_tracks = 16;
+};
+
+struct [[nodiscard]] InvalidTimeToCollisionConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+struct CollisionThreat {
+	/// id of the TrackedObstacle
+	uint32_t id = 0;
+	/// blob of the latest frame the track was seen in
+	ObstacleBlob blob;
+	/// smoothed relative growth per second of the obstacle, 1 / time to
+	/// collision, negative while it moves away
+	float expansion_rate = 0.0f;
+	/// in seconds, nullopt if it does not approach or has too few samples
+	std::optional<float> time_to_collision;
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/**
+ * Estimates the time to collision of tracked obstacles from timestamped
+ * frames. Inverse depth and the apparent size of an approaching obstacle
+ * both grow with 1 / distance, so the slope of their logarithm over time is
+ * 1 / time to collision without knowing the metric depth. The slopes are
+ * Theil-Sen fits (median of all pairwise slopes) over a short window of
+ * samples, which ignores single bad frames, and are smoothed over time.
+ *
+ * The histories are kept ordered by track id like the tracks themselves, so
+ * update() is a single merge over both in O(tracks). All buffers are
+ * allocated in create().
+ */
+class TimeToCollisionEstimator {
+  public:
+	static constexpr int MAX_WINDOW_SAMPLES = 8;
+
+	[[nodiscard]] static tl::
+		expected<TimeToCollisionEstimator, InvalidTimeToCollisionConfig>
+		create(const TimeToCollisionConfig& config);
+
+	/// tracks have to be ordered by id (see ObstacleTracker::get_tracks()),
+	/// only tracks seen in this frame get a new sample
+	void update(
+		std::span<const TrackedObstacle> tracks,
+		frame_clock::time_point frame_time
+	);
+
+	/// drops all histories
+	void reset();
+
+	/// one threat per track of the latest update(), ordered by id
+	[[nodiscard]] std::span<const CollisionThreat> get_threats() const {
+		return threats;
+	}
+	/// threat with the shortest time to collision, nullopt if nothing
+	/// approaches
+	[[nodiscard]] std::optional<CollisionThreat> get_most_urgent() const;
+
+	[[nodiscard]] const TimeToCollisionConfig& get_config() const {
+		return config;
+	}
+
+  private:
+	struct Sample {
+		frame_clock::time_point time;
+		float log_nearest;
+		/// log of the square root of the blob area
+		float log_size;
+	};
+
+	struct TrackHistory {
+		uint32_t id = 0;
+		/// oldest first
+		std::array<Sample, MAX_WINDOW_SAMPLES> samples{};
+		int sample_count = 0;
+		std::optional<float> expansion_rate;
+	};
+
+	explicit TimeToCollisionEstimator(const TimeToCollisionConfig& config);
+
+	void add_sample(TrackHistory& history, const Sample& sample) const;
+	/// robust expansion rate of the samples, nullopt with too few samples
+	[[nodiscard]] std::optional<float>
+	fit_expansion_rate(const TrackHistory& history);
+
+	TimeToCollisionConfig config;
+
+	/// ordered by id, next_histories is the merge target of update()
+	std::vector<TrackHistory> histories;
+	std::vector<TrackHistory> next_histories;
+	std::vector<CollisionThreat> threats;
+	/// pairwise slopes of one signal
+	std::vector<float> slopes;
+};
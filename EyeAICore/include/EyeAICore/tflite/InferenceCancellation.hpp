@@ -0,0 +1,110 @@
+#pragma once
+
+#include "EyeAICore/tflite/TfLiteRuntime.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/FrameTracing.hpp"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+struct InferenceCancellationConfig {
+	/// an inference is cancelled once a newer frame is available and its own
+	/// frame is older than this, its result would be outdated when shown,
+	/// nullopt never cancels for newer frames
+	std::optional<frame_clock::duration> max_result_age =
+		std::chrono::milliseconds(400);
+	/// an inference is cancelled once it runs longer than this, even if no
+	/// newer frame is available, nullopt disables the deadline
+	std::optional<frame_clock::duration> max_inference_time;
+	/// after this many cancellations in a row the next inference is never
+	/// cancelled, so a device that is too slow for the limits still gets
+	/// results
+	int max_consecutive_cancellations = 1;
+};
+
+struct [[nodiscard]] InvalidInferenceCancellationConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+struct InferenceCancellationStats {
+	uint64_t completed = 0;
+	uint64_t cancelled_for_newer_frame = 0;
+	uint64_t cancelled_at_deadline = 0;
+	/// inferences that were due but ran to completion, because too many in
+	/// a row were cancelled before
+	uint64_t protected_from_cancellation = 0;
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/**
+ * Decides when the running inference is stale and cancels it with
+ * TfLiteRuntime::cancel_inference, so a throttled or stuck invoke does not
+ * end in an outdated result. The inference thread reports the inference it
+ * runs with begin_inference() / end_inference(), every other thread can
+ * trigger the policy: frame_available() for newer frames, check() for the
+ * deadline. (thread-safe)
+ */
+class StaleInferenceCanceller {
+  public:
+	/// on the heap, the inference thread and the frame producers share it
+	[[nodiscard]] static tl::expected<
+		std::unique_ptr<StaleInferenceCanceller>,
+		InvalidInferenceCancellationConfig>
+	create(const InferenceCancellationConfig& config);
+
+	StaleInferenceCanceller(const StaleInferenceCanceller&) = delete;
+	StaleInferenceCanceller& operator=(const StaleInferenceCanceller&) = delete;
+
+	/// inference thread, right before running runtime (which has to be
+	/// created with TfLiteRuntimeOptions::enable_cancellation), runtime has to
+	/// outlive end_inference()
+	void begin_inference(
+		const TfLiteRuntime& runtime,
+		frame_clock::time_point capture_time,
+		frame_clock::time_point now = frame_clock::now()
+	);
+	/// inference thread, right after running, also if it failed
+	void end_inference(bool cancelled);
+
+	/// a frame captured at capture_time is waiting for the inference, cancels
+	/// the running inference if it is stale, returns true if it did
+	bool frame_available(
+		frame_clock::time_point capture_time,
+		frame_clock::time_point now = frame_clock::now()
+	);
+	/// cancels the running inference if it is stale, returns true if it did
+	bool check(frame_clock::time_point now = frame_clock::now());
+
+	[[nodiscard]] InferenceCancellationStats get_stats() const;
+
+  private:
+	enum class CancelReason : uint8_t { None, NewerFrame, Deadline };
+
+	explicit StaleInferenceCanceller(const InferenceCancellationConfig& config)
+		: config(config) {}
+
+	/// mutex has to be locked
+	bool cancel_if_stale(frame_clock::time_point now);
+
+	InferenceCancellationConfig config;
+
+	mutable std::mutex mutex;
+	/// nullptr while no inference is running
+	const TfLiteRuntime* running_runtime = nullptr;
+	frame_clock::time_point running_capture_time;
+	frame_clock::time_point running_start_time;
+	/// reason of the cancellation of the running inference, None if it was
+	/// not cancelled
+	CancelReason cancel_reason = CancelReason::None;
+	/// the running inference was due but is protected from cancellation
+	bool protected_inference = false;
+	std::optional<frame_clock::time_point> newest_frame_time;
+	int consecutive_cancellations = 0;
+	InferenceCancellationStats stats;
+};
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "EyeAICore/tflite/TfLiteRuntime.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/FrameTracing.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class TensorLayout : uint8_t {
+	/// interleaved channels, [height, width, 3]
+	Hwc,
+	/// planar channels, [3, height, width]
+	Chw,
+};
+
+/// how a model wants the rgb camera frame, models with equal parameters share
+/// one preprocessed input
+struct PreprocessParams {
+	int width = 0;
+	int height = 0;
+	TensorLayout layout = TensorLayout::Hwc;
+	/// the input is (rgb - mean) / stddev per channel, rgb in [0, 255]
+	std::array<float, 3> mean = {0.0f, 0.0f, 0.0f};
+	std::array<float, 3> stddev = {1.0f, 1.0f, 1.0f};
+
+	[[nodiscard]] size_t get_element_count() const {
+		return static_cast<size_t>(width) * static_cast<size_t>(height) * 3;
+	}
+
+	/// only resized, every other preprocessed input starts from it
+	[[nodiscard]] bool is_resize_only() const;
+
+	[[nodiscard]] bool operator==(const PreprocessParams&) const = default;
+};
+
+struct PreprocessCacheStats {
+	/// frames resized to the size of a model input
+	uint64_t resized = 0;
+	/// resized frames normalized and / or converted to another layout
+	uint64_t converted = 0;
+	/// requests (also for the resize of a conversion) that got an input
+	/// computed earlier in the same frame
+	uint64_t reused = 0;
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/**
+ * Preprocessed inputs of the current frame, keyed by their PreprocessParams:
+ * every distinct resize and every distinct normalization / layout of it is
+ * computed once per frame, no matter how many models request it. The buffers
+ * are shared with the requesters and recycled once nobody holds them anymore,
+ * so a model that is still running on an older frame keeps its input. Holders
+ * on other threads have to drop them in sync with get() (e.g. under a lock
+ * that is also held while calling get()). (not thread-safe)
+ */
+class PreprocessCache {
+  public:
+	/// rgb 888 pixels, they have to stay valid until the next begin_frame()
+	void
+	begin_frame(std::span<const uint8_t> rgb_pixels, int width, int height);
+
+	/// input of the current frame, computed on the first request
+	[[nodiscard]] tl::expected<
+		std::shared_ptr<const std::vector<float>>,
+		ImageBufferSizeMismatch>
+	get(const PreprocessParams& params);
+
+	[[nodiscard]] const PreprocessCacheStats& get_stats() const {
+		return stats;
+	}
+
+  private:
+	struct Entry {
+		PreprocessParams params;
+		std::shared_ptr<std::vector<float>> values;
+	};
+
+	/// a buffer that nobody holds anymore, or a new one
+	[[nodiscard]] std::shared_ptr<std::vector<float>>
+	acquire_buffer(size_t size);
+
+	std::span<const uint8_t> rgb_pixels;
+	int width = 0;
+	int height = 0;
+	/// inputs of the current frame
+	std::vector<Entry> entries;
+	/// every buffer that was allocated
+	std::vector<std::shared_ptr<std::vector<float>>> buffers;
+	PreprocessCacheStats stats;
+};
+
+struct PipelineModelConfig {
+	std::string name;
+	PreprocessParams preprocess;
+	/// the model runs on every n-th frame
+	int interval = 1;
+};
+
+/// a runtime and how ModelPipeline runs it, the runtime must not have input
+/// operators, the pipeline preprocesses its input
+struct PipelineModel {
+	PipelineModelConfig config;
+	std::unique_ptr<TfLiteRuntime> runtime;
+};
+
+struct [[nodiscard]] InvalidModelPipelineConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+struct PipelineModelStats {
+	uint64_t runs = 0;
+	/// frames the model was due on while it still ran on an earlier frame
+	uint64_t skipped_busy = 0;
+	uint64_t errors = 0;
+	frame_clock::duration last_inference_time{};
+};
+
+struct ModelPipelineStats {
+	uint64_t frames = 0;
+	PreprocessCacheStats preprocess;
+	/// in the order of the models
+	std::vector<PipelineModelStats> models;
+
+	[[nodiscard]] std::string
+	formatted(const std::vector<PipelineModelConfig>& configs) const;
+};
+
+/// output of the model at model_index for the frame at frame_index, called
+/// on the worker thread of the model, output is only valid during the call
+using ModelResultCallback = std::function<void(
+	size_t model_index,
+	uint64_t frame_index,
+	const tl::expected<std::span<const float>, TfLiteRunInferenceError>&
+		output
+)>;
+
+/**
+ * Runs several models on the same camera frames. Every frame is preprocessed
+ * once through a PreprocessCache, so models with the same input share it and
+ * a second model does not repeat the resize. Every model has its own worker
+ * thread (an interpreter must not run on two threads at once), so the models
+ * run concurrently, each on every n-th frame of its interval. A model that is
+ * still busy with an earlier frame skips the frame instead of queueing it, so
+ * a slow model never delays a fast one. (thread-safe)
+ */
+class ModelPipeline {
+  public:
+	/// on the heap, the workers refer to it
+	[[nodiscard]] static tl::
+		expected<std::unique_ptr<ModelPipeline>, InvalidModelPipelineConfig>
+		create(
+			std::vector<PipelineModel>&& models,
+			ModelResultCallback callback
+		);
+
+	~ModelPipeline();
+
+	ModelPipeline(const ModelPipeline&) = delete;
+	ModelPipeline(ModelPipeline&&) = delete;
+	ModelPipeline& operator=(const ModelPipeline&) = delete;
+	ModelPipeline& operator=(ModelPipeline&&) = delete;
+
+	/// preprocesses rgb 888 pixels for the models that are due and idle and
+	/// hands the frame to their workers without waiting for them, returns the
+	/// number of models that run on it
+	[[nodiscard]] tl::expected<size_t, ImageBufferSizeMismatch>
+	process_frame(std::span<const uint8_t> rgb_pixels, int width, int height);
+
+	/// blocks until no model is running anymore
+	void wait_idle();
+
+	[[nodiscard]] const std::vector<PipelineModelConfig>& get_configs() const {
+		return configs;
+	}
+
+	[[nodiscard]] ModelPipelineStats get_stats() const;
+
+  private:
+	struct Job {
+		uint64_t frame_index;
+		std::shared_ptr<const std::vector<float>> input;
+	};
+
+	struct Worker {
+		std::unique_ptr<TfLiteRuntime> runtime;
+		std::vector<float> output;
+
+		/// guards job and stats
+		mutable std::mutex mutex;
+		std::condition_variable_any job_changed;
+		/// set while the model runs on a frame
+		std::optional<Job> job;
+		PipelineModelStats stats;
+
+		std::jthread thread;
+	};
+
+	explicit ModelPipeline(ModelResultCallback callback)
+		: callback(std::move(callback)) {}
+
+	void run_worker(size_t model_index, const std::stop_token& stop_token);
+
+	std::vector<PipelineModelConfig> configs;
+	ModelResultCallback callback;
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	/// guards the cache, the frame counter and the scratch of process_frame()
+	mutable std::mutex frame_mutex;
+	PreprocessCache preprocess_cache;
+	uint64_t frame_index = 0;
+	/// reserved for all workers in create(), so process_frame() does not
+	/// allocate
+	std::vector<std::unique_lock<std::mutex>> worker_locks;
+	std::vector<size_t> started_workers;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "EyeAICore/Operators.hpp"
+#include "EyeAICore/utils/FrameTracing.hpp"
 #include "TfLiteUtils.hpp"
 #if EYE_AI_CORE_USE_PREBUILT_TFLITE
 #include "tflite/c/c_api.h" // IWYU pragma: export
@@ -9,10 +10,12 @@
 #include "tensorflow/lite/c/c_api.h" // IWYU pragma: export
 #include "tensorflow/lite/delegates/gpu/delegate.h"
 #endif
+#include <chrono>
 #include <memory>
 #include <span>
 #include <string>
 #include <string_view>
+#include <vector>
 
 using TfLiteLogWarningCallback = void (*)(std::string);
 using TfLiteLogErrorCallback = void (*)(std::string);
@@ -22,6 +25,36 @@ struct TfLiteErrorReporterUserData {
 	TfLiteLogErrorCallback log_error_callback;
 };
 
+/// configuration of the interpreter created by TfLiteRuntime
+struct TfLiteRuntimeOptions {
+	int num_threads = 4;
+	/// falls back to cpu only mode if the gpu delegate is not supported
+	bool use_gpu_delegate = true;
+	/// applies an explicitly configured xnnpack delegate for cpu inference
+	/// (only available when tflite is built from source, prebuilt litert
+	/// always uses its default cpu delegates)
+	bool use_xnnpack = false;
+	/// resizes the first dimension of the input tensor, 1 keeps the shape of
+	/// the model
+	int batch_size = 1;
+	/// allows TfLiteRuntime::cancel_inference, the interpreter checks for it
+	/// between its nodes (a gpu delegated graph can only be cancelled before
+	/// or after the delegate runs)
+	bool enable_cancellation = false;
+};
+
+/// time spent in the different steps of TfLiteRuntime::create
+struct TfLiteRuntimeStartupTimings {
+	std::chrono::steady_clock::duration model_load{};
+	/// includes creating the delegates
+	std::chrono::steady_clock::duration interpreter_create{};
+	std::chrono::steady_clock::duration allocate_tensors{};
+
+	[[nodiscard]] std::chrono::steady_clock::duration total() const {
+		return model_load + interpreter_create + allocate_tensors;
+	}
+};
+
 /** Helper class that wraps the tflite c api */
 class TfLiteRuntime {
 	std::vector<int8_t> model_data;
@@ -37,11 +70,22 @@ class TfLiteRuntime {
 	/// can be null if GPU delegates are not supported on this device
 	std::unique_ptr<TfLiteDelegate, decltype(&TfLiteGpuDelegateV2Delete)>
 		gpu_delegate{nullptr, TfLiteGpuDelegateV2Delete};
+#if !EYE_AI_CORE_USE_PREBUILT_TFLITE
+	/// only set if TfLiteRuntimeOptions::use_xnnpack is enabled
+	std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+		xnnpack_delegate{nullptr, TfLiteXNNPackDelegateDelete};
+#endif
 
 	TfLiteErrorReporterUserData error_reporter_user_data;
 
 	std::vector<std::unique_ptr<Operator>> input_operators;
 	std::vector<std::unique_ptr<Operator>> output_operators;
+	/// persistent state of every operator (see Operator::get_state_size),
+	/// allocated once when the tensor sizes are known
+	std::vector<std::vector<float>> input_operator_states;
+	std::vector<std::vector<float>> output_operator_states;
+
+	TfLiteRuntimeStartupTimings startup_timings;
 
   public:
 	[[nodiscard]] static tl::
@@ -53,7 +97,8 @@ class TfLiteRuntime {
 			std::vector<std::unique_ptr<Operator>>&& input_operators,
 			std::vector<std::unique_ptr<Operator>>&& output_operators,
 			TfLiteLogWarningCallback log_warning_callback,
-			TfLiteLogErrorCallback log_error_callback
+			TfLiteLogErrorCallback log_error_callback,
+			const TfLiteRuntimeOptions& options = {}
 		);
 
 	~TfLiteRuntime();
@@ -68,7 +113,81 @@ class TfLiteRuntime {
 	[[nodiscard]] std::optional<TfLiteRunInferenceError>
 	run_inference(std::span<float> input, std::span<float> output);
 
+	/// same as above, but records the end of each stage in trace
+	[[nodiscard]] std::optional<TfLiteRunInferenceError> run_inference(
+		std::span<float> input,
+		std::span<float> output,
+		FrameTrace& trace
+	);
+
+	/// for input that is already preprocessed and may be shared with other
+	/// runtimes (e.g. by ModelPipeline), it is not modified, so the runtime
+	/// must not have input operators
+	[[nodiscard]] std::optional<TfLiteRunInferenceError>
+	run_inference_preprocessed(
+		std::span<const float> input,
+		std::span<float> output,
+		FrameTrace& trace
+	);
+
+	/// runs the operators without their state (Operator::execute), so the
+	/// history of stateful operators is neither used nor updated, e.g. for
+	/// crops that are not part of the frame sequence
+	[[nodiscard]] std::optional<TfLiteRunInferenceError>
+	run_inference_without_state(
+		std::span<float> input,
+		std::span<float> output
+	);
+
+	/// cancels the inference that is running right now from any thread, it
+	/// returns TfLiteInferenceCancelledError, later inferences are not
+	/// affected, returns false if cancellation is not enabled in the options
+	/// (thread-safe)
+	bool cancel_inference() const;
+
+	/// dimensions of the first input tensor (including the batch dimension)
+	[[nodiscard]] std::vector<int> get_input_shape() const;
+	/// dimensions of the first output tensor (including the batch dimension)
+	[[nodiscard]] std::vector<int> get_output_shape() const;
+	/// number of floats expected by run_inference as input
+	[[nodiscard]] size_t get_input_element_count() const;
+	/// number of floats written by run_inference to output
+	[[nodiscard]] size_t get_output_element_count() const;
+	/// run_inference_preprocessed only works without input operators
+	[[nodiscard]] bool has_input_operators() const {
+		return !input_operators.empty();
+	}
+
+	/// forgets the history of stateful operators (e.g. temporal filters), for
+	/// example after a scene change
+	void reset_operator_states();
+
+	/// state of the output operator at index (in the order they were added),
+	/// empty for stateless operators
+	[[nodiscard]] std::span<const float>
+	get_output_operator_state(size_t index) const;
+
+	[[nodiscard]] const TfLiteRuntimeStartupTimings&
+	get_startup_timings() const {
+		return startup_timings;
+	}
+
   private:
+	[[nodiscard]] std::optional<TfLiteRunInferenceError> run_inference(
+		std::span<float> input,
+		std::span<float> output,
+		FrameTrace& trace,
+		bool use_operator_states
+	);
+
+	/// everything after the input operators
+	[[nodiscard]] std::optional<TfLiteRunInferenceError> run_preprocessed(
+		std::span<const float> input,
+		std::span<float> output,
+		FrameTrace& trace,
+		bool use_operator_states
+	);
+
 	explicit TfLiteRuntime(
 		std::vector<int8_t>&& model_data,
 		std::vector<std::unique_ptr<Operator>>&& input_operators,
@@ -80,7 +199,7 @@ class TfLiteRuntime {
 		  output_operators(std::move(output_operators)),
 		  error_reporter_user_data(error_reporter_user_data) {}
 
-	[[nodiscard]] std::optional<TfLiteInvokeInterpreterError> invoke();
+	[[nodiscard]] std::optional<TfLiteRunInferenceError> invoke();
 
 	[[nodiscard]] std::optional<TfLiteLoadInputError>
 	load_input(std::span<const float> input);
@@ -105,6 +224,16 @@ class TfLiteRuntimeBuilder {
 	TfLiteRuntimeBuilder&
 	add_output_operator(std::unique_ptr<Operator>&& output_operator);
 
+	TfLiteRuntimeBuilder& set_num_threads(int num_threads);
+
+	TfLiteRuntimeBuilder& set_use_gpu_delegate(bool use_gpu_delegate);
+
+	TfLiteRuntimeBuilder& set_use_xnnpack(bool use_xnnpack);
+
+	TfLiteRuntimeBuilder& set_batch_size(int batch_size);
+
+	TfLiteRuntimeBuilder& set_enable_cancellation(bool enable_cancellation);
+
 	/// all modified configurations of `this` will be discarded after this
 	/// method
 	[[nodiscard]] tl::
@@ -119,4 +248,5 @@ class TfLiteRuntimeBuilder {
 	std::vector<std::unique_ptr<Operator>> output_operators;
 	TfLiteLogWarningCallback log_warning_callback;
 	TfLiteLogErrorCallback log_error_callback;
+	TfLiteRuntimeOptions options;
 };
\ No newline at end of file
@@ -12,7 +12,9 @@
 #else
 #include <tensorflow/lite/c/c_api.h>
 #include <tensorflow/lite/delegates/gpu/delegate.h>
+#include <tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h>
 #endif
+#include <vector>
 
 std::string_view format_tflite_type(TfLiteType type);
 
@@ -30,6 +32,18 @@ get_tensor_quantization(const TfLiteTensor* tensor);
 		std::string_view model_token
 	);
 
+#if !EYE_AI_CORE_USE_PREBUILT_TFLITE
+[[nodiscard]] std::
+	unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+	create_xnnpack_delegate(int num_threads);
+#endif
+
+/// dimensions of the tensor, empty if the tensor has no dimensions yet
+[[nodiscard]] std::vector<int> get_tensor_shape(const TfLiteTensor* tensor);
+
+/// product of all dimensions of the tensor
+[[nodiscard]] size_t get_tensor_element_count(const TfLiteTensor* tensor);
+
 class TensorType {
   public:
 	enum Type : uint8_t { Input, Output } type;
@@ -99,6 +113,16 @@ COMBINED_ERROR(
 	QuantizationElementsMismatch,
 	AsymmetricQuantizationError
 );
+
+/// quantizes values to uint8 with the scale and zero point of quantization
+/// (only per-tensor quantization is supported)
+[[nodiscard]] std::optional<QuantizeFloatError> quantize_floats(
+	std::span<const float> values,
+	std::span<std::byte> out_quantized_values,
+	TfLiteType quantized_type,
+	const TfLiteAffineQuantization& quantization
+);
+
 COMBINED_ERROR(
 	TfLiteLoadQuantizedInputError,
 	TfLiteTensorsNotCreatedError,
@@ -135,6 +159,15 @@ COMBINED_ERROR(
 	QuantizationElementsMismatch,
 	AsymmetricQuantizationError
 );
+
+/// inverse of quantize_floats
+[[nodiscard]] std::optional<DequantizeFloatError> dequantize_to_floats(
+	std::span<const std::byte> quantized_values,
+	std::span<float> out_values,
+	TfLiteType quantized_type,
+	const TfLiteAffineQuantization& quantization
+);
+
 COMBINED_ERROR(
 	TfLiteReadQuantizedOutputError,
 	TfLiteTensorsNotCreatedError,
@@ -153,10 +186,20 @@ read_floats_from_output_tensor(
 	std::span<float> output
 );
 
+struct [[nodiscard]] TfLiteCreateModelError {
+	[[nodiscard]] static std::string to_string();
+};
+
 struct [[nodiscard]] TfLiteCreateInterpreterError {
 	[[nodiscard]] std::string to_string() const;
 };
 
+struct [[nodiscard]] TfLiteResizeInputTensorError {
+	TfLiteStatus status;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
 struct [[nodiscard]] TfLiteAllocateTensorsError {
 	TfLiteStatus status;
 
@@ -165,7 +208,9 @@ struct [[nodiscard]] TfLiteAllocateTensorsError {
 
 COMBINED_ERROR(
 	TfLiteCreateRuntimeError,
+	TfLiteCreateModelError,
 	TfLiteCreateInterpreterError,
+	TfLiteResizeInputTensorError,
 	TfLiteAllocateTensorsError
 );
 
@@ -175,10 +220,17 @@ struct [[nodiscard]] TfLiteInvokeInterpreterError {
 	[[nodiscard]] std::string to_string() const;
 };
 
+/// the inference was cancelled by TfLiteRuntime::cancel_inference, its
+/// output was not written
+struct [[nodiscard]] TfLiteInferenceCancelledError {
+	[[nodiscard]] static std::string to_string();
+};
+
 COMBINED_ERROR(
 	TfLiteRunInferenceError,
 	OperatorError,
 	TfLiteLoadInputError,
 	TfLiteInvokeInterpreterError,
+	TfLiteInferenceCancelledError,
 	TfLiteReadOutputError
 );
\ No newline at end of file
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "EyeAICore/tflite/TfLiteRuntime.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct TiledInferenceConfig {
+	/// overlap of neighbouring tiles relative to the tile size, the tiles are
+	/// feathered over the overlap
+	float overlap_fraction = 0.25f;
+};
+
+struct [[nodiscard]] InvalidTiledInferenceConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+COMBINED_ERROR(
+	TiledInferenceError,
+	ImageBufferSizeMismatch,
+	TfLiteRunInferenceError
+);
+
+/**
+ * Depth of images larger than the model input: the image is split into
+ * overlapping tiles of the model input size, which are inferred at full
+ * resolution, as many per inference as the batch size of the runtime allows.
+ * Relative depth has an arbitrary scale and shift per inference, so the whole
+ * image is also inferred once downscaled and every tile is aligned to this
+ * reference by least squares before it is feathered into the output. Only the
+ * output and tensors of the batch size are allocated, the feather weights are
+ * separable and normalized with per column and per row sums.
+ */
+class TiledDepthInference {
+  public:
+	/// runtime needs an input of [batch, height, width, 3] and an output of
+	/// [batch, height, width] or [batch, height, width, 1], width and height
+	/// are the size of the images
+	[[nodiscard]] static tl::
+		expected<TiledDepthInference, InvalidTiledInferenceConfig>
+		create(
+			const TiledInferenceConfig& config,
+			const TfLiteRuntime& runtime,
+			int width,
+			int height
+		);
+
+	/// rgb 888 pixels in, relative inverse depth in [0, 1] at the image
+	/// resolution out, runtime has to have the shapes of the one passed to
+	/// create(), its operators run without their state
+	[[nodiscard]] std::optional<TiledInferenceError> run(
+		TfLiteRuntime& runtime,
+		std::span<const uint8_t> rgb_pixels,
+		std::span<float> out_depth
+	);
+
+	[[nodiscard]] int get_width() const { return width; }
+	[[nodiscard]] int get_height() const { return height; }
+
+	[[nodiscard]] int get_tile_count() const {
+		return static_cast<int>(tile_columns.size() * tile_rows.size());
+	}
+
+	/// model runs per image, including the downscaled reference
+	[[nodiscard]] int get_inference_count() const {
+		return (get_tile_count() + 1 + batch_size - 1) / batch_size;
+	}
+
+  private:
+	/// least squares fit of a tile to the reference
+	struct TileAlignment {
+		float scale = 0.0f;
+		float shift = 0.0f;
+	};
+
+	TiledDepthInference(
+		const TiledInferenceConfig& config,
+		int width,
+		int height,
+		int batch_size,
+		int tile_width,
+		int tile_height,
+		int tile_output_width,
+		int tile_output_height
+	);
+
+	void load_tile(
+		int tile,
+		std::span<const uint8_t> rgb_pixels,
+		std::span<float> out_values
+	) const;
+	[[nodiscard]] TileAlignment
+	align_tile(int tile, std::span<const float> tile_output) const;
+	[[nodiscard]] std::optional<ImageBufferSizeMismatch> accumulate_tile(
+		int tile,
+		std::span<const float> tile_output,
+		std::span<float> out_depth
+	);
+
+	TiledInferenceConfig config;
+	int width;
+	int height;
+	int batch_size;
+	int tile_width;
+	int tile_height;
+	int tile_output_width;
+	int tile_output_height;
+	/// left and top image coordinate of the tiles of every column and row
+	std::vector<int> tile_columns;
+	std::vector<int> tile_rows;
+	/// feather weights of one tile
+	std::vector<float> tile_column_weights;
+	std::vector<float> tile_row_weights;
+	/// sum of the feather weights of all tiles over every image column and row
+	std::vector<float> column_weight_sums;
+	std::vector<float> row_weight_sums;
+
+	std::vector<float> batch_input;
+	std::vector<float> batch_output;
+	/// depth of the downscaled image, at the tile output resolution
+	std::vector<float> reference;
+	/// tile output resized to the tile input resolution
+	std::vector<float> tile_depth;
+};
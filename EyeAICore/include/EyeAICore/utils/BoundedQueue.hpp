@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+/**
+ * Blocking multi producer / multi consumer queue with a fixed capacity, used to
+ * connect the stages of a pipeline so a fast stage can not run ahead of a slow
+ * one (thread-safe)
+ */
+template<typename T>
+class BoundedQueue {
+  public:
+	explicit BoundedQueue(size_t capacity)
+		: capacity(capacity > 0 ? capacity : 1) {}
+
+	/// blocks while the queue is full, returns false (and drops value) if the
+	/// queue was closed
+	bool push(T&& value) {
+		std::unique_lock lock(mutex);
+		if (items.size() >= capacity && !closed) {
+			full_waits++;
+			not_full.wait(lock, [this] {
+				return items.size() < capacity || closed;
+			});
+		}
+		if (closed)
+			return false;
+
+		items.push_back(std::move(value));
+		lock.unlock();
+		not_empty.notify_one();
+		return true;
+	}
+
+	/// blocks while the queue is empty, returns nullopt once the queue is
+	/// closed and all remaining items are taken
+	std::optional<T> pop() {
+		std::unique_lock lock(mutex);
+		if (items.empty() && !closed) {
+			empty_waits++;
+			not_empty.wait(lock, [this] { return !items.empty() || closed; });
+		}
+		if (items.empty())
+			return std::nullopt;
+
+		T value = std::move(items.front());
+		items.pop_front();
+		lock.unlock();
+		not_full.notify_one();
+		return value;
+	}
+
+	/// wakes up all waiting threads, further pushes fail, items that are
+	/// already queued can still be popped
+	void close() {
+		{
+			const std::lock_guard lock(mutex);
+			closed = true;
+		}
+		not_empty.notify_all();
+		not_full.notify_all();
+	}
+
+	/// how often push had to wait for a free slot (consumers are too slow)
+	[[nodiscard]] uint64_t get_full_waits() const {
+		const std::lock_guard lock(mutex);
+		return full_waits;
+	}
+
+	/// how often pop had to wait for an item (producers are too slow)
+	[[nodiscard]] uint64_t get_empty_waits() const {
+		const std::lock_guard lock(mutex);
+		return empty_waits;
+	}
+
+  private:
+	size_t capacity;
+	std::deque<T> items;
+	bool closed = false;
+	uint64_t full_waits = 0;
+	uint64_t empty_waits = 0;
+
+	mutable std::mutex mutex;
+	std::condition_variable not_empty;
+	std::condition_variable not_full;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+/// converts to ieee 754 half precision bits, rounds to nearest even, values
+/// too large for half become infinity
+[[nodiscard]] constexpr uint16_t float_to_half_bits(float value) {
+	const auto bits = std::bit_cast<uint32_t>(value);
+	const auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+	const uint32_t exponent = (bits >> 23) & 0xffu;
+	uint32_t mantissa = bits & 0x7fffffu;
+
+	// nan and infinity
+	if (exponent == 0xffu)
+		return sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u);
+
+	const int half_exponent = static_cast<int>(exponent) - 127 + 15;
+	if (half_exponent >= 31)
+		return sign | 0x7c00u;
+
+	if (half_exponent <= 0) {
+		// subnormal half or zero
+		if (half_exponent < -10)
+			return sign;
+		mantissa |= 0x800000u;
+		const auto shift = static_cast<uint32_t>(14 - half_exponent);
+		uint32_t half_mantissa = mantissa >> shift;
+		const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+		const uint32_t halfway = 1u << (shift - 1u);
+		if (remainder > halfway ||
+			(remainder == halfway && (half_mantissa & 1u) != 0))
+			half_mantissa++;
+		return sign | static_cast<uint16_t>(half_mantissa);
+	}
+
+	auto half = static_cast<uint32_t>(half_exponent << 10) | (mantissa >> 13);
+	const uint32_t remainder = mantissa & 0x1fffu;
+	// a carry into the exponent is correct, it also rounds up to infinity
+	if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u) != 0))
+		half++;
+	return sign | static_cast<uint16_t>(half);
+}
+
+/// converts ieee 754 half precision bits to float (exact)
+[[nodiscard]] constexpr float half_bits_to_float(uint16_t half) {
+	const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+	const uint32_t exponent = (half >> 10) & 0x1fu;
+	uint32_t mantissa = half & 0x3ffu;
+
+	if (exponent == 0x1fu)
+		return std::bit_cast<float>(sign | 0x7f800000u | (mantissa << 13));
+
+	if (exponent == 0) {
+		if (mantissa == 0)
+			return std::bit_cast<float>(sign);
+		// normalize the subnormal half
+		int shift = 0;
+		while ((mantissa & 0x400u) == 0) {
+			mantissa <<= 1;
+			shift++;
+		}
+		mantissa &= 0x3ffu;
+		const auto float_exponent = static_cast<uint32_t>(127 - 15 + 1 - shift);
+		return std::bit_cast<float>(
+			sign | (float_exponent << 23) | (mantissa << 13)
+		);
+	}
+
+	return std::bit_cast<float>(
+		sign | ((exponent + 127 - 15) << 23) | (mantissa << 13)
+	);
+}
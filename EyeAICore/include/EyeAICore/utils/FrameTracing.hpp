@@ -0,0 +1,131 @@
+#pragma once
+
+#include "EyeAICore/utils/MutexGuard.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/// monotonic clock, same timebase as CLOCK_MONOTONIC (System.nanoTime() on
+/// android), so camera capture timestamps can be compared against it
+using frame_clock = std::chrono::steady_clock;
+
+[[nodiscard]] constexpr frame_clock::time_point
+frame_time_from_nanos(int64_t nanos) {
+	return frame_clock::time_point(std::chrono::duration_cast<
+								   frame_clock::duration>(
+		std::chrono::nanoseconds(nanos)
+	));
+}
+
+[[nodiscard]] constexpr int64_t frame_time_to_nanos(frame_clock::time_point time
+) {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			   time.time_since_epoch()
+	)
+		.count();
+}
+
+/// timestamps of a single camera frame on its way from capture to the depth
+/// output, filled in by the different stages it passes
+struct FrameTrace {
+	uint64_t frame_id = 0;
+	frame_clock::time_point capture_time;
+	/// frame was handed over to the processing thread
+	frame_clock::time_point submit_time;
+	/// processing thread picked up the frame
+	frame_clock::time_point dequeue_time;
+	/// input operators ran and the input tensor is loaded
+	frame_clock::time_point preprocess_end_time;
+	/// interpreter invoke finished
+	frame_clock::time_point inference_end_time;
+	/// output is read and output operators ran, result is ready to be used
+	frame_clock::time_point postprocess_end_time;
+
+	[[nodiscard]] frame_clock::duration queue_wait() const {
+		return dequeue_time - submit_time;
+	}
+	[[nodiscard]] frame_clock::duration preprocess_duration() const {
+		return preprocess_end_time - dequeue_time;
+	}
+	[[nodiscard]] frame_clock::duration inference_duration() const {
+		return inference_end_time - preprocess_end_time;
+	}
+	[[nodiscard]] frame_clock::duration postprocess_duration() const {
+		return postprocess_end_time - inference_end_time;
+	}
+	/// age of the result when it became available (capture -> output)
+	[[nodiscard]] frame_clock::duration motion_to_output_latency() const {
+		return postprocess_end_time - capture_time;
+	}
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/// snapshot of the latency statistics of a FrameLatencyTracker
+struct FrameLatencyStats {
+	uint64_t submitted_frames = 0;
+	uint64_t processed_frames = 0;
+	/// frames that were replaced by a newer frame before being processed
+	uint64_t dropped_frames = 0;
+	/// averages and maxima over the most recently processed frames
+	frame_clock::duration average_latency{};
+	frame_clock::duration max_latency{};
+	frame_clock::duration average_queue_wait{};
+	std::optional<FrameTrace> last_frame;
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/**
+ * Keeps track of camera frames from capture to output. Frames get consecutive
+ * ids when submitted, every id that is skipped by the processing thread counts
+ * as a dropped frame. (thread-safe)
+ */
+class FrameLatencyTracker {
+  public:
+	/// registers a new captured frame and returns its frame id, capture times
+	/// that are in the future or implausibly old (different timebase) are
+	/// replaced by the submit time
+	uint64_t submit_frame(frame_clock::time_point capture_time);
+
+	/// starts the trace of frame_id, all frames submitted before it that were
+	/// not processed are counted as dropped
+	[[nodiscard]] FrameTrace begin_processing(
+		uint64_t frame_id,
+		frame_clock::time_point dequeue_time = frame_clock::now()
+	);
+
+	/// records a trace that went through all stages
+	void finish_processing(const FrameTrace& trace);
+
+	[[nodiscard]] FrameLatencyStats stats() const;
+
+	/// age of the newest finished result, nullopt if there is none yet
+	[[nodiscard]] std::optional<frame_clock::duration>
+	latest_result_age(frame_clock::time_point now = frame_clock::now()) const;
+
+  private:
+	static constexpr size_t HISTORY_SIZE = 64;
+
+	struct SubmittedFrame {
+		uint64_t frame_id = 0;
+		frame_clock::time_point capture_time;
+		frame_clock::time_point submit_time;
+	};
+
+	struct State {
+		uint64_t next_frame_id = 1;
+		uint64_t last_begun_frame_id = 0;
+		uint64_t processed_frames = 0;
+		uint64_t dropped_frames = 0;
+		/// ring buffer indexed by frame_id % HISTORY_SIZE
+		std::array<SubmittedFrame, HISTORY_SIZE> submitted_frames{};
+		/// ring buffer of the latest finished frames
+		std::array<FrameTrace, HISTORY_SIZE> finished_frames{};
+		std::optional<FrameTrace> last_finished_frame;
+	};
+
+	MutexGuard<State> state{State()};
+};
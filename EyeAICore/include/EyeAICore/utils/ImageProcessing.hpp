@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct [[nodiscard]] ImageBufferSizeMismatch {
+	size_t expected_size;
+	size_t actual_size;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+/// bilinearly resizes an rgb 888 image (3 bytes per pixel, row-major) and
+/// writes it as rgb hwc floats in [0, 255], the input layout of the depth
+/// models
+[[nodiscard]] std::optional<ImageBufferSizeMismatch> resize_rgb8_to_floats(
+	std::span<const uint8_t> rgb_pixels,
+	int width,
+	int height,
+	std::span<float> out_values,
+	int out_width,
+	int out_height
+);
+
+/// cell bounds and row scratch of a box downsampling from width x height to
+/// out_width x out_height, built once so the per frame calls do not allocate
+struct BoxDownsamplePlan {
+	int width = 0;
+	int height = 0;
+	int out_width = 0;
+	int out_height = 0;
+	/// output column x covers the input columns
+	/// [column_bounds[x], column_bounds[x + 1]), rows likewise
+	std::vector<int> column_bounds;
+	std::vector<int> row_bounds;
+	/// sums of one band of rows, width * channels values
+	std::vector<float> row_sums;
+
+	/// channels of the summed rows, 3 for rgb floats and 1 for argb pixels
+	[[nodiscard]] static BoxDownsamplePlan
+	create(int width, int height, int out_width, int out_height, int channels);
+};
+
+/// box filters rgb hwc floats in [0, 255] (the depth model input) down to luma
+/// in [0, 1], plan has to be created with 3 channels and the output should not
+/// be larger than the input
+[[nodiscard]] std::optional<ImageBufferSizeMismatch>
+downsample_rgb_floats_to_luma(
+	std::span<const float> rgb_values,
+	std::span<float> out_luma,
+	BoxDownsamplePlan& plan
+);
+
+/// box filters argb 8888 pixels (e.g. a camera frame) down to luma in [0, 1],
+/// plan has to be created with 1 channel and the output should not be larger
+/// than the input
+[[nodiscard]] std::optional<ImageBufferSizeMismatch> downsample_argb_to_luma(
+	std::span<const int> argb_pixels,
+	std::span<float> out_luma,
+	BoxDownsamplePlan& plan
+);
+
+/// bilinearly resizes a single channel float image (e.g. a depth map)
+[[nodiscard]] std::optional<ImageBufferSizeMismatch> resize_floats(
+	std::span<const float> values,
+	int width,
+	int height,
+	std::span<float> out_values,
+	int out_width,
+	int out_height
+);
@@ -20,4 +20,19 @@ constexpr uint8_t green_channel_from_argb_color(int color) {
 }
 constexpr uint8_t blue_channel_from_argb_color(int color) {
 	return color & 255;
-}
\ No newline at end of file
+}
+
+/// weights of rgb for luma (rec. 601)
+constexpr float LUMA_RED_WEIGHT = 0.299f;
+constexpr float LUMA_GREEN_WEIGHT = 0.587f;
+constexpr float LUMA_BLUE_WEIGHT = 0.114f;
+
+/// in the range of 0.0f to 255.0f
+constexpr float luma_from_argb_color(int color) {
+	return LUMA_RED_WEIGHT *
+			   static_cast<float>(red_channel_from_argb_color(color)) +
+		   LUMA_GREEN_WEIGHT *
+			   static_cast<float>(green_channel_from_argb_color(color)) +
+		   LUMA_BLUE_WEIGHT *
+			   static_cast<float>(blue_channel_from_argb_color(color));
+}
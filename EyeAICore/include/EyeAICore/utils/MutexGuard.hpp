@@ -49,7 +49,7 @@ class MutexGuard {
 	struct ConstScopedAccess {
 		explicit ConstScopedAccess(const T& value, std::mutex& mutex)
 			: value(value), lock(mutex) {}
-		~ConstScopedAccess() = delete;
+		~ConstScopedAccess() = default;
 
 		ConstScopedAccess(ConstScopedAccess&&) = default;
 		ConstScopedAccess(const ConstScopedAccess&) = delete;
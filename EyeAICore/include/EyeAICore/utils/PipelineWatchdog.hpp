@@ -0,0 +1,175 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/FrameTracing.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// a stage is stalled once a single piece of work takes longer than deadline
+struct PipelineStageConfig {
+	std::string name;
+	frame_clock::duration deadline = std::chrono::milliseconds(1000);
+};
+
+struct PipelineWatchdogConfig {
+	std::vector<PipelineStageConfig> stages;
+	/// the pipeline lags once a submitted frame waits longer than this
+	/// without any new result
+	frame_clock::duration result_deadline = std::chrono::milliseconds(500);
+	/// how often the monitor thread checks, events are raised at most this
+	/// long after a deadline passed
+	frame_clock::duration check_interval = std::chrono::milliseconds(5);
+};
+
+struct [[nodiscard]] InvalidPipelineWatchdogConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+enum class PipelineHealth : uint8_t {
+	Healthy,
+	/// results come too slowly, the latest one is stale
+	Lagging,
+	/// a stage did not finish its work within its deadline
+	Stalled,
+};
+
+struct PipelineWatchdogStatus {
+	PipelineHealth health = PipelineHealth::Healthy;
+	/// index of the longest overdue stage, nullopt unless stalled
+	std::optional<size_t> stalled_stage;
+	/// how long the stalled stage is busy, or how long frames wait for a
+	/// result while lagging
+	frame_clock::duration overdue_time{};
+
+	[[nodiscard]] std::string formatted(const PipelineWatchdogConfig& config
+	) const;
+};
+
+struct PipelineWatchdogStats {
+	uint64_t checks = 0;
+	uint64_t lagging_events = 0;
+	uint64_t stalled_events = 0;
+	/// longest time an event took to be raised after its deadline passed
+	frame_clock::duration max_detection_delay{};
+};
+
+/**
+ * Detects when the pipeline can not keep up, independent of the threads that
+ * do the work. Stages report heartbeats (begin_stage() / end_stage()) and
+ * the pipeline reports submitted frames and finished results, all of them
+ * are single relaxed atomic stores, so they are cheap enough for every frame.
+ *
+ * check() only reads these atomics and never waits on the pipeline, so a
+ * stage blocked in TfLiteInterpreterInvoke can not delay it. start() runs it
+ * on its own thread every check_interval and calls the event callback
+ * whenever the health changes, so an event is raised at most check_interval
+ * after a deadline passed.
+ */
+class PipelineWatchdog {
+  public:
+	/// called on the monitor thread, has to return quickly
+	using EventCallback = std::function<void(const PipelineWatchdogStatus&)>;
+
+	/// on the heap, the stages and the monitor thread keep pointers to it
+	[[nodiscard]] static tl::expected<
+		std::unique_ptr<PipelineWatchdog>, InvalidPipelineWatchdogConfig>
+	create(PipelineWatchdogConfig config);
+
+	PipelineWatchdog(const PipelineWatchdog&) = delete;
+	PipelineWatchdog& operator=(const PipelineWatchdog&) = delete;
+	~PipelineWatchdog();
+
+	/// heartbeats of a stage around a single piece of work, stages outside
+	/// the config are ignored
+	void begin_stage(
+		size_t stage, frame_clock::time_point now = frame_clock::now()
+	) noexcept;
+	void end_stage(size_t stage) noexcept;
+
+	/// a new frame entered the pipeline
+	void frame_submitted(frame_clock::time_point now = frame_clock::now());
+	/// a frame left the pipeline with its result
+	void result_ready();
+
+	/// health at now, does not change the state or raise events
+	[[nodiscard]] PipelineWatchdogStatus
+	check(frame_clock::time_point now = frame_clock::now()) const;
+
+	/// starts the monitor thread, restarts it if it is already running
+	void start(EventCallback callback);
+	/// stops the monitor thread, does nothing if it is not running
+	void stop();
+
+	/// latest status of the monitor thread
+	[[nodiscard]] PipelineWatchdogStatus get_status() const;
+	[[nodiscard]] PipelineWatchdogStats get_stats() const;
+
+	[[nodiscard]] const PipelineWatchdogConfig& get_config() const {
+		return config;
+	}
+
+  private:
+	/// nanoseconds since the frame_clock epoch, 0 if not set
+	using AtomicTime = std::atomic<int64_t>;
+
+	explicit PipelineWatchdog(PipelineWatchdogConfig config);
+
+	void
+	monitor(const std::stop_token& stop_token, const EventCallback& callback);
+
+	PipelineWatchdogConfig config;
+
+	/// start of the current work of every stage, 0 while idle
+	std::unique_ptr<AtomicTime[]> stage_busy_since;
+	/// first frame submitted after the latest result, 0 if none is waiting
+	AtomicTime waiting_since{0};
+
+	/// only locked by the monitor thread and by readers of the status, never
+	/// by the pipeline
+	mutable std::mutex status_mutex;
+	PipelineWatchdogStatus status;
+	PipelineWatchdogStats stats;
+
+	std::mutex wait_mutex;
+	/// only woken by stop()
+	std::condition_variable_any wait_condition;
+	std::jthread monitor_thread;
+};
+
+/// heartbeats of a stage for the lifetime of the scope, so early returns do
+/// not leave the stage busy, does nothing if watchdog is nullptr
+struct PipelineStageScope {
+	PipelineStageScope(PipelineWatchdog* watchdog, size_t stage) noexcept
+		: watchdog(watchdog), stage(stage) {
+		if (watchdog != nullptr)
+			watchdog->begin_stage(stage);
+	}
+	~PipelineStageScope() noexcept { end(); }
+
+	PipelineStageScope(const PipelineStageScope&) = delete;
+	PipelineStageScope(PipelineStageScope&&) = delete;
+	void operator=(const PipelineStageScope&) = delete;
+	void operator=(PipelineStageScope&&) = delete;
+
+	/// ends the stage before the scope ends
+	void end() noexcept {
+		if (watchdog != nullptr)
+			watchdog->end_stage(stage);
+		watchdog = nullptr;
+	}
+
+  private:
+	PipelineWatchdog* watchdog;
+	size_t stage;
+};
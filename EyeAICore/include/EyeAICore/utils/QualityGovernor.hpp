@@ -0,0 +1,145 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/FrameTracing.hpp"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+/// one step between quality and speed of the depth pipeline
+struct QualityLevel {
+	std::string name;
+	/// resolution of the frames handed to the depth pipeline relative to the
+	/// camera frames, in (0, 1], the model input is resized to the model size
+	/// anyway, so this only makes resizing and upsampling cheaper
+	float input_scale = 1.0f;
+	/// the depth model runs on every n-th frame, this saves power but makes
+	/// the newest result older, the governor only sees it as a worse level
+	int inference_interval = 1;
+	/// runs the quantized variant of the model instead of the float one
+	bool quantized = false;
+};
+
+struct QualityGovernorConfig {
+	/// from the best to the cheapest level
+	std::vector<QualityLevel> levels;
+	/// the newest result should not be older than this, averaged over the
+	/// camera frames, so it includes the time until the next result
+	frame_clock::duration target_result_age = std::chrono::milliseconds(200);
+	/// smoothing factor of the result age in (0, 1], higher follows faster
+	float smoothing = 0.2f;
+	/// steps to a cheaper level once the smoothed age was above the target for
+	/// this long
+	frame_clock::duration downgrade_delay = std::chrono::milliseconds(500);
+	/// steps to a better level once the smoothed age was below
+	/// upgrade_fraction * target for upgrade_delay, the gap between both
+	/// thresholds keeps a level that is just fast enough from oscillating
+	float upgrade_fraction = 0.7f;
+	frame_clock::duration upgrade_delay = std::chrono::seconds(3);
+	/// measurements right after a change still show the previous level (e.g.
+	/// while a model is switched), they are ignored for this long
+	frame_clock::duration settle_time = std::chrono::seconds(1);
+	/// every upgrade that is reverted within upgrade_delay doubles the
+	/// upgrade delay, up to this factor
+	int max_upgrade_backoff = 8;
+};
+
+struct [[nodiscard]] InvalidQualityGovernorConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+enum class QualityChangeReason : uint8_t {
+	/// results were too old, a cheaper level is used
+	OverBudget,
+	/// results were fast enough for a better level
+	UnderBudget,
+};
+
+/// a change of the quality level, kept for logging
+struct QualityDecision {
+	frame_clock::time_point time;
+	size_t from_level = 0;
+	size_t to_level = 0;
+	QualityChangeReason reason = QualityChangeReason::OverBudget;
+	frame_clock::duration smoothed_result_age{};
+
+	[[nodiscard]] std::string formatted(const QualityGovernorConfig& config
+	) const;
+};
+
+/**
+ * Trades quality for speed against a latency budget. It observes the age of
+ * the newest result (capture of its frame -> now) at every camera frame, so
+ * the gaps between results count as well as their latency, and steps through
+ * the configured levels, one level at a time: down when the smoothed age stays
+ * above the target, up when it stays well below. Thresholds, delays, a
+ * settle time after every change and a growing delay for upgrades that had to
+ * be reverted avoid oscillating between two levels. (not thread-safe)
+ */
+class QualityGovernor {
+  public:
+	[[nodiscard]] static tl::
+		expected<QualityGovernor, InvalidQualityGovernorConfig>
+		create(QualityGovernorConfig config);
+
+	/// observes the age of the newest result of tracker, call it for every
+	/// camera frame (also the ones without inference), returns the decision
+	/// if the level changed
+	std::optional<QualityDecision> observe(
+		const FrameLatencyTracker& tracker,
+		frame_clock::time_point now = frame_clock::now()
+	);
+
+	/// same as above, for a newest result that was result_age old at now
+	std::optional<QualityDecision>
+	observe(frame_clock::duration result_age, frame_clock::time_point now);
+
+	/// back to the best level, e.g. after the model was switched by hand
+	void reset();
+
+	[[nodiscard]] size_t get_level_index() const { return level; }
+	[[nodiscard]] const QualityLevel& get_level() const {
+		return config.levels[level];
+	}
+	[[nodiscard]] std::optional<frame_clock::duration>
+	get_smoothed_result_age() const {
+		return smoothed_result_age;
+	}
+	/// latest decisions, the newest last
+	[[nodiscard]] const std::deque<QualityDecision>& get_decisions() const {
+		return decisions;
+	}
+	[[nodiscard]] const QualityGovernorConfig& get_config() const {
+		return config;
+	}
+
+	[[nodiscard]] std::string formatted() const;
+
+  private:
+	static constexpr size_t MAX_DECISIONS = 16;
+
+	explicit QualityGovernor(QualityGovernorConfig config)
+		: config(std::move(config)) {}
+
+	[[nodiscard]] QualityDecision change_level(
+		size_t to_level,
+		QualityChangeReason reason,
+		frame_clock::time_point now
+	);
+
+	QualityGovernorConfig config;
+	size_t level = 0;
+	std::optional<frame_clock::duration> smoothed_result_age;
+	/// since when the smoothed age is above the target / below the upgrade
+	/// threshold
+	std::optional<frame_clock::time_point> over_budget_since;
+	std::optional<frame_clock::time_point> under_budget_since;
+	std::optional<frame_clock::time_point> last_change_time;
+	int upgrade_backoff = 1;
+	std::deque<QualityDecision> decisions;
+};
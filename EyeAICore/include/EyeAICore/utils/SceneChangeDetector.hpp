@@ -0,0 +1,95 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include "EyeAICore/utils/FrameTracing.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct SceneChangeConfig {
+	/// size of the luma thumbnail the frames are compared on
+	int thumbnail_width = 32;
+	int thumbnail_height = 24;
+	/// mean absolute luma difference (luma in [0, 1]) to the last inferred
+	/// frame below which the inference is skipped
+	float change_threshold = 0.015f;
+	/// how long after the capture of the last inferred frame its depth may
+	/// still be reused
+	frame_clock::duration max_result_age = std::chrono::milliseconds(500);
+};
+
+struct [[nodiscard]] InvalidSceneChangeConfig {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+
+struct SceneChange {
+	/// mean absolute luma difference to the last inferred frame, 1 if there
+	/// is none
+	float difference = 1.0f;
+	bool run_inference = true;
+};
+
+struct SceneChangeStats {
+	uint64_t inferred_frames = 0;
+	uint64_t skipped_frames = 0;
+	float last_difference = 1.0f;
+
+	/// fraction of the checked frames that were skipped
+	[[nodiscard]] float skip_rate() const;
+
+	[[nodiscard]] std::string formatted() const;
+};
+
+/**
+ * Cheap stage in front of the depth model that skips the inference while the
+ * camera sees the same scene. Every frame is reduced to a small box filtered
+ * luma thumbnail, which is compared against the thumbnail of the last
+ * inferred frame (not the previous one, so slow drifts add up until they
+ * trigger an inference). The depth of the last inferred frame is reused for
+ * at most max_result_age.
+ */
+class SceneChangeDetector {
+  public:
+	/// width and height of the rgb frames, has to be at least the thumbnail
+	/// size
+	[[nodiscard]] static tl::
+		expected<SceneChangeDetector, InvalidSceneChangeConfig>
+		create(const SceneChangeConfig& config, int width, int height);
+
+	/// rgb are hwc floats in [0, 255] (the depth model input before the input
+	/// operators ran), skipped frames are counted here
+	[[nodiscard]] tl::expected<SceneChange, ImageBufferSizeMismatch>
+	check(std::span<const float> rgb, frame_clock::time_point capture_time);
+
+	/// the frame of the last check() was inferred, its thumbnail becomes the
+	/// reference for the following frames
+	void mark_inferred();
+
+	/// the next frame is inferred regardless of its content, e.g. after the
+	/// depth model was recreated
+	void reset();
+
+	[[nodiscard]] const SceneChangeStats& get_stats() const { return stats; }
+	[[nodiscard]] const SceneChangeConfig& get_config() const {
+		return config;
+	}
+
+  private:
+	SceneChangeDetector(const SceneChangeConfig& config, int width, int height);
+
+	SceneChangeConfig config;
+	int width;
+	int height;
+	BoxDownsamplePlan thumbnail_plan;
+	std::vector<float> thumbnail;
+	frame_clock::time_point thumbnail_capture_time;
+	std::vector<float> reference_thumbnail;
+	std::optional<frame_clock::time_point> reference_capture_time;
+	SceneChangeStats stats;
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+/// how depth values are stored in a recorded session
+enum class DepthEncoding : uint8_t {
+	/// half precision floats, any value range
+	Float16 = 0,
+	/// values in [0, 1] quantized to 16 bit
+	UInt16 = 1,
+};
+
+/// fixed properties of a recorded session, every frame has the same sizes
+struct SessionInfo {
+	std::string model_token;
+	/// size of the rgb 888 input frames
+	int input_width = 0;
+	int input_height = 0;
+	/// size of the depth outputs
+	int depth_width = 0;
+	int depth_height = 0;
+	DepthEncoding depth_encoding = DepthEncoding::UInt16;
+	/// depth is stored as the difference to the previous frame (varint
+	/// encoded), which is a lot smaller for slowly changing scenes
+	bool depth_delta = true;
+	/// every n-th frame stores its depth without delta, 1 disables deltas
+	uint32_t keyframe_interval = 30;
+
+	[[nodiscard]] size_t input_size() const {
+		return static_cast<size_t>(input_width) *
+			   static_cast<size_t>(input_height) * 3;
+	}
+	[[nodiscard]] size_t depth_size() const {
+		return static_cast<size_t>(depth_width) *
+			   static_cast<size_t>(depth_height);
+	}
+};
+
+struct [[nodiscard]] SessionFileError {
+	std::string path;
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+struct [[nodiscard]] SessionFormatError {
+	std::string reason;
+
+	[[nodiscard]] std::string to_string() const;
+};
+struct [[nodiscard]] SessionFrameSizeMismatch {
+	const char* buffer_name;
+	size_t expected_size;
+	size_t actual_size;
+
+	[[nodiscard]] std::string to_string() const;
+};
+COMBINED_ERROR(
+	SessionRecordingError,
+	SessionFileError,
+	SessionFormatError,
+	SessionFrameSizeMismatch
+);
+
+/// single frame of a recorded session
+struct RecordedFrame {
+	uint64_t frame_index = 0;
+	/// CLOCK_MONOTONIC nanoseconds of the capture
+	int64_t capture_timestamp_nanos = 0;
+	/// rgb 888 input, points into the mapped session file
+	std::span<const uint8_t> rgb_pixels;
+	std::vector<float> depth;
+};
+
+/**
+ * Writes a recorded session: a header followed by one self-contained record
+ * per frame, so recordings can be streamed to disk and stay readable up to the
+ * last complete frame if recording stops unexpectedly. All records are 8 byte
+ * aligned so the input frames can be used directly from a memory mapping.
+ */
+class SessionRecorder {
+  public:
+	[[nodiscard]] static tl::
+		expected<std::unique_ptr<SessionRecorder>, SessionRecordingError>
+		create(const std::string& path, SessionInfo info);
+
+	~SessionRecorder();
+
+	SessionRecorder(const SessionRecorder&) = delete;
+	SessionRecorder(SessionRecorder&&) = delete;
+	SessionRecorder& operator=(const SessionRecorder&) = delete;
+	SessionRecorder& operator=(SessionRecorder&&) = delete;
+
+	/// frames are numbered in the order they are written
+	[[nodiscard]] std::optional<SessionRecordingError> write_frame(
+		int64_t capture_timestamp_nanos,
+		std::span<const uint8_t> rgb_pixels,
+		std::span<const float> depth
+	);
+
+	/// flushes and closes the file, called by the destructor otherwise
+	[[nodiscard]] std::optional<SessionRecordingError> finish();
+
+	[[nodiscard]] uint64_t get_frame_count() const { return frame_count; }
+
+  private:
+	SessionRecorder(std::FILE* file, std::string path, SessionInfo info)
+		: file(file), path(std::move(path)), info(std::move(info)) {}
+
+	[[nodiscard]] std::optional<SessionRecordingError>
+	write_bytes(std::span<const uint8_t> bytes);
+
+	std::FILE* file;
+	std::string path;
+	SessionInfo info;
+	uint64_t frame_count = 0;
+	/// encoded depth of the previous frame, reference of the delta encoding
+	std::vector<uint16_t> previous_depth_codes;
+	std::vector<uint16_t> depth_codes;
+	std::vector<uint8_t> depth_payload;
+};
+
+/**
+ * Reads a recorded session through a read-only memory mapping. Frames are
+ * decoded sequentially since delta encoded depth depends on the previous frame.
+ */
+class SessionReader {
+  public:
+	[[nodiscard]] static tl::
+		expected<std::unique_ptr<SessionReader>, SessionRecordingError>
+		open(const std::string& path);
+
+	~SessionReader();
+
+	SessionReader(const SessionReader&) = delete;
+	SessionReader(SessionReader&&) = delete;
+	SessionReader& operator=(const SessionReader&) = delete;
+	SessionReader& operator=(SessionReader&&) = delete;
+
+	[[nodiscard]] const SessionInfo& get_info() const { return info; }
+
+	/// complete frames in the file, a truncated last frame is ignored
+	[[nodiscard]] size_t get_frame_count() const {
+		return frame_offsets.size();
+	}
+
+	/// nullopt after the last frame
+	[[nodiscard]] tl::expected<std::optional<RecordedFrame>, SessionFormatError>
+	read_next_frame();
+
+	/// starts reading from the first frame again
+	void rewind();
+
+  private:
+	SessionReader(
+		const uint8_t* data,
+		size_t size,
+		SessionInfo info,
+		std::vector<size_t> frame_offsets
+	)
+		: data(data), size(size), info(std::move(info)),
+		  frame_offsets(std::move(frame_offsets)) {}
+
+	const uint8_t* data;
+	size_t size;
+	SessionInfo info;
+	/// byte offset of every complete frame record
+	std::vector<size_t> frame_offsets;
+	size_t next_frame = 0;
+	std::vector<uint16_t> depth_codes;
+};
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define EYE_AI_CORE_SIMD_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EYE_AI_CORE_SIMD_SSE2 1
+#endif
+
+/**
+ * Minimal 4 wide float vector on top of NEON (arm) or SSE2 (x86) with a
+ * scalar fallback, so the hot loops are written once for all android ABIs.
+ * Comparisons return masks with all bits set in the lanes where they are true.
+ */
+struct Float4 {
+#if EYE_AI_CORE_SIMD_NEON
+	float32x4_t value;
+
+	[[nodiscard]] static Float4 load(const float* values) {
+		return {vld1q_f32(values)};
+	}
+	[[nodiscard]] static Float4 broadcast(float value) {
+		return {vdupq_n_f32(value)};
+	}
+	void store(float* values) const { vst1q_f32(values, value); }
+
+	[[nodiscard]] friend Float4 operator+(Float4 a, Float4 b) {
+		return {vaddq_f32(a.value, b.value)};
+	}
+	[[nodiscard]] friend Float4 operator-(Float4 a, Float4 b) {
+		return {vsubq_f32(a.value, b.value)};
+	}
+	[[nodiscard]] friend Float4 operator*(Float4 a, Float4 b) {
+		return {vmulq_f32(a.value, b.value)};
+	}
+	[[nodiscard]] static Float4 min(Float4 a, Float4 b) {
+		return {vminq_f32(a.value, b.value)};
+	}
+	[[nodiscard]] static Float4 max(Float4 a, Float4 b) {
+		return {vmaxq_f32(a.value, b.value)};
+	}
+	[[nodiscard]] static Float4 abs(Float4 a) { return {vabsq_f32(a.value)}; }
+	/// 1 / a, refined from the estimate with two newton steps
+	[[nodiscard]] static Float4 reciprocal(Float4 a) {
+		float32x4_t estimate = vrecpeq_f32(a.value);
+		estimate = vmulq_f32(vrecpsq_f32(a.value, estimate), estimate);
+		return {vmulq_f32(vrecpsq_f32(a.value, estimate), estimate)};
+	}
+	/// mask of a >= b
+	[[nodiscard]] static Float4 greater_equal(Float4 a, Float4 b) {
+		return {vreinterpretq_f32_u32(vcgeq_f32(a.value, b.value))};
+	}
+	/// lanes of a where mask is set, b otherwise
+	[[nodiscard]] static Float4 select(Float4 mask, Float4 a, Float4 b) {
+		return {vbslq_f32(vreinterpretq_u32_f32(mask.value), a.value, b.value)
+		};
+	}
+	/// 1.0f in the lanes where mask is set, 0.0f otherwise
+	[[nodiscard]] static Float4 mask_to_ones(Float4 mask) {
+		return {vreinterpretq_f32_u32(vandq_u32(
+			vreinterpretq_u32_f32(mask.value),
+			vreinterpretq_u32_f32(vdupq_n_f32(1.0f))
+		))};
+	}
+
+	/// inclusive prefix sum over the lanes
+	[[nodiscard]] Float4 prefix_sum() const {
+		const float32x4_t zero = vdupq_n_f32(0.0f);
+		const float32x4_t sum1 = vaddq_f32(value, vextq_f32(zero, value, 3));
+		return {vaddq_f32(sum1, vextq_f32(zero, sum1, 2))};
+	}
+	/// last lane in all lanes
+	[[nodiscard]] Float4 broadcast_last() const {
+		return {vdupq_n_f32(vgetq_lane_f32(value, 3))};
+	}
+	/// even lanes of a and b (a0 a2 b0 b2) and odd lanes (a1 a3 b1 b3)
+	[[nodiscard]] static std::pair<Float4, Float4>
+	deinterleave(Float4 a, Float4 b) {
+		const float32x4x2_t lanes = vuzpq_f32(a.value, b.value);
+		return {{lanes.val[0]}, {lanes.val[1]}};
+	}
+	/// lanes of a and b alternating (a0 b0 a1 b1) and (a2 b2 a3 b3)
+	[[nodiscard]] static std::pair<Float4, Float4>
+	interleave(Float4 a, Float4 b) {
+		const float32x4x2_t lanes = vzipq_f32(a.value, b.value);
+		return {{lanes.val[0]}, {lanes.val[1]}};
+	}
+
+	[[nodiscard]] float horizontal_sum() const {
+		const float32x2_t pair =
+			vadd_f32(vget_low_f32(value), vget_high_f32(value));
+		return vget_lane_f32(vpadd_f32(pair, pair), 0);
+	}
+	[[nodiscard]] float horizontal_min() const {
+		const float32x2_t pair =
+			vmin_f32(vget_low_f32(value), vget_high_f32(value));
+		return vget_lane_f32(vpmin_f32(pair, pair), 0);
+	}
+	[[nodiscard]] float horizontal_max() const {
+		const float32x2_t pair =
+			vmax_f32(vget_low_f32(value), vget_high_f32(value));
+		return vget_lane_f32(vpmax_f32(pair, pair), 0);
+	}
+#elif EYE_AI_CORE_SIMD_SSE2
+	__m128 value;
+
+	[[nodiscard]] static Float4 load(const float* values) {
+		return {_mm_loadu_ps(values)};
+	}
+	[[nodiscard]] static Float4 broadcast(float value) {
+		return {_mm_set1_ps(value)};
+	}
+	void store(float* values) const { _mm_storeu_ps(values, value); }
+
+	[[nodiscard]] friend Float4 operator+(Float4 a, Float4 b) {
+		return {_mm_add_ps(a.value, b.value)};
+	}
+	[[nodiscard]] friend Float4 operator-(Float4 a, Float4 b) {
+		return {_mm_sub_ps(a.value, b.value)};
+	}
+	[[nodiscard]] friend Float4 operator*(Float4 a, Float4 b) {
+		return {_mm_mul_ps(a.value, b.value)};
+	}
+	[[nodiscard]] static Float4 min(Float4 a, Float4 b) {
+		return {_mm_min_ps(a.value, b.value)};
+	}
+	[[nodiscard]] static Float4 max(Float4 a, Float4 b) {
+		return {_mm_max_ps(a.value, b.value)};
+	}
+	[[nodiscard]] static Float4 abs(Float4 a) {
+		return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.value)};
+	}
+	/// 1 / a
+	[[nodiscard]] static Float4 reciprocal(Float4 a) {
+		return {_mm_div_ps(_mm_set1_ps(1.0f), a.value)};
+	}
+	/// mask of a >= b
+	[[nodiscard]] static Float4 greater_equal(Float4 a, Float4 b) {
+		return {_mm_cmpge_ps(a.value, b.value)};
+	}
+	/// lanes of a where mask is set, b otherwise
+	[[nodiscard]] static Float4 select(Float4 mask, Float4 a, Float4 b) {
+		return {_mm_or_ps(
+			_mm_and_ps(mask.value, a.value), _mm_andnot_ps(mask.value, b.value)
+		)};
+	}
+	/// 1.0f in the lanes where mask is set, 0.0f otherwise
+	[[nodiscard]] static Float4 mask_to_ones(Float4 mask) {
+		return {_mm_and_ps(mask.value, _mm_set1_ps(1.0f))};
+	}
+
+	/// inclusive prefix sum over the lanes
+	[[nodiscard]] Float4 prefix_sum() const {
+		const __m128 sum1 = _mm_add_ps(
+			value, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(value), 4))
+		);
+		return {_mm_add_ps(
+			sum1, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(sum1), 8))
+		)};
+	}
+	/// last lane in all lanes
+	[[nodiscard]] Float4 broadcast_last() const {
+		return {_mm_shuffle_ps(value, value, _MM_SHUFFLE(3, 3, 3, 3))};
+	}
+	/// even lanes of a and b (a0 a2 b0 b2) and odd lanes (a1 a3 b1 b3)
+	[[nodiscard]] static std::pair<Float4, Float4>
+	deinterleave(Float4 a, Float4 b) {
+		return {
+			{_mm_shuffle_ps(a.value, b.value, _MM_SHUFFLE(2, 0, 2, 0))},
+			{_mm_shuffle_ps(a.value, b.value, _MM_SHUFFLE(3, 1, 3, 1))}
+		};
+	}
+	/// lanes of a and b alternating (a0 b0 a1 b1) and (a2 b2 a3 b3)
+	[[nodiscard]] static std::pair<Float4, Float4>
+	interleave(Float4 a, Float4 b) {
+		return {
+			{_mm_unpacklo_ps(a.value, b.value)},
+			{_mm_unpackhi_ps(a.value, b.value)}
+		};
+	}
+
+	[[nodiscard]] float horizontal_sum() const {
+		const __m128 high = _mm_movehl_ps(value, value);
+		const __m128 pair = _mm_add_ps(value, high);
+		return _mm_cvtss_f32(
+			_mm_add_ss(pair, _mm_shuffle_ps(pair, pair, _MM_SHUFFLE(1, 1, 1, 1))
+			)
+		);
+	}
+	[[nodiscard]] float horizontal_min() const {
+		const __m128 high = _mm_movehl_ps(value, value);
+		const __m128 pair = _mm_min_ps(value, high);
+		return _mm_cvtss_f32(
+			_mm_min_ss(pair, _mm_shuffle_ps(pair, pair, _MM_SHUFFLE(1, 1, 1, 1))
+			)
+		);
+	}
+	[[nodiscard]] float horizontal_max() const {
+		const __m128 high = _mm_movehl_ps(value, value);
+		const __m128 pair = _mm_max_ps(value, high);
+		return _mm_cvtss_f32(
+			_mm_max_ss(pair, _mm_shuffle_ps(pair, pair, _MM_SHUFFLE(1, 1, 1, 1))
+			)
+		);
+	}
+#else
+	float value[4];
+
+	[[nodiscard]] static Float4 load(const float* values) {
+		return {{values[0], values[1], values[2], values[3]}};
+	}
+	[[nodiscard]] static Float4 broadcast(float value) {
+		return {{value, value, value, value}};
+	}
+	void store(float* values) const { std::copy_n(value, 4, values); }
+
+	template<typename F>
+	[[nodiscard]] static Float4 per_lane(Float4 a, Float4 b, F f) {
+		return {{f(a.value[0], b.value[0]), f(a.value[1], b.value[1]),
+				 f(a.value[2], b.value[2]), f(a.value[3], b.value[3])}};
+	}
+
+	[[nodiscard]] friend Float4 operator+(Float4 a, Float4 b) {
+		return per_lane(a, b, [](float x, float y) { return x + y; });
+	}
+	[[nodiscard]] friend Float4 operator-(Float4 a, Float4 b) {
+		return per_lane(a, b, [](float x, float y) { return x - y; });
+	}
+	[[nodiscard]] friend Float4 operator*(Float4 a, Float4 b) {
+		return per_lane(a, b, [](float x, float y) { return x * y; });
+	}
+	[[nodiscard]] static Float4 min(Float4 a, Float4 b) {
+		return per_lane(a, b, [](float x, float y) { return std::min(x, y); });
+	}
+	[[nodiscard]] static Float4 max(Float4 a, Float4 b) {
+		return per_lane(a, b, [](float x, float y) { return std::max(x, y); });
+	}
+	[[nodiscard]] static Float4 abs(Float4 a) {
+		return per_lane(a, a, [](float x, float) { return x < 0 ? -x : x; });
+	}
+	/// 1 / a
+	[[nodiscard]] static Float4 reciprocal(Float4 a) {
+		return per_lane(a, a, [](float x, float) { return 1.0f / x; });
+	}
+	/// mask of a >= b, the scalar fallback uses 1.0f as set lane
+	[[nodiscard]] static Float4 greater_equal(Float4 a, Float4 b) {
+		return per_lane(a, b, [](float x, float y) {
+			return x >= y ? 1.0f : 0.0f;
+		});
+	}
+	/// lanes of a where mask is set, b otherwise
+	[[nodiscard]] static Float4 select(Float4 mask, Float4 a, Float4 b) {
+		return {{mask.value[0] != 0.0f ? a.value[0] : b.value[0],
+				 mask.value[1] != 0.0f ? a.value[1] : b.value[1],
+				 mask.value[2] != 0.0f ? a.value[2] : b.value[2],
+				 mask.value[3] != 0.0f ? a.value[3] : b.value[3]}};
+	}
+	/// 1.0f in the lanes where mask is set, 0.0f otherwise
+	[[nodiscard]] static Float4 mask_to_ones(Float4 mask) { return mask; }
+
+	/// inclusive prefix sum over the lanes
+	[[nodiscard]] Float4 prefix_sum() const {
+		const float sum01 = value[0] + value[1];
+		return {{value[0], sum01, sum01 + value[2], sum01 + value[2] + value[3]}
+		};
+	}
+	/// last lane in all lanes
+	[[nodiscard]] Float4 broadcast_last() const { return broadcast(value[3]); }
+	/// even lanes of a and b (a0 a2 b0 b2) and odd lanes (a1 a3 b1 b3)
+	[[nodiscard]] static std::pair<Float4, Float4>
+	deinterleave(Float4 a, Float4 b) {
+		return {
+			{{a.value[0], a.value[2], b.value[0], b.value[2]}},
+			{{a.value[1], a.value[3], b.value[1], b.value[3]}}
+		};
+	}
+	/// lanes of a and b alternating (a0 b0 a1 b1) and (a2 b2 a3 b3)
+	[[nodiscard]] static std::pair<Float4, Float4>
+	interleave(Float4 a, Float4 b) {
+		return {
+			{{a.value[0], b.value[0], a.value[1], b.value[1]}},
+			{{a.value[2], b.value[2], a.value[3], b.value[3]}}
+		};
+	}
+
+	[[nodiscard]] float horizontal_sum() const {
+		return (value[0] + value[1]) + (value[2] + value[3]);
+	}
+	[[nodiscard]] float horizontal_min() const {
+		return std::min(
+			std::min(value[0], value[1]), std::min(value[2], value[3])
+		);
+	}
+	[[nodiscard]] float horizontal_max() const {
+		return std::max(
+			std::max(value[0], value[1]), std::max(value[2], value[3])
+		);
+	}
+#endif
+};
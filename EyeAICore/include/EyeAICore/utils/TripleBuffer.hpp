@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Hands the latest value from one writer thread to one reader thread without
+ * locks, neither side ever waits. The writer fills a back slot and publishes
+ * it by swapping it with the middle slot, the reader swaps the middle slot
+ * with its front slot when something new was published. With only two slots
+ * the writer would have to wait while the reader is still using the other
+ * one, the third slot removes that wait (e.g. for an audio callback that can
+ * not block). Values that are overwritten before the reader picks them up
+ * are skipped. (thread-safe for one writer and one reader)
+ */
+template<typename T>
+class TripleBuffer {
+  public:
+	TripleBuffer() = default;
+	explicit TripleBuffer(const T& initial_value) {
+		slots.fill(initial_value);
+	}
+
+	/// writer side, the slot to fill before publish(), it still contains an
+	/// older value
+	[[nodiscard]] T& write_slot() { return slots[back]; }
+
+	/// writer side, makes the write slot the latest value
+	void publish() {
+		const uint8_t previous =
+			middle.exchange(back | NEW_VALUE_FLAG, std::memory_order_acq_rel);
+		back = previous & INDEX_MASK;
+	}
+
+	/// reader side, switches to the latest published value if there is one,
+	/// returns true if it did
+	bool update() {
+		if ((middle.load(std::memory_order_relaxed) & NEW_VALUE_FLAG) == 0)
+			return false;
+		const uint8_t previous =
+			middle.exchange(front, std::memory_order_acq_rel);
+		front = previous & INDEX_MASK;
+		return true;
+	}
+
+	/// reader side, the value of the latest update()
+	[[nodiscard]] const T& read_slot() const { return slots[front]; }
+
+  private:
+	static constexpr uint8_t INDEX_MASK = 0b011;
+	static constexpr uint8_t NEW_VALUE_FLAG = 0b100;
+
+	std::array<T, 3> slots{};
+	/// index of the writer slot, only used by the writer
+	uint8_t back = 0;
+	/// index of the middle slot, with NEW_VALUE_FLAG if it was published but
+	/// not read yet
+	std::atomic<uint8_t> middle{1};
+	/// index of the reader slot, only used by the reader
+	uint8_t front = 2;
+};
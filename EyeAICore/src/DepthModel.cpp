@@ -1,6 +1,16 @@
 #include "EyeAICore/DepthModel.hpp"
 #include "EyeAICore/Operators.hpp"
 #include "EyeAICore/tflite/TfLiteRuntime.hpp"
+#include <format>
+
+std::string CascadeModelMismatchError::to_string() const {
+	return std::format(
+		"Cascade models do not match: fast model has {} input and {} output "
+		"values, refined model has {} input and {} output values",
+		fast_input_size, fast_output_size, refined_input_size,
+		refined_output_size
+	);
+}
 
 tl::expected<std::unique_ptr<DepthModel>, TfLiteCreateRuntimeError>
 DepthModel::create(
@@ -10,13 +20,21 @@ DepthModel::create(
 	TfLiteLogWarningCallback log_warning_callback,
 	TfLiteLogErrorCallback log_error_callback
 ) {
+	// normalizing with a smoothed range keeps the aligned depth consistent
+	auto min_max = std::make_unique<MinMaxOperator>();
+	min_max->range_alpha = 0.2f;
+
+	// keep ALIGN_OPERATOR_INDEX in sync with the order of output operators
 	auto runtime_result =
 		TfLiteRuntimeBuilder(
 			std::move(model_data), gpu_delegate_serialization_dir, model_token,
 			log_warning_callback, log_error_callback
 		)
 			.add_input_operator(std::make_unique<RgbNormalizeOperator>())
-			.add_output_operator(std::make_unique<MinMaxOperator>())
+			.add_output_operator(std::make_unique<ScaleShiftAlignOperator>())
+			.add_output_operator(std::move(min_max))
+			.add_output_operator(std::make_unique<TemporalFilterOperator>())
+			.set_enable_cancellation(true)
 			.build();
 	if (!runtime_result.has_value())
 		return tl::unexpected(runtime_result.error());
@@ -24,7 +42,147 @@ DepthModel::create(
 	return std::make_unique<DepthModel>(std::move(runtime_result.value()));
 }
 
+tl::expected<std::unique_ptr<DepthModel>, CreateCascadeDepthModelError>
+DepthModel::create_cascade(
+	std::vector<int8_t>&& fast_model_data,
+	std::vector<int8_t>&& refined_model_data,
+	std::string_view gpu_delegate_serialization_dir,
+	std::string_view fast_model_token,
+	std::string_view refined_model_token,
+	std::unique_ptr<DepthCascade>&& cascade,
+	TfLiteLogWarningCallback log_warning_callback,
+	TfLiteLogErrorCallback log_error_callback
+) {
+	auto min_max = std::make_unique<MinMaxOperator>();
+	min_max->range_alpha = 0.2f;
+
+	// same output operators as create(), the refined output is fused into the
+	// aligned fast output before it is normalized
+	auto runtime_result =
+		TfLiteRuntimeBuilder(
+			std::move(fast_model_data), gpu_delegate_serialization_dir,
+			fast_model_token, log_warning_callback, log_error_callback
+		)
+			.add_output_operator(std::make_unique<ScaleShiftAlignOperator>())
+			.add_output_operator(std::make_unique<CascadeFuseOperator>(*cascade)
+			)
+			.add_output_operator(std::move(min_max))
+			.add_output_operator(std::make_unique<TemporalFilterOperator>())
+			.set_enable_cancellation(true)
+			.build();
+	if (!runtime_result.has_value())
+		return tl::unexpected(runtime_result.error());
+
+	// the raw output is fused, so the refined model has no operators
+	auto refined_runtime_result =
+		TfLiteRuntimeBuilder(
+			std::move(refined_model_data), gpu_delegate_serialization_dir,
+			refined_model_token, log_warning_callback, log_error_callback
+		)
+			.set_enable_cancellation(true)
+			.build();
+	if (!refined_runtime_result.has_value())
+		return tl::unexpected(refined_runtime_result.error());
+
+	const auto& runtime = *runtime_result;
+	const auto& refined_runtime = *refined_runtime_result;
+	if (runtime->get_input_element_count() !=
+			refined_runtime->get_input_element_count() ||
+		runtime->get_output_element_count() !=
+			refined_runtime->get_output_element_count())
+		return tl::unexpected(CascadeModelMismatchError(
+			runtime->get_input_element_count(),
+			runtime->get_output_element_count(),
+			refined_runtime->get_input_element_count(),
+			refined_runtime->get_output_element_count()
+		));
+
+	return std::make_unique<DepthModel>(
+		std::move(runtime_result.value()),
+		std::move(refined_runtime_result.value()), std::move(cascade)
+	);
+}
+
+/// reports the invoke of runtime in run to canceller, if there is one, so a
+/// cancellation reaches the interpreter that is actually running
+template<typename Run>
+static std::optional<TfLiteRunInferenceError> run_cancellable(
+	const TfLiteRuntime& runtime,
+	StaleInferenceCanceller* canceller,
+	frame_clock::time_point capture_time,
+	Run&& run
+) {
+	if (canceller != nullptr)
+		canceller->begin_inference(runtime, capture_time);
+	auto error = run();
+	if (canceller != nullptr)
+		canceller->end_inference(
+			error &&
+			std::holds_alternative<TfLiteInferenceCancelledError>(*error)
+		);
+	return error;
+}
+
 std::optional<TfLiteRunInferenceError>
 DepthModel::run(std::span<float> input, std::span<float> output) {
-	return runtime->run_inference(input, output);
+	FrameTrace trace;
+	return run(input, output, trace);
+}
+
+std::optional<TfLiteRunInferenceError> DepthModel::run(
+	std::span<float> input,
+	std::span<float> output,
+	FrameTrace& trace,
+	StaleInferenceCanceller* canceller
+) {
+	const auto run_fast = [&] {
+		return run_cancellable(*runtime, canceller, trace.capture_time, [&] {
+			return runtime->run_inference(input, output, trace);
+		});
+	};
+	if (!cascade)
+		return run_fast();
+
+	// both models get the input normalized once
+	if (const auto error = cascade_input_operator.execute(input))
+		return *error;
+	if (const auto reason = cascade->begin_frame(get_alignment_fit())) {
+		refined_output.resize(output.size());
+		// a cancelled refined run is not fused, begin_frame does not advance
+		// the schedule, so the next frame is refined instead
+		if (const auto error = run_cancellable(
+				*refined_runtime, canceller, trace.capture_time,
+				[&] {
+					return refined_runtime->run_inference(
+						input, refined_output
+					);
+				}
+			))
+			return error;
+		cascade->set_refined(refined_output, *reason);
+	}
+	return run_fast();
+}
+
+std::optional<TfLiteRunInferenceError> DepthModel::run_without_temporal_state(
+	std::span<float> input,
+	std::span<float> output
+) {
+	if (cascade) {
+		if (const auto error = cascade_input_operator.execute(input))
+			return *error;
+	}
+	return runtime->run_inference_without_state(input, output);
+}
+
+void DepthModel::reset_temporal_state() {
+	runtime->reset_operator_states();
+	if (cascade)
+		cascade->reset();
+}
+
+std::optional<ScaleShiftFit> DepthModel::get_alignment_fit() const {
+	return ScaleShiftAlignOperator::get_fit(
+		runtime->get_output_operator_state(ALIGN_OPERATOR_INDEX)
+	);
 }
\ No newline at end of file
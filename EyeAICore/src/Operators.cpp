@@ -1,7 +1,26 @@
 #include "EyeAICore/Operators.hpp"
 #include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
+
+/// rescales values from [min, max] to [0, 1], values outside are clamped
+static void
+rescale_to_unit_range(std::span<float> values, float min, float max) {
+	const float diff = max - min;
+
+	if (diff > 0.0f) {
+		for (float& value : values) {
+			value = std::clamp((value - min) / diff, 0.0f, 1.0f);
+		}
+	} else {
+		for (float& value : values) {
+			value = 0.5f;
+		}
+	}
+}
 
 std::optional<OperatorError>
 MinMaxOperator::execute(std::span<float> values) const {
@@ -11,20 +30,38 @@ MinMaxOperator::execute(std::span<float> values) const {
 		return std::nullopt;
 
 	const auto [min_iter, max_iter] = std::ranges::minmax_element(values);
-	const float min = *min_iter;
-	const float max = *max_iter;
+	rescale_to_unit_range(values, *min_iter, *max_iter);
 
-	const float diff = max - min;
+	return std::nullopt;
+}
 
-	if (diff > 0.0f) {
-		for (float& value : values) {
-			value = (value - min) / diff;
-		}
+std::optional<OperatorError> MinMaxOperator::execute_with_state(
+	std::span<float> values,
+	std::span<float> state
+) const {
+	if (state.empty())
+		return execute(values);
+
+	PROFILE_DEPTH_SCOPE("MinMaxOperator")
+
+	if (state.size() != get_state_size(values.size()))
+		return OperatorError::fmt("Invalid state size of {}", state.size());
+	if (values.empty())
+		return std::nullopt;
+
+	const auto [min_iter, max_iter] = std::ranges::minmax_element(values);
+	float& initialized = state[0];
+	float& smoothed_min = state[1];
+	float& smoothed_max = state[2];
+	if (initialized == 0.0f) {
+		smoothed_min = *min_iter;
+		smoothed_max = *max_iter;
+		initialized = 1.0f;
 	} else {
-		for (float& value : values) {
-			value = 0.5f;
-		}
+		smoothed_min += range_alpha * (*min_iter - smoothed_min);
+		smoothed_max += range_alpha * (*max_iter - smoothed_max);
 	}
+	rescale_to_unit_range(values, smoothed_min, smoothed_max);
 
 	return std::nullopt;
 }
@@ -47,4 +84,345 @@ RgbNormalizeOperator::execute(std::span<float> values) const {
 	}
 
 	return std::nullopt;
-}
\ No newline at end of file
+}
+
+std::optional<OperatorError>
+TemporalFilterOperator::execute(std::span<float> /*values*/) const {
+	return std::nullopt;
+}
+
+std::optional<OperatorError> TemporalFilterOperator::execute_with_state(
+	std::span<float> values,
+	std::span<float> state
+) const {
+	PROFILE_DEPTH_SCOPE("TemporalFilterOperator")
+
+	if (state.size() != get_state_size(values.size()))
+		return OperatorError::fmt(
+			"Invalid state size of {} for {} values", state.size(),
+			values.size()
+		);
+
+	float& initialized = state[0];
+	const auto history = state.subspan(1);
+	if (initialized == 0.0f) {
+		std::ranges::copy(values, history.begin());
+		initialized = 1.0f;
+		return std::nullopt;
+	}
+
+	const Float4 min_alpha_vector = Float4::broadcast(min_alpha);
+	const Float4 alpha_per_change_vector = Float4::broadcast(alpha_per_change);
+	const Float4 reset_threshold_vector = Float4::broadcast(reset_threshold);
+	const Float4 one = Float4::broadcast(1.0f);
+
+	size_t i = 0;
+	for (; i + 4 <= values.size(); i += 4) {
+		const Float4 previous = Float4::load(&history[i]);
+		const Float4 change = Float4::load(&values[i]) - previous;
+		const Float4 change_magnitude = Float4::abs(change);
+		const Float4 reset =
+			Float4::greater_equal(change_magnitude, reset_threshold_vector);
+		const Float4 alpha = Float4::select(
+			reset, one,
+			Float4::min(
+				min_alpha_vector + alpha_per_change_vector * change_magnitude,
+				one
+			)
+		);
+		const Float4 filtered = previous + alpha * change;
+		filtered.store(&values[i]);
+		filtered.store(&history[i]);
+	}
+	for (; i < values.size(); i++) {
+		const float change = values[i] - history[i];
+		const float change_magnitude = std::abs(change);
+		const float alpha = change_magnitude >= reset_threshold
+								? 1.0f
+								: std::min(
+									  min_alpha +
+										  alpha_per_change * change_magnitude,
+									  1.0f
+								  );
+		history[i] += alpha * change;
+		values[i] = history[i];
+	}
+
+	return std::nullopt;
+}
+
+/// sums of a weighted least squares fit of y = scale * x + shift
+struct LinearFitSums {
+	double weight = 0.0;
+	double x = 0.0;
+	double y = 0.0;
+	double xx = 0.0;
+	double xy = 0.0;
+	double yy = 0.0;
+};
+
+/// accumulates 4 values every stride values, weight_of(x, y) returns the
+/// weight of each lane, the float vectors are flushed into doubles regularly
+/// to keep the sums precise
+template<typename WeightOf>
+static LinearFitSums accumulate_fit_sums(
+	std::span<const float> x_values,
+	std::span<const float> y_values,
+	size_t stride,
+	WeightOf weight_of
+) {
+	constexpr size_t FLUSH_INTERVAL = 64;
+
+	LinearFitSums sums;
+	size_t i = 0;
+	while (i + 4 <= x_values.size()) {
+		Float4 weight = Float4::broadcast(0.0f);
+		Float4 x = Float4::broadcast(0.0f);
+		Float4 y = Float4::broadcast(0.0f);
+		Float4 xx = Float4::broadcast(0.0f);
+		Float4 xy = Float4::broadcast(0.0f);
+		Float4 yy = Float4::broadcast(0.0f);
+		for (size_t block = 0;
+			 block < FLUSH_INTERVAL && i + 4 <= x_values.size();
+			 block++, i += stride) {
+			const Float4 x_value = Float4::load(&x_values[i]);
+			const Float4 y_value = Float4::load(&y_values[i]);
+			const Float4 lane_weight = weight_of(x_value, y_value);
+			const Float4 weighted_x = lane_weight * x_value;
+			const Float4 weighted_y = lane_weight * y_value;
+			weight = weight + lane_weight;
+			x = x + weighted_x;
+			y = y + weighted_y;
+			xx = xx + weighted_x * x_value;
+			xy = xy + weighted_x * y_value;
+			yy = yy + weighted_y * y_value;
+		}
+		sums.weight += weight.horizontal_sum();
+		sums.x += x.horizontal_sum();
+		sums.y += y.horizontal_sum();
+		sums.xx += xx.horizontal_sum();
+		sums.xy += xy.horizontal_sum();
+		sums.yy += yy.horizontal_sum();
+	}
+	return sums;
+}
+
+/// scale and shift, nullopt if x does not vary enough for a fit
+static std::optional<std::pair<double, double>>
+solve_linear_fit(const LinearFitSums& sums) {
+	if (sums.weight < 2.0)
+		return std::nullopt;
+	const double x_variance =
+		sums.xx / sums.weight - (sums.x / sums.weight) * (sums.x / sums.weight);
+	if (!(x_variance > 1e-12))
+		return std::nullopt;
+
+	const double determinant = sums.weight * sums.xx - sums.x * sums.x;
+	const double scale =
+		(sums.weight * sums.xy - sums.x * sums.y) / determinant;
+	const double shift = (sums.y - scale * sums.x) / sums.weight;
+	return std::pair(scale, shift);
+}
+
+/// value at fraction (0..1) of the sorted values, reorders values
+static float quantile(std::span<float> values, float fraction) {
+	const auto index = static_cast<size_t>(
+		fraction * static_cast<float>(values.size() - 1) + 0.5f
+	);
+	std::ranges::nth_element(values, values.begin() + index);
+	return values[index];
+}
+
+/// scale and shift from the medians and interquartile ranges of every
+/// spacing-th value, it is not skewed by up to a quarter of outliers like a
+/// least squares fit, scratch needs 2 values per sample
+static std::optional<std::pair<double, double>> robust_initial_fit(
+	std::span<const float> x_values,
+	std::span<const float> y_values,
+	size_t spacing,
+	std::span<float> scratch
+) {
+	const size_t sample_count = scratch.size() / 2;
+	const auto x_samples = scratch.first(sample_count);
+	const auto y_samples = scratch.subspan(sample_count, sample_count);
+	for (size_t i = 0; i < sample_count; i++) {
+		x_samples[i] = x_values[i * spacing];
+		y_samples[i] = y_values[i * spacing];
+	}
+	if (sample_count < 4)
+		return std::nullopt;
+
+	const float x_median = quantile(x_samples, 0.5f);
+	const float x_range =
+		quantile(x_samples, 0.75f) - quantile(x_samples, 0.25f);
+	const float y_median = quantile(y_samples, 0.5f);
+	const float y_range =
+		quantile(y_samples, 0.75f) - quantile(y_samples, 0.25f);
+	if (!(x_range > 0.0f))
+		return std::nullopt;
+
+	const double scale = static_cast<double>(y_range) / x_range;
+	return std::pair(scale, y_median - scale * x_median);
+}
+
+/// fit state layout: initialized flag, scale, shift, relative residual,
+/// inlier fraction, reset flag
+static void store_fit(std::span<float> state, const ScaleShiftFit& fit) {
+	state[0] = 1.0f;
+	state[1] = fit.scale;
+	state[2] = fit.shift;
+	state[3] = fit.relative_residual;
+	state[4] = fit.inlier_fraction;
+	state[5] = fit.reset ? 1.0f : 0.0f;
+}
+
+std::optional<ScaleShiftFit>
+ScaleShiftAlignOperator::get_fit(std::span<const float> state) {
+	if (state.size() < FIT_STATE_SIZE || state[0] == 0.0f)
+		return std::nullopt;
+	return ScaleShiftFit(state[1], state[2], state[3], state[4], state[5] != 0);
+}
+
+std::optional<OperatorError> ScaleShiftAlignOperator::align_to(
+	std::span<float> values,
+	std::span<const float> reference,
+	std::span<float> state
+) const {
+	if (reference.size() != values.size() ||
+		state.size() != get_state_size(values.size()))
+		return OperatorError::fmt(
+			"Invalid reference size of {} or state size of {} for {} values",
+			reference.size(), state.size(), values.size()
+		);
+
+	// the reference takes the place of the previous frame
+	std::ranges::copy(reference, state.begin() + FIT_STATE_SIZE);
+	store_fit(state, ScaleShiftFit());
+	return execute_with_state(values, state);
+}
+
+std::optional<OperatorError>
+ScaleShiftAlignOperator::execute(std::span<float> /*values*/) const {
+	return std::nullopt;
+}
+
+std::optional<OperatorError> ScaleShiftAlignOperator::execute_with_state(
+	std::span<float> values,
+	std::span<float> state
+) const {
+	PROFILE_DEPTH_SCOPE("ScaleShiftAlignOperator")
+
+	if (state.size() != get_state_size(values.size()))
+		return OperatorError::fmt(
+			"Invalid state size of {} for {} values", state.size(),
+			values.size()
+		);
+
+	const auto previous_values = state.subspan(FIT_STATE_SIZE, values.size());
+	const auto restart = [&] {
+		std::ranges::copy(values, previous_values.begin());
+		store_fit(state, ScaleShiftFit());
+		return std::nullopt;
+	};
+	if (state[0] == 0.0f)
+		return restart();
+
+	const size_t stride = std::max<size_t>(sample_stride, 4);
+	const auto all_samples = accumulate_fit_sums(
+		values, previous_values, stride,
+		[](Float4, Float4) { return Float4::broadcast(1.0f); }
+	);
+
+	auto fit = robust_initial_fit(
+		values, previous_values, stride * INITIAL_FIT_BLOCK_SPACING,
+		state.subspan(FIT_STATE_SIZE + values.size())
+	);
+	if (!fit)
+		return restart();
+
+	// refits only with the samples that agree with the previous fit, the
+	// threshold is a multiple of their mean absolute residual, every round
+	// tightens it as the outliers skew the fit less
+	auto inlier_samples = all_samples;
+	float threshold = std::numeric_limits<float>::infinity();
+	for (int round = 0; round < TRIM_ROUNDS; round++) {
+		const Float4 scale = Float4::broadcast(static_cast<float>(fit->first));
+		const Float4 shift = Float4::broadcast(static_cast<float>(fit->second)
+		);
+		const auto absolute_residual = [&](Float4 x, Float4 y) {
+			return Float4::abs(scale * x + shift - y);
+		};
+
+		const Float4 previous_threshold = Float4::broadcast(threshold);
+		Float4 residual_sum = Float4::broadcast(0.0f);
+		Float4 weight_sum = Float4::broadcast(0.0f);
+		for (size_t i = 0; i + 4 <= values.size(); i += stride) {
+			const Float4 residual = absolute_residual(
+				Float4::load(&values[i]), Float4::load(&previous_values[i])
+			);
+			const Float4 weight = Float4::mask_to_ones(
+				Float4::greater_equal(previous_threshold, residual)
+			);
+			residual_sum = residual_sum + weight * residual;
+			weight_sum = weight_sum + weight;
+		}
+		threshold = outlier_factor * residual_sum.horizontal_sum() /
+					std::max(weight_sum.horizontal_sum(), 1.0f);
+
+		const Float4 threshold_vector = Float4::broadcast(threshold);
+		inlier_samples = accumulate_fit_sums(
+			values, previous_values, stride,
+			[&](Float4 x, Float4 y) {
+				return Float4::mask_to_ones(Float4::greater_equal(
+					threshold_vector, absolute_residual(x, y)
+				));
+			}
+		);
+		fit = solve_linear_fit(inlier_samples);
+		if (!fit)
+			return restart();
+	}
+	const auto [scale, shift] = *fit;
+
+	const double residual_sum_of_squares =
+		scale * scale * inlier_samples.xx +
+		2.0 * scale * shift * inlier_samples.x +
+		shift * shift * inlier_samples.weight -
+		2.0 * scale * inlier_samples.xy - 2.0 * shift * inlier_samples.y +
+		inlier_samples.yy;
+	const double previous_variance =
+		all_samples.yy / all_samples.weight -
+		(all_samples.y / all_samples.weight) *
+			(all_samples.y / all_samples.weight);
+	const auto relative_residual = static_cast<float>(std::sqrt(
+		std::max(residual_sum_of_squares, 0.0) / inlier_samples.weight /
+		std::max(previous_variance, 1e-12)
+	));
+	if (!(scale > 0.0) || !(relative_residual <= max_relative_residual))
+		return restart();
+
+	const Float4 scale_vector = Float4::broadcast(static_cast<float>(scale));
+	const Float4 shift_vector = Float4::broadcast(static_cast<float>(shift));
+	size_t i = 0;
+	for (; i + 4 <= values.size(); i += 4) {
+		const Float4 aligned =
+			scale_vector * Float4::load(&values[i]) + shift_vector;
+		aligned.store(&values[i]);
+		aligned.store(&previous_values[i]);
+	}
+	for (; i < values.size(); i++) {
+		values[i] = static_cast<float>(scale) * values[i] +
+					static_cast<float>(shift);
+		previous_values[i] = values[i];
+	}
+
+	const auto inlier_fraction =
+		static_cast<float>(inlier_samples.weight / all_samples.weight);
+	store_fit(
+		state, ScaleShiftFit(
+				   static_cast<float>(scale), static_cast<float>(shift),
+				   relative_residual, inlier_fraction, false
+			   )
+	);
+	return std::nullopt;
+}
@@ -0,0 +1,329 @@
+#include "EyeAICore/audio/SpatialAudio.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <format>
+#include <numbers>
+
+/// part of a pulse period that is audible, the rest is silence
+constexpr float PULSE_DUTY_CYCLE = 0.35f;
+
+/// voices with lower gains are not rendered
+constexpr float SILENT_GAIN = 1e-4f;
+
+static float radians(float degrees) {
+	return degrees * std::numbers::pi_v<float> / 180.0f;
+}
+
+/// phase increment per sample of a frequency, in 1 / 2^32 of a period
+static uint32_t phase_step_of(float frequency, int sample_rate) {
+	return static_cast<uint32_t>(
+		std::llround(static_cast<double>(frequency) / sample_rate * 0x1p32)
+	);
+}
+
+std::string InvalidSpatialAudioConfig::to_string() const {
+	return std::format("Invalid spatial audio config: {}", reason);
+}
+
+std::string InvalidAudioBlock::to_string() const {
+	return std::format(
+		"Invalid audio block of {} samples, has to be interleaved stereo of at "
+		"most {} frames",
+		sample_count, max_frames
+	);
+}
+
+tl::expected<SpatialAudioSynth, InvalidSpatialAudioConfig>
+SpatialAudioSynth::create(const SpatialAudioConfig& config) {
+	if (config.sample_rate <= 0 || config.max_block_frames <= 0)
+		return tl::unexpected(InvalidSpatialAudioConfig(
+			"sample rate and max block frames have to be positive"
+		));
+	if (config.voices <= 0 || config.voices > MAX_SPATIAL_AUDIO_VOICES)
+		return tl::unexpected(InvalidSpatialAudioConfig(std::format(
+			"voices have to be in [1, {}]", MAX_SPATIAL_AUDIO_VOICES
+		)));
+	if (config.wavetable_size < 4 ||
+		!std::has_single_bit(static_cast<unsigned>(config.wavetable_size)))
+		return tl::unexpected(InvalidSpatialAudioConfig(
+			"wavetable size has to be a power of 2 of at least 4"
+		));
+	const auto nyquist = static_cast<float>(config.sample_rate) / 2.0f;
+	if (config.min_frequency <= 0.0f ||
+		config.max_frequency < config.min_frequency ||
+		config.max_frequency >= nyquist)
+		return tl::unexpected(InvalidSpatialAudioConfig(
+			"frequencies have to be ordered, positive and below nyquist"
+		));
+	if (config.min_pulse_rate <= 0.0f ||
+		config.max_pulse_rate < config.min_pulse_rate ||
+		config.max_pulse_rate >= nyquist)
+		return tl::unexpected(InvalidSpatialAudioConfig(
+			"pulse rates have to be ordered, positive and below nyquist"
+		));
+	if (config.max_interaural_delay_seconds < 0.0f ||
+		config.smoothing_seconds < 0.0f || config.master_gain < 0.0f)
+		return tl::unexpected(InvalidSpatialAudioConfig(
+			"interaural delay, smoothing and master gain can not be negative"
+		));
+
+	return SpatialAudioSynth(config);
+}
+
+SpatialAudioSynth::SpatialAudioSynth(const SpatialAudioConfig& config)
+	: config(config), wavetable_bits(std::countr_zero(
+						  static_cast<unsigned>(config.wavetable_size)
+					  )) {
+	const auto table_size = static_cast<size_t>(config.wavetable_size);
+	tone_table.resize(table_size + 1);
+	pulse_table.resize(table_size + 1);
+	for (size_t i = 0; i < table_size; i++) {
+		const float x =
+			static_cast<float>(i) / static_cast<float>(config.wavetable_size);
+		const float angle = 2.0f * std::numbers::pi_v<float> * x;
+		// a few harmonics, pure sines are hard to localize
+		tone_table[i] = (std::sin(angle) + 0.3f * std::sin(2.0f * angle) +
+						 0.15f * std::sin(3.0f * angle)) /
+						1.3f;
+		// smooth raised cosine pulse followed by silence
+		const float pulse_angle = angle / PULSE_DUTY_CYCLE;
+		pulse_table[i] =
+			x < PULSE_DUTY_CYCLE ? 0.5f - 0.5f * std::cos(pulse_angle) : 0.0f;
+	}
+	tone_table[table_size] = tone_table[0];
+	pulse_table[table_size] = pulse_table[0];
+
+	cue_buffer = std::make_unique<TripleBuffer<AudioCueSet>>();
+	voices.resize(static_cast<size_t>(config.voices));
+	const auto max_frames = static_cast<size_t>(config.max_block_frames);
+	near_ear_block.resize(max_frames);
+	far_ear_block.resize(max_frames);
+	left_mix.resize(max_frames);
+	right_mix.resize(max_frames);
+}
+
+void SpatialAudioSynth::set_cues(std::span<const AudioCue> cues) {
+	AudioCueSet& cue_set = cue_buffer->write_slot();
+	cue_set.count = static_cast<int>(
+		std::min(cues.size(), static_cast<size_t>(config.voices))
+	);
+	std::copy_n(cues.begin(), cue_set.count, cue_set.cues.begin());
+	cue_buffer->publish();
+}
+
+SpatialAudioSynth::VoiceTarget SpatialAudioSynth::target_of(const AudioCue& cue
+) const {
+	const float nearness = std::clamp(cue.nearness, 0.0f, 1.0f);
+	const float gain =
+		std::clamp(cue.gain, 0.0f, 1.0f) * (0.25f + 0.75f * nearness);
+	const float side =
+		std::sin(radians(std::clamp(cue.azimuth_degrees, -90.0f, 90.0f)));
+	// constant power panning
+	const float pan_angle = (side + 1.0f) * std::numbers::pi_v<float> / 4.0f;
+
+	const float frequency =
+		config.min_frequency *
+		std::pow(config.max_frequency / config.min_frequency, nearness);
+	const float pulse_rate =
+		config.min_pulse_rate +
+		(config.max_pulse_rate - config.min_pulse_rate) * nearness;
+
+	VoiceTarget target;
+	target.left_gain = gain * std::cos(pan_angle);
+	target.right_gain = gain * std::sin(pan_angle);
+	target.phase_step = phase_step_of(frequency, config.sample_rate);
+	target.pulse_phase_step = phase_step_of(pulse_rate, config.sample_rate);
+	target.delay_samples = std::abs(side) *
+						   config.max_interaural_delay_seconds *
+						   static_cast<float>(config.sample_rate);
+	target.left_delayed = side > 0.0f;
+	return target;
+}
+
+void SpatialAudioSynth::apply_cues(const AudioCueSet& cue_set) {
+	const auto cues = std::span(cue_set.cues).first(
+		static_cast<size_t>(cue_set.count)
+	);
+
+	// voices whose cue is gone fade out
+	for (Voice& voice : voices) {
+		const bool kept = std::ranges::any_of(cues, [&](const AudioCue& cue) {
+			return cue.id == voice.cue_id;
+		});
+		if (!kept) {
+			voice.cue_id = 0;
+			voice.target.left_gain = 0.0f;
+			voice.target.right_gain = 0.0f;
+		}
+	}
+
+	for (const AudioCue& cue : cues) {
+		if (cue.id == 0)
+			continue;
+		auto voice = std::ranges::find(voices, cue.id, &Voice::cue_id);
+		// new cues take the quietest free voice, voices of cues that are gone
+		// are still fading out
+		if (voice == voices.end()) {
+			for (auto free_voice = voices.begin(); free_voice != voices.end();
+				 free_voice++) {
+				if (free_voice->cue_id == 0 &&
+					(voice == voices.end() ||
+					 free_voice->left_gain + free_voice->right_gain <
+						 voice->left_gain + voice->right_gain))
+					voice = free_voice;
+			}
+			if (voice == voices.end())
+				continue;
+			voice->cue_id = cue.id;
+		}
+		voice->target = target_of(cue);
+	}
+}
+
+float SpatialAudioSynth::lookup(const std::vector<float>& table, uint32_t phase)
+	const {
+	const uint32_t index = phase >> (32 - wavetable_bits);
+	const uint32_t fraction_bits = phase << wavetable_bits;
+	const float fraction = static_cast<float>(fraction_bits) * 0x1p-32f;
+	const float a = table[index];
+	const float b = table[index + 1];
+	return a + (b - a) * fraction;
+}
+
+void SpatialAudioSynth::render_voice(Voice& voice, size_t frames) {
+	const float smoothing_samples = std::max(
+		config.smoothing_seconds * static_cast<float>(config.sample_rate), 1.0f
+	);
+	const float smoothing =
+		1.0f - std::exp(-static_cast<float>(frames) / smoothing_samples);
+	const float next_left_gain =
+		voice.left_gain +
+		smoothing * (voice.target.left_gain - voice.left_gain);
+	const float next_right_gain =
+		voice.right_gain +
+		smoothing * (voice.target.right_gain - voice.right_gain);
+	voice.delay_samples +=
+		smoothing * (voice.target.delay_samples - voice.delay_samples);
+
+	if (std::max(voice.left_gain, voice.right_gain) < SILENT_GAIN &&
+		std::max(next_left_gain, next_right_gain) < SILENT_GAIN) {
+		voice.left_gain = next_left_gain;
+		voice.right_gain = next_right_gain;
+		return;
+	}
+
+	// the interaural delay as phase offsets of the ear facing away
+	const uint32_t phase_step = voice.target.phase_step;
+	const uint32_t pulse_phase_step = voice.target.pulse_phase_step;
+	const auto phase_delay = static_cast<uint32_t>(
+		static_cast<double>(voice.delay_samples) * phase_step
+	);
+	const auto pulse_phase_delay = static_cast<uint32_t>(
+		static_cast<double>(voice.delay_samples) * pulse_phase_step
+	);
+	uint32_t phase = voice.phase;
+	uint32_t pulse_phase = voice.pulse_phase;
+	for (size_t i = 0; i < frames; i++) {
+		near_ear_block[i] =
+			lookup(tone_table, phase) * lookup(pulse_table, pulse_phase);
+		far_ear_block[i] = lookup(tone_table, phase - phase_delay) *
+						   lookup(pulse_table, pulse_phase - pulse_phase_delay);
+		phase += phase_step;
+		pulse_phase += pulse_phase_step;
+	}
+	voice.phase = phase;
+	voice.pulse_phase = pulse_phase;
+
+	const float* left_block = voice.target.left_delayed ? far_ear_block.data()
+														: near_ear_block.data();
+	const float* right_block = voice.target.left_delayed
+								   ? near_ear_block.data()
+								   : far_ear_block.data();
+	// gains ramp linearly over the block
+	const float frame_count = static_cast<float>(frames);
+	const float left_slope = (next_left_gain - voice.left_gain) / frame_count;
+	const float right_slope =
+		(next_right_gain - voice.right_gain) / frame_count;
+	constexpr std::array<float, 4> LANE_OFFSETS = {0.0f, 1.0f, 2.0f, 3.0f};
+	const Float4 lane_offsets = Float4::load(LANE_OFFSETS.data());
+	Float4 left_gain = Float4::broadcast(voice.left_gain) +
+					   Float4::broadcast(left_slope) * lane_offsets;
+	Float4 right_gain = Float4::broadcast(voice.right_gain) +
+						Float4::broadcast(right_slope) * lane_offsets;
+	const Float4 left_step = Float4::broadcast(4.0f * left_slope);
+	const Float4 right_step = Float4::broadcast(4.0f * right_slope);
+	size_t i = 0;
+	for (; i + 4 <= frames; i += 4) {
+		const Float4 left = Float4::load(left_mix.data() + i) +
+							Float4::load(left_block + i) * left_gain;
+		const Float4 right = Float4::load(right_mix.data() + i) +
+							 Float4::load(right_block + i) * right_gain;
+		left.store(left_mix.data() + i);
+		right.store(right_mix.data() + i);
+		left_gain = left_gain + left_step;
+		right_gain = right_gain + right_step;
+	}
+	for (; i < frames; i++) {
+		const auto offset = static_cast<float>(i);
+		left_mix[i] += left_block[i] * (voice.left_gain + left_slope * offset);
+		right_mix[i] +=
+			right_block[i] * (voice.right_gain + right_slope * offset);
+	}
+
+	voice.left_gain = next_left_gain;
+	voice.right_gain = next_right_gain;
+}
+
+std::optional<InvalidAudioBlock>
+SpatialAudioSynth::render(std::span<float> stereo_samples) {
+	// no profiling scope, it is not real time safe
+	const size_t frames = stereo_samples.size() / 2;
+	if (stereo_samples.size() % 2 != 0 ||
+		frames > static_cast<size_t>(config.max_block_frames))
+		return InvalidAudioBlock(
+			static_cast<size_t>(config.max_block_frames), stereo_samples.size()
+		);
+	if (frames == 0)
+		return std::nullopt;
+
+	if (cue_buffer->update())
+		apply_cues(cue_buffer->read_slot());
+
+	std::fill_n(left_mix.begin(), frames, 0.0f);
+	std::fill_n(right_mix.begin(), frames, 0.0f);
+	for (Voice& voice : voices)
+		render_voice(voice, frames);
+
+	const Float4 master_gain = Float4::broadcast(config.master_gain);
+	const Float4 lower_limit = Float4::broadcast(-1.0f);
+	const Float4 upper_limit = Float4::broadcast(1.0f);
+	float* out = stereo_samples.data();
+	size_t i = 0;
+	for (; i + 4 <= frames; i += 4) {
+		const Float4 left = Float4::min(
+			Float4::max(
+				Float4::load(left_mix.data() + i) * master_gain, lower_limit
+			),
+			upper_limit
+		);
+		const Float4 right = Float4::min(
+			Float4::max(
+				Float4::load(right_mix.data() + i) * master_gain, lower_limit
+			),
+			upper_limit
+		);
+		const auto [first, second] = Float4::interleave(left, right);
+		first.store(out + 2 * i);
+		second.store(out + 2 * i + 4);
+	}
+	for (; i < frames; i++) {
+		out[2 * i] =
+			std::clamp(left_mix[i] * config.master_gain, -1.0f, 1.0f);
+		out[2 * i + 1] =
+			std::clamp(right_mix[i] * config.master_gain, -1.0f, 1.0f);
+	}
+	return std::nullopt;
+}
@@ -0,0 +1,111 @@
+#include "EyeAICore/depth/DepthCascade.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include <algorithm>
+#include <format>
+
+std::string InvalidDepthCascadeConfig::to_string() const {
+	return std::format("Invalid depth cascade config: {}", reason);
+}
+
+std::string DepthCascadeStats::formatted() const {
+	const auto formatted_fit =
+		refined_fit && !refined_fit->reset
+			? std::format(
+				  ", refined fit residual {:.1f}%",
+				  refined_fit->relative_residual * 100.0f
+			  )
+			: std::string();
+	return std::format(
+		"Depth cascade: {} fast, {} refined ({} uncertain, {} rejected){}",
+		fast_frames, refined_frames, uncertain_refinements,
+		rejected_refinements, formatted_fit
+	);
+}
+
+tl::expected<std::unique_ptr<DepthCascade>, InvalidDepthCascadeConfig>
+DepthCascade::create(const DepthCascadeConfig& config) {
+	if (config.min_refine_interval < 1)
+		return tl::unexpected(InvalidDepthCascadeConfig(
+			"min refine interval has to be at least 1"
+		));
+	if (config.refine_interval < config.min_refine_interval)
+		return tl::unexpected(InvalidDepthCascadeConfig(
+			"refine interval must not be smaller than the min refine interval"
+		));
+	if (!(config.uncertainty_threshold > 0.0f))
+		return tl::unexpected(
+			InvalidDepthCascadeConfig("uncertainty threshold has to be positive"
+			)
+		);
+
+	return std::unique_ptr<DepthCascade>(new DepthCascade(config));
+}
+
+std::optional<CascadeRefineReason>
+DepthCascade::begin_frame(const std::optional<ScaleShiftFit>& fast_alignment
+) const {
+	if (!frames_since_refined)
+		return CascadeRefineReason::FirstFrame;
+	const int frames = *frames_since_refined + 1;
+	if (frames < config.min_refine_interval)
+		return std::nullopt;
+	if (frames >= config.refine_interval)
+		return CascadeRefineReason::Scheduled;
+	if (!fast_alignment || fast_alignment->reset ||
+		fast_alignment->relative_residual > config.uncertainty_threshold)
+		return CascadeRefineReason::Uncertain;
+	return std::nullopt;
+}
+
+void DepthCascade::set_refined(
+	std::span<const float> refined,
+	CascadeRefineReason reason
+) {
+	pending_refined.assign(refined.begin(), refined.end());
+	pending_reason = reason;
+}
+
+std::optional<OperatorError> DepthCascade::fuse(std::span<float> depth) {
+	PROFILE_DEPTH_FUNCTION()
+
+	// fast frames stay as they are
+	if (!pending_reason) {
+		stats.fast_frames++;
+		if (frames_since_refined)
+			(*frames_since_refined)++;
+		return std::nullopt;
+	}
+
+	const auto reason = *pending_reason;
+	pending_reason.reset();
+	// also when the refined output is rejected, so the refined model does not
+	// run on every frame while both models disagree
+	frames_since_refined = 0;
+	stats.refined_frames++;
+	if (reason == CascadeRefineReason::Uncertain)
+		stats.uncertain_refinements++;
+
+	if (pending_refined.size() != depth.size())
+		return OperatorError::fmt(
+			"Refined output of {} values for {} depth values",
+			pending_refined.size(), depth.size()
+		);
+	align_state.resize(aligner.get_state_size(depth.size()));
+	if (const auto error =
+			aligner.align_to(pending_refined, depth, align_state))
+		return error;
+	stats.refined_fit = ScaleShiftAlignOperator::get_fit(align_state);
+	if (!stats.refined_fit || stats.refined_fit->reset) {
+		// the fast output stays as it is
+		stats.rejected_refinements++;
+		return std::nullopt;
+	}
+
+	std::ranges::copy(pending_refined, depth.begin());
+	return std::nullopt;
+}
+
+void DepthCascade::reset() {
+	pending_reason.reset();
+	frames_since_refined.reset();
+}
@@ -0,0 +1,375 @@
+#include "EyeAICore/depth/DepthPropagation.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <limits>
+
+std::string InvalidDepthPropagationConfig::to_string() const {
+	return std::format("Invalid depth propagation config: {}", reason);
+}
+
+std::string DepthPropagationStats::formatted() const {
+	const uint64_t frames = keyframes + propagated_frames;
+	return std::format(
+		"Keyframes: {} of {} frames, motion: {:.1f} px, match error: {:.3f}",
+		keyframes, frames, mean_motion, match_error
+	);
+}
+
+tl::expected<DepthPropagator, InvalidDepthPropagationConfig>
+DepthPropagator::create(
+	const DepthPropagationConfig& config,
+	int input_width,
+	int input_height,
+	int depth_width,
+	int depth_height
+) {
+	if (config.luma_downscale < 1 || config.block_size < 1)
+		return tl::unexpected(InvalidDepthPropagationConfig(
+			"luma downscale and block size have to be positive"
+		));
+	if (config.search_radius < 0 || config.max_propagated_frames < 0)
+		return tl::unexpected(InvalidDepthPropagationConfig(
+			"search radius and max propagated frames must not be negative"
+		));
+	if (depth_width <= 0 || depth_height <= 0)
+		return tl::unexpected(
+			InvalidDepthPropagationConfig("depth size has to be positive")
+		);
+	if (input_width / config.luma_downscale < config.block_size ||
+		input_height / config.luma_downscale < config.block_size) {
+		return tl::unexpected(InvalidDepthPropagationConfig(std::format(
+			"input size {}x{} is too small for {}x downscaled blocks of {}",
+			input_width, input_height, config.luma_downscale, config.block_size
+		)));
+	}
+
+	return DepthPropagator(
+		config, input_width, input_height, depth_width, depth_height
+	);
+}
+
+DepthPropagator::DepthPropagator(
+	const DepthPropagationConfig& config,
+	int input_width,
+	int input_height,
+	int depth_width,
+	int depth_height
+)
+	: config(config), input_width(input_width), input_height(input_height),
+	  depth_width(depth_width), depth_height(depth_height),
+	  luma_width(input_width / config.luma_downscale),
+	  luma_height(input_height / config.luma_downscale),
+	  block_columns(luma_width / config.block_size),
+	  block_rows(luma_height / config.block_size),
+	  luma_plan(BoxDownsamplePlan::create(
+		  input_width, input_height, luma_width, luma_height, 3
+	  )),
+	  luma(static_cast<size_t>(luma_width) * luma_height),
+	  keyframe_luma(luma.size()),
+	  keyframe_depth(static_cast<size_t>(depth_width) * depth_height),
+	  motion(static_cast<size_t>(block_columns) * block_rows),
+	  column_samples(compute_block_samples(
+		  depth_width, luma_width, config.block_size, block_columns
+	  )),
+	  row_samples(compute_block_samples(
+		  depth_height, luma_height, config.block_size, block_rows
+	  )),
+	  row_motion_x(static_cast<size_t>(block_columns)),
+	  row_motion_y(static_cast<size_t>(block_columns)) {}
+
+std::optional<ImageBufferSizeMismatch>
+DepthPropagator::begin_frame(std::span<const float> rgb) {
+	return downsample_rgb_floats_to_luma(rgb, luma, luma_plan);
+}
+
+bool DepthPropagator::needs_keyframe() const {
+	if (!has_keyframe ||
+		frames_since_keyframe >= config.max_propagated_frames ||
+		match_error > config.max_match_error)
+		return true;
+	if (frames_since_keyframe == 0)
+		return false;
+
+	// assumes the motion continues with the same speed
+	const float next_mean_motion =
+		mean_motion + mean_motion / static_cast<float>(frames_since_keyframe);
+	return next_mean_motion > config.max_mean_motion;
+}
+
+std::optional<ImageBufferSizeMismatch>
+DepthPropagator::set_keyframe(std::span<const float> depth) {
+	if (depth.size() != keyframe_depth.size())
+		return ImageBufferSizeMismatch(keyframe_depth.size(), depth.size());
+
+	std::ranges::copy(depth, keyframe_depth.begin());
+	std::swap(keyframe_luma, luma);
+	std::ranges::fill(motion, MotionVector());
+	has_keyframe = true;
+	frames_since_keyframe = 0;
+	mean_motion = 0.0f;
+	match_error = 0.0f;
+	stats.keyframes++;
+	return std::nullopt;
+}
+
+std::optional<ImageBufferSizeMismatch>
+DepthPropagator::propagate(std::span<float> out_depth) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (out_depth.size() != keyframe_depth.size())
+		return ImageBufferSizeMismatch(keyframe_depth.size(), out_depth.size());
+	if (!has_keyframe)
+		return std::nullopt;
+
+	estimate_motion();
+	frames_since_keyframe++;
+	warp_keyframe_depth(out_depth);
+
+	stats.propagated_frames++;
+	stats.mean_motion = mean_motion;
+	stats.match_error = match_error;
+	return std::nullopt;
+}
+
+void DepthPropagator::reset() {
+	has_keyframe = false;
+	frames_since_keyframe = 0;
+}
+
+/// sum of absolute differences of two size x size blocks
+static float block_sad(
+	const float* a,
+	const float* b,
+	size_t row_stride,
+	size_t size
+) {
+	Float4 sum = Float4::broadcast(0.0f);
+	float tail_sum = 0.0f;
+	for (size_t y = 0; y < size; y++) {
+		const float* a_row = a + y * row_stride;
+		const float* b_row = b + y * row_stride;
+		size_t x = 0;
+		for (; x + 4 <= size; x += 4) {
+			sum = sum + Float4::abs(
+							Float4::load(a_row + x) - Float4::load(b_row + x)
+						);
+		}
+		for (; x < size; x++)
+			tail_sum += std::abs(a_row[x] - b_row[x]);
+	}
+	return sum.horizontal_sum() + tail_sum;
+}
+
+void DepthPropagator::estimate_motion() {
+	PROFILE_DEPTH_FUNCTION()
+
+	const int block_size = config.block_size;
+	const auto row_stride = static_cast<size_t>(luma_width);
+	// constant speed prediction from the motion of the previous frame
+	const float prediction_scale =
+		frames_since_keyframe == 0
+			? 0.0f
+			: static_cast<float>(frames_since_keyframe + 1) /
+				  static_cast<float>(frames_since_keyframe);
+
+	float motion_sum = 0.0f;
+	float sad_sum = 0.0f;
+	for (int block_y = 0; block_y < block_rows; block_y++) {
+		for (int block_x = 0; block_x < block_columns; block_x++) {
+			auto& vector =
+				motion[static_cast<size_t>(block_y) * block_columns + block_x];
+			const int origin_x = block_x * block_size;
+			const int origin_y = block_y * block_size;
+			const size_t block_offset =
+				static_cast<size_t>(origin_y) * row_stride + origin_x;
+			const float* block = &luma[block_offset];
+
+			const auto predicted_x =
+				static_cast<int>(std::lround(vector.x * prediction_scale));
+			const auto predicted_y =
+				static_cast<int>(std::lround(vector.y * prediction_scale));
+			// the matched block has to stay inside of the keyframe
+			const int min_x = std::max(
+				predicted_x - config.search_radius, -origin_x
+			);
+			const int max_x = std::min(
+				predicted_x + config.search_radius,
+				luma_width - block_size - origin_x
+			);
+			const int min_y = std::max(
+				predicted_y - config.search_radius, -origin_y
+			);
+			const int max_y = std::min(
+				predicted_y + config.search_radius,
+				luma_height - block_size - origin_y
+			);
+
+			// nullopt if the offset block is not inside of the keyframe
+			const auto sad_at =
+				[&](int offset_x, int offset_y) -> std::optional<float> {
+				if (origin_x + offset_x < 0 || origin_y + offset_y < 0 ||
+					origin_x + offset_x > luma_width - block_size ||
+					origin_y + offset_y > luma_height - block_size)
+					return std::nullopt;
+				return block_sad(
+					block,
+					&keyframe_luma
+						[block_offset +
+						 static_cast<ptrdiff_t>(offset_y) *
+							 static_cast<ptrdiff_t>(row_stride) +
+						 offset_x],
+					row_stride, static_cast<size_t>(block_size)
+				);
+			};
+
+			// the search window is empty when the prediction points far
+			// outside of the frame, zero motion is the fallback
+			int best_x = 0;
+			int best_y = 0;
+			float best_sad = *sad_at(0, 0);
+			bool found = false;
+			for (int offset_y = min_y; offset_y <= max_y; offset_y++) {
+				for (int offset_x = min_x; offset_x <= max_x; offset_x++) {
+					const float sad = *sad_at(offset_x, offset_y);
+					// prefers the smaller motion on ties, flat areas match
+					// everywhere
+					if (!found || sad < best_sad ||
+						(sad == best_sad &&
+						 std::abs(offset_x) + std::abs(offset_y) <
+							 std::abs(best_x) + std::abs(best_y))) {
+						best_sad = sad;
+						best_x = offset_x;
+						best_y = offset_y;
+						found = true;
+					}
+				}
+			}
+
+			// sub-pixel offset from a parabola through the neighbors
+			const auto refine = [&](std::optional<float> minus,
+									std::optional<float> plus) {
+				if (!minus || !plus)
+					return 0.0f;
+				const float curvature = *minus - 2.0f * best_sad + *plus;
+				if (curvature <= 0.0f)
+					return 0.0f;
+				return std::clamp(
+					0.5f * (*minus - *plus) / curvature, -0.5f, 0.5f
+				);
+			};
+			const MotionVector best(
+				static_cast<float>(best_x) + refine(
+												 sad_at(best_x - 1, best_y),
+												 sad_at(best_x + 1, best_y)
+											 ),
+				static_cast<float>(best_y) + refine(
+												 sad_at(best_x, best_y - 1),
+												 sad_at(best_x, best_y + 1)
+											 )
+			);
+
+			vector = best;
+			motion_sum += std::hypot(best.x, best.y);
+			sad_sum += best_sad;
+		}
+	}
+
+	const auto block_count = static_cast<float>(motion.size());
+	mean_motion = motion_sum / block_count;
+	match_error = sad_sum / (block_count * static_cast<float>(
+											   block_size * block_size
+										   ));
+}
+
+std::vector<DepthPropagator::BlockSample>
+DepthPropagator::compute_block_samples(
+	int depth_size,
+	int luma_size,
+	int block_size,
+	int block_count
+) {
+	std::vector<BlockSample> samples(static_cast<size_t>(depth_size));
+	const float luma_per_depth =
+		static_cast<float>(luma_size) / static_cast<float>(depth_size);
+	for (int i = 0; i < depth_size; i++) {
+		const float luma_position =
+			(static_cast<float>(i) + 0.5f) * luma_per_depth;
+		const float block_position = std::clamp(
+			luma_position / static_cast<float>(block_size) - 0.5f, 0.0f,
+			static_cast<float>(block_count - 1)
+		);
+		const auto index0 = static_cast<size_t>(block_position);
+		samples[static_cast<size_t>(i)] = BlockSample(
+			index0,
+			std::min(index0 + 1, static_cast<size_t>(block_count - 1)),
+			block_position - static_cast<float>(index0)
+		);
+	}
+	return samples;
+}
+
+void DepthPropagator::warp_keyframe_depth(std::span<float> out_depth) {
+	PROFILE_DEPTH_FUNCTION()
+	const float depth_per_luma_x =
+		static_cast<float>(depth_width) / static_cast<float>(luma_width);
+	const float depth_per_luma_y =
+		static_cast<float>(depth_height) / static_cast<float>(luma_height);
+	const auto max_x = static_cast<float>(depth_width - 1);
+	const auto max_y = static_cast<float>(depth_height - 1);
+	const auto depth_stride = static_cast<size_t>(depth_width);
+
+	for (int y = 0; y < depth_height; y++) {
+		const auto& row_sample = row_samples[static_cast<size_t>(y)];
+		for (size_t block_x = 0; block_x < row_motion_x.size(); block_x++) {
+			const auto& top =
+				motion[row_sample.index0 * row_motion_x.size() + block_x];
+			const auto& bottom =
+				motion[row_sample.index1 * row_motion_x.size() + block_x];
+			row_motion_x[block_x] =
+				(top.x + row_sample.weight * (bottom.x - top.x)) *
+				depth_per_luma_x;
+			row_motion_y[block_x] =
+				(top.y + row_sample.weight * (bottom.y - top.y)) *
+				depth_per_luma_y;
+		}
+
+		float* out_row = &out_depth[static_cast<size_t>(y) * depth_stride];
+		for (int x = 0; x < depth_width; x++) {
+			const auto& column_sample = column_samples[static_cast<size_t>(x)];
+			const size_t index0 = column_sample.index0;
+			const size_t index1 = column_sample.index1;
+			const float motion_x =
+				row_motion_x[index0] +
+				column_sample.weight *
+					(row_motion_x[index1] - row_motion_x[index0]);
+			const float motion_y =
+				row_motion_y[index0] +
+				column_sample.weight *
+					(row_motion_y[index1] - row_motion_y[index0]);
+
+			// bilinear sample of the keyframe depth at the matched position
+			const float source_x =
+				std::clamp(static_cast<float>(x) + motion_x, 0.0f, max_x);
+			const float source_y =
+				std::clamp(static_cast<float>(y) + motion_y, 0.0f, max_y);
+			// int instead of size_t, float to unsigned conversion is slow
+			const int x0 = static_cast<int>(source_x);
+			const int y0 = static_cast<int>(source_y);
+			const int x1 = std::min(x0 + 1, depth_width - 1);
+			const int y1 = std::min(y0 + 1, depth_height - 1);
+			const float weight_x = source_x - static_cast<float>(x0);
+			const float weight_y = source_y - static_cast<float>(y0);
+
+			const float* row0 =
+				&keyframe_depth[static_cast<size_t>(y0) * depth_stride];
+			const float* row1 =
+				&keyframe_depth[static_cast<size_t>(y1) * depth_stride];
+			const float top = row0[x0] + weight_x * (row0[x1] - row0[x0]);
+			const float bottom = row1[x0] + weight_x * (row1[x1] - row1[x0]);
+			out_row[x] = top + weight_y * (bottom - top);
+		}
+	}
+}
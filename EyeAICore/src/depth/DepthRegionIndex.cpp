@@ -0,0 +1,291 @@
+#include "EyeAICore/depth/DepthRegionIndex.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+
+DepthRegionIndex::DepthRegionIndex(int width, int height) :
+	width(std::max(width, 0)), height(std::max(height, 0)) {
+	summed_area_table.assign(
+		static_cast<size_t>(this->width + 1) *
+			static_cast<size_t>(this->height + 1),
+		0.0f
+	);
+
+	int level_width = this->width;
+	int level_height = this->height;
+	pyramid.emplace_back(
+		level_width, level_height,
+		std::vector<float>(static_cast<size_t>(level_width) * level_height),
+		std::vector<float>()
+	);
+	while (level_width > 1 || level_height > 1) {
+		level_width = (level_width + 1) / 2;
+		level_height = (level_height + 1) / 2;
+		const size_t size = static_cast<size_t>(level_width) * level_height;
+		pyramid.emplace_back(
+			level_width, level_height, std::vector<float>(size),
+			std::vector<float>(size)
+		);
+	}
+	row_min_values.resize(static_cast<size_t>(this->width));
+	row_max_values.resize(static_cast<size_t>(this->width));
+}
+
+static float mean_of(std::span<const float> values) {
+	if (values.empty())
+		return 0.0f;
+	Float4 sum = Float4::broadcast(0.0f);
+	size_t i = 0;
+	for (; i + 4 <= values.size(); i += 4)
+		sum = sum + Float4::load(&values[i]);
+	float tail_sum = 0.0f;
+	for (; i < values.size(); i++)
+		tail_sum += values[i];
+	return (sum.horizontal_sum() + tail_sum) /
+		   static_cast<float>(values.size());
+}
+
+std::optional<ImageBufferSizeMismatch>
+DepthRegionIndex::update(std::span<const float> depth) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const size_t expected_size = static_cast<size_t>(width) * height;
+	if (depth.size() != expected_size)
+		return ImageBufferSizeMismatch(expected_size, depth.size());
+
+	frame_mean = mean_of(depth);
+
+	// prefix sums are computed 4 values at a time in registers, only the
+	// running sum of the row is carried from one vector to the next
+	const auto table_width = static_cast<size_t>(width) + 1;
+	const Float4 mean = Float4::broadcast(frame_mean);
+	for (size_t y = 0; y < static_cast<size_t>(height); y++) {
+		const auto row = depth.subspan(y * width, static_cast<size_t>(width));
+		float* table_row = &summed_area_table[(y + 1) * table_width + 1];
+		const float* table_row_above = table_row - table_width;
+
+		Float4 row_sum = Float4::broadcast(0.0f);
+		size_t x = 0;
+		for (; x + 4 <= row.size(); x += 4) {
+			const Float4 prefix_sum =
+				(Float4::load(&row[x]) - mean).prefix_sum() + row_sum;
+			(prefix_sum + Float4::load(&table_row_above[x]))
+				.store(&table_row[x]);
+			row_sum = prefix_sum.broadcast_last();
+		}
+		// all lanes hold the running sum
+		float tail_row_sum = row_sum.horizontal_max();
+		for (; x < row.size(); x++) {
+			tail_row_sum += row[x] - frame_mean;
+			table_row[x] = tail_row_sum + table_row_above[x];
+		}
+	}
+
+	std::ranges::copy(depth, pyramid[0].min_values.begin());
+	for (size_t level = 1; level < pyramid.size(); level++) {
+		const PyramidLevel& source = pyramid[level - 1];
+		const auto& source_min_values = source.min_values;
+		const auto& source_max_values =
+			level == 1 ? source.min_values : source.max_values;
+		PyramidLevel& target = pyramid[level];
+
+		const auto source_width = static_cast<size_t>(source.width);
+		for (int y = 0; y < target.height; y++) {
+			const size_t row0 = static_cast<size_t>(2 * y) * source_width;
+			const size_t row1 =
+				static_cast<size_t>(std::min(2 * y + 1, source.height - 1)) *
+				source_width;
+
+			size_t x = 0;
+			for (; x + 4 <= source_width; x += 4) {
+				Float4::min(
+					Float4::load(&source_min_values[row0 + x]),
+					Float4::load(&source_min_values[row1 + x])
+				)
+					.store(&row_min_values[x]);
+				Float4::max(
+					Float4::load(&source_max_values[row0 + x]),
+					Float4::load(&source_max_values[row1 + x])
+				)
+					.store(&row_max_values[x]);
+			}
+			for (; x < source_width; x++) {
+				row_min_values[x] = std::min(
+					source_min_values[row0 + x], source_min_values[row1 + x]
+				);
+				row_max_values[x] = std::max(
+					source_max_values[row0 + x], source_max_values[row1 + x]
+				);
+			}
+
+			const size_t target_row = static_cast<size_t>(y) * target.width;
+			size_t target_x = 0;
+			for (; 2 * target_x + 8 <= source_width; target_x += 4) {
+				const size_t x0 = 2 * target_x;
+				const auto [even_min, odd_min] = Float4::deinterleave(
+					Float4::load(&row_min_values[x0]),
+					Float4::load(&row_min_values[x0 + 4])
+				);
+				Float4::min(even_min, odd_min)
+					.store(&target.min_values[target_row + target_x]);
+				const auto [even_max, odd_max] = Float4::deinterleave(
+					Float4::load(&row_max_values[x0]),
+					Float4::load(&row_max_values[x0 + 4])
+				);
+				Float4::max(even_max, odd_max)
+					.store(&target.max_values[target_row + target_x]);
+			}
+			for (; target_x < static_cast<size_t>(target.width); target_x++) {
+				const size_t x0 = 2 * target_x;
+				const size_t x1 = std::min(x0 + 1, source_width - 1);
+				target.min_values[target_row + target_x] =
+					std::min(row_min_values[x0], row_min_values[x1]);
+				target.max_values[target_row + target_x] =
+					std::max(row_max_values[x0], row_max_values[x1]);
+			}
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::optional<DepthRegion> DepthRegionIndex::clamp_region(DepthRegion region
+) const {
+	const int x0 = std::clamp(region.x, 0, width);
+	const int y0 = std::clamp(region.y, 0, height);
+	const int x1 = std::clamp(region.x + region.width, 0, width);
+	const int y1 = std::clamp(region.y + region.height, 0, height);
+	if (x1 <= x0 || y1 <= y0)
+		return std::nullopt;
+	return DepthRegion(x0, y0, x1 - x0, y1 - y0);
+}
+
+std::optional<float> DepthRegionIndex::sum(DepthRegion region) const {
+	const auto clamped = clamp_region(region);
+	if (!clamped)
+		return std::nullopt;
+
+	const auto table_width = static_cast<size_t>(width) + 1;
+	const auto x0 = static_cast<size_t>(clamped->x);
+	const auto y0 = static_cast<size_t>(clamped->y);
+	const auto x1 = x0 + static_cast<size_t>(clamped->width);
+	const auto y1 = y0 + static_cast<size_t>(clamped->height);
+	const float relative_sum = summed_area_table[y1 * table_width + x1] -
+							   summed_area_table[y0 * table_width + x1] -
+							   summed_area_table[y1 * table_width + x0] +
+							   summed_area_table[y0 * table_width + x0];
+	const auto area = static_cast<float>(clamped->width * clamped->height);
+	return relative_sum + area * frame_mean;
+}
+
+std::optional<float> DepthRegionIndex::mean(DepthRegion region) const {
+	const auto clamped = clamp_region(region);
+	if (!clamped)
+		return std::nullopt;
+	return *sum(*clamped) /
+		   static_cast<float>(clamped->width * clamped->height);
+}
+
+template<bool IsMax>
+static float reduce(float a, float b) {
+	return IsMax ? std::max(a, b) : std::min(a, b);
+}
+
+template<bool IsMax>
+static Float4 reduce(Float4 a, Float4 b) {
+	return IsMax ? Float4::max(a, b) : Float4::min(a, b);
+}
+
+template<bool IsMax>
+float DepthRegionIndex::reduce_pyramid(const DepthRegion& region, float result)
+	const {
+	const int x1 = region.x + region.width;
+	const int y1 = region.y + region.height;
+
+	// coarsest level at which at least one cell lies completely inside of the
+	// region, cells at the right and bottom border are cut off by the image
+	// size
+	size_t level = 0;
+	int cell_x0 = region.x;
+	int cell_y0 = region.y;
+	int cell_x1 = x1;
+	int cell_y1 = y1;
+	for (size_t next_level = 1; next_level < pyramid.size(); next_level++) {
+		const int cell_size = 1 << next_level;
+		const int next_x0 = (region.x + cell_size - 1) >> next_level;
+		const int next_y0 = (region.y + cell_size - 1) >> next_level;
+		const int next_x1 =
+			x1 == width ? pyramid[next_level].width : x1 >> next_level;
+		const int next_y1 =
+			y1 == height ? pyramid[next_level].height : y1 >> next_level;
+		if (next_x1 <= next_x0 || next_y1 <= next_y0)
+			break;
+		level = next_level;
+		cell_x0 = next_x0;
+		cell_y0 = next_y0;
+		cell_x1 = next_x1;
+		cell_y1 = next_y1;
+	}
+
+	const PyramidLevel& pyramid_level = pyramid[level];
+	const auto& values = IsMax && level > 0 ? pyramid_level.max_values
+											: pyramid_level.min_values;
+	Float4 vector_result = Float4::broadcast(result);
+	for (int y = cell_y0; y < cell_y1; y++) {
+		const float* row =
+			&values[static_cast<size_t>(y) * pyramid_level.width];
+		int x = cell_x0;
+		for (; x + 4 <= cell_x1; x += 4)
+			vector_result = reduce<IsMax>(vector_result, Float4::load(&row[x]));
+		for (; x < cell_x1; x++)
+			result = reduce<IsMax>(result, row[x]);
+	}
+	result = reduce<IsMax>(
+		result, IsMax ? vector_result.horizontal_max()
+					  : vector_result.horizontal_min()
+	);
+	if (level == 0)
+		return result;
+
+	// the border strips around the inner cells are thinner than a cell and
+	// resolved at finer levels
+	const int inner_x0 = cell_x0 << level;
+	const int inner_y0 = cell_y0 << level;
+	const int inner_x1 = std::min(cell_x1 << level, width);
+	const int inner_y1 = std::min(cell_y1 << level, height);
+	const std::array<DepthRegion, 4> strips = {
+		DepthRegion(region.x, region.y, region.width, inner_y0 - region.y),
+		DepthRegion(region.x, inner_y1, region.width, y1 - inner_y1),
+		DepthRegion(
+			region.x, inner_y0, inner_x0 - region.x, inner_y1 - inner_y0
+		),
+		DepthRegion(inner_x1, inner_y0, x1 - inner_x1, inner_y1 - inner_y0),
+	};
+	for (const auto& strip : strips) {
+		if (strip.width > 0 && strip.height > 0)
+			result = reduce_pyramid<IsMax>(strip, result);
+	}
+	return result;
+}
+
+template<bool IsMax>
+std::optional<float> DepthRegionIndex::query_pyramid(DepthRegion region
+) const {
+	const auto clamped = clamp_region(region);
+	if (!clamped)
+		return std::nullopt;
+	return reduce_pyramid<IsMax>(
+		*clamped, IsMax ? -std::numeric_limits<float>::infinity()
+						: std::numeric_limits<float>::infinity()
+	);
+}
+
+std::optional<float> DepthRegionIndex::min(DepthRegion region) const {
+	return query_pyramid<false>(region);
+}
+
+std::optional<float> DepthRegionIndex::max(DepthRegion region) const {
+	return query_pyramid<true>(region);
+}
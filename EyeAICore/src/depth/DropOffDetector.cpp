@@ -0,0 +1,257 @@
+#include "EyeAICore/depth/DropOffDetector.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <numbers>
+
+/// the rows below a jump look like floor if their mean gradient is at least
+/// this fraction of the floor gradient of the band
+constexpr float MIN_SUPPORT_GRADIENT_RATIO = 0.5f;
+
+static float radians(float degrees) {
+	return degrees * std::numbers::pi_v<float> / 180.0f;
+}
+
+static float degrees(float radians) {
+	return radians * 180.0f / std::numbers::pi_v<float>;
+}
+
+std::string InvalidDropOffConfig::to_string() const {
+	return std::format("Invalid drop-off detector config: {}", reason);
+}
+
+tl::expected<DropOffDetector, InvalidDropOffConfig>
+DropOffDetector::create(const DropOffConfig& config, int width, int height) {
+	if (config.horizontal_fov_degrees <= 0.0f ||
+		config.horizontal_fov_degrees >= 180.0f)
+		return tl::unexpected(
+			InvalidDropOffConfig("horizontal fov has to be in (0, 180) degrees")
+		);
+	if (config.path_width_fraction <= 0.0f || config.path_width_fraction > 1.0f)
+		return tl::unexpected(
+			InvalidDropOffConfig("path width fraction has to be in (0, 1]")
+		);
+	if (config.path_start_fraction < 0.0f || config.path_start_fraction >= 1.0f)
+		return tl::unexpected(
+			InvalidDropOffConfig("path start fraction has to be in [0, 1)")
+		);
+	if (config.bands <= 0)
+		return tl::unexpected(
+			InvalidDropOffConfig("there has to be at least one band")
+		);
+	if (config.jump_ratio <= 1.0f || config.min_jump <= 0.0f ||
+		config.full_confidence_jump < config.min_jump)
+		return tl::unexpected(InvalidDropOffConfig(
+			"jump ratio has to be above 1 and the jumps positive and ordered"
+		));
+	if (config.support_rows <= 0)
+		return tl::unexpected(
+			InvalidDropOffConfig("support rows have to be positive")
+		);
+
+	// the outermost columns and rows have no neighbours for the gradient
+	const int path_width = std::min(
+		static_cast<int>(
+			std::lround(static_cast<float>(width) * config.path_width_fraction)
+		),
+		width - 2
+	);
+	const int path_begin = (width - path_width) / 2;
+	const int first_row = std::max(
+		static_cast<int>(
+			std::lround(static_cast<float>(height) * config.path_start_fraction)
+		),
+		1
+	);
+	if (path_width < config.bands ||
+		height - 1 - first_row <= config.support_rows)
+		return tl::unexpected(InvalidDropOffConfig(
+			"depth size is too small for the walking path"
+		));
+
+	return DropOffDetector(
+		config, width, height, path_begin, path_begin + path_width, first_row
+	);
+}
+
+DropOffDetector::DropOffDetector(
+	const DropOffConfig& config,
+	int width,
+	int height,
+	int path_begin,
+	int path_end,
+	int first_row
+)
+	: config(config), width(width), height(height), path_begin(path_begin),
+	  path_end(path_end), first_row(first_row) {
+	const int path_width = path_end - path_begin;
+	const auto path_rows = static_cast<size_t>(height - 1 - first_row);
+	const float half_plane_width =
+		std::tan(radians(config.horizontal_fov_degrees) / 2.0f);
+	for (int band = 0; band < config.bands; band++) {
+		const int begin = path_begin + path_width * band / config.bands;
+		const int end = path_begin + path_width * (band + 1) / config.bands;
+		band_columns.push_back(begin);
+		const float center = static_cast<float>(begin + end) / 2.0f;
+		const float u = (2.0f * center / static_cast<float>(width) - 1.0f) *
+						half_plane_width;
+		band_azimuths.push_back(degrees(std::atan(u)));
+	}
+	band_columns.push_back(path_end);
+
+	row_differences.resize(static_cast<size_t>(path_width) + 2);
+	row_gradients.resize(static_cast<size_t>(path_width));
+	band_profiles.resize(static_cast<size_t>(config.bands) * path_rows);
+	sorted_profile.resize(path_rows);
+	hazards.reserve(static_cast<size_t>(config.bands));
+}
+
+void DropOffDetector::compute_row_profile(
+	std::span<const float> depth,
+	int row
+) {
+	const auto row_width = static_cast<size_t>(width);
+	// one column of padding on both sides of the path
+	const auto padded_begin = static_cast<size_t>(path_begin - 1);
+	const float* above =
+		depth.data() + static_cast<size_t>(row - 1) * row_width + padded_begin;
+	const float* below =
+		depth.data() + static_cast<size_t>(row + 1) * row_width + padded_begin;
+	const size_t difference_count = row_differences.size();
+	float* differences = row_differences.data();
+
+	// positive where the depth increases upwards
+	size_t x = 0;
+	for (; x + 4 <= difference_count; x += 4) {
+		const Float4 difference =
+			Float4::load(below + x) - Float4::load(above + x);
+		difference.store(differences + x);
+	}
+	for (; x < difference_count; x++)
+		differences[x] = below[x] - above[x];
+
+	// horizontal [3 10 3] / 32 smoothing of the [-1 0 1] vertical derivative
+	const size_t gradient_count = row_gradients.size();
+	float* gradients = row_gradients.data();
+	const Float4 side_weight = Float4::broadcast(3.0f / 32.0f);
+	const Float4 center_weight = Float4::broadcast(10.0f / 32.0f);
+	x = 0;
+	for (; x + 4 <= gradient_count; x += 4) {
+		const Float4 gradient =
+			side_weight * (Float4::load(differences + x) +
+						   Float4::load(differences + x + 2)) +
+			center_weight * Float4::load(differences + x + 1);
+		gradient.store(gradients + x);
+	}
+	for (; x < gradient_count; x++) {
+		gradients[x] = (3.0f * (differences[x] + differences[x + 2]) +
+						10.0f * differences[x + 1]) /
+					   32.0f;
+	}
+
+	const auto path_rows = static_cast<size_t>(height - 1 - first_row);
+	for (size_t band = 0; band + 1 < band_columns.size(); band++) {
+		const auto begin =
+			static_cast<size_t>(band_columns[band] - path_begin);
+		const auto end =
+			static_cast<size_t>(band_columns[band + 1] - path_begin);
+		Float4 sum4 = Float4::broadcast(0.0f);
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+			sum4 = sum4 + Float4::load(gradients + i);
+		float sum = sum4.horizontal_sum();
+		for (; i < end; i++)
+			sum += gradients[i];
+		band_profiles[band * path_rows + static_cast<size_t>(row - first_row)] =
+			sum / static_cast<float>(end - begin);
+	}
+}
+
+DropOffHazard DropOffDetector::find_drop_off(
+	const DepthRegionIndex& region_index,
+	int band
+) {
+	const auto path_rows = static_cast<int>(sorted_profile.size());
+	const std::span<const float> profile(
+		band_profiles.data() + static_cast<size_t>(band) * path_rows,
+		static_cast<size_t>(path_rows)
+	);
+
+	// the floor dominates the walking path, so the median is its gradient
+	std::ranges::copy(profile, sorted_profile.begin());
+	const auto median_position = sorted_profile.begin() + path_rows / 2;
+	std::ranges::nth_element(sorted_profile, median_position);
+	const float floor_gradient = *median_position;
+
+	DropOffHazard hazard;
+	hazard.azimuth_degrees = band_azimuths[static_cast<size_t>(band)];
+	// a band without floor (e.g. covered by a wall) has no drop-offs
+	if (floor_gradient <= 0.0f)
+		return hazard;
+	const float jump_gradient = floor_gradient * config.jump_ratio;
+
+	// upwards from the nearest row that has support rows below it
+	for (int row = path_rows - 1 - config.support_rows; row >= 0; row--) {
+		if (profile[static_cast<size_t>(row)] <= jump_gradient)
+			continue;
+
+		float jump = 0.0f;
+		int top = row;
+		for (; top >= 0 && profile[static_cast<size_t>(top)] > jump_gradient;
+			 top--)
+			jump += profile[static_cast<size_t>(top)] - floor_gradient;
+
+		float support = 0.0f;
+		for (int i = row + 1; i <= row + config.support_rows; i++)
+			support += profile[static_cast<size_t>(i)];
+		support /= static_cast<float>(config.support_rows);
+
+		if (jump >= config.min_jump &&
+			support >= floor_gradient * MIN_SUPPORT_GRADIENT_RATIO) {
+			const int begin = band_columns[static_cast<size_t>(band)];
+			const int end = band_columns[static_cast<size_t>(band) + 1];
+			const DepthRegion floor_row(
+				begin, first_row + row + 1, end - begin, 1
+			);
+			hazard.nearness = region_index.mean(floor_row).value_or(0.0f);
+			hazard.jump = jump;
+			hazard.confidence =
+				std::min(jump / config.full_confidence_jump, 1.0f);
+			return hazard;
+		}
+		// continue above the rejected jump
+		row = top + 1;
+	}
+	return hazard;
+}
+
+tl::expected<std::span<const DropOffHazard>, ImageBufferSizeMismatch>
+DropOffDetector::detect(
+	std::span<const float> depth,
+	const DepthRegionIndex& region_index
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto depth_size = static_cast<size_t>(width) * height;
+	if (depth.size() != depth_size)
+		return tl::unexpected(ImageBufferSizeMismatch(depth_size, depth.size())
+		);
+	const auto index_size = static_cast<size_t>(region_index.get_width()) *
+							region_index.get_height();
+	if (region_index.get_width() != width ||
+		region_index.get_height() != height)
+		return tl::unexpected(ImageBufferSizeMismatch(depth_size, index_size));
+
+	for (int row = first_row; row < height - 1; row++)
+		compute_row_profile(depth, row);
+
+	hazards.clear();
+	for (int band = 0; band < config.bands; band++) {
+		const DropOffHazard hazard = find_drop_off(region_index, band);
+		if (hazard.confidence > 0.0f)
+			hazards.push_back(hazard);
+	}
+	return std::span<const DropOffHazard>(hazards);
+}
@@ -0,0 +1,229 @@
+#include "EyeAICore/depth/FoveatedDepth.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+/// model runs of a frame with the center crop
+constexpr float FOVEATED_FRAME_RUNS = 2.0f;
+/// at most this many unused model runs are saved up for later frames
+constexpr float MAX_BUDGET_CREDIT = 1.0f;
+
+std::string InvalidFoveationConfig::to_string() const {
+	return std::format("Invalid foveation config: {}", reason);
+}
+
+/// smooth 0 to 1 ramp over the first ramp_size values from both ends
+static std::vector<float> compute_blend_weights(int size, float ramp_size) {
+	std::vector<float> weights(static_cast<size_t>(size));
+	for (int i = 0; i < size; i++) {
+		const int edge_pixels = std::min(i, size - 1 - i);
+		const float edge_distance = static_cast<float>(edge_pixels) + 0.5f;
+		const float t =
+			ramp_size > 0.0f ? std::min(edge_distance / ramp_size, 1.0f) : 1.0f;
+		weights[static_cast<size_t>(i)] = t * t * (3.0f - 2.0f * t);
+	}
+	return weights;
+}
+
+tl::expected<FoveatedDepthBlender, InvalidFoveationConfig>
+FoveatedDepthBlender::create(
+	const FoveationConfig& config,
+	int depth_width,
+	int depth_height,
+	int center_depth_width,
+	int center_depth_height
+) {
+	if (config.crop_fraction <= 0.0f || config.crop_fraction > 1.0f)
+		return tl::unexpected(
+			InvalidFoveationConfig("crop fraction has to be in (0, 1]")
+		);
+	if (config.blend_fraction < 0.0f || config.blend_fraction > 0.5f)
+		return tl::unexpected(
+			InvalidFoveationConfig("blend fraction has to be in [0, 0.5]")
+		);
+	if (config.inference_budget < 1.0f)
+		return tl::unexpected(InvalidFoveationConfig(
+			"inference budget has to cover at least the full frame"
+		));
+	if (depth_width <= 0 || depth_height <= 0 || center_depth_width <= 0 ||
+		center_depth_height <= 0)
+		return tl::unexpected(
+			InvalidFoveationConfig("depth sizes have to be positive")
+		);
+
+	const int region_width = std::max(
+		static_cast<int>(
+			std::lround(static_cast<float>(depth_width) * config.crop_fraction)
+		),
+		1
+	);
+	const int region_height = std::max(
+		static_cast<int>(
+			std::lround(static_cast<float>(depth_height) * config.crop_fraction)
+		),
+		1
+	);
+	const DepthRegion center_region(
+		(depth_width - region_width) / 2, (depth_height - region_height) / 2,
+		region_width, region_height
+	);
+
+	return FoveatedDepthBlender(
+		config, depth_width, depth_height, center_depth_width,
+		center_depth_height, center_region
+	);
+}
+
+FoveatedDepthBlender::FoveatedDepthBlender(
+	const FoveationConfig& config,
+	int depth_width,
+	int depth_height,
+	int center_depth_width,
+	int center_depth_height,
+	DepthRegion center_region
+)
+	: config(config), depth_width(depth_width), depth_height(depth_height),
+	  center_depth_width(center_depth_width),
+	  center_depth_height(center_depth_height), center_region(center_region),
+	  resampled_center(
+		  static_cast<size_t>(center_region.width) * center_region.height
+	  ),
+	  column_weights(compute_blend_weights(
+		  center_region.width,
+		  static_cast<float>(center_region.width) * config.blend_fraction
+	  )),
+	  row_weights(compute_blend_weights(
+		  center_region.height,
+		  static_cast<float>(center_region.height) * config.blend_fraction
+	  )) {}
+
+bool FoveatedDepthBlender::can_afford_center() const {
+	return budget_credit + config.inference_budget >= FOVEATED_FRAME_RUNS;
+}
+
+void FoveatedDepthBlender::record_frame(int model_runs) {
+	budget_credit = std::min(
+		budget_credit + config.inference_budget -
+			static_cast<float>(model_runs),
+		MAX_BUDGET_CREDIT
+	);
+}
+
+std::optional<FoveaBlend>
+FoveatedDepthBlender::fit_center(std::span<const float> depth) const {
+	const auto region_width = static_cast<size_t>(center_region.width);
+
+	// least squares fit of depth = scale * center + shift, the row sums are
+	// vectorized and accumulated in double
+	double sum_x = 0.0;
+	double sum_y = 0.0;
+	double sum_xx = 0.0;
+	double sum_xy = 0.0;
+	for (size_t y = 0; y < static_cast<size_t>(center_region.height); y++) {
+		const float* center_row = &resampled_center[y * region_width];
+		const float* depth_row =
+			&depth
+				[(static_cast<size_t>(center_region.y) + y) * depth_width +
+				 static_cast<size_t>(center_region.x)];
+
+		Float4 row_x = Float4::broadcast(0.0f);
+		Float4 row_y = Float4::broadcast(0.0f);
+		Float4 row_xx = Float4::broadcast(0.0f);
+		Float4 row_xy = Float4::broadcast(0.0f);
+		size_t x = 0;
+		for (; x + 4 <= region_width; x += 4) {
+			const Float4 center = Float4::load(center_row + x);
+			const Float4 full = Float4::load(depth_row + x);
+			row_x = row_x + center;
+			row_y = row_y + full;
+			row_xx = row_xx + center * center;
+			row_xy = row_xy + center * full;
+		}
+		float tail_x = 0.0f;
+		float tail_y = 0.0f;
+		float tail_xx = 0.0f;
+		float tail_xy = 0.0f;
+		for (; x < region_width; x++) {
+			tail_x += center_row[x];
+			tail_y += depth_row[x];
+			tail_xx += center_row[x] * center_row[x];
+			tail_xy += center_row[x] * depth_row[x];
+		}
+		sum_x += row_x.horizontal_sum() + tail_x;
+		sum_y += row_y.horizontal_sum() + tail_y;
+		sum_xx += row_xx.horizontal_sum() + tail_xx;
+		sum_xy += row_xy.horizontal_sum() + tail_xy;
+	}
+
+	const auto count = static_cast<double>(resampled_center.size());
+	const double variance = sum_xx - sum_x * sum_x / count;
+	const double covariance = sum_xy - sum_x * sum_y / count;
+	if (variance <= 1e-9 * count)
+		return std::nullopt;
+	const double scale = covariance / variance;
+	// a negative scale would flip near and far
+	if (scale <= 0.0)
+		return std::nullopt;
+	const double shift = (sum_y - scale * sum_x) / count;
+	return FoveaBlend(
+		static_cast<float>(scale), static_cast<float>(shift), true
+	);
+}
+
+tl::expected<FoveaBlend, ImageBufferSizeMismatch> FoveatedDepthBlender::blend(
+	std::span<float> depth,
+	std::span<const float> center_depth
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto depth_size = static_cast<size_t>(depth_width) * depth_height;
+	if (depth.size() != depth_size)
+		return tl::unexpected(ImageBufferSizeMismatch(depth_size, depth.size())
+		);
+	if (const auto error = resize_floats(
+			center_depth, center_depth_width, center_depth_height,
+			resampled_center, center_region.width, center_region.height
+		))
+		return tl::unexpected(*error);
+
+	const auto fit = fit_center(depth);
+	if (!fit)
+		return FoveaBlend();
+
+	const auto region_width = static_cast<size_t>(center_region.width);
+	const Float4 scale = Float4::broadcast(fit->scale);
+	const Float4 shift = Float4::broadcast(fit->shift);
+	const Float4 zero = Float4::broadcast(0.0f);
+	const Float4 one = Float4::broadcast(1.0f);
+	for (size_t y = 0; y < static_cast<size_t>(center_region.height); y++) {
+		const float* center_row = &resampled_center[y * region_width];
+		float* depth_row =
+			&depth
+				[(static_cast<size_t>(center_region.y) + y) * depth_width +
+				 static_cast<size_t>(center_region.x)];
+		const float row_weight = row_weights[y];
+		const Float4 row_weight4 = Float4::broadcast(row_weight);
+
+		size_t x = 0;
+		for (; x + 4 <= region_width; x += 4) {
+			const Float4 full = Float4::load(depth_row + x);
+			const Float4 aligned = Float4::load(center_row + x) * scale + shift;
+			const Float4 weight =
+				Float4::load(&column_weights[x]) * row_weight4;
+			const Float4 blended = full + weight * (aligned - full);
+			// the full depth map is normalized, the fit can overshoot it
+			Float4::min(Float4::max(blended, zero), one).store(depth_row + x);
+		}
+		for (; x < region_width; x++) {
+			const float aligned = center_row[x] * fit->scale + fit->shift;
+			const float weight = column_weights[x] * row_weight;
+			depth_row[x] = std::clamp(
+				depth_row[x] + weight * (aligned - depth_row[x]), 0.0f, 1.0f
+			);
+		}
+	}
+
+	return *fit;
+}
@@ -0,0 +1,447 @@
+#include "EyeAICore/depth/GroundPlane.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <numbers>
+#include <thread>
+
+/// probability that at least one hypothesis only has inliers, determines
+/// when further hypotheses are pointless
+constexpr double RANSAC_CONFIDENCE = 0.99;
+/// random triples tried per hypothesis before giving up on it, most rejected
+/// triples are degenerate or too steep
+constexpr int MAX_HYPOTHESIS_ATTEMPTS = 4;
+
+static float radians(float degrees) {
+	return degrees * std::numbers::pi_v<float> / 180.0f;
+}
+
+static float degrees(float radians) {
+	return radians * 180.0f / std::numbers::pi_v<float>;
+}
+
+/// hypotheses needed to find an all-inlier triple with RANSAC_CONFIDENCE
+static int required_hypotheses(float inlier_ratio) {
+	const double all_inliers = std::pow(static_cast<double>(inlier_ratio), 3);
+	if (all_inliers >= 1.0)
+		return 1;
+	if (all_inliers <= 0.0)
+		return std::numeric_limits<int>::max();
+	return static_cast<int>(std::ceil(
+		std::log(1.0 - RANSAC_CONFIDENCE) / std::log(1.0 - all_inliers)
+	));
+}
+
+float GroundPlane::tilt_degrees() const {
+	return degrees(std::acos(std::clamp(normal_y, -1.0f, 1.0f)));
+}
+
+std::string InvalidGroundPlaneConfig::to_string() const {
+	return std::format("Invalid ground plane config: {}", reason);
+}
+
+std::string GroundPlaneEstimate::formatted() const {
+	if (!found)
+		return std::format(
+			"Ground plane: not found ({} hypotheses)", hypotheses
+		);
+	return std::format(
+		"Ground plane: {:.2f} m below, {:.1f}° tilt, {:.0f}% inliers, {} "
+		"hypotheses{}",
+		plane.offset, plane.tilt_degrees(), inlier_ratio * 100.0f, hypotheses,
+		seeded ? " (seeded)" : ""
+	);
+}
+
+tl::expected<GroundPlaneEstimator, InvalidGroundPlaneConfig>
+GroundPlaneEstimator::create(
+	const GroundPlaneConfig& config,
+	int width,
+	int height
+) {
+	if (width <= 0 || height <= 0)
+		return tl::unexpected(
+			InvalidGroundPlaneConfig("depth size has to be positive")
+		);
+	if (config.sample_start_fraction < 0.0f ||
+		config.sample_start_fraction >= 1.0f)
+		return tl::unexpected(InvalidGroundPlaneConfig(
+			"sample start fraction has to be in [0, 1)"
+		));
+	if (config.max_samples < 3)
+		return tl::unexpected(
+			InvalidGroundPlaneConfig("at least 3 samples are needed")
+		);
+	if (config.max_sample_distance <= 0.0f || config.inlier_distance <= 0.0f)
+		return tl::unexpected(InvalidGroundPlaneConfig(
+			"sample and inlier distances have to be positive"
+		));
+	if (config.max_tilt_degrees <= 0.0f || config.max_tilt_degrees >= 90.0f)
+		return tl::unexpected(
+			InvalidGroundPlaneConfig("max tilt has to be in (0, 90) degrees")
+		);
+	if (config.max_iterations <= 0 || config.seeded_iterations < 0)
+		return tl::unexpected(InvalidGroundPlaneConfig(
+			"max iterations has to be positive and seeded iterations not "
+			"negative"
+		));
+	if (config.min_inlier_ratio <= 0.0f || config.min_inlier_ratio > 1.0f ||
+		config.seed_inlier_ratio <= 0.0f || config.seed_inlier_ratio > 1.0f)
+		return tl::unexpected(
+			InvalidGroundPlaneConfig("inlier ratios have to be in (0, 1]")
+		);
+	if (config.time_budget.count() <= 0)
+		return tl::unexpected(
+			InvalidGroundPlaneConfig("time budget has to be positive")
+		);
+
+	return GroundPlaneEstimator(config, width, height);
+}
+
+GroundPlaneEstimator::GroundPlaneEstimator(
+	const GroundPlaneConfig& config,
+	int width,
+	int height
+)
+	: config(config), width(width), height(height),
+	  min_normal_y(std::cos(radians(config.max_tilt_degrees))) {
+	const auto max_samples = static_cast<size_t>(config.max_samples);
+	samples_x.reserve(max_samples);
+	samples_y.reserve(max_samples);
+	samples_z.reserve(max_samples);
+	hypotheses.reserve(static_cast<size_t>(
+		std::max(config.max_iterations, config.seeded_iterations)
+	));
+}
+
+void GroundPlaneEstimator::sample_points(const PointCloud& points) {
+	const int start_row = std::min(
+		static_cast<int>(
+			static_cast<float>(height) * config.sample_start_fraction
+		),
+		height - 1
+	);
+	const double region_pixels =
+		static_cast<double>(width) * static_cast<double>(height - start_row);
+	const int stride = std::max(
+		static_cast<int>(std::ceil(
+			std::sqrt(region_pixels / static_cast<double>(config.max_samples))
+		)),
+		1
+	);
+
+	samples_x.clear();
+	samples_y.clear();
+	samples_z.clear();
+	for (int y = start_row; y < height; y += stride) {
+		for (int x = 0; x < width; x += stride) {
+			const auto i = static_cast<size_t>(y) * width + x;
+			// also rejects nan
+			if (!(points.z[i] > 0.0f &&
+				  points.z[i] <= config.max_sample_distance))
+				continue;
+			if (samples_x.size() == static_cast<size_t>(config.max_samples))
+				return;
+			samples_x.push_back(points.x[i]);
+			samples_y.push_back(points.y[i]);
+			samples_z.push_back(points.z[i]);
+		}
+	}
+}
+
+std::optional<GroundPlane> GroundPlaneEstimator::random_hypothesis() {
+	std::uniform_int_distribution<size_t> distribution(
+		0, samples_x.size() - 1
+	);
+	for (int attempt = 0; attempt < MAX_HYPOTHESIS_ATTEMPTS; attempt++) {
+		const size_t a = distribution(random);
+		const size_t b = distribution(random);
+		const size_t c = distribution(random);
+
+		const float ab_x = samples_x[b] - samples_x[a];
+		const float ab_y = samples_y[b] - samples_y[a];
+		const float ab_z = samples_z[b] - samples_z[a];
+		const float ac_x = samples_x[c] - samples_x[a];
+		const float ac_y = samples_y[c] - samples_y[a];
+		const float ac_z = samples_z[c] - samples_z[a];
+		float normal_x = ab_y * ac_z - ab_z * ac_y;
+		float normal_y = ab_z * ac_x - ab_x * ac_z;
+		float normal_z = ab_x * ac_y - ab_y * ac_x;
+		const float length = std::sqrt(
+			normal_x * normal_x + normal_y * normal_y + normal_z * normal_z
+		);
+		// also rejects duplicate and collinear samples
+		if (!(length > 1e-6f))
+			continue;
+		const float sign = normal_y < 0.0f ? -1.0f : 1.0f;
+		normal_x *= sign / length;
+		normal_y *= sign / length;
+		normal_z *= sign / length;
+		if (normal_y < min_normal_y)
+			continue;
+
+		const float offset =
+			-(normal_x * samples_x[a] + normal_y * samples_y[a] +
+			  normal_z * samples_z[a]);
+		// the floor is below the camera
+		if (offset <= 0.0f)
+			continue;
+		return GroundPlane(normal_x, normal_y, normal_z, offset);
+	}
+	return std::nullopt;
+}
+
+int GroundPlaneEstimator::count_inliers(const GroundPlane& plane) const {
+	const size_t sample_count = samples_x.size();
+	const Float4 normal_x = Float4::broadcast(plane.normal_x);
+	const Float4 normal_y = Float4::broadcast(plane.normal_y);
+	const Float4 normal_z = Float4::broadcast(plane.normal_z);
+	const Float4 offset = Float4::broadcast(plane.offset);
+	const Float4 inlier_distance = Float4::broadcast(config.inlier_distance);
+
+	Float4 inliers4 = Float4::broadcast(0.0f);
+	size_t i = 0;
+	for (; i + 4 <= sample_count; i += 4) {
+		const Float4 distance = Float4::abs(
+			normal_x * Float4::load(samples_x.data() + i) +
+			normal_y * Float4::load(samples_y.data() + i) +
+			normal_z * Float4::load(samples_z.data() + i) + offset
+		);
+		const Float4 inlier = Float4::greater_equal(inlier_distance, distance);
+		inliers4 = inliers4 + Float4::mask_to_ones(inlier);
+	}
+	auto inliers = static_cast<int>(inliers4.horizontal_sum());
+	for (; i < sample_count; i++) {
+		if (std::abs(plane.height(samples_x[i], samples_y[i], samples_z[i])) <=
+			config.inlier_distance)
+			inliers++;
+	}
+	return inliers;
+}
+
+GroundPlaneEstimator::HypothesisResult
+GroundPlaneEstimator::evaluate_hypotheses(
+	size_t begin,
+	size_t end,
+	std::chrono::steady_clock::time_point deadline
+) const {
+	const auto sample_count = static_cast<float>(samples_x.size());
+	HypothesisResult result;
+	int required = std::numeric_limits<int>::max();
+	for (size_t i = begin; i < end && result.evaluated < required; i++) {
+		if (std::chrono::steady_clock::now() >= deadline)
+			break;
+		const int inliers = count_inliers(hypotheses[i]);
+		result.evaluated++;
+		if (inliers > result.inliers) {
+			result.plane = hypotheses[i];
+			result.inliers = inliers;
+			required = required_hypotheses(
+				static_cast<float>(inliers) / sample_count
+			);
+		}
+	}
+	return result;
+}
+
+GroundPlane GroundPlaneEstimator::refine(const GroundPlane& plane) const {
+	// least squares fit of y = a * x + b * z + c, the floor is close to level
+	// so the vertical residual is close to the distance to the plane
+	double sum_xx = 0.0;
+	double sum_xz = 0.0;
+	double sum_zz = 0.0;
+	double sum_x = 0.0;
+	double sum_z = 0.0;
+	double sum_xy = 0.0;
+	double sum_zy = 0.0;
+	double sum_y = 0.0;
+	double count = 0.0;
+	for (size_t i = 0; i < samples_x.size(); i++) {
+		const float x = samples_x[i];
+		const float y = samples_y[i];
+		const float z = samples_z[i];
+		if (std::abs(plane.height(x, y, z)) > config.inlier_distance)
+			continue;
+		sum_xx += static_cast<double>(x) * x;
+		sum_xz += static_cast<double>(x) * z;
+		sum_zz += static_cast<double>(z) * z;
+		sum_x += x;
+		sum_z += z;
+		sum_xy += static_cast<double>(x) * y;
+		sum_zy += static_cast<double>(z) * y;
+		sum_y += y;
+		count += 1.0;
+	}
+
+	// cramer's rule on the normal equations
+	const auto determinant3 = [](double a00, double a01, double a02,
+								 double a10, double a11, double a12,
+								 double a20, double a21, double a22) {
+		return a00 * (a11 * a22 - a12 * a21) - a01 * (a10 * a22 - a12 * a20) +
+			   a02 * (a10 * a21 - a11 * a20);
+	};
+	const double determinant = determinant3(
+		sum_xx, sum_xz, sum_x, sum_xz, sum_zz, sum_z, sum_x, sum_z, count
+	);
+	if (count < 3.0 || std::abs(determinant) < 1e-9)
+		return plane;
+	const double a = determinant3(
+						 sum_xy, sum_xz, sum_x, sum_zy, sum_zz, sum_z, sum_y,
+						 sum_z, count
+					 ) /
+					 determinant;
+	const double b = determinant3(
+						 sum_xx, sum_xy, sum_x, sum_xz, sum_zy, sum_z, sum_x,
+						 sum_y, count
+					 ) /
+					 determinant;
+	const double c = determinant3(
+						 sum_xx, sum_xz, sum_xy, sum_xz, sum_zz, sum_zy, sum_x,
+						 sum_z, sum_y
+					 ) /
+					 determinant;
+
+	const double length = std::sqrt(a * a + 1.0 + b * b);
+	const GroundPlane refined(
+		static_cast<float>(-a / length), static_cast<float>(1.0 / length),
+		static_cast<float>(-b / length), static_cast<float>(-c / length)
+	);
+	if (refined.normal_y < min_normal_y || refined.offset <= 0.0f)
+		return plane;
+	return refined;
+}
+
+tl::expected<GroundPlaneEstimate, ImageBufferSizeMismatch>
+GroundPlaneEstimator::estimate(const PointCloud& points, int threads) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto deadline = std::chrono::steady_clock::now() + config.time_budget;
+	const auto point_count = static_cast<size_t>(width) * height;
+	if (points.size() != point_count)
+		return tl::unexpected(
+			ImageBufferSizeMismatch(point_count, points.size())
+		);
+
+	sample_points(points);
+	GroundPlaneEstimate estimate;
+	estimate.plane = previous_plane.value_or(latest.plane);
+	if (samples_x.size() < 3) {
+		latest = estimate;
+		return estimate;
+	}
+	const auto sample_count = static_cast<int>(samples_x.size());
+
+	HypothesisResult best;
+	if (previous_plane) {
+		best.plane = *previous_plane;
+		best.inliers = count_inliers(*previous_plane);
+		best.evaluated = 1;
+		estimate.seeded = static_cast<float>(best.inliers) >=
+						  config.seed_inlier_ratio *
+							  static_cast<float>(sample_count);
+	}
+
+	const int iterations =
+		estimate.seeded ? config.seeded_iterations : config.max_iterations;
+	hypotheses.clear();
+	for (int i = 0; i < iterations; i++) {
+		if (const auto hypothesis = random_hypothesis())
+			hypotheses.push_back(*hypothesis);
+	}
+
+	threads = std::clamp(
+		threads, 1, std::max(static_cast<int>(hypotheses.size()), 1)
+	);
+	std::vector<HypothesisResult> results(static_cast<size_t>(threads));
+	const auto band = [&](int i) {
+		return hypotheses.size() * static_cast<size_t>(i) /
+			   static_cast<size_t>(threads);
+	};
+	{
+		std::vector<std::jthread> workers;
+		for (int i = 1; i < threads; i++) {
+			workers.emplace_back([&, i] {
+				results[static_cast<size_t>(i)] =
+					evaluate_hypotheses(band(i), band(i + 1), deadline);
+			});
+		}
+		results[0] = evaluate_hypotheses(band(0), band(1), deadline);
+	}
+	for (const auto& result : results) {
+		best.evaluated += result.evaluated;
+		if (result.inliers > best.inliers) {
+			best.plane = result.plane;
+			best.inliers = result.inliers;
+		}
+	}
+	estimate.hypotheses = best.evaluated;
+
+	if (static_cast<float>(best.inliers) <
+		config.min_inlier_ratio * static_cast<float>(sample_count)) {
+		// keep the previous plane as seed, the floor might just be occluded
+		latest = estimate;
+		return estimate;
+	}
+
+	estimate.plane = refine(best.plane);
+	estimate.inlier_ratio = static_cast<float>(count_inliers(estimate.plane)) /
+							static_cast<float>(sample_count);
+	estimate.found = true;
+	previous_plane = estimate.plane;
+	latest = estimate;
+	return estimate;
+}
+
+std::optional<ImageBufferSizeMismatch>
+GroundPlaneEstimator::compute_above_ground_mask(
+	const PointCloud& points,
+	std::span<uint8_t> out_mask
+) const {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto point_count = static_cast<size_t>(width) * height;
+	if (points.size() != point_count)
+		return ImageBufferSizeMismatch(point_count, points.size());
+	if (out_mask.size() != point_count)
+		return ImageBufferSizeMismatch(point_count, out_mask.size());
+	if (!previous_plane) {
+		std::ranges::fill(out_mask, uint8_t{1});
+		return std::nullopt;
+	}
+
+	const GroundPlane& plane = *previous_plane;
+	const Float4 normal_x = Float4::broadcast(plane.normal_x);
+	const Float4 normal_y = Float4::broadcast(plane.normal_y);
+	const Float4 normal_z = Float4::broadcast(plane.normal_z);
+	const Float4 offset = Float4::broadcast(plane.offset);
+	const Float4 obstacle_height = Float4::broadcast(config.obstacle_height);
+
+	size_t i = 0;
+	for (; i + 4 <= point_count; i += 4) {
+		const Float4 height = normal_x * Float4::load(points.x.data() + i) +
+							  normal_y * Float4::load(points.y.data() + i) +
+							  normal_z * Float4::load(points.z.data() + i) +
+							  offset;
+		std::array<float, 4> above{};
+		Float4::mask_to_ones(Float4::greater_equal(height, obstacle_height))
+			.store(above.data());
+		for (size_t lane = 0; lane < 4; lane++)
+			out_mask[i + lane] = static_cast<uint8_t>(above[lane]);
+	}
+	for (; i < point_count; i++) {
+		out_mask[i] = static_cast<uint8_t>(
+			plane.height(points.x[i], points.y[i], points.z[i]) >=
+			config.obstacle_height
+		);
+	}
+	return std::nullopt;
+}
+
+void GroundPlaneEstimator::reset() {
+	previous_plane.reset();
+	latest = GroundPlaneEstimate();
+}
@@ -0,0 +1,393 @@
+#include "EyeAICore/depth/GuidedUpsampling.hpp"
+#include "EyeAICore/utils/ImageUtils.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <format>
+#include <limits>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+std::string InvalidGuidedUpsamplingConfig::to_string() const {
+	return std::format("Invalid guided upsampling config: {}", reason);
+}
+
+struct GuidedDepthUpsampler::BandWorkers {
+	std::mutex mutex;
+	std::condition_variable_any work_changed;
+	/// increased by every upsample(), each worker runs its band once per
+	/// generation
+	uint64_t generation = 0;
+	/// workers that did not finish the current generation yet
+	size_t pending = 0;
+	GuidedDepthUpsampler* upsampler = nullptr;
+	std::span<const int> guide;
+	std::span<float> out_depth;
+	/// last, so the threads are joined before the rest is destroyed
+	std::vector<std::jthread> threads;
+
+	void run(size_t band, const std::stop_token& stop_token) {
+		uint64_t finished_generation = 0;
+		while (true) {
+			{
+				std::unique_lock lock(mutex);
+				if (!work_changed.wait(lock, stop_token, [&] {
+						return generation != finished_generation;
+					}))
+					return;
+				finished_generation = generation;
+			}
+			// upsampler and the spans only change while no worker is pending
+			upsampler->apply_band(guide, out_depth, band);
+			{
+				const std::scoped_lock lock(mutex);
+				pending--;
+			}
+			work_changed.notify_all();
+		}
+	}
+};
+
+tl::expected<GuidedDepthUpsampler, InvalidGuidedUpsamplingConfig>
+GuidedDepthUpsampler::create(
+	const GuidedUpsamplingConfig& config,
+	int depth_width,
+	int depth_height,
+	int guide_width,
+	int guide_height,
+	int threads
+) {
+	if (config.radius < 1)
+		return tl::unexpected(
+			InvalidGuidedUpsamplingConfig("radius has to be at least 1")
+		);
+	if (config.epsilon <= 0.0f)
+		return tl::unexpected(
+			InvalidGuidedUpsamplingConfig("epsilon has to be positive")
+		);
+	if (depth_width <= 0 || depth_height <= 0)
+		return tl::unexpected(
+			InvalidGuidedUpsamplingConfig("depth size has to be positive")
+		);
+	if (guide_width < depth_width || guide_height < depth_height)
+		return tl::unexpected(InvalidGuidedUpsamplingConfig(
+			"guide has to be at least as large as the depth"
+		));
+
+	return GuidedDepthUpsampler(
+		config, depth_width, depth_height, guide_width, guide_height,
+		std::clamp(threads, 1, guide_height)
+	);
+}
+
+std::vector<GuidedDepthUpsampler::CoefficientSample>
+GuidedDepthUpsampler::compute_coefficient_samples(int size, int out_size) {
+	std::vector<CoefficientSample> samples(static_cast<size_t>(out_size));
+	const float scale = static_cast<float>(size) / static_cast<float>(out_size);
+	for (int i = 0; i < out_size; i++) {
+		const float position = std::clamp(
+			(static_cast<float>(i) + 0.5f) * scale - 0.5f, 0.0f,
+			static_cast<float>(size - 1)
+		);
+		const int index0 = static_cast<int>(position);
+		const int index1 = std::min(index0 + 1, size - 1);
+		samples[static_cast<size_t>(i)] = CoefficientSample(
+			static_cast<size_t>(index0), static_cast<size_t>(index1),
+			position - static_cast<float>(index0)
+		);
+	}
+	return samples;
+}
+
+GuidedDepthUpsampler::GuidedDepthUpsampler(
+	const GuidedUpsamplingConfig& config,
+	int depth_width,
+	int depth_height,
+	int guide_width,
+	int guide_height,
+	int threads
+)
+	: config(config), depth_width(depth_width), depth_height(depth_height),
+	  guide_width(guide_width), guide_height(guide_height),
+	  luma_plan(BoxDownsamplePlan::create(
+		  guide_width, guide_height, depth_width, depth_height, 1
+	  )),
+	  column_samples(compute_coefficient_samples(depth_width, guide_width)),
+	  row_samples(compute_coefficient_samples(depth_height, guide_height)) {
+	const auto depth_size = static_cast<size_t>(depth_width) * depth_height;
+	for (auto* buffer :
+		 {&luma, &products, &mean_luma, &mean_depth, &luma_variance,
+		  &luma_depth_covariance, &scales, &offsets})
+		buffer->resize(depth_size);
+	column_sums.resize(static_cast<size_t>(depth_width));
+	vertical_sums.resize(static_cast<size_t>(depth_width));
+
+	band_scratch.resize(static_cast<size_t>(threads));
+	for (auto& scratch : band_scratch) {
+		for (auto* buffer :
+			 {&scratch.upper_scales, &scratch.upper_offsets,
+			  &scratch.lower_scales, &scratch.lower_offsets, &scratch.row_luma})
+			buffer->resize(static_cast<size_t>(guide_width));
+	}
+	if (threads > 1) {
+		band_workers = std::make_unique<BandWorkers>();
+		for (size_t band = 1; band < band_scratch.size(); band++) {
+			band_workers->threads.emplace_back(
+				[workers = band_workers.get(),
+				 band](const std::stop_token& stop_token) {
+					workers->run(band, stop_token);
+				}
+			);
+		}
+	}
+}
+
+GuidedDepthUpsampler::GuidedDepthUpsampler(GuidedDepthUpsampler&&) noexcept =
+	default;
+GuidedDepthUpsampler&
+GuidedDepthUpsampler::operator=(GuidedDepthUpsampler&&) noexcept = default;
+GuidedDepthUpsampler::~GuidedDepthUpsampler() = default;
+
+/// sums += sign * row
+static void
+accumulate_row(float* sums, const float* row, size_t size, float sign) {
+	const Float4 sign4 = Float4::broadcast(sign);
+	size_t i = 0;
+	for (; i + 4 <= size; i += 4) {
+		const Float4 sum = Float4::load(sums + i);
+		(sum + Float4::load(row + i) * sign4).store(sums + i);
+	}
+	for (; i < size; i++)
+		sums[i] += sign * row[i];
+}
+
+void GuidedDepthUpsampler::box_filter(
+	std::span<const float> values,
+	std::span<float> out_values
+) {
+	const auto width = static_cast<size_t>(depth_width);
+	const int radius = config.radius;
+
+	// running sums over the rows [y - radius, y + radius] of every column,
+	// windows are cut at the borders and normalized by their size
+	std::ranges::fill(column_sums, 0.0f);
+	for (int y = 0; y <= std::min(radius, depth_height - 1); y++)
+		accumulate_row(
+			column_sums.data(), &values[static_cast<size_t>(y) * width], width,
+			1.0f
+		);
+
+	for (int y = 0; y < depth_height; y++) {
+		if (y > 0 && y + radius < depth_height)
+			accumulate_row(
+				column_sums.data(),
+				&values[static_cast<size_t>(y + radius) * width], width, 1.0f
+			);
+		if (y - radius - 1 >= 0)
+			accumulate_row(
+				column_sums.data(),
+				&values[static_cast<size_t>(y - radius - 1) * width], width,
+				-1.0f
+			);
+		const int rows = std::min(y + radius, depth_height - 1) -
+						 std::max(y - radius, 0) + 1;
+		const float row_scale = 1.0f / static_cast<float>(rows);
+		for (size_t x = 0; x < width; x++)
+			vertical_sums[x] = column_sums[x] * row_scale;
+
+		// same running sum horizontally
+		float* out_row = &out_values[static_cast<size_t>(y) * width];
+		float sum = 0.0f;
+		for (int x = 0; x <= std::min(radius, depth_width - 1); x++)
+			sum += vertical_sums[static_cast<size_t>(x)];
+		for (int x = 0; x < depth_width; x++) {
+			if (x > 0 && x + radius < depth_width)
+				sum += vertical_sums[static_cast<size_t>(x + radius)];
+			if (x - radius - 1 >= 0)
+				sum -= vertical_sums[static_cast<size_t>(x - radius - 1)];
+			const int columns = std::min(x + radius, depth_width - 1) -
+								std::max(x - radius, 0) + 1;
+			out_row[x] = sum / static_cast<float>(columns);
+		}
+	}
+}
+
+std::optional<ImageBufferSizeMismatch> GuidedDepthUpsampler::fit(
+	std::span<const float> depth,
+	std::span<const int> guide
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto depth_size = static_cast<size_t>(depth_width) * depth_height;
+	if (depth.size() != depth_size)
+		return ImageBufferSizeMismatch(depth_size, depth.size());
+	if (const auto error = downsample_argb_to_luma(guide, luma, luma_plan))
+		return error;
+
+	box_filter(luma, mean_luma);
+	box_filter(depth, mean_depth);
+	for (size_t i = 0; i < depth_size; i++)
+		products[i] = luma[i] * luma[i];
+	box_filter(products, luma_variance);
+	for (size_t i = 0; i < depth_size; i++)
+		products[i] = luma[i] * depth[i];
+	box_filter(products, luma_depth_covariance);
+
+	// per window least squares fit of depth = scale * luma + offset, the
+	// scale is stored in luma_variance and the offset in
+	// luma_depth_covariance
+	for (size_t i = 0; i < depth_size; i++) {
+		const float variance = luma_variance[i] - mean_luma[i] * mean_luma[i];
+		const float covariance =
+			luma_depth_covariance[i] - mean_luma[i] * mean_depth[i];
+		const float scale = covariance / (variance + config.epsilon);
+		luma_variance[i] = scale;
+		luma_depth_covariance[i] = mean_depth[i] - scale * mean_luma[i];
+	}
+	// every pixel is covered by multiple windows, their fits are averaged
+	box_filter(luma_variance, scales);
+	box_filter(luma_depth_covariance, offsets);
+	return std::nullopt;
+}
+
+void GuidedDepthUpsampler::upsample_coefficient_row(
+	size_t row,
+	std::span<float> out_scales,
+	std::span<float> out_offsets
+) const {
+	const float* scale_row = &scales[row * static_cast<size_t>(depth_width)];
+	const float* offset_row = &offsets[row * static_cast<size_t>(depth_width)];
+	for (size_t x = 0; x < column_samples.size(); x++) {
+		const auto& sample = column_samples[x];
+		out_scales[x] =
+			scale_row[sample.index0] +
+			sample.weight *
+				(scale_row[sample.index1] - scale_row[sample.index0]);
+		out_offsets[x] =
+			offset_row[sample.index0] +
+			sample.weight *
+				(offset_row[sample.index1] - offset_row[sample.index0]);
+	}
+}
+
+void GuidedDepthUpsampler::apply_band(
+	std::span<const int> guide,
+	std::span<float> out_depth,
+	size_t band
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto width = static_cast<size_t>(guide_width);
+	const auto bands = band_scratch.size();
+	const auto rows = static_cast<size_t>(guide_height);
+	const auto row_begin = static_cast<int>(band * rows / bands);
+	const auto row_end = static_cast<int>((band + 1) * rows / bands);
+
+	// consecutive rows mostly interpolate between the same two coefficient
+	// rows, they are only upsampled horizontally when the rows change
+	auto& scratch = band_scratch[band];
+	auto& upper_scales = scratch.upper_scales;
+	auto& upper_offsets = scratch.upper_offsets;
+	auto& lower_scales = scratch.lower_scales;
+	auto& lower_offsets = scratch.lower_offsets;
+	auto& row_luma = scratch.row_luma;
+	constexpr size_t NO_ROW = std::numeric_limits<size_t>::max();
+	size_t upper_row = NO_ROW;
+	size_t lower_row = NO_ROW;
+
+	const Float4 zero = Float4::broadcast(0.0f);
+	const Float4 one = Float4::broadcast(1.0f);
+	const Float4 luma_scale = Float4::broadcast(1.0f / 255.0f);
+	for (int y = row_begin; y < row_end; y++) {
+		const auto& sample = row_samples[static_cast<size_t>(y)];
+		if (sample.index0 != upper_row) {
+			if (sample.index0 == lower_row) {
+				std::swap(upper_scales, lower_scales);
+				std::swap(upper_offsets, lower_offsets);
+				upper_row = lower_row;
+				lower_row = NO_ROW;
+			} else {
+				upsample_coefficient_row(
+					sample.index0, upper_scales, upper_offsets
+				);
+				upper_row = sample.index0;
+			}
+		}
+		if (sample.index1 != lower_row) {
+			upsample_coefficient_row(
+				sample.index1, lower_scales, lower_offsets
+			);
+			lower_row = sample.index1;
+		}
+
+		const int* guide_row = &guide[static_cast<size_t>(y) * width];
+		for (size_t x = 0; x < width; x++)
+			row_luma[x] = luma_from_argb_color(guide_row[x]);
+
+		float* out_row = &out_depth[static_cast<size_t>(y) * width];
+		const Float4 weight = Float4::broadcast(sample.weight);
+		size_t x = 0;
+		for (; x + 4 <= width; x += 4) {
+			const Float4 upper_scale = Float4::load(&upper_scales[x]);
+			const Float4 upper_offset = Float4::load(&upper_offsets[x]);
+			const Float4 scale =
+				upper_scale + weight * (Float4::load(&lower_scales[x]) -
+										upper_scale);
+			const Float4 offset =
+				upper_offset + weight * (Float4::load(&lower_offsets[x]) -
+										 upper_offset);
+			const Float4 depth =
+				scale * Float4::load(&row_luma[x]) * luma_scale + offset;
+			Float4::min(Float4::max(depth, zero), one).store(out_row + x);
+		}
+		for (; x < width; x++) {
+			const float scale =
+				upper_scales[x] +
+				sample.weight * (lower_scales[x] - upper_scales[x]);
+			const float offset =
+				upper_offsets[x] +
+				sample.weight * (lower_offsets[x] - upper_offsets[x]);
+			out_row[x] = std::clamp(
+				scale * row_luma[x] / 255.0f + offset, 0.0f, 1.0f
+			);
+		}
+	}
+}
+
+std::optional<ImageBufferSizeMismatch> GuidedDepthUpsampler::upsample(
+	std::span<const float> depth,
+	std::span<const int> guide,
+	std::span<float> out_depth
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto guide_size = static_cast<size_t>(guide_width) * guide_height;
+	if (guide.size() != guide_size)
+		return ImageBufferSizeMismatch(guide_size, guide.size());
+	if (out_depth.size() != guide_size)
+		return ImageBufferSizeMismatch(guide_size, out_depth.size());
+	if (const auto error = fit(depth, guide))
+		return error;
+	if (!band_workers) {
+		apply_band(guide, out_depth, 0);
+		return std::nullopt;
+	}
+
+	{
+		const std::scoped_lock lock(band_workers->mutex);
+		band_workers->upsampler = this;
+		band_workers->guide = guide;
+		band_workers->out_depth = out_depth;
+		band_workers->pending = band_workers->threads.size();
+		band_workers->generation++;
+	}
+	band_workers->work_changed.notify_all();
+	apply_band(guide, out_depth, 0);
+	std::unique_lock lock(band_workers->mutex);
+	band_workers->work_changed.wait(lock, [this] {
+		return band_workers->pending == 0;
+	});
+	return std::nullopt;
+}
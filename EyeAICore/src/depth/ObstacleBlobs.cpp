@@ -0,0 +1,189 @@
+#include "EyeAICore/depth/ObstacleBlobs.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include <algorithm>
+#include <format>
+
+std::string InvalidObstacleBlobConfig::to_string() const {
+	return std::format("Invalid obstacle blob config: {}", reason);
+}
+
+tl::expected<ObstacleBlobExtractor, InvalidObstacleBlobConfig>
+ObstacleBlobExtractor::create(
+	const ObstacleBlobConfig& config,
+	int width,
+	int height
+) {
+	if (width <= 0 || height <= 0)
+		return tl::unexpected(
+			InvalidObstacleBlobConfig("depth size has to be positive")
+		);
+	if (config.near_threshold <= 0.0f || config.near_threshold > 1.0f)
+		return tl::unexpected(
+			InvalidObstacleBlobConfig("near threshold has to be in (0, 1]")
+		);
+	if (config.min_area <= 0 || config.max_blobs <= 0)
+		return tl::unexpected(InvalidObstacleBlobConfig(
+			"min area and max blobs have to be positive"
+		));
+
+	return ObstacleBlobExtractor(config, width, height);
+}
+
+ObstacleBlobExtractor::ObstacleBlobExtractor(
+	const ObstacleBlobConfig& config,
+	int width,
+	int height
+)
+	: config(config), width(width), height(height) {
+	// every other pixel of a row starts a run in the worst case
+	const size_t max_runs =
+		static_cast<size_t>(height) * ((static_cast<size_t>(width) + 1) / 2);
+	runs.reserve(max_runs);
+	run_parents.reserve(max_runs);
+	run_components.reserve(max_runs);
+	components.reserve(max_runs);
+	blobs.reserve(static_cast<size_t>(config.max_blobs));
+}
+
+size_t
+ObstacleBlobExtractor::collect_runs(std::span<const float> depth, int row) {
+	const float* values = depth.data() + static_cast<size_t>(row) * width;
+	const size_t runs_before = runs.size();
+	int x = 0;
+	while (x < width) {
+		while (x < width && values[x] < config.near_threshold)
+			x++;
+		if (x == width)
+			break;
+
+		Run run(row, x, x, 0.0f, 0.0f);
+		for (; x < width && values[x] >= config.near_threshold; x++) {
+			run.depth_sum += values[x];
+			run.depth_max = std::max(run.depth_max, values[x]);
+		}
+		run.end = x;
+		run_parents.push_back(static_cast<uint32_t>(runs.size()));
+		runs.push_back(run);
+	}
+	return runs.size() - runs_before;
+}
+
+uint32_t ObstacleBlobExtractor::find_root(uint32_t run) {
+	// path halving
+	while (run_parents[run] != run) {
+		run_parents[run] = run_parents[run_parents[run]];
+		run = run_parents[run];
+	}
+	return run;
+}
+
+void ObstacleBlobExtractor::unite(uint32_t a, uint32_t b) {
+	const uint32_t root_a = find_root(a);
+	const uint32_t root_b = find_root(b);
+	if (root_a < root_b)
+		run_parents[root_b] = root_a;
+	else if (root_b < root_a)
+		run_parents[root_a] = root_b;
+}
+
+void ObstacleBlobExtractor::merge_runs(
+	size_t previous_begin,
+	size_t previous_end,
+	size_t current_begin,
+	size_t current_end
+) {
+	// both rows are sorted by column, 8-connected runs touch diagonally too
+	size_t previous = previous_begin;
+	for (size_t current = current_begin; current < current_end; current++) {
+		const Run& run = runs[current];
+		while (previous < previous_end && runs[previous].end < run.begin)
+			previous++;
+		for (size_t other = previous;
+			 other < previous_end && runs[other].begin <= run.end; other++)
+			unite(static_cast<uint32_t>(current), static_cast<uint32_t>(other));
+	}
+}
+
+void ObstacleBlobExtractor::collect_blobs() {
+	// roots are the first run of their component, so a component is created
+	// before any of its other runs is visited
+	components.clear();
+	run_components.resize(runs.size());
+	for (size_t i = 0; i < runs.size(); i++) {
+		const Run& run = runs[i];
+		const uint32_t root = find_root(static_cast<uint32_t>(i));
+		if (root == i) {
+			run_components[i] = static_cast<uint32_t>(components.size());
+			components.push_back(Component(
+				run.begin, run.row, run.end - 1, run.row, 0, 0.0, 0.0, 0.0, 0.0f
+			));
+		} else {
+			run_components[i] = run_components[root];
+		}
+
+		Component& component = components[run_components[i]];
+		const int length = run.end - run.begin;
+		component.min_x = std::min(component.min_x, run.begin);
+		component.max_x = std::max(component.max_x, run.end - 1);
+		component.max_y = run.row;
+		component.area += length;
+		component.x_sum += static_cast<double>(run.begin + run.end - 1) *
+						   static_cast<double>(length) / 2.0;
+		component.y_sum +=
+			static_cast<double>(run.row) * static_cast<double>(length);
+		component.depth_sum += run.depth_sum;
+		component.depth_max = std::max(component.depth_max, run.depth_max);
+	}
+
+	blobs.clear();
+	const auto max_blobs = static_cast<size_t>(config.max_blobs);
+	const auto nearer = [](const ObstacleBlob& a, const ObstacleBlob& b) {
+		return a.nearest > b.nearest;
+	};
+	for (const Component& component : components) {
+		if (component.area < config.min_area)
+			continue;
+		const auto area = static_cast<double>(component.area);
+		const ObstacleBlob blob(
+			component.min_x, component.min_y, component.max_x, component.max_y,
+			component.area, static_cast<float>(component.x_sum / area),
+			static_cast<float>(component.y_sum / area),
+			static_cast<float>(component.depth_sum / area),
+			component.depth_max
+		);
+		// keeps the nearest blobs as a min-heap of nearest
+		if (blobs.size() < max_blobs) {
+			blobs.push_back(blob);
+			std::ranges::push_heap(blobs, nearer);
+		} else if (blob.nearest > blobs.front().nearest) {
+			std::ranges::pop_heap(blobs, nearer);
+			blobs.back() = blob;
+			std::ranges::push_heap(blobs, nearer);
+		}
+	}
+	std::ranges::sort(blobs, nearer);
+}
+
+tl::expected<std::span<const ObstacleBlob>, ImageBufferSizeMismatch>
+ObstacleBlobExtractor::extract(std::span<const float> depth) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto depth_size = static_cast<size_t>(width) * height;
+	if (depth.size() != depth_size)
+		return tl::unexpected(ImageBufferSizeMismatch(depth_size, depth.size())
+		);
+
+	runs.clear();
+	run_parents.clear();
+	size_t previous_begin = 0;
+	size_t previous_end = 0;
+	for (int row = 0; row < height; row++) {
+		const size_t current_begin = runs.size();
+		collect_runs(depth, row);
+		merge_runs(previous_begin, previous_end, current_begin, runs.size());
+		previous_begin = current_begin;
+		previous_end = runs.size();
+	}
+	collect_blobs();
+	return std::span<const ObstacleBlob>(blobs);
+}
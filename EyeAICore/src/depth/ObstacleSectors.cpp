@@ -0,0 +1,302 @@
+#include "EyeAICore/depth/ObstacleSectors.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+static float radians(float degrees) {
+	return degrees * std::numbers::pi_v<float> / 180.0f;
+}
+
+static float degrees(float radians) {
+	return radians * 180.0f / std::numbers::pi_v<float>;
+}
+
+std::string InvalidSectorLayout::to_string() const {
+	return std::format("Invalid obstacle sector layout: {}", reason);
+}
+
+std::string SectorDepthSizeMismatch::to_string() const {
+	return std::format(
+		"Depth map has {} values, but the obstacle sectors expect {}",
+		actual_size, expected_size
+	);
+}
+
+std::string SectorCountMismatch::to_string() const {
+	return std::format(
+		"Output has room for {} obstacle sectors, but the layout has {}",
+		actual_count, expected_count
+	);
+}
+
+/// sector of each pixel (row-major), -1 for pixels outside of all sectors
+static std::vector<int> compute_sector_map(
+	const SectorLayoutConfig& config,
+	int width,
+	int height,
+	float vertical_fov_degrees
+) {
+	const float half_plane_width =
+		std::tan(radians(config.horizontal_fov_degrees) / 2.0f);
+	const float half_plane_height =
+		std::tan(radians(vertical_fov_degrees) / 2.0f);
+	const float roll = radians(config.roll_degrees);
+	const float roll_cos = std::cos(roll);
+	const float roll_sin = std::sin(roll);
+	const float pitch = radians(config.pitch_degrees);
+	const float pitch_cos = std::cos(pitch);
+	const float pitch_sin = std::sin(pitch);
+
+	const float half_azimuth = radians(config.horizontal_fov_degrees) / 2.0f;
+	const float min_elevation = pitch - radians(vertical_fov_degrees) / 2.0f;
+	const float elevation_range = radians(vertical_fov_degrees);
+
+	std::vector<int> sector_map(static_cast<size_t>(width) * height, -1);
+	for (int y = 0; y < height; y++) {
+		// image plane coordinates at distance 1, y upwards
+		const float v = (1.0f - 2.0f * (static_cast<float>(y) + 0.5f) /
+									static_cast<float>(height)) *
+						half_plane_height;
+		for (int x = 0; x < width; x++) {
+			const float u = (2.0f * (static_cast<float>(x) + 0.5f) /
+								 static_cast<float>(width) -
+							 1.0f) *
+							half_plane_width;
+			// undo the roll, so rows of sectors are parallel to the horizon
+			const float level_u = u * roll_cos + v * roll_sin;
+			const float level_v = -u * roll_sin + v * roll_cos;
+
+			float column_position = 0.0f;
+			float row_position = 0.0f;
+			if (config.layout == SectorLayout::Grid) {
+				column_position =
+					(level_u + half_plane_width) / (2.0f * half_plane_width);
+				row_position =
+					(half_plane_height - level_v) / (2.0f * half_plane_height);
+			} else {
+				const float forward = pitch_cos - level_v * pitch_sin;
+				const float up = pitch_sin + level_v * pitch_cos;
+				const float azimuth = std::atan2(level_u, forward);
+				const float elevation =
+					std::atan2(up, std::hypot(level_u, forward));
+				column_position =
+					(azimuth + half_azimuth) / (2.0f * half_azimuth);
+				row_position =
+					1.0f - (elevation - min_elevation) / elevation_range;
+			}
+			if (column_position < 0.0f || column_position >= 1.0f ||
+				row_position < 0.0f || row_position >= 1.0f)
+				continue;
+
+			const int column = static_cast<int>(
+				column_position * static_cast<float>(config.columns)
+			);
+			const int row = static_cast<int>(
+				row_position * static_cast<float>(config.rows)
+			);
+			sector_map[static_cast<size_t>(y) * width + x] =
+				row * config.columns + column;
+		}
+	}
+	return sector_map;
+}
+
+static std::vector<SectorDirection> compute_sector_directions(
+	const SectorLayoutConfig& config,
+	float vertical_fov_degrees
+) {
+	const float half_plane_width =
+		std::tan(radians(config.horizontal_fov_degrees) / 2.0f);
+	const float half_plane_height =
+		std::tan(radians(vertical_fov_degrees) / 2.0f);
+
+	std::vector<SectorDirection> directions;
+	for (int row = 0; row < config.rows; row++) {
+		const float row_center =
+			(static_cast<float>(row) + 0.5f) / static_cast<float>(config.rows);
+		for (int column = 0; column < config.columns; column++) {
+			const float column_center = (static_cast<float>(column) + 0.5f) /
+										static_cast<float>(config.columns);
+			if (config.layout == SectorLayout::Grid) {
+				const float u =
+					(2.0f * column_center - 1.0f) * half_plane_width;
+				const float v = (1.0f - 2.0f * row_center) * half_plane_height;
+				directions.emplace_back(
+					degrees(std::atan(u)),
+					degrees(std::atan2(v, std::hypot(u, 1.0f)))
+				);
+			} else {
+				directions.emplace_back(
+					(column_center - 0.5f) * config.horizontal_fov_degrees,
+					config.pitch_degrees +
+						(0.5f - row_center) * vertical_fov_degrees
+				);
+			}
+		}
+	}
+	return directions;
+}
+
+tl::expected<ObstacleSectorSummarizer, InvalidSectorLayout>
+ObstacleSectorSummarizer::create(
+	const SectorLayoutConfig& config,
+	int width,
+	int height
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (width <= 0 || height <= 0) {
+		return tl::unexpected(InvalidSectorLayout(
+			std::format("depth map size {}x{} is empty", width, height)
+		));
+	}
+	if (config.columns <= 0 || config.rows <= 0) {
+		return tl::unexpected(InvalidSectorLayout(std::format(
+			"{}x{} sectors, needs at least one column and row", config.columns,
+			config.rows
+		)));
+	}
+	const float vertical_fov_degrees = config.vertical_fov_degrees.value_or(
+		degrees(
+			2.0f * std::atan(
+					   std::tan(radians(config.horizontal_fov_degrees) / 2.0f) *
+					   static_cast<float>(height) / static_cast<float>(width)
+				   )
+		)
+	);
+	for (const float fov : {config.horizontal_fov_degrees, vertical_fov_degrees}
+	) {
+		if (!(fov > 0.0f && fov < 180.0f)) {
+			return tl::unexpected(InvalidSectorLayout(
+				std::format("field of view of {} degrees", fov)
+			));
+		}
+	}
+	if (!(config.full_confidence_coverage > 0.0f)) {
+		return tl::unexpected(InvalidSectorLayout(
+			"full confidence coverage has to be greater than 0"
+		));
+	}
+
+	const auto sector_map =
+		compute_sector_map(config, width, height, vertical_fov_degrees);
+	const auto sector_count =
+		static_cast<size_t>(config.columns) * static_cast<size_t>(config.rows);
+
+	std::vector<std::vector<PixelRun>> runs_per_sector(sector_count);
+	for (int y = 0; y < height; y++) {
+		const size_t row_offset = static_cast<size_t>(y) * width;
+		int x = 0;
+		while (x < width) {
+			const int sector = sector_map[row_offset + x];
+			const int run_start = x;
+			while (x < width && sector_map[row_offset + x] == sector)
+				x++;
+			if (sector >= 0) {
+				runs_per_sector[static_cast<size_t>(sector)].emplace_back(
+					static_cast<uint32_t>(row_offset + run_start),
+					static_cast<uint32_t>(x - run_start)
+				);
+			}
+		}
+	}
+
+	std::vector<PixelRun> runs;
+	std::vector<uint32_t> sector_run_offsets;
+	std::vector<uint32_t> sector_pixel_counts;
+	sector_run_offsets.reserve(sector_count + 1);
+	sector_pixel_counts.reserve(sector_count);
+	for (const auto& sector_runs : runs_per_sector) {
+		sector_run_offsets.push_back(static_cast<uint32_t>(runs.size()));
+		uint32_t pixel_count = 0;
+		for (const auto& run : sector_runs)
+			pixel_count += run.length;
+		sector_pixel_counts.push_back(pixel_count);
+		runs.insert(runs.end(), sector_runs.begin(), sector_runs.end());
+	}
+	sector_run_offsets.push_back(static_cast<uint32_t>(runs.size()));
+
+	return ObstacleSectorSummarizer(
+		config, width, height, std::move(runs), std::move(sector_run_offsets),
+		std::move(sector_pixel_counts),
+		compute_sector_directions(config, vertical_fov_degrees)
+	);
+}
+
+ObstacleSectorSummarizer::ObstacleSectorSummarizer(
+	const SectorLayoutConfig& config,
+	int width,
+	int height,
+	std::vector<PixelRun>&& runs,
+	std::vector<uint32_t>&& sector_run_offsets,
+	std::vector<uint32_t>&& sector_pixel_counts,
+	std::vector<SectorDirection>&& sector_directions
+) :
+	config(config), width(width), height(height), runs(std::move(runs)),
+	sector_run_offsets(std::move(sector_run_offsets)),
+	sector_pixel_counts(std::move(sector_pixel_counts)),
+	sector_directions(std::move(sector_directions)) {}
+
+std::optional<SummarizeObstacleSectorsError>
+ObstacleSectorSummarizer::summarize(
+	std::span<const float> depth,
+	std::span<ObstacleSector> out_sectors
+) const {
+	PROFILE_DEPTH_FUNCTION()
+
+	const size_t expected_size = static_cast<size_t>(width) * height;
+	if (depth.size() != expected_size)
+		return SectorDepthSizeMismatch(expected_size, depth.size());
+	if (out_sectors.size() != get_sector_count())
+		return SectorCountMismatch(get_sector_count(), out_sectors.size());
+
+	const Float4 threshold = Float4::broadcast(config.obstacle_threshold);
+	for (size_t sector = 0; sector < get_sector_count(); sector++) {
+		const uint32_t pixel_count = sector_pixel_counts[sector];
+		if (pixel_count == 0) {
+			out_sectors[sector] = ObstacleSector();
+			continue;
+		}
+
+		Float4 max = Float4::broadcast(0.0f);
+		Float4 sum = Float4::broadcast(0.0f);
+		Float4 obstacle_count = Float4::broadcast(0.0f);
+		float tail_max = 0.0f;
+		float tail_sum = 0.0f;
+		float tail_obstacle_count = 0.0f;
+		for (uint32_t i = sector_run_offsets[sector];
+			 i < sector_run_offsets[sector + 1]; i++) {
+			const auto values = depth.subspan(runs[i].offset, runs[i].length);
+			size_t x = 0;
+			for (; x + 4 <= values.size(); x += 4) {
+				const Float4 value = Float4::load(&values[x]);
+				max = Float4::max(max, value);
+				sum = sum + value;
+				obstacle_count = obstacle_count +
+								 Float4::mask_to_ones(
+									 Float4::greater_equal(value, threshold)
+								 );
+			}
+			for (; x < values.size(); x++) {
+				tail_max = std::max(tail_max, values[x]);
+				tail_sum += values[x];
+				if (values[x] >= config.obstacle_threshold)
+					tail_obstacle_count += 1.0f;
+			}
+		}
+
+		const float coverage =
+			(obstacle_count.horizontal_sum() + tail_obstacle_count) /
+			static_cast<float>(pixel_count);
+		out_sectors[sector] = ObstacleSector(
+			std::max(max.horizontal_max(), tail_max),
+			(sum.horizontal_sum() + tail_sum) / static_cast<float>(pixel_count),
+			coverage,
+			std::min(1.0f, coverage / config.full_confidence_coverage)
+		);
+	}
+
+	return std::nullopt;
+}
@@ -0,0 +1,129 @@
+#include "EyeAICore/depth/ObstacleTracker.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include <algorithm>
+#include <format>
+
+/// intersection over union of two inclusive bounding boxes
+static float overlap(const ObstacleBlob& a, const ObstacleBlob& b) {
+	const int width =
+		std::min(a.max_x, b.max_x) - std::max(a.min_x, b.min_x) + 1;
+	const int height =
+		std::min(a.max_y, b.max_y) - std::max(a.min_y, b.min_y) + 1;
+	if (width <= 0 || height <= 0)
+		return 0.0f;
+
+	const auto area = [](const ObstacleBlob& blob) {
+		return (blob.max_x - blob.min_x + 1) * (blob.max_y - blob.min_y + 1);
+	};
+	const int intersection = width * height;
+	return static_cast<float>(intersection) /
+		   static_cast<float>(area(a) + area(b) - intersection);
+}
+
+std::string InvalidObstacleTrackerConfig::to_string() const {
+	return std::format("Invalid obstacle tracker config: {}", reason);
+}
+
+tl::expected<ObstacleTracker, InvalidObstacleTrackerConfig>
+ObstacleTracker::create(const ObstacleTrackerConfig& config, int max_blobs) {
+	if (config.min_overlap <= 0.0f || config.min_overlap > 1.0f)
+		return tl::unexpected(
+			InvalidObstacleTrackerConfig("min overlap has to be in (0, 1]")
+		);
+	if (config.max_missed_frames < 0 || config.min_confirmed_frames <= 0)
+		return tl::unexpected(InvalidObstacleTrackerConfig(
+			"missed frames can not be negative and confirmed frames have to "
+			"be positive"
+		));
+	if (config.max_tracks <= 0 || max_blobs <= 0)
+		return tl::unexpected(InvalidObstacleTrackerConfig(
+			"max tracks and max blobs have to be positive"
+		));
+	if (config.approach_smoothing <= 0.0f || config.approach_smoothing > 1.0f)
+		return tl::unexpected(InvalidObstacleTrackerConfig(
+			"approach smoothing has to be in (0, 1]"
+		));
+
+	return ObstacleTracker(config, max_blobs);
+}
+
+ObstacleTracker::ObstacleTracker(
+	const ObstacleTrackerConfig& config,
+	int max_blobs
+)
+	: config(config), max_blobs(max_blobs) {
+	const auto max_tracks = static_cast<size_t>(config.max_tracks);
+	tracks.reserve(max_tracks);
+	candidates.reserve(max_tracks * static_cast<size_t>(max_blobs));
+	matched_tracks.reserve(max_tracks);
+	matched_blobs.reserve(static_cast<size_t>(max_blobs));
+}
+
+void ObstacleTracker::update(std::span<const ObstacleBlob> blobs) {
+	PROFILE_DEPTH_FUNCTION()
+
+	blobs = blobs.first(std::min(blobs.size(), static_cast<size_t>(max_blobs)));
+
+	candidates.clear();
+	for (size_t track = 0; track < tracks.size(); track++) {
+		for (size_t blob = 0; blob < blobs.size(); blob++) {
+			const float track_overlap =
+				overlap(tracks[track].blob, blobs[blob]);
+			if (track_overlap >= config.min_overlap)
+				candidates.push_back(Candidate(
+					track_overlap, static_cast<uint32_t>(track),
+					static_cast<uint32_t>(blob)
+				));
+		}
+	}
+	std::ranges::sort(candidates, [](const Candidate& a, const Candidate& b) {
+		return a.overlap > b.overlap;
+	});
+
+	matched_tracks.assign(tracks.size(), 0);
+	matched_blobs.assign(blobs.size(), 0);
+	for (const Candidate& candidate : candidates) {
+		if (matched_tracks[candidate.track] != 0 ||
+			matched_blobs[candidate.blob] != 0)
+			continue;
+		matched_tracks[candidate.track] = 1;
+		matched_blobs[candidate.blob] = 1;
+
+		TrackedObstacle& track = tracks[candidate.track];
+		const ObstacleBlob& blob = blobs[candidate.blob];
+		// spread the change over the frames the blob was missing
+		const float approach = (blob.nearest - track.blob.nearest) /
+							   static_cast<float>(track.missed_frames + 1);
+		track.approach_rate +=
+			config.approach_smoothing * (approach - track.approach_rate);
+		track.blob = blob;
+		track.missed_frames = 0;
+		track.seen_frames++;
+		if (track.seen_frames >= config.min_confirmed_frames)
+			track.confirmed = true;
+	}
+
+	for (size_t i = 0; i < tracks.size(); i++) {
+		tracks[i].age++;
+		if (matched_tracks[i] == 0)
+			tracks[i].missed_frames++;
+	}
+	std::erase_if(tracks, [&](const TrackedObstacle& track) {
+		return track.missed_frames > config.max_missed_frames;
+	});
+
+	// blobs are ordered nearest first, so the nearest get the free tracks
+	for (size_t blob = 0; blob < blobs.size(); blob++) {
+		if (matched_blobs[blob] != 0)
+			continue;
+		if (tracks.size() >= static_cast<size_t>(config.max_tracks))
+			break;
+		TrackedObstacle track;
+		track.id = next_id++;
+		track.blob = blobs[blob];
+		track.confirmed = config.min_confirmed_frames <= 1;
+		tracks.push_back(track);
+	}
+}
+
+void ObstacleTracker::reset() { tracks.clear(); }
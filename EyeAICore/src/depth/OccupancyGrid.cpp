@@ -0,0 +1,148 @@
+#include "EyeAICore/depth/OccupancyGrid.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+std::string InvalidOccupancyGridConfig::to_string() const {
+	return std::format("Invalid occupancy grid config: {}", reason);
+}
+
+tl::expected<OccupancyGrid, InvalidOccupancyGridConfig>
+OccupancyGrid::create(const OccupancyGridConfig& config) {
+	if (config.cell_size <= 0.0f)
+		return tl::unexpected(
+			InvalidOccupancyGridConfig("cell size has to be positive")
+		);
+	if (config.columns <= 0 || config.rows <= 0)
+		return tl::unexpected(
+			InvalidOccupancyGridConfig("grid size has to be positive")
+		);
+	if (config.camera_height <= 0.0f || config.floor_clearance < 0.0f ||
+		config.floor_clearance >= config.camera_height + config.head_clearance)
+		return tl::unexpected(InvalidOccupancyGridConfig(
+			"camera height and clearances leave no obstacle heights"
+		));
+	if (config.full_occupancy_area <= 0.0f)
+		return tl::unexpected(InvalidOccupancyGridConfig(
+			"full occupancy area has to be positive"
+		));
+	if (config.decay < 0.0f || config.decay > 1.0f)
+		return tl::unexpected(
+			InvalidOccupancyGridConfig("decay has to be in [0, 1]")
+		);
+	if (config.min_occupancy <= 0.0f || config.min_occupancy > 1.0f)
+		return tl::unexpected(
+			InvalidOccupancyGridConfig("min occupancy has to be in (0, 1]")
+		);
+
+	return OccupancyGrid(config);
+}
+
+OccupancyGrid::OccupancyGrid(const OccupancyGridConfig& config)
+	: config(config) {
+	const auto cell_count = static_cast<size_t>(config.columns) * config.rows;
+	occupancy.resize(cell_count);
+	bottom_heights.resize(cell_count);
+	top_heights.resize(cell_count);
+	occupied_cells.reserve(cell_count);
+	occupied_flags.resize(cell_count);
+	frame_areas.resize(cell_count);
+	frame_bottom_heights.resize(cell_count);
+	frame_top_heights.resize(cell_count);
+	observed_cells.reserve(cell_count);
+}
+
+void OccupancyGrid::bin_points(
+	const PointCloud& points,
+	const GroundPlane& floor
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const float inverse_cell_size = 1.0f / config.cell_size;
+	const float column_offset = static_cast<float>(config.columns) / 2.0f;
+	const auto columns = static_cast<float>(config.columns);
+	const auto rows = static_cast<float>(config.rows);
+	const float min_height = config.floor_clearance;
+	// the head clearance is relative to the camera
+	const float max_height = floor.offset + config.head_clearance;
+
+	observed_cells.clear();
+	for (size_t i = 0; i < points.size(); i++) {
+		const float height =
+			floor.height(points.x[i], points.y[i], points.z[i]);
+		if (height <= min_height || height > max_height)
+			continue;
+		const float column = points.x[i] * inverse_cell_size + column_offset;
+		const float row = points.z[i] * inverse_cell_size;
+		// also rejects points behind the camera and nan
+		if (!(column >= 0.0f && column < columns && row >= 0.0f && row < rows))
+			continue;
+
+		const auto cell = static_cast<uint32_t>(row) *
+							  static_cast<uint32_t>(config.columns) +
+						  static_cast<uint32_t>(column);
+		const float area = points.z[i] * points.z[i] * points.pixel_area;
+		if (frame_areas[cell] == 0.0f) {
+			observed_cells.push_back(cell);
+			frame_bottom_heights[cell] = height;
+			frame_top_heights[cell] = height;
+		} else {
+			frame_bottom_heights[cell] =
+				std::min(frame_bottom_heights[cell], height);
+			frame_top_heights[cell] = std::max(frame_top_heights[cell], height);
+		}
+		frame_areas[cell] += area;
+	}
+}
+
+void OccupancyGrid::integrate(const PointCloud& points) {
+	integrate(points, GroundPlane::level(config.camera_height));
+}
+
+void OccupancyGrid::integrate(
+	const PointCloud& points,
+	const GroundPlane& floor
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	// free cells stay 0 under the decay, so only occupied cells are decayed
+	std::erase_if(occupied_cells, [this](uint32_t cell) {
+		occupancy[cell] *= config.decay;
+		if (occupancy[cell] >= config.min_occupancy)
+			return false;
+		occupancy[cell] = 0.0f;
+		occupied_flags[cell] = 0;
+		return true;
+	});
+
+	bin_points(points, floor);
+
+	const float inverse_full_area = 1.0f / config.full_occupancy_area;
+	for (const uint32_t cell : observed_cells) {
+		const float hit = std::min(frame_areas[cell] * inverse_full_area, 1.0f);
+		frame_areas[cell] = 0.0f;
+		const float updated = occupancy[cell] + (1.0f - occupancy[cell]) * hit;
+		if (updated < config.min_occupancy)
+			continue;
+
+		// the latest frame decides the extent, older points are only
+		// remembered through the occupancy
+		occupancy[cell] = updated;
+		bottom_heights[cell] = frame_bottom_heights[cell];
+		top_heights[cell] = frame_top_heights[cell];
+		if (occupied_flags[cell] == 0) {
+			occupied_flags[cell] = 1;
+			occupied_cells.push_back(cell);
+		}
+	}
+}
+
+void OccupancyGrid::reset() {
+	for (const uint32_t cell : occupied_cells) {
+		occupancy[cell] = 0.0f;
+		occupied_flags[cell] = 0;
+	}
+	occupied_cells.clear();
+	observed_cells.clear();
+}
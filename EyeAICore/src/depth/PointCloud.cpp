@@ -0,0 +1,160 @@
+#include "EyeAICore/depth/PointCloud.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <numbers>
+
+static float radians(float degrees) {
+	return degrees * std::numbers::pi_v<float> / 180.0f;
+}
+
+CameraIntrinsics CameraIntrinsics::from_horizontal_fov(
+	int width,
+	int height,
+	float horizontal_fov_degrees
+) {
+	const float focal = static_cast<float>(width) / 2.0f /
+						std::tan(radians(horizontal_fov_degrees) / 2.0f);
+	return CameraIntrinsics(
+		focal, focal, static_cast<float>(width) / 2.0f,
+		static_cast<float>(height) / 2.0f
+	);
+}
+
+std::string InvalidBackProjectionConfig::to_string() const {
+	return std::format("Invalid back-projection config: {}", reason);
+}
+
+tl::expected<DepthBackProjector, InvalidBackProjectionConfig>
+DepthBackProjector::create(
+	const BackProjectionConfig& config,
+	int width,
+	int height
+) {
+	if (width <= 0 || height <= 0)
+		return tl::unexpected(
+			InvalidBackProjectionConfig("depth size has to be positive")
+		);
+	if (config.near_distance <= 0.0f ||
+		config.far_distance <= config.near_distance)
+		return tl::unexpected(InvalidBackProjectionConfig(
+			"near distance has to be positive and below the far distance"
+		));
+	if (!config.intrinsics && (config.horizontal_fov_degrees <= 0.0f ||
+							   config.horizontal_fov_degrees >= 180.0f))
+		return tl::unexpected(InvalidBackProjectionConfig(
+			"horizontal fov has to be in (0, 180) degrees"
+		));
+
+	const CameraIntrinsics intrinsics = config.intrinsics.value_or(
+		CameraIntrinsics::from_horizontal_fov(
+			width, height, config.horizontal_fov_degrees
+		)
+	);
+	if (intrinsics.focal_x <= 0.0f || intrinsics.focal_y <= 0.0f)
+		return tl::unexpected(
+			InvalidBackProjectionConfig("focal lengths have to be positive")
+		);
+
+	return DepthBackProjector(config, intrinsics, width, height);
+}
+
+DepthBackProjector::DepthBackProjector(
+	const BackProjectionConfig& config,
+	const CameraIntrinsics& intrinsics,
+	int width,
+	int height
+)
+	: config(config), intrinsics(intrinsics), width(width), height(height),
+	  column_u(static_cast<size_t>(width)),
+	  row_offsets(static_cast<size_t>(height) * 3) {
+	const float roll = radians(config.roll_degrees);
+	const float roll_cos = std::cos(roll);
+	const float roll_sin = std::sin(roll);
+	const float pitch = radians(config.pitch_degrees);
+	const float pitch_cos = std::cos(pitch);
+	const float pitch_sin = std::sin(pitch);
+
+	for (int x = 0; x < width; x++) {
+		column_u[static_cast<size_t>(x)] =
+			(static_cast<float>(x) + 0.5f - intrinsics.center_x) /
+			intrinsics.focal_x;
+	}
+
+	// the ray (u, v, 1) of the camera (v upwards) is rotated like in the
+	// obstacle sectors: the roll is undone first, then the pitch, both are
+	// linear in u and v
+	u_axis = {roll_cos, -roll_sin * pitch_cos, roll_sin * pitch_sin};
+	for (int y = 0; y < height; y++) {
+		const float v = (intrinsics.center_y - static_cast<float>(y) - 0.5f) /
+						intrinsics.focal_y;
+		const auto row = static_cast<size_t>(y) * 3;
+		row_offsets[row] = v * roll_sin;
+		row_offsets[row + 1] = pitch_sin + v * roll_cos * pitch_cos;
+		row_offsets[row + 2] = pitch_cos - v * roll_cos * pitch_sin;
+	}
+}
+
+std::optional<ImageBufferSizeMismatch> DepthBackProjector::project(
+	std::span<const float> depth,
+	PointCloud& out_points
+) const {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto row_width = static_cast<size_t>(width);
+	const auto depth_size = row_width * height;
+	if (depth.size() != depth_size)
+		return ImageBufferSizeMismatch(depth_size, depth.size());
+	out_points.resize(depth_size);
+	out_points.pixel_area = 1.0f / (intrinsics.focal_x * intrinsics.focal_y);
+
+	// distance = 1 / (far_inverse + depth * inverse_range)
+	const float far_inverse = 1.0f / config.far_distance;
+	const float inverse_range = 1.0f / config.near_distance - far_inverse;
+
+	const Float4 zero = Float4::broadcast(0.0f);
+	const Float4 one = Float4::broadcast(1.0f);
+	const Float4 far_inverse4 = Float4::broadcast(far_inverse);
+	const Float4 inverse_range4 = Float4::broadcast(inverse_range);
+	const Float4 u_axis_x = Float4::broadcast(u_axis[0]);
+	const Float4 u_axis_y = Float4::broadcast(u_axis[1]);
+	const Float4 u_axis_z = Float4::broadcast(u_axis[2]);
+
+	for (size_t y = 0; y < static_cast<size_t>(height); y++) {
+		const float* depth_row = depth.data() + y * row_width;
+		float* out_x = out_points.x.data() + y * row_width;
+		float* out_y = out_points.y.data() + y * row_width;
+		float* out_z = out_points.z.data() + y * row_width;
+		const float offset_x = row_offsets[y * 3];
+		const float offset_y = row_offsets[y * 3 + 1];
+		const float offset_z = row_offsets[y * 3 + 2];
+		const Float4 offset_x4 = Float4::broadcast(offset_x);
+		const Float4 offset_y4 = Float4::broadcast(offset_y);
+		const Float4 offset_z4 = Float4::broadcast(offset_z);
+
+		size_t x = 0;
+		for (; x + 4 <= row_width; x += 4) {
+			const Float4 value = Float4::min(
+				Float4::max(Float4::load(depth_row + x), zero), one
+			);
+			const Float4 distance =
+				Float4::reciprocal(far_inverse4 + value * inverse_range4);
+			const Float4 u = Float4::load(column_u.data() + x);
+			(distance * (u * u_axis_x + offset_x4)).store(out_x + x);
+			(distance * (u * u_axis_y + offset_y4)).store(out_y + x);
+			(distance * (u * u_axis_z + offset_z4)).store(out_z + x);
+		}
+		for (; x < row_width; x++) {
+			const float value = std::clamp(depth_row[x], 0.0f, 1.0f);
+			const float distance =
+				1.0f / (far_inverse + value * inverse_range);
+			const float u = column_u[x];
+			out_x[x] = distance * (u * u_axis[0] + offset_x);
+			out_y[x] = distance * (u * u_axis[1] + offset_y);
+			out_z[x] = distance * (u * u_axis[2] + offset_z);
+		}
+	}
+	return std::nullopt;
+}
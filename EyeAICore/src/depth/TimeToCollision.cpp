@@ -0,0 +1,194 @@
+#include "EyeAICore/depth/TimeToCollision.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+std::string InvalidTimeToCollisionConfig::to_string() const {
+	return std::format("Invalid time to collision config: {}", reason);
+}
+
+std::string CollisionThreat::formatted() const {
+	if (!time_to_collision)
+		return std::format("Obstacle #{}: not approaching", id);
+	return std::format(
+		"Obstacle #{}: {:.1f} s to collision (nearest: {:.2f})", id,
+		*time_to_collision, blob.nearest
+	);
+}
+
+tl::expected<TimeToCollisionEstimator, InvalidTimeToCollisionConfig>
+TimeToCollisionEstimator::create(const TimeToCollisionConfig& config) {
+	if (config.window_samples < 2 ||
+		config.window_samples > MAX_WINDOW_SAMPLES)
+		return tl::unexpected(InvalidTimeToCollisionConfig(std::format(
+			"window samples have to be in [2, {}]", MAX_WINDOW_SAMPLES
+		)));
+	if (config.min_samples < 2 || config.min_samples > config.window_samples)
+		return tl::unexpected(InvalidTimeToCollisionConfig(
+			"min samples have to be in [2, window samples]"
+		));
+	if (config.window_seconds <= 0.0f || config.max_time_to_collision <= 0.0f)
+		return tl::unexpected(InvalidTimeToCollisionConfig(
+			"window seconds and max time to collision have to be positive"
+		));
+	if (config.looming_weight < 0.0f || config.looming_weight > 1.0f)
+		return tl::unexpected(
+			InvalidTimeToCollisionConfig("looming weight has to be in [0, 1]")
+		);
+	if (config.smoothing <= 0.0f || config.smoothing > 1.0f)
+		return tl::unexpected(
+			InvalidTimeToCollisionConfig("smoothing has to be in (0, 1]")
+		);
+	if (config.max_tracks <= 0)
+		return tl::unexpected(
+			InvalidTimeToCollisionConfig("max tracks have to be positive")
+		);
+
+	return TimeToCollisionEstimator(config);
+}
+
+TimeToCollisionEstimator::TimeToCollisionEstimator(
+	const TimeToCollisionConfig& config
+)
+	: config(config) {
+	const auto max_tracks = static_cast<size_t>(config.max_tracks);
+	histories.reserve(max_tracks);
+	next_histories.reserve(max_tracks);
+	threats.reserve(max_tracks);
+	const auto window = static_cast<size_t>(config.window_samples);
+	slopes.reserve(window * (window - 1) / 2);
+}
+
+void TimeToCollisionEstimator::add_sample(
+	TrackHistory& history,
+	const Sample& sample
+) const {
+	// the same depth output can be analyzed twice (e.g. skipped inference)
+	if (history.sample_count > 0 &&
+		history.samples[static_cast<size_t>(history.sample_count - 1)].time >=
+			sample.time)
+		return;
+
+	const auto window = std::chrono::duration_cast<frame_clock::duration>(
+		std::chrono::duration<float>(config.window_seconds)
+	);
+	int first_kept = 0;
+	while (first_kept < history.sample_count &&
+		   sample.time - history.samples[static_cast<size_t>(first_kept)].time >
+			   window)
+		first_kept++;
+	if (history.sample_count - first_kept == config.window_samples)
+		first_kept++;
+
+	auto samples = std::span(history.samples);
+	std::copy(
+		samples.begin() + first_kept, samples.begin() + history.sample_count,
+		samples.begin()
+	);
+	history.sample_count -= first_kept;
+	samples[static_cast<size_t>(history.sample_count)] = sample;
+	history.sample_count++;
+}
+
+std::optional<float>
+TimeToCollisionEstimator::fit_expansion_rate(const TrackHistory& history) {
+	if (history.sample_count < config.min_samples)
+		return std::nullopt;
+
+	const auto theil_sen_slope = [&](float Sample::* value) {
+		slopes.clear();
+		for (int i = 0; i < history.sample_count; i++) {
+			const Sample& a = history.samples[static_cast<size_t>(i)];
+			for (int j = i + 1; j < history.sample_count; j++) {
+				const Sample& b = history.samples[static_cast<size_t>(j)];
+				const float seconds =
+					std::chrono::duration<float>(b.time - a.time).count();
+				slopes.push_back((b.*value - a.*value) / seconds);
+			}
+		}
+		const auto median = slopes.begin() + slopes.size() / 2;
+		std::ranges::nth_element(slopes, median);
+		return *median;
+	};
+
+	// a signal without weight is not fitted
+	float rate = 0.0f;
+	if (config.looming_weight > 0.0f)
+		rate += config.looming_weight * theil_sen_slope(&Sample::log_size);
+	if (config.looming_weight < 1.0f)
+		rate += (1.0f - config.looming_weight) *
+				theil_sen_slope(&Sample::log_nearest);
+	return rate;
+}
+
+void TimeToCollisionEstimator::update(
+	std::span<const TrackedObstacle> tracks,
+	frame_clock::time_point frame_time
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	tracks = tracks.first(
+		std::min(tracks.size(), static_cast<size_t>(config.max_tracks))
+	);
+
+	// histories of tracks that are gone are dropped by the merge
+	next_histories.clear();
+	threats.clear();
+	auto history = histories.begin();
+	for (const TrackedObstacle& track : tracks) {
+		while (history != histories.end() && history->id < track.id)
+			history++;
+		if (history != histories.end() && history->id == track.id) {
+			next_histories.push_back(*history);
+		} else {
+			next_histories.push_back(TrackHistory());
+			next_histories.back().id = track.id;
+		}
+
+		TrackHistory& next = next_histories.back();
+		if (track.missed_frames == 0) {
+			const auto area = static_cast<float>(std::max(track.blob.area, 1));
+			const Sample sample(
+				frame_time, std::log(std::max(track.blob.nearest, 1e-6f)),
+				0.5f * std::log(area)
+			);
+			add_sample(next, sample);
+			if (const auto rate = fit_expansion_rate(next)) {
+				next.expansion_rate =
+					next.expansion_rate
+						? *next.expansion_rate +
+							  config.smoothing * (*rate - *next.expansion_rate)
+						: *rate;
+			}
+		}
+
+		CollisionThreat threat;
+		threat.id = track.id;
+		threat.blob = track.blob;
+		if (next.expansion_rate) {
+			threat.expansion_rate = *next.expansion_rate;
+			if (threat.expansion_rate * config.max_time_to_collision > 1.0f)
+				threat.time_to_collision = 1.0f / threat.expansion_rate;
+		}
+		threats.push_back(threat);
+	}
+	std::swap(histories, next_histories);
+}
+
+void TimeToCollisionEstimator::reset() {
+	histories.clear();
+	threats.clear();
+}
+
+std::optional<CollisionThreat> TimeToCollisionEstimator::get_most_urgent(
+) const {
+	std::optional<CollisionThreat> most_urgent;
+	for (const CollisionThreat& threat : threats) {
+		if (threat.time_to_collision &&
+			(!most_urgent ||
+			 *threat.time_to_collision < *most_urgent->time_to_collision))
+			most_urgent = threat;
+	}
+	return most_urgent;
+}
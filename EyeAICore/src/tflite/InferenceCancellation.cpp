@@ -0,0 +1,117 @@
+#include "EyeAICore/tflite/InferenceCancellation.hpp"
+#include <format>
+
+std::string InvalidInferenceCancellationConfig::to_string() const {
+	return std::format("Invalid inference cancellation config: {}", reason);
+}
+
+std::string InferenceCancellationStats::formatted() const {
+	return std::format(
+		"Cancelled inferences: {} for newer frames, {} at deadline ({} "
+		"completed, {} protected)",
+		cancelled_for_newer_frame, cancelled_at_deadline, completed,
+		protected_from_cancellation
+	);
+}
+
+tl::expected<
+	std::unique_ptr<StaleInferenceCanceller>,
+	InvalidInferenceCancellationConfig>
+StaleInferenceCanceller::create(const InferenceCancellationConfig& config) {
+	if (config.max_result_age &&
+		*config.max_result_age < frame_clock::duration::zero())
+		return tl::unexpected(InvalidInferenceCancellationConfig(
+			"max result age must not be negative"
+		));
+	if (config.max_inference_time &&
+		*config.max_inference_time <= frame_clock::duration::zero())
+		return tl::unexpected(InvalidInferenceCancellationConfig(
+			"max inference time has to be positive"
+		));
+	if (config.max_consecutive_cancellations < 1)
+		return tl::unexpected(InvalidInferenceCancellationConfig(
+			"max consecutive cancellations have to be at least 1"
+		));
+
+	return std::unique_ptr<StaleInferenceCanceller>(
+		new StaleInferenceCanceller(config)
+	);
+}
+
+void StaleInferenceCanceller::begin_inference(
+	const TfLiteRuntime& runtime,
+	frame_clock::time_point capture_time,
+	frame_clock::time_point now
+) {
+	const std::scoped_lock lock(mutex);
+	running_runtime = &runtime;
+	running_capture_time = capture_time;
+	running_start_time = now;
+	cancel_reason = CancelReason::None;
+	protected_inference = false;
+}
+
+void StaleInferenceCanceller::end_inference(bool cancelled) {
+	const std::scoped_lock lock(mutex);
+	running_runtime = nullptr;
+
+	// a cancellation can come too late, then the inference completed anyway
+	if (!cancelled) {
+		stats.completed++;
+		consecutive_cancellations = 0;
+		return;
+	}
+	consecutive_cancellations++;
+	if (cancel_reason == CancelReason::Deadline)
+		stats.cancelled_at_deadline++;
+	else
+		stats.cancelled_for_newer_frame++;
+}
+
+bool StaleInferenceCanceller::frame_available(
+	frame_clock::time_point capture_time,
+	frame_clock::time_point now
+) {
+	const std::scoped_lock lock(mutex);
+	if (!newest_frame_time || capture_time > *newest_frame_time)
+		newest_frame_time = capture_time;
+	return cancel_if_stale(now);
+}
+
+bool StaleInferenceCanceller::check(frame_clock::time_point now) {
+	const std::scoped_lock lock(mutex);
+	return cancel_if_stale(now);
+}
+
+InferenceCancellationStats StaleInferenceCanceller::get_stats() const {
+	const std::scoped_lock lock(mutex);
+	return stats;
+}
+
+bool StaleInferenceCanceller::cancel_if_stale(frame_clock::time_point now) {
+	if (running_runtime == nullptr || cancel_reason != CancelReason::None ||
+		protected_inference)
+		return false;
+
+	CancelReason reason = CancelReason::None;
+	if (config.max_inference_time &&
+		now - running_start_time > *config.max_inference_time)
+		reason = CancelReason::Deadline;
+	else if (config.max_result_age && newest_frame_time &&
+			 *newest_frame_time > running_capture_time &&
+			 now - running_capture_time > *config.max_result_age)
+		reason = CancelReason::NewerFrame;
+	if (reason == CancelReason::None)
+		return false;
+
+	if (consecutive_cancellations >= config.max_consecutive_cancellations) {
+		protected_inference = true;
+		stats.protected_from_cancellation++;
+		return false;
+	}
+	// without cancellation support the inference just runs to completion
+	if (!running_runtime->cancel_inference())
+		return false;
+	cancel_reason = reason;
+	return true;
+}
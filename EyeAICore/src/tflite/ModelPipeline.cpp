@@ -0,0 +1,299 @@
+#include "EyeAICore/tflite/ModelPipeline.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include <format>
+
+bool PreprocessParams::is_resize_only() const {
+	return layout == TensorLayout::Hwc &&
+		   mean == std::array<float, 3>{0.0f, 0.0f, 0.0f} &&
+		   stddev == std::array<float, 3>{1.0f, 1.0f, 1.0f};
+}
+
+std::string PreprocessCacheStats::formatted() const {
+	return std::format(
+		"Preprocessed inputs: {} resized, {} converted, {} reused", resized,
+		converted, reused
+	);
+}
+
+void PreprocessCache::begin_frame(
+	std::span<const uint8_t> rgb_pixels,
+	int width,
+	int height
+) {
+	this->rgb_pixels = rgb_pixels;
+	this->width = width;
+	this->height = height;
+	entries.clear();
+}
+
+tl::expected<std::shared_ptr<const std::vector<float>>, ImageBufferSizeMismatch>
+PreprocessCache::get(const PreprocessParams& params) {
+	for (const auto& entry : entries) {
+		if (entry.params == params) {
+			stats.reused++;
+			return entry.values;
+		}
+	}
+
+	PROFILE_DEPTH_FUNCTION()
+
+	if (params.is_resize_only()) {
+		auto values = acquire_buffer(params.get_element_count());
+		if (const auto error = resize_rgb8_to_floats(
+				rgb_pixels, width, height, *values, params.width,
+				params.height
+			))
+			return tl::unexpected(*error);
+		stats.resized++;
+		entries.emplace_back(params, values);
+		return values;
+	}
+
+	// normalizations and layouts of the same size share the resize
+	PreprocessParams resize_params;
+	resize_params.width = params.width;
+	resize_params.height = params.height;
+	const auto resized = get(resize_params);
+	if (!resized)
+		return tl::unexpected(resized.error());
+
+	auto values = acquire_buffer(params.get_element_count());
+	const size_t pixel_count = params.get_element_count() / 3;
+	for (size_t c = 0; c < 3; c++) {
+		const float mean = params.mean[c];
+		const float scale = 1.0f / params.stddev[c];
+		const size_t pixel_stride = params.layout == TensorLayout::Hwc ? 3 : 1;
+		float* out = params.layout == TensorLayout::Hwc
+						 ? values->data() + c
+						 : values->data() + c * pixel_count;
+		const float* in = (*resized)->data() + c;
+		for (size_t i = 0; i < pixel_count; i++)
+			out[i * pixel_stride] = (in[i * 3] - mean) * scale;
+	}
+	stats.converted++;
+	entries.emplace_back(params, values);
+	return values;
+}
+
+std::shared_ptr<std::vector<float>> PreprocessCache::acquire_buffer(size_t size
+) {
+	for (const auto& buffer : buffers) {
+		if (buffer.use_count() == 1) {
+			buffer->resize(size);
+			return buffer;
+		}
+	}
+	buffers.push_back(std::make_shared<std::vector<float>>(size));
+	return buffers.back();
+}
+
+std::string InvalidModelPipelineConfig::to_string() const {
+	return std::format("Invalid model pipeline config: {}", reason);
+}
+
+std::string
+ModelPipelineStats::formatted(const std::vector<PipelineModelConfig>& configs
+) const {
+	std::string formatted = std::format(
+		"Model pipeline: {} frames, {}", frames, preprocess.formatted()
+	);
+	for (size_t i = 0; i < models.size() && i < configs.size(); i++) {
+		formatted += std::format(
+			"\n{}: {} runs, {} skipped while busy, {} errors, last {:.1f} ms",
+			configs[i].name, models[i].runs, models[i].skipped_busy,
+			models[i].errors,
+			std::chrono::duration<double, std::milli>(
+				models[i].last_inference_time
+			)
+				.count()
+		);
+	}
+	return formatted;
+}
+
+tl::expected<std::unique_ptr<ModelPipeline>, InvalidModelPipelineConfig>
+ModelPipeline::create(
+	std::vector<PipelineModel>&& models,
+	ModelResultCallback callback
+) {
+	if (models.empty())
+		return tl::unexpected(
+			InvalidModelPipelineConfig("at least one model is required")
+		);
+	for (const auto& model : models) {
+		const auto& config = model.config;
+		if (model.runtime == nullptr)
+			return tl::unexpected(InvalidModelPipelineConfig(
+				std::format("model {} has no runtime", config.name)
+			));
+		if (model.runtime->has_input_operators())
+			return tl::unexpected(InvalidModelPipelineConfig(std::format(
+				"runtime of model {} must not have input operators, the "
+				"pipeline preprocesses its input",
+				config.name
+			)));
+		if (config.preprocess.width <= 0 || config.preprocess.height <= 0)
+			return tl::unexpected(InvalidModelPipelineConfig(std::format(
+				"input size of model {} has to be positive", config.name
+			)));
+		for (const float stddev : config.preprocess.stddev) {
+			if (!(stddev > 0.0f))
+				return tl::unexpected(InvalidModelPipelineConfig(std::format(
+					"stddev of model {} has to be positive", config.name
+				)));
+		}
+		if (config.interval < 1)
+			return tl::unexpected(InvalidModelPipelineConfig(std::format(
+				"interval of model {} has to be at least 1", config.name
+			)));
+		if (model.runtime->get_input_element_count() !=
+			config.preprocess.get_element_count())
+			return tl::unexpected(InvalidModelPipelineConfig(std::format(
+				"model {} expects {} input values, its preprocessing "
+				"produces {}",
+				config.name, model.runtime->get_input_element_count(),
+				config.preprocess.get_element_count()
+			)));
+	}
+
+	auto pipeline =
+		std::unique_ptr<ModelPipeline>(new ModelPipeline(std::move(callback)));
+	for (auto& model : models) {
+		auto worker = std::make_unique<Worker>();
+		worker->output.resize(model.runtime->get_output_element_count());
+		worker->runtime = std::move(model.runtime);
+		pipeline->configs.push_back(std::move(model.config));
+		pipeline->workers.push_back(std::move(worker));
+	}
+	pipeline->worker_locks.reserve(pipeline->workers.size());
+	pipeline->started_workers.reserve(pipeline->workers.size());
+	for (size_t i = 0; i < pipeline->workers.size(); i++) {
+		pipeline->workers[i]->thread =
+			std::jthread([pipeline = pipeline.get(),
+						  i](const std::stop_token& stop_token) {
+				pipeline->run_worker(i, stop_token);
+			});
+	}
+	return pipeline;
+}
+
+ModelPipeline::~ModelPipeline() {
+	// all workers stop at once instead of one after another
+	for (auto& worker : workers)
+		worker->thread.request_stop();
+	for (auto& worker : workers) {
+		if (worker->thread.joinable())
+			worker->thread.join();
+	}
+}
+
+tl::expected<size_t, ImageBufferSizeMismatch> ModelPipeline::process_frame(
+	std::span<const uint8_t> rgb_pixels,
+	int width,
+	int height
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const std::scoped_lock lock(frame_mutex);
+	const uint64_t index = frame_index++;
+
+	// the workers drop their inputs under their locks, so the cache sees every
+	// buffer that became free and no worker finishes during the busy checks
+	for (const auto& worker : workers)
+		worker_locks.emplace_back(worker->mutex);
+
+	preprocess_cache.begin_frame(rgb_pixels, width, height);
+	started_workers.clear();
+	std::optional<ImageBufferSizeMismatch> error;
+	for (size_t i = 0; i < workers.size(); i++) {
+		if (index % static_cast<uint64_t>(configs[i].interval) != 0)
+			continue;
+		auto& worker = *workers[i];
+		if (worker.job) {
+			worker.stats.skipped_busy++;
+			continue;
+		}
+		auto input = preprocess_cache.get(configs[i].preprocess);
+		if (!input) {
+			error = input.error();
+			break;
+		}
+		worker.job = Job(index, std::move(*input));
+		started_workers.push_back(i);
+	}
+
+	// unlocks the workers, the capacity stays for the next frame
+	worker_locks.clear();
+	for (const size_t i : started_workers)
+		workers[i]->job_changed.notify_all();
+	if (error)
+		return tl::unexpected(*error);
+	return started_workers.size();
+}
+
+void ModelPipeline::wait_idle() {
+	for (const auto& worker : workers) {
+		std::unique_lock lock(worker->mutex);
+		worker->job_changed.wait(lock, [&worker] { return !worker->job; });
+	}
+}
+
+ModelPipelineStats ModelPipeline::get_stats() const {
+	ModelPipelineStats stats;
+	{
+		const std::scoped_lock lock(frame_mutex);
+		stats.frames = frame_index;
+		stats.preprocess = preprocess_cache.get_stats();
+	}
+	for (const auto& worker : workers) {
+		const std::scoped_lock lock(worker->mutex);
+		stats.models.push_back(worker->stats);
+	}
+	return stats;
+}
+
+void ModelPipeline::run_worker(
+	size_t model_index,
+	const std::stop_token& stop_token
+) {
+	auto& worker = *workers[model_index];
+	while (true) {
+		uint64_t job_frame_index = 0;
+		const std::vector<float>* input = nullptr;
+		{
+			std::unique_lock lock(worker.mutex);
+			if (!worker.job_changed.wait(lock, stop_token, [&worker] {
+					return worker.job.has_value();
+				}))
+				return;
+			job_frame_index = worker.job->frame_index;
+			// the job keeps the input alive until it is cleared
+			input = worker.job->input.get();
+		}
+
+		FrameTrace trace;
+		const auto start_time = frame_clock::now();
+		const auto error = worker.runtime->run_inference_preprocessed(
+			*input, worker.output, trace
+		);
+		const auto inference_time = frame_clock::now() - start_time;
+		if (error) {
+			callback(model_index, job_frame_index, tl::unexpected(*error));
+		} else {
+			callback(
+				model_index, job_frame_index,
+				std::span<const float>(worker.output)
+			);
+		}
+
+		{
+			const std::scoped_lock lock(worker.mutex);
+			worker.stats.runs++;
+			if (error)
+				worker.stats.errors++;
+			worker.stats.last_inference_time = inference_time;
+			worker.job.reset();
+		}
+		worker.job_changed.notify_all();
+	}
+}
@@ -2,6 +2,7 @@
 #include "EyeAICore/tflite/TfLiteUtils.hpp"
 #include "EyeAICore/utils/Profiling.hpp"
 
+#include <algorithm>
 #include <format>
 
 #if EYE_AI_CORE_USE_PREBUILT_TFLITE
@@ -22,7 +23,8 @@ TfLiteRuntime::create(
 	std::vector<std::unique_ptr<Operator>>&& input_operators,
 	std::vector<std::unique_ptr<Operator>>&& output_operators,
 	TfLiteLogWarningCallback log_warning_callback,
-	TfLiteLogErrorCallback log_error_callback
+	TfLiteLogErrorCallback log_error_callback,
+	const TfLiteRuntimeOptions& options
 ) {
 	PROFILE_DEPTH_SCOPE("Initialize TfLiteRuntime")
 
@@ -32,13 +34,19 @@ TfLiteRuntime::create(
 		TfLiteErrorReporterUserData(log_warning_callback, log_error_callback)
 	));
 
+	const auto model_load_start = std::chrono::steady_clock::now();
 	runtime->model = {
 		TfLiteModelCreate(
 			runtime->model_data.data(), runtime->model_data.size()
 		),
 		TfLiteModelDelete
 	};
+	if (runtime->model == nullptr)
+		return tl::unexpected(TfLiteCreateModelError());
+	runtime->startup_timings.model_load =
+		std::chrono::steady_clock::now() - model_load_start;
 
+	const auto interpreter_create_start = std::chrono::steady_clock::now();
 	std::unique_ptr<
 		TfLiteInterpreterOptions, decltype(&TfLiteInterpreterOptionsDelete)>
 		interpreter_options_without_gpu_delegate = {
@@ -49,36 +57,67 @@ TfLiteRuntime::create(
 		&runtime->error_reporter_user_data
 	);
 	TfLiteInterpreterOptionsSetNumThreads(
-		interpreter_options_without_gpu_delegate.get(), 4
+		interpreter_options_without_gpu_delegate.get(), options.num_threads
 	);
+	if (options.enable_cancellation) {
+		TfLiteInterpreterOptionsEnableCancellation(
+			interpreter_options_without_gpu_delegate.get(), true
+		);
+	}
 
-	std::unique_ptr<
-		TfLiteInterpreterOptions, decltype(&TfLiteInterpreterOptionsDelete)>
-		interpreter_options_with_gpu_delegate = {
-			TfLiteInterpreterOptionsCopy(
-				interpreter_options_without_gpu_delegate.get()
+	if (options.use_gpu_delegate) {
+		std::unique_ptr<
+			TfLiteInterpreterOptions,
+			decltype(&TfLiteInterpreterOptionsDelete)>
+			interpreter_options_with_gpu_delegate = {
+				TfLiteInterpreterOptionsCopy(
+					interpreter_options_without_gpu_delegate.get()
+				),
+				TfLiteInterpreterOptionsDelete
+			};
+		runtime->gpu_delegate =
+			create_gpu_delegate(gpu_delegate_serialization_dir, model_token);
+		TfLiteInterpreterOptionsAddDelegate(
+			interpreter_options_with_gpu_delegate.get(),
+			runtime->gpu_delegate.get()
+		);
+
+		// first try to create interpreter with gpu delegate
+		runtime->interpreter = {
+			TfLiteInterpreterCreate(
+				runtime->model.get(),
+				interpreter_options_with_gpu_delegate.get()
 			),
-			TfLiteInterpreterOptionsDelete
+			TfLiteInterpreterDelete
 		};
-	runtime->gpu_delegate =
-		create_gpu_delegate(gpu_delegate_serialization_dir, model_token);
-	TfLiteInterpreterOptionsAddDelegate(
-		interpreter_options_with_gpu_delegate.get(), runtime->gpu_delegate.get()
-	);
 
-	// first try to create interpreter with gpu delegate
-	runtime->interpreter = {
-		TfLiteInterpreterCreate(
-			runtime->model.get(), interpreter_options_with_gpu_delegate.get()
-		),
-		TfLiteInterpreterDelete
-	};
+		if (runtime->interpreter == nullptr) {
+			log_warning_callback(
+				"GPU Delegate is not supported, falling back to CPU only mode"
+			);
+			runtime->gpu_delegate.reset();
+		} else {
+			runtime->interpreter_options =
+				std::move(interpreter_options_with_gpu_delegate);
+		}
+	}
 
 	if (runtime->interpreter == nullptr) {
-		// trying to create interpreter again, just without gpu delegate
-		log_warning_callback(
-			"GPU Delegate is not supported, falling back to CPU only mode"
-		);
+		// create interpreter without gpu delegate
+#if !EYE_AI_CORE_USE_PREBUILT_TFLITE
+		if (options.use_xnnpack) {
+			runtime->xnnpack_delegate =
+				create_xnnpack_delegate(options.num_threads);
+			if (runtime->xnnpack_delegate != nullptr) {
+				TfLiteInterpreterOptionsAddDelegate(
+					interpreter_options_without_gpu_delegate.get(),
+					runtime->xnnpack_delegate.get()
+				);
+			} else {
+				log_warning_callback("Failed to create XNNPACK delegate");
+			}
+		}
+#endif
 		runtime->interpreter = {
 			TfLiteInterpreterCreate(
 				runtime->model.get(),
@@ -91,12 +130,30 @@ TfLiteRuntime::create(
 		}
 		runtime->interpreter_options =
 			std::move(interpreter_options_without_gpu_delegate);
-		runtime->gpu_delegate.reset();
-	} else {
-		runtime->interpreter_options =
-			std::move(interpreter_options_with_gpu_delegate);
 	}
 
+	if (options.batch_size != 1) {
+		TfLiteTensor* input_tensor =
+			TfLiteInterpreterGetInputTensor(runtime->interpreter.get(), 0);
+		auto input_shape = get_tensor_shape(input_tensor);
+		if (!input_shape.empty()) {
+			input_shape[0] = options.batch_size;
+			const TfLiteStatus resize_status =
+				TfLiteInterpreterResizeInputTensor(
+					runtime->interpreter.get(), 0, input_shape.data(),
+					static_cast<int32_t>(input_shape.size())
+				);
+			if (resize_status != kTfLiteOk) {
+				return tl::unexpected(
+					TfLiteResizeInputTensorError(resize_status)
+				);
+			}
+		}
+	}
+	runtime->startup_timings.interpreter_create =
+		std::chrono::steady_clock::now() - interpreter_create_start;
+
+	const auto allocate_tensors_start = std::chrono::steady_clock::now();
 	const TfLiteStatus allocate_tensors_status =
 		TfLiteInterpreterAllocateTensors(runtime->interpreter.get());
 	if (allocate_tensors_status != kTfLiteOk) {
@@ -104,6 +161,20 @@ TfLiteRuntime::create(
 			TfLiteAllocateTensorsError(allocate_tensors_status)
 		);
 	}
+	runtime->startup_timings.allocate_tensors =
+		std::chrono::steady_clock::now() - allocate_tensors_start;
+
+	for (const auto& input_operator : runtime->input_operators) {
+		runtime->input_operator_states.emplace_back(
+			input_operator->get_state_size(runtime->get_input_element_count())
+		);
+	}
+	for (const auto& output_operator : runtime->output_operators) {
+		runtime->output_operator_states.emplace_back(
+			output_operator->get_state_size(runtime->get_output_element_count()
+			)
+		);
+	}
 
 	return runtime;
 }
@@ -113,37 +184,106 @@ TfLiteRuntime::~TfLiteRuntime() {
 
 	interpreter.reset();
 	gpu_delegate.reset();
+#if !EYE_AI_CORE_USE_PREBUILT_TFLITE
+	xnnpack_delegate.reset();
+#endif
 	interpreter_options.reset();
 	model.reset();
 }
 
-std::optional<TfLiteInvokeInterpreterError> TfLiteRuntime::invoke() {
+std::optional<TfLiteRunInferenceError> TfLiteRuntime::invoke() {
 	PROFILE_DEPTH_SCOPE("Invoking of model")
 
 	const TfLiteStatus status = TfLiteInterpreterInvoke(interpreter.get());
 	if (status == kTfLiteOk)
 		return std::nullopt;
+	if (status == kTfLiteCancelled)
+		return TfLiteInferenceCancelledError();
 	return TfLiteInvokeInterpreterError(status);
 }
 
+bool TfLiteRuntime::cancel_inference() const {
+	return TfLiteInterpreterCancel(interpreter.get()) == kTfLiteOk;
+}
+
 std::optional<TfLiteRunInferenceError>
 TfLiteRuntime::run_inference(std::span<float> input, std::span<float> output) {
+	FrameTrace trace;
+	return run_inference(input, output, trace);
+}
+
+std::optional<TfLiteRunInferenceError> TfLiteRuntime::run_inference(
+	std::span<float> input,
+	std::span<float> output,
+	FrameTrace& trace
+) {
+	return run_inference(input, output, trace, true);
+}
+
+std::optional<TfLiteRunInferenceError>
+TfLiteRuntime::run_inference_without_state(
+	std::span<float> input,
+	std::span<float> output
+) {
+	FrameTrace trace;
+	return run_inference(input, output, trace, false);
+}
+
+std::optional<TfLiteRunInferenceError> TfLiteRuntime::run_inference(
+	std::span<float> input,
+	std::span<float> output,
+	FrameTrace& trace,
+	bool use_operator_states
+) {
 	PROFILE_DEPTH_FUNCTION()
 
 	{
 		PROFILE_DEPTH_SCOPE("Preprocessing input using operators")
 
-		for (auto& input_operator : input_operators) {
-			if (const auto error = input_operator->execute(input))
+		for (size_t i = 0; i < input_operators.size(); i++) {
+			const auto error =
+				use_operator_states
+					? input_operators[i]->execute_with_state(
+						  input, input_operator_states[i]
+					  )
+					: input_operators[i]->execute(input);
+			if (error)
 				return error;
 		}
 	}
 
+	return run_preprocessed(input, output, trace, use_operator_states);
+}
+
+std::optional<TfLiteRunInferenceError>
+TfLiteRuntime::run_inference_preprocessed(
+	std::span<const float> input,
+	std::span<float> output,
+	FrameTrace& trace
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (!input_operators.empty())
+		return OperatorError::fmt(
+			"Preprocessed input can not run through {} input operators",
+			input_operators.size()
+		);
+	return run_preprocessed(input, output, trace, true);
+}
+
+std::optional<TfLiteRunInferenceError> TfLiteRuntime::run_preprocessed(
+	std::span<const float> input,
+	std::span<float> output,
+	FrameTrace& trace,
+	bool use_operator_states
+) {
 	if (const auto load_input_error = load_input(input))
 		return load_input_error;
+	trace.preprocess_end_time = frame_clock::now();
 
 	if (const auto invoke_error = invoke())
 		return invoke_error;
+	trace.inference_end_time = frame_clock::now();
 
 	if (const auto read_output_error = read_output(output))
 		return read_output_error;
@@ -151,15 +291,60 @@ TfLiteRuntime::run_inference(std::span<float> input, std::span<float> output) {
 	{
 		PROFILE_DEPTH_SCOPE("Postprocessing output using operators")
 
-		for (auto& output_operator : output_operators) {
-			if (const auto error = output_operator->execute(output))
+		for (size_t i = 0; i < output_operators.size(); i++) {
+			const auto error =
+				use_operator_states
+					? output_operators[i]->execute_with_state(
+						  output, output_operator_states[i]
+					  )
+					: output_operators[i]->execute(output);
+			if (error)
 				return error;
 		}
 	}
+	trace.postprocess_end_time = frame_clock::now();
 
 	return std::nullopt;
 }
 
+void TfLiteRuntime::reset_operator_states() {
+	for (auto& state : input_operator_states)
+		std::ranges::fill(state, 0.0f);
+	for (auto& state : output_operator_states)
+		std::ranges::fill(state, 0.0f);
+}
+
+std::span<const float>
+TfLiteRuntime::get_output_operator_state(size_t index) const {
+	if (index >= output_operator_states.size())
+		return {};
+	return output_operator_states[index];
+}
+
+std::vector<int> TfLiteRuntime::get_input_shape() const {
+	return get_tensor_shape(
+		TfLiteInterpreterGetInputTensor(interpreter.get(), 0)
+	);
+}
+
+std::vector<int> TfLiteRuntime::get_output_shape() const {
+	return get_tensor_shape(
+		TfLiteInterpreterGetOutputTensor(interpreter.get(), 0)
+	);
+}
+
+size_t TfLiteRuntime::get_input_element_count() const {
+	return get_tensor_element_count(
+		TfLiteInterpreterGetInputTensor(interpreter.get(), 0)
+	);
+}
+
+size_t TfLiteRuntime::get_output_element_count() const {
+	return get_tensor_element_count(
+		TfLiteInterpreterGetOutputTensor(interpreter.get(), 0)
+	);
+}
+
 std::optional<TfLiteLoadInputError>
 TfLiteRuntime::load_input(std::span<const float> input) {
 	PROFILE_DEPTH_SCOPE("Loading input")
@@ -238,20 +423,57 @@ TfLiteRuntimeBuilder& TfLiteRuntimeBuilder::add_output_operator(
 	return *this;
 }
 
+TfLiteRuntimeBuilder& TfLiteRuntimeBuilder::set_num_threads(int num_threads) {
+	options.num_threads = num_threads;
+	return *this;
+}
+
+TfLiteRuntimeBuilder&
+TfLiteRuntimeBuilder::set_use_gpu_delegate(bool use_gpu_delegate) {
+	options.use_gpu_delegate = use_gpu_delegate;
+	return *this;
+}
+
+TfLiteRuntimeBuilder& TfLiteRuntimeBuilder::set_use_xnnpack(bool use_xnnpack) {
+	options.use_xnnpack = use_xnnpack;
+	return *this;
+}
+
+TfLiteRuntimeBuilder& TfLiteRuntimeBuilder::set_batch_size(int batch_size) {
+	options.batch_size = batch_size;
+	return *this;
+}
+
+TfLiteRuntimeBuilder&
+TfLiteRuntimeBuilder::set_enable_cancellation(bool enable_cancellation) {
+	options.enable_cancellation = enable_cancellation;
+	return *this;
+}
+
 tl::expected<std::unique_ptr<TfLiteRuntime>, TfLiteCreateRuntimeError>
 TfLiteRuntimeBuilder::build() {
 	return TfLiteRuntime::create(
 		std::move(model_data), gpu_delegate_serialization_dir, model_token,
 		std::move(input_operators), std::move(output_operators),
-		log_warning_callback, log_error_callback
+		log_warning_callback, log_error_callback, options
 	);
 }
 
+std::string TfLiteCreateModelError::to_string() {
+	return "failed to create TfLite Model (invalid model data)";
+}
+
 std::string TfLiteCreateInterpreterError::to_string() const {
 	return "failed to create TfLite Interpreter (with and without gpu "
 		   "delegate)";
 }
 
+std::string TfLiteResizeInputTensorError::to_string() const {
+	return std::format(
+		"failed to resize tflite input tensor: {}", format_tflite_status(status)
+	);
+}
+
 std::string TfLiteAllocateTensorsError::to_string() const {
 	return std::format(
 		"failed to allocate tflite tensors: {}", format_tflite_status(status)
@@ -262,4 +484,8 @@ std::string TfLiteInvokeInterpreterError::to_string() const {
 	return std::format(
 		"failed to invoke tflite interpreter: {}", format_tflite_status(status)
 	);
+}
+
+std::string TfLiteInferenceCancelledError::to_string() {
+	return "tflite inference was cancelled";
 }
\ No newline at end of file
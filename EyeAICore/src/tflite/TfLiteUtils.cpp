@@ -1,19 +1,7 @@
 #include "EyeAICore/tflite/TfLiteUtils.hpp"
 #include "EyeAICore/utils/Profiling.hpp"
 
-[[nodiscard]] static std::optional<QuantizeFloatError> quantize_floats(
-	std::span<const float> values,
-	std::span<std::byte> out_quantized_values,
-	TfLiteType quantized_type,
-	const TfLiteAffineQuantization& quantization
-);
-
-[[nodiscard]] static std::optional<DequantizeFloatError> dequantize_to_floats(
-	std::span<const std::byte> quantized_values,
-	std::span<float> out_values,
-	TfLiteType quantized_type,
-	const TfLiteAffineQuantization& quantization
-);
+#include <algorithm>
 
 std::optional<TfLiteAffineQuantization>
 get_tensor_quantization(const TfLiteTensor* tensor) {
@@ -49,6 +37,38 @@ create_gpu_delegate(
 	};
 }
 
+#if !EYE_AI_CORE_USE_PREBUILT_TFLITE
+std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>
+create_xnnpack_delegate(int num_threads) {
+	PROFILE_DEPTH_FUNCTION()
+
+	TfLiteXNNPackDelegateOptions xnnpack_delegate_options =
+		TfLiteXNNPackDelegateOptionsDefault();
+	xnnpack_delegate_options.num_threads = num_threads;
+
+	return {
+		TfLiteXNNPackDelegateCreate(&xnnpack_delegate_options),
+		TfLiteXNNPackDelegateDelete
+	};
+}
+#endif
+
+std::vector<int> get_tensor_shape(const TfLiteTensor* tensor) {
+	const int32_t num_dims = TfLiteTensorNumDims(tensor);
+	std::vector<int> shape;
+	shape.reserve(std::max(num_dims, 0));
+	for (int32_t i = 0; i < num_dims; i++)
+		shape.push_back(TfLiteTensorDim(tensor, i));
+	return shape;
+}
+
+size_t get_tensor_element_count(const TfLiteTensor* tensor) {
+	size_t element_count = 1;
+	for (const int dim : get_tensor_shape(tensor))
+		element_count *= static_cast<size_t>(std::max(dim, 0));
+	return element_count;
+}
+
 [[nodiscard]] static std::optional<TfLiteLoadNonQuantizedInputError>
 load_nonquantized_input_tensor_with_floats(
 	TfLiteTensor* input_tensor,
@@ -0,0 +1,384 @@
+#include "EyeAICore/tflite/TiledInference.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+std::string InvalidTiledInferenceConfig::to_string() const {
+	return std::format("Invalid tiled inference config: {}", reason);
+}
+
+/// evenly spread origins of tiles that cover size with at least overlap
+/// pixels between neighbours
+static std::vector<int>
+compute_tile_origins(int size, int tile_size, int overlap) {
+	if (size <= tile_size)
+		return {0};
+	const int stride = tile_size - overlap;
+	const int count = std::max((size - overlap + stride - 1) / stride, 2);
+	std::vector<int> origins(static_cast<size_t>(count));
+	for (int i = 0; i < count; i++) {
+		origins[static_cast<size_t>(i)] = static_cast<int>(std::lround(
+			static_cast<double>(i) * (size - tile_size) / (count - 1)
+		));
+	}
+	return origins;
+}
+
+/// smooth ramp over ramp_size values from both ends, never 0 so every pixel
+/// of a tile contributes
+static std::vector<float> compute_feather_weights(int size, int ramp_size) {
+	std::vector<float> weights(static_cast<size_t>(size));
+	for (int i = 0; i < size; i++) {
+		const int edge_pixels = std::min(i, size - 1 - i);
+		const float t =
+			ramp_size > 0 ? std::min(
+								(static_cast<float>(edge_pixels) + 0.5f) /
+									static_cast<float>(ramp_size),
+								1.0f
+							)
+						  : 1.0f;
+		weights[static_cast<size_t>(i)] = t * t * (3.0f - 2.0f * t);
+	}
+	return weights;
+}
+
+/// sums the feather weights of all tiles over every image pixel of one axis
+static std::vector<float> compute_weight_sums(
+	int size,
+	std::span<const int> origins,
+	std::span<const float> tile_weights
+) {
+	std::vector<float> sums(static_cast<size_t>(size), 0.0f);
+	const auto tile_size = static_cast<int>(tile_weights.size());
+	for (const int origin : origins) {
+		for (int i = 0; i < tile_size && origin + i < size; i++)
+			sums[static_cast<size_t>(origin + i)] +=
+				tile_weights[static_cast<size_t>(i)];
+	}
+	return sums;
+}
+
+tl::expected<TiledDepthInference, InvalidTiledInferenceConfig>
+TiledDepthInference::create(
+	const TiledInferenceConfig& config,
+	const TfLiteRuntime& runtime,
+	int width,
+	int height
+) {
+	if (config.overlap_fraction < 0.0f || config.overlap_fraction > 0.5f)
+		return tl::unexpected(InvalidTiledInferenceConfig(
+			"overlap fraction has to be in [0, 0.5]"
+		));
+	if (width <= 0 || height <= 0)
+		return tl::unexpected(
+			InvalidTiledInferenceConfig("image size has to be positive")
+		);
+
+	const auto input_shape = runtime.get_input_shape();
+	if (input_shape.size() != 4 || input_shape[3] != 3)
+		return tl::unexpected(InvalidTiledInferenceConfig(
+			"model input has to be [batch, height, width, 3]"
+		));
+	const auto output_shape = runtime.get_output_shape();
+	if (output_shape.size() < 3 || output_shape.size() > 4 ||
+		output_shape[0] != input_shape[0] ||
+		(output_shape.size() == 4 && output_shape[3] != 1))
+		return tl::unexpected(InvalidTiledInferenceConfig(
+			"model output has to be [batch, height, width] or "
+			"[batch, height, width, 1]"
+		));
+	if (input_shape[0] <= 0 || input_shape[1] <= 0 || input_shape[2] <= 0 ||
+		output_shape[1] <= 0 || output_shape[2] <= 0)
+		return tl::unexpected(
+			InvalidTiledInferenceConfig("model tensors have to be non empty")
+		);
+
+	return TiledDepthInference(
+		config, width, height, input_shape[0], input_shape[2], input_shape[1],
+		output_shape[2], output_shape[1]
+	);
+}
+
+TiledDepthInference::TiledDepthInference(
+	const TiledInferenceConfig& config,
+	int width,
+	int height,
+	int batch_size,
+	int tile_width,
+	int tile_height,
+	int tile_output_width,
+	int tile_output_height
+)
+	: config(config), width(width), height(height), batch_size(batch_size),
+	  tile_width(tile_width), tile_height(tile_height),
+	  tile_output_width(tile_output_width),
+	  tile_output_height(tile_output_height),
+	  batch_input(
+		  static_cast<size_t>(batch_size) * tile_width * tile_height * 3
+	  ),
+	  batch_output(
+		  static_cast<size_t>(batch_size) * tile_output_width *
+		  tile_output_height
+	  ),
+	  reference(static_cast<size_t>(tile_output_width) * tile_output_height),
+	  tile_depth(static_cast<size_t>(tile_width) * tile_height) {
+	const auto overlap_width = static_cast<int>(
+		std::lround(static_cast<float>(tile_width) * config.overlap_fraction)
+	);
+	const auto overlap_height = static_cast<int>(
+		std::lround(static_cast<float>(tile_height) * config.overlap_fraction)
+	);
+	tile_columns = compute_tile_origins(width, tile_width, overlap_width);
+	tile_rows = compute_tile_origins(height, tile_height, overlap_height);
+	tile_column_weights = compute_feather_weights(tile_width, overlap_width);
+	tile_row_weights = compute_feather_weights(tile_height, overlap_height);
+	column_weight_sums =
+		compute_weight_sums(width, tile_columns, tile_column_weights);
+	row_weight_sums = compute_weight_sums(height, tile_rows, tile_row_weights);
+}
+
+void TiledDepthInference::load_tile(
+	int tile,
+	std::span<const uint8_t> rgb_pixels,
+	std::span<float> out_values
+) const {
+	const int origin_x = tile_columns[static_cast<size_t>(tile) %
+									  tile_columns.size()];
+	const int origin_y = tile_rows[static_cast<size_t>(tile) /
+								   tile_columns.size()];
+
+	// tiles are only larger than the image if the image is smaller than the
+	// model input, the border pixels are repeated then
+	float* out = out_values.data();
+	for (int y = 0; y < tile_height; y++) {
+		const auto image_y =
+			static_cast<size_t>(std::min(origin_y + y, height - 1));
+		const uint8_t* row =
+			&rgb_pixels[image_y * static_cast<size_t>(width) * 3];
+		for (int x = 0; x < tile_width; x++) {
+			const auto image_x =
+				static_cast<size_t>(std::min(origin_x + x, width - 1));
+			*out++ = static_cast<float>(row[image_x * 3]);
+			*out++ = static_cast<float>(row[image_x * 3 + 1]);
+			*out++ = static_cast<float>(row[image_x * 3 + 2]);
+		}
+	}
+}
+
+TiledDepthInference::TileAlignment TiledDepthInference::align_tile(
+	int tile,
+	std::span<const float> tile_output
+) const {
+	const int origin_x = tile_columns[static_cast<size_t>(tile) %
+									  tile_columns.size()];
+	const int origin_y = tile_rows[static_cast<size_t>(tile) /
+								   tile_columns.size()];
+
+	// position of a tile output pixel in the reference, which covers the
+	// whole image at the tile output resolution
+	const auto reference_position = [](int index, int origin, int tile_size,
+									   int output_size, int image_size) {
+		const auto output_scale =
+			static_cast<float>(output_size) / static_cast<float>(tile_size);
+		const auto reference_scale =
+			static_cast<float>(output_size) / static_cast<float>(image_size);
+		const float image_position =
+			static_cast<float>(origin) +
+			(static_cast<float>(index) + 0.5f) / output_scale;
+		return std::clamp(
+			image_position * reference_scale - 0.5f, 0.0f,
+			static_cast<float>(output_size - 1)
+		);
+	};
+	const auto reference_width = static_cast<size_t>(tile_output_width);
+
+	// least squares fit of reference = scale * tile + shift, accumulated in
+	// double per row
+	double sum_x = 0.0;
+	double sum_y = 0.0;
+	double sum_xx = 0.0;
+	double sum_xy = 0.0;
+	for (int v = 0; v < tile_output_height; v++) {
+		const float ry = reference_position(
+			v, origin_y, tile_height, tile_output_height, height
+		);
+		const auto ry0 = static_cast<size_t>(ry);
+		const size_t ry1 =
+			std::min(ry0 + 1, static_cast<size_t>(tile_output_height - 1));
+		const float wy = ry - static_cast<float>(ry0);
+		const float* tile_row =
+			&tile_output[static_cast<size_t>(v) * reference_width];
+
+		float row_x = 0.0f;
+		float row_y = 0.0f;
+		float row_xx = 0.0f;
+		float row_xy = 0.0f;
+		for (int u = 0; u < tile_output_width; u++) {
+			const float rx = reference_position(
+				u, origin_x, tile_width, tile_output_width, width
+			);
+			const auto rx0 = static_cast<size_t>(rx);
+			const size_t rx1 = std::min(rx0 + 1, reference_width - 1);
+			const float wx = rx - static_cast<float>(rx0);
+			const float top = reference[ry0 * reference_width + rx0] +
+							  wx * (reference[ry0 * reference_width + rx1] -
+									reference[ry0 * reference_width + rx0]);
+			const float bottom = reference[ry1 * reference_width + rx0] +
+								 wx * (reference[ry1 * reference_width + rx1] -
+									   reference[ry1 * reference_width + rx0]);
+			const float y = top + wy * (bottom - top);
+			const float x = tile_row[u];
+			row_x += x;
+			row_y += y;
+			row_xx += x * x;
+			row_xy += x * y;
+		}
+		sum_x += row_x;
+		sum_y += row_y;
+		sum_xx += row_xx;
+		sum_xy += row_xy;
+	}
+
+	const auto count = static_cast<double>(tile_output.size());
+	const double variance = sum_xx - sum_x * sum_x / count;
+	const double covariance = sum_xy - sum_x * sum_y / count;
+	// flat tiles or tiles that disagree with the reference (near and far
+	// flipped) take the mean depth of the reference instead
+	if (variance <= 1e-9 * count || covariance <= 0.0)
+		return TileAlignment(0.0f, static_cast<float>(sum_y / count));
+	const double scale = covariance / variance;
+	return TileAlignment(
+		static_cast<float>(scale),
+		static_cast<float>((sum_y - scale * sum_x) / count)
+	);
+}
+
+std::optional<ImageBufferSizeMismatch> TiledDepthInference::accumulate_tile(
+	int tile,
+	std::span<const float> tile_output,
+	std::span<float> out_depth
+) {
+	const auto alignment = align_tile(tile, tile_output);
+
+	std::span<const float> depth = tile_output;
+	if (tile_output_width != tile_width || tile_output_height != tile_height) {
+		if (const auto error = resize_floats(
+				tile_output, tile_output_width, tile_output_height, tile_depth,
+				tile_width, tile_height
+			))
+			return error;
+		depth = tile_depth;
+	}
+
+	const int origin_x = tile_columns[static_cast<size_t>(tile) %
+									  tile_columns.size()];
+	const int origin_y = tile_rows[static_cast<size_t>(tile) /
+								   tile_columns.size()];
+	const auto columns =
+		static_cast<size_t>(std::min(tile_width, width - origin_x));
+	const int rows = std::min(tile_height, height - origin_y);
+
+	const Float4 scale = Float4::broadcast(alignment.scale);
+	const Float4 shift = Float4::broadcast(alignment.shift);
+	for (int y = 0; y < rows; y++) {
+		const float* depth_row =
+			&depth[static_cast<size_t>(y) * static_cast<size_t>(tile_width)];
+		const auto out_offset =
+			static_cast<size_t>(origin_y + y) * static_cast<size_t>(width) +
+			static_cast<size_t>(origin_x);
+		float* out_row = &out_depth[out_offset];
+		const float row_weight = tile_row_weights[static_cast<size_t>(y)];
+		const Float4 row_weight4 = Float4::broadcast(row_weight);
+
+		size_t x = 0;
+		for (; x + 4 <= columns; x += 4) {
+			const Float4 aligned = Float4::load(depth_row + x) * scale + shift;
+			const Float4 weight =
+				Float4::load(&tile_column_weights[x]) * row_weight4;
+			(Float4::load(out_row + x) + aligned * weight).store(out_row + x);
+		}
+		for (; x < columns; x++) {
+			const float aligned =
+				depth_row[x] * alignment.scale + alignment.shift;
+			out_row[x] += aligned * tile_column_weights[x] * row_weight;
+		}
+	}
+	return std::nullopt;
+}
+
+std::optional<TiledInferenceError> TiledDepthInference::run(
+	TfLiteRuntime& runtime,
+	std::span<const uint8_t> rgb_pixels,
+	std::span<float> out_depth
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	const auto pixels =
+		static_cast<size_t>(width) * static_cast<size_t>(height);
+	if (rgb_pixels.size() != pixels * 3)
+		return ImageBufferSizeMismatch(pixels * 3, rgb_pixels.size());
+	if (out_depth.size() != pixels)
+		return ImageBufferSizeMismatch(pixels, out_depth.size());
+	std::ranges::fill(out_depth, 0.0f);
+
+	const auto input_size = static_cast<size_t>(tile_width) * tile_height * 3;
+	const auto output_size =
+		static_cast<size_t>(tile_output_width) * tile_output_height;
+	// job 0 is the downscaled reference, the tiles follow, so the reference
+	// is known before the first tile is aligned
+	const int jobs = get_tile_count() + 1;
+	for (int first_job = 0; first_job < jobs; first_job += batch_size) {
+		const int batch_jobs = std::min(batch_size, jobs - first_job);
+		{
+			PROFILE_DEPTH_SCOPE("Loading tiles")
+			for (int slot = 0; slot < batch_jobs; slot++) {
+				const auto slot_input = std::span(batch_input).subspan(
+					static_cast<size_t>(slot) * input_size, input_size
+				);
+				const int job = first_job + slot;
+				if (job > 0) {
+					load_tile(job - 1, rgb_pixels, slot_input);
+				} else if (const auto error = resize_rgb8_to_floats(
+							   rgb_pixels, width, height, slot_input,
+							   tile_width, tile_height
+						   )) {
+					return *error;
+				}
+			}
+		}
+
+		// tiles are not part of a frame sequence
+		if (const auto error =
+				runtime.run_inference_without_state(batch_input, batch_output))
+			return *error;
+
+		PROFILE_DEPTH_SCOPE("Blending tiles")
+		for (int slot = 0; slot < batch_jobs; slot++) {
+			const auto slot_offset = static_cast<size_t>(slot) * output_size;
+			const auto slot_output = std::span<const float>(batch_output)
+										 .subspan(slot_offset, output_size);
+			const int job = first_job + slot;
+			if (job == 0) {
+				std::ranges::copy(slot_output, reference.begin());
+			} else if (const auto error = accumulate_tile(
+						   job - 1, slot_output, out_depth
+					   )) {
+				return *error;
+			}
+		}
+	}
+
+	PROFILE_DEPTH_SCOPE("Normalizing tiled depth")
+	for (int y = 0; y < height; y++) {
+		float* out_row = &out_depth[static_cast<size_t>(y) * width];
+		const float row_weight = row_weight_sums[static_cast<size_t>(y)];
+		for (size_t x = 0; x < static_cast<size_t>(width); x++) {
+			out_row[x] = std::clamp(
+				out_row[x] / (column_weight_sums[x] * row_weight), 0.0f, 1.0f
+			);
+		}
+	}
+	return std::nullopt;
+}
@@ -0,0 +1,132 @@
+#include "EyeAICore/utils/FrameTracing.hpp"
+#include <algorithm>
+#include <format>
+
+/// capture timestamps older than this are assumed to come from another clock
+constexpr auto MAX_PLAUSIBLE_CAPTURE_AGE = std::chrono::seconds(10);
+
+static float duration_millis(frame_clock::duration duration) {
+	return static_cast<float>(
+			   std::chrono::duration_cast<std::chrono::microseconds>(duration)
+				   .count()
+		   ) /
+		   1000.0f;
+}
+
+std::string FrameTrace::formatted() const {
+	return std::format(
+		"Frame #{}: {:.2f} ms capture to output (queue: {:.2f} ms, "
+		"preprocess: {:.2f} ms, inference: {:.2f} ms, postprocess: {:.2f} ms)",
+		frame_id, duration_millis(motion_to_output_latency()),
+		duration_millis(queue_wait()), duration_millis(preprocess_duration()),
+		duration_millis(inference_duration()),
+		duration_millis(postprocess_duration())
+	);
+}
+
+std::string FrameLatencyStats::formatted() const {
+	auto formatted = std::format(
+		"Latency: {:.2f} ms avg, {:.2f} ms max, queue wait: {:.2f} ms avg\n"
+		"Frames: {} submitted, {} processed, {} dropped",
+		duration_millis(average_latency), duration_millis(max_latency),
+		duration_millis(average_queue_wait), submitted_frames,
+		processed_frames, dropped_frames
+	);
+	if (last_frame)
+		formatted += std::format("\n{}", last_frame->formatted());
+	return formatted;
+}
+
+uint64_t FrameLatencyTracker::submit_frame(frame_clock::time_point capture_time
+) {
+	const auto now = frame_clock::now();
+	if (capture_time > now || now - capture_time > MAX_PLAUSIBLE_CAPTURE_AGE)
+		capture_time = now;
+
+	auto state_scope = state.lock();
+	const uint64_t frame_id = state_scope->next_frame_id++;
+	state_scope->submitted_frames[frame_id % HISTORY_SIZE] =
+		SubmittedFrame(frame_id, capture_time, now);
+	return frame_id;
+}
+
+FrameTrace FrameLatencyTracker::begin_processing(
+	uint64_t frame_id,
+	frame_clock::time_point dequeue_time
+) {
+	auto state_scope = state.lock();
+
+	if (frame_id > state_scope->last_begun_frame_id) {
+		state_scope->dropped_frames +=
+			frame_id - state_scope->last_begun_frame_id - 1;
+		state_scope->last_begun_frame_id = frame_id;
+	}
+
+	FrameTrace trace;
+	trace.frame_id = frame_id;
+	trace.dequeue_time = dequeue_time;
+
+	const auto& submitted =
+		state_scope->submitted_frames[frame_id % HISTORY_SIZE];
+	if (submitted.frame_id == frame_id) {
+		trace.capture_time = submitted.capture_time;
+		trace.submit_time = submitted.submit_time;
+	} else {
+		// unknown or already overwritten frame, only the processing time can be
+		// measured
+		trace.capture_time = dequeue_time;
+		trace.submit_time = dequeue_time;
+	}
+	trace.preprocess_end_time = dequeue_time;
+	trace.inference_end_time = dequeue_time;
+	trace.postprocess_end_time = dequeue_time;
+
+	return trace;
+}
+
+void FrameLatencyTracker::finish_processing(const FrameTrace& trace) {
+	auto state_scope = state.lock();
+	state_scope->finished_frames
+		[state_scope->processed_frames % HISTORY_SIZE] = trace;
+	state_scope->processed_frames++;
+	state_scope->last_finished_frame = trace;
+}
+
+FrameLatencyStats FrameLatencyTracker::stats() const {
+	auto state_scope = state.lock();
+
+	FrameLatencyStats stats;
+	stats.submitted_frames = state_scope->next_frame_id - 1;
+	stats.processed_frames = state_scope->processed_frames;
+	stats.dropped_frames = state_scope->dropped_frames;
+	stats.last_frame = state_scope->last_finished_frame;
+
+	const size_t window_size =
+		std::min<uint64_t>(state_scope->processed_frames, HISTORY_SIZE);
+	if (window_size == 0)
+		return stats;
+
+	frame_clock::duration latency_sum{};
+	frame_clock::duration queue_wait_sum{};
+	for (size_t i = 0; i < window_size; i++) {
+		const auto& trace = state_scope->finished_frames[i];
+		const auto latency = trace.motion_to_output_latency();
+		latency_sum += latency;
+		queue_wait_sum += trace.queue_wait();
+		stats.max_latency = std::max(stats.max_latency, latency);
+	}
+	stats.average_latency =
+		latency_sum / static_cast<frame_clock::rep>(window_size);
+	stats.average_queue_wait =
+		queue_wait_sum / static_cast<frame_clock::rep>(window_size);
+
+	return stats;
+}
+
+std::optional<frame_clock::duration>
+FrameLatencyTracker::latest_result_age(frame_clock::time_point now) const {
+	auto state_scope = state.lock();
+	if (!state_scope->last_finished_frame)
+		return std::nullopt;
+	return now - state_scope->last_finished_frame->capture_time;
+}
@@ -0,0 +1,300 @@
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include "EyeAICore/utils/ImageUtils.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+
+#include <algorithm>
+#include <format>
+#include <vector>
+
+/// source position of an output coordinate for bilinear sampling
+struct BilinearSample {
+	size_t index0;
+	size_t index1;
+	/// weight of index1, index0 has 1 - weight
+	float weight;
+};
+
+/// pixel centers are aligned (same as android's bitmap scaling with filtering)
+static std::vector<BilinearSample>
+compute_bilinear_samples(int size, int out_size) {
+	std::vector<BilinearSample> samples(static_cast<size_t>(out_size));
+	const float scale = static_cast<float>(size) / static_cast<float>(out_size);
+	for (int i = 0; i < out_size; i++) {
+		const float position = std::clamp(
+			(static_cast<float>(i) + 0.5f) * scale - 0.5f, 0.0f,
+			static_cast<float>(size - 1)
+		);
+		const int index0 = static_cast<int>(position);
+		const int index1 = std::min(index0 + 1, size - 1);
+		samples[static_cast<size_t>(i)] = BilinearSample(
+			static_cast<size_t>(index0), static_cast<size_t>(index1),
+			position - static_cast<float>(index0)
+		);
+	}
+	return samples;
+}
+
+/// checks the sizes of both buffers, channels values per pixel
+static std::optional<ImageBufferSizeMismatch> check_image_buffer_sizes(
+	size_t size,
+	int width,
+	int height,
+	size_t out_size,
+	int out_width,
+	int out_height,
+	size_t channels
+) {
+	const auto expected_size = static_cast<size_t>(std::max(width, 0)) *
+							   static_cast<size_t>(std::max(height, 0)) *
+							   channels;
+	if (size != expected_size || expected_size == 0)
+		return ImageBufferSizeMismatch(expected_size, size);
+
+	const auto expected_out_size =
+		static_cast<size_t>(std::max(out_width, 0)) *
+		static_cast<size_t>(std::max(out_height, 0)) * channels;
+	if (out_size != expected_out_size || expected_out_size == 0)
+		return ImageBufferSizeMismatch(expected_out_size, out_size);
+
+	return std::nullopt;
+}
+
+template<typename T, size_t Channels>
+static void resize_bilinear(
+	std::span<const T> values,
+	int width,
+	int height,
+	std::span<float> out_values,
+	int out_width,
+	int out_height
+) {
+	const auto x_samples = compute_bilinear_samples(width, out_width);
+	const auto y_samples = compute_bilinear_samples(height, out_height);
+	const auto row_stride = static_cast<size_t>(width) * Channels;
+
+	float* out = out_values.data();
+	for (const auto& y_sample : y_samples) {
+		const T* row0 = values.data() + y_sample.index0 * row_stride;
+		const T* row1 = values.data() + y_sample.index1 * row_stride;
+		for (const auto& x_sample : x_samples) {
+			const size_t offset0 = x_sample.index0 * Channels;
+			const size_t offset1 = x_sample.index1 * Channels;
+			for (size_t channel = 0; channel < Channels; channel++) {
+				const float top =
+					static_cast<float>(row0[offset0 + channel]) +
+					x_sample.weight *
+						(static_cast<float>(row0[offset1 + channel]) -
+						 static_cast<float>(row0[offset0 + channel]));
+				const float bottom =
+					static_cast<float>(row1[offset0 + channel]) +
+					x_sample.weight *
+						(static_cast<float>(row1[offset1 + channel]) -
+						 static_cast<float>(row1[offset0 + channel]));
+				*out++ = top + y_sample.weight * (bottom - top);
+			}
+		}
+	}
+}
+
+std::optional<ImageBufferSizeMismatch> resize_rgb8_to_floats(
+	std::span<const uint8_t> rgb_pixels,
+	int width,
+	int height,
+	std::span<float> out_values,
+	int out_width,
+	int out_height
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (const auto error = check_image_buffer_sizes(
+			rgb_pixels.size(), width, height, out_values.size(), out_width,
+			out_height, 3
+		))
+		return error;
+
+	resize_bilinear<uint8_t, 3>(
+		rgb_pixels, width, height, out_values, out_width, out_height
+	);
+	return std::nullopt;
+}
+
+/// count + 1 evenly spaced bounds from 0 to size
+static std::vector<int> split_evenly(int size, int count) {
+	std::vector<int> bounds(static_cast<size_t>(std::max(count, 0)) + 1);
+	for (int i = 1; i <= count; i++)
+		bounds[static_cast<size_t>(i)] = i * size / count;
+	return bounds;
+}
+
+BoxDownsamplePlan BoxDownsamplePlan::create(
+	int width,
+	int height,
+	int out_width,
+	int out_height,
+	int channels
+) {
+	return BoxDownsamplePlan(
+		width, height, out_width, out_height, split_evenly(width, out_width),
+		split_evenly(height, out_height),
+		std::vector<float>(
+			static_cast<size_t>(std::max(width, 0)) *
+			static_cast<size_t>(std::max(channels, 0))
+		)
+	);
+}
+
+/// checks the buffers against the plan and that its row scratch holds
+/// channels values per input column
+static std::optional<ImageBufferSizeMismatch> check_box_downsample_sizes(
+	size_t size,
+	size_t out_size,
+	const BoxDownsamplePlan& plan,
+	size_t channels
+) {
+	const auto width = static_cast<size_t>(std::max(plan.width, 0));
+	const auto expected_size =
+		width * static_cast<size_t>(std::max(plan.height, 0)) * channels;
+	if (size != expected_size || expected_size == 0)
+		return ImageBufferSizeMismatch(expected_size, size);
+	const auto expected_out_size =
+		static_cast<size_t>(std::max(plan.out_width, 0)) *
+		static_cast<size_t>(std::max(plan.out_height, 0));
+	if (out_size != expected_out_size || expected_out_size == 0)
+		return ImageBufferSizeMismatch(expected_out_size, out_size);
+	if (plan.row_sums.size() != width * channels)
+		return ImageBufferSizeMismatch(width * channels, plan.row_sums.size());
+	return std::nullopt;
+}
+
+std::optional<ImageBufferSizeMismatch> downsample_rgb_floats_to_luma(
+	std::span<const float> rgb_values,
+	std::span<float> out_luma,
+	BoxDownsamplePlan& plan
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (const auto error = check_box_downsample_sizes(
+			rgb_values.size(), out_luma.size(), plan, 3
+		))
+		return error;
+
+	const auto& column_bounds = plan.column_bounds;
+	const auto& row_bounds = plan.row_bounds;
+	auto& row_sums = plan.row_sums;
+	const auto row_size = row_sums.size();
+	const auto out_width = static_cast<size_t>(plan.out_width);
+
+	for (size_t out_y = 0; out_y < static_cast<size_t>(plan.out_height);
+		 out_y++) {
+		// sums the rows of the band vertically, rgb stays interleaved so this
+		// runs over contiguous memory
+		std::ranges::fill(row_sums, 0.0f);
+		for (int y = row_bounds[out_y]; y < row_bounds[out_y + 1]; y++) {
+			const float* row = &rgb_values[static_cast<size_t>(y) * row_size];
+			size_t i = 0;
+			for (; i + 4 <= row_size; i += 4)
+				(Float4::load(&row_sums[i]) + Float4::load(&row[i]))
+					.store(&row_sums[i]);
+			for (; i < row_size; i++)
+				row_sums[i] += row[i];
+		}
+
+		const int band_height = row_bounds[out_y + 1] - row_bounds[out_y];
+		for (size_t out_x = 0; out_x < out_width; out_x++) {
+			float red = 0.0f;
+			float green = 0.0f;
+			float blue = 0.0f;
+			for (int x = column_bounds[out_x]; x < column_bounds[out_x + 1];
+				 x++) {
+				const size_t i = static_cast<size_t>(x) * 3;
+				red += row_sums[i];
+				green += row_sums[i + 1];
+				blue += row_sums[i + 2];
+			}
+			const int cell_pixels = std::max(
+				(column_bounds[out_x + 1] - column_bounds[out_x]) * band_height,
+				1
+			);
+			out_luma[out_y * out_width + out_x] =
+				(LUMA_RED_WEIGHT * red + LUMA_GREEN_WEIGHT * green +
+				 LUMA_BLUE_WEIGHT * blue) /
+				(255.0f * static_cast<float>(cell_pixels));
+		}
+	}
+	return std::nullopt;
+}
+
+std::optional<ImageBufferSizeMismatch> downsample_argb_to_luma(
+	std::span<const int> argb_pixels,
+	std::span<float> out_luma,
+	BoxDownsamplePlan& plan
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (const auto error = check_box_downsample_sizes(
+			argb_pixels.size(), out_luma.size(), plan, 1
+		))
+		return error;
+
+	const auto& column_bounds = plan.column_bounds;
+	const auto& row_bounds = plan.row_bounds;
+	auto& row_sums = plan.row_sums;
+	const auto width = row_sums.size();
+	const auto out_width = static_cast<size_t>(plan.out_width);
+
+	for (size_t out_y = 0; out_y < static_cast<size_t>(plan.out_height);
+		 out_y++) {
+		// the luma of every pixel is summed vertically over the band first
+		std::ranges::fill(row_sums, 0.0f);
+		for (int y = row_bounds[out_y]; y < row_bounds[out_y + 1]; y++) {
+			const int* row = &argb_pixels[static_cast<size_t>(y) * width];
+			for (size_t x = 0; x < width; x++)
+				row_sums[x] += luma_from_argb_color(row[x]);
+		}
+
+		const int band_height = row_bounds[out_y + 1] - row_bounds[out_y];
+		for (size_t out_x = 0; out_x < out_width; out_x++) {
+			float luma = 0.0f;
+			for (int x = column_bounds[out_x]; x < column_bounds[out_x + 1];
+				 x++)
+				luma += row_sums[static_cast<size_t>(x)];
+			const int cell_pixels = std::max(
+				(column_bounds[out_x + 1] - column_bounds[out_x]) * band_height,
+				1
+			);
+			out_luma[out_y * out_width + out_x] =
+				luma / (255.0f * static_cast<float>(cell_pixels));
+		}
+	}
+	return std::nullopt;
+}
+
+std::optional<ImageBufferSizeMismatch> resize_floats(
+	std::span<const float> values,
+	int width,
+	int height,
+	std::span<float> out_values,
+	int out_width,
+	int out_height
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (const auto error = check_image_buffer_sizes(
+			values.size(), width, height, out_values.size(), out_width,
+			out_height, 1
+		))
+		return error;
+
+	resize_bilinear<float, 1>(
+		values, width, height, out_values, out_width, out_height
+	);
+	return std::nullopt;
+}
+
+std::string ImageBufferSizeMismatch::to_string() const {
+	return std::format(
+		"image buffer has {} values, but {} were expected", actual_size,
+		expected_size
+	);
+}
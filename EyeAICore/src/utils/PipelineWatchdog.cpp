@@ -0,0 +1,200 @@
+#include "EyeAICore/utils/PipelineWatchdog.hpp"
+#include <algorithm>
+#include <format>
+
+namespace {
+[[nodiscard]] int64_t to_nanos(frame_clock::time_point time) {
+	// 0 marks an unset time, the epoch itself is never reported
+	return std::max<int64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+			time.time_since_epoch()
+		)
+			.count(),
+		1
+	);
+}
+
+[[nodiscard]] frame_clock::duration
+elapsed_since(int64_t nanos, frame_clock::time_point now) {
+	return std::chrono::duration_cast<frame_clock::duration>(
+		now.time_since_epoch() - std::chrono::nanoseconds(nanos)
+	);
+}
+
+[[nodiscard]] double to_millis(frame_clock::duration duration) {
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+} // namespace
+
+std::string InvalidPipelineWatchdogConfig::to_string() const {
+	return std::format("Invalid pipeline watchdog config: {}", reason);
+}
+
+std::string
+PipelineWatchdogStatus::formatted(const PipelineWatchdogConfig& config) const {
+	switch (health) {
+		case PipelineHealth::Healthy:
+			return "Pipeline healthy";
+		case PipelineHealth::Lagging:
+			return std::format(
+				"Pipeline lagging: no result for {:.0f} ms",
+				to_millis(overdue_time)
+			);
+		case PipelineHealth::Stalled:
+			return std::format(
+				"Pipeline stalled: {} busy for {:.0f} ms",
+				stalled_stage && *stalled_stage < config.stages.size()
+					? config.stages[*stalled_stage].name
+					: "unknown stage",
+				to_millis(overdue_time)
+			);
+	}
+	return "";
+}
+
+tl::expected<std::unique_ptr<PipelineWatchdog>, InvalidPipelineWatchdogConfig>
+PipelineWatchdog::create(PipelineWatchdogConfig config) {
+	for (const auto& stage : config.stages) {
+		if (stage.deadline <= frame_clock::duration::zero())
+			return tl::unexpected(InvalidPipelineWatchdogConfig(std::format(
+				"deadline of stage {} has to be positive", stage.name
+			)));
+	}
+	if (config.result_deadline <= frame_clock::duration::zero() ||
+		config.check_interval <= frame_clock::duration::zero())
+		return tl::unexpected(InvalidPipelineWatchdogConfig(
+			"result deadline and check interval have to be positive"
+		));
+
+	return std::unique_ptr<PipelineWatchdog>(
+		new PipelineWatchdog(std::move(config))
+	);
+}
+
+PipelineWatchdog::PipelineWatchdog(PipelineWatchdogConfig config)
+	: config(std::move(config)),
+	  stage_busy_since(
+		  std::make_unique<AtomicTime[]>(this->config.stages.size())
+	  ) {}
+
+PipelineWatchdog::~PipelineWatchdog() { stop(); }
+
+void PipelineWatchdog::begin_stage(
+	size_t stage, frame_clock::time_point now
+) noexcept {
+	if (stage < config.stages.size())
+		stage_busy_since[stage].store(to_nanos(now), std::memory_order_relaxed);
+}
+
+void PipelineWatchdog::end_stage(size_t stage) noexcept {
+	if (stage < config.stages.size())
+		stage_busy_since[stage].store(0, std::memory_order_relaxed);
+}
+
+void PipelineWatchdog::frame_submitted(frame_clock::time_point now) {
+	// only the first frame after a result starts the wait
+	int64_t expected = 0;
+	waiting_since.compare_exchange_strong(
+		expected, to_nanos(now), std::memory_order_relaxed
+	);
+}
+
+void PipelineWatchdog::result_ready() {
+	waiting_since.store(0, std::memory_order_relaxed);
+}
+
+PipelineWatchdogStatus
+PipelineWatchdog::check(frame_clock::time_point now) const {
+	PipelineWatchdogStatus result;
+
+	// a stalled stage explains the lag as well, so it is reported first
+	for (size_t i = 0; i < config.stages.size(); i++) {
+		const int64_t busy_since =
+			stage_busy_since[i].load(std::memory_order_relaxed);
+		if (busy_since == 0)
+			continue;
+		const auto busy_time = elapsed_since(busy_since, now);
+		if (busy_time > config.stages[i].deadline &&
+			busy_time > result.overdue_time) {
+			result.health = PipelineHealth::Stalled;
+			result.stalled_stage = i;
+			result.overdue_time = busy_time;
+		}
+	}
+	if (result.health == PipelineHealth::Stalled)
+		return result;
+
+	const int64_t waiting = waiting_since.load(std::memory_order_relaxed);
+	if (waiting != 0) {
+		const auto waiting_time = elapsed_since(waiting, now);
+		if (waiting_time > config.result_deadline) {
+			result.health = PipelineHealth::Lagging;
+			result.overdue_time = waiting_time;
+		}
+	}
+	return result;
+}
+
+void PipelineWatchdog::start(EventCallback callback) {
+	stop();
+	monitor_thread = std::jthread(
+		[this, callback = std::move(callback)](const std::stop_token& token) {
+			monitor(token, callback);
+		}
+	);
+}
+
+void PipelineWatchdog::stop() {
+	if (!monitor_thread.joinable())
+		return;
+	monitor_thread.request_stop();
+	wait_condition.notify_all();
+	monitor_thread.join();
+}
+
+PipelineWatchdogStatus PipelineWatchdog::get_status() const {
+	const std::scoped_lock lock(status_mutex);
+	return status;
+}
+
+PipelineWatchdogStats PipelineWatchdog::get_stats() const {
+	const std::scoped_lock lock(status_mutex);
+	return stats;
+}
+
+void PipelineWatchdog::monitor(
+	const std::stop_token& stop_token, const EventCallback& callback
+) {
+	while (!stop_token.stop_requested()) {
+		const auto current = check();
+
+		bool changed = false;
+		{
+			const std::scoped_lock lock(status_mutex);
+			stats.checks++;
+			changed = current.health != status.health ||
+					  current.stalled_stage != status.stalled_stage;
+			if (changed && current.health != PipelineHealth::Healthy) {
+				const auto deadline =
+					current.stalled_stage
+						? config.stages[*current.stalled_stage].deadline
+						: config.result_deadline;
+				stats.max_detection_delay = std::max(
+					stats.max_detection_delay, current.overdue_time - deadline
+				);
+				if (current.health == PipelineHealth::Stalled)
+					stats.stalled_events++;
+				else
+					stats.lagging_events++;
+			}
+			status = current;
+		}
+		if (changed && callback)
+			callback(current);
+
+		std::unique_lock lock(wait_mutex);
+		wait_condition.wait_for(lock, stop_token, config.check_interval, [] {
+			return false;
+		});
+	}
+}
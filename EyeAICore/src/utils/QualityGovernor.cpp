@@ -0,0 +1,175 @@
+#include "EyeAICore/utils/QualityGovernor.hpp"
+#include <algorithm>
+#include <format>
+
+namespace {
+[[nodiscard]] double to_millis(frame_clock::duration duration) {
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+} // namespace
+
+std::string InvalidQualityGovernorConfig::to_string() const {
+	return std::format("Invalid quality governor config: {}", reason);
+}
+
+std::string
+QualityDecision::formatted(const QualityGovernorConfig& config) const {
+	return std::format(
+		"Quality {} -> {} ({}), result age {:.0f} ms, target {:.0f} ms",
+		config.levels[from_level].name, config.levels[to_level].name,
+		reason == QualityChangeReason::OverBudget ? "over budget"
+												  : "under budget",
+		to_millis(smoothed_result_age), to_millis(config.target_result_age)
+	);
+}
+
+tl::expected<QualityGovernor, InvalidQualityGovernorConfig>
+QualityGovernor::create(QualityGovernorConfig config) {
+	if (config.levels.empty())
+		return tl::unexpected(
+			InvalidQualityGovernorConfig("at least one level is required")
+		);
+	for (const auto& level : config.levels) {
+		if (level.input_scale <= 0.0f || level.input_scale > 1.0f)
+			return tl::unexpected(InvalidQualityGovernorConfig(std::format(
+				"input scale of level {} has to be in (0, 1]", level.name
+			)));
+		if (level.inference_interval < 1)
+			return tl::unexpected(InvalidQualityGovernorConfig(std::format(
+				"inference interval of level {} has to be at least 1",
+				level.name
+			)));
+	}
+	if (config.target_result_age <= frame_clock::duration::zero())
+		return tl::unexpected(
+			InvalidQualityGovernorConfig("target result age has to be positive")
+		);
+	if (config.smoothing <= 0.0f || config.smoothing > 1.0f)
+		return tl::unexpected(
+			InvalidQualityGovernorConfig("smoothing has to be in (0, 1]")
+		);
+	if (config.upgrade_fraction <= 0.0f || config.upgrade_fraction >= 1.0f)
+		return tl::unexpected(
+			InvalidQualityGovernorConfig("upgrade fraction has to be in (0, 1)")
+		);
+	if (config.downgrade_delay < frame_clock::duration::zero() ||
+		config.upgrade_delay < frame_clock::duration::zero() ||
+		config.settle_time < frame_clock::duration::zero())
+		return tl::unexpected(InvalidQualityGovernorConfig(
+			"delays and settle time must not be negative"
+		));
+	if (config.max_upgrade_backoff < 1)
+		return tl::unexpected(InvalidQualityGovernorConfig(
+			"max upgrade backoff has to be at least 1"
+		));
+
+	return QualityGovernor(std::move(config));
+}
+
+std::optional<QualityDecision> QualityGovernor::observe(
+	const FrameLatencyTracker& tracker,
+	frame_clock::time_point now
+) {
+	const auto result_age = tracker.latest_result_age(now);
+	if (!result_age)
+		return std::nullopt;
+	return observe(*result_age, now);
+}
+
+std::optional<QualityDecision> QualityGovernor::observe(
+	frame_clock::duration result_age,
+	frame_clock::time_point now
+) {
+	if (!smoothed_result_age) {
+		smoothed_result_age = result_age;
+	} else {
+		const std::chrono::duration<double> difference =
+			result_age - *smoothed_result_age;
+		*smoothed_result_age +=
+			std::chrono::duration_cast<frame_clock::duration>(
+				difference * config.smoothing
+			);
+	}
+
+	if (last_change_time) {
+		const auto since_change = now - *last_change_time;
+		if (since_change < config.settle_time)
+			return std::nullopt;
+		// the last upgrade held, the next one does not have to wait longer
+		if (!decisions.empty() &&
+			decisions.back().reason == QualityChangeReason::UnderBudget &&
+			since_change >= config.upgrade_delay)
+			upgrade_backoff = 1;
+	}
+
+	const auto upgrade_threshold =
+		std::chrono::duration_cast<frame_clock::duration>(
+			config.target_result_age * config.upgrade_fraction
+		);
+	if (*smoothed_result_age > config.target_result_age) {
+		under_budget_since.reset();
+		if (!over_budget_since)
+			over_budget_since = now;
+	} else if (*smoothed_result_age < upgrade_threshold) {
+		over_budget_since.reset();
+		if (!under_budget_since)
+			under_budget_since = now;
+	} else {
+		// in between the thresholds the level is right
+		over_budget_since.reset();
+		under_budget_since.reset();
+	}
+
+	if (over_budget_since && level + 1 < config.levels.size() &&
+		now - *over_budget_since >= config.downgrade_delay) {
+		// the last upgrade was too optimistic, wait longer for the next one
+		if (!decisions.empty() &&
+			decisions.back().reason == QualityChangeReason::UnderBudget &&
+			now - decisions.back().time < config.upgrade_delay)
+			upgrade_backoff =
+				std::min(upgrade_backoff * 2, config.max_upgrade_backoff);
+		return change_level(level + 1, QualityChangeReason::OverBudget, now);
+	}
+	if (under_budget_since && level > 0 &&
+		now - *under_budget_since >= config.upgrade_delay * upgrade_backoff)
+		return change_level(level - 1, QualityChangeReason::UnderBudget, now);
+	return std::nullopt;
+}
+
+void QualityGovernor::reset() {
+	level = 0;
+	smoothed_result_age.reset();
+	over_budget_since.reset();
+	under_budget_since.reset();
+	last_change_time.reset();
+	upgrade_backoff = 1;
+}
+
+std::string QualityGovernor::formatted() const {
+	if (!smoothed_result_age)
+		return std::format("Quality: {}", get_level().name);
+	return std::format(
+		"Quality: {} ({}/{}), result age {:.0f} ms (target {:.0f} ms)",
+		get_level().name, level + 1, config.levels.size(),
+		to_millis(*smoothed_result_age), to_millis(config.target_result_age)
+	);
+}
+
+QualityDecision QualityGovernor::change_level(
+	size_t to_level,
+	QualityChangeReason reason,
+	frame_clock::time_point now
+) {
+	const QualityDecision decision(
+		now, level, to_level, reason, *smoothed_result_age
+	);
+	level = to_level;
+	last_change_time = now;
+	over_budget_since.reset();
+	under_budget_since.reset();
+
+	decisions.push_back(decision);
+	if (decisions.size() > MAX_DECISIONS)
+		decisions.pop_front();
+	return decision;
+}
@@ -0,0 +1,118 @@
+#include "EyeAICore/utils/SceneChangeDetector.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/Simd.hpp"
+#include <cmath>
+#include <format>
+
+std::string InvalidSceneChangeConfig::to_string() const {
+	return std::format("Invalid scene change detector config: {}", reason);
+}
+
+float SceneChangeStats::skip_rate() const {
+	const uint64_t checked_frames = inferred_frames + skipped_frames;
+	if (checked_frames == 0)
+		return 0.0f;
+	return static_cast<float>(skipped_frames) /
+		   static_cast<float>(checked_frames);
+}
+
+std::string SceneChangeStats::formatted() const {
+	return std::format(
+		"Static frames skipped: {:.1f}% ({} of {}), last change: {:.3f}",
+		skip_rate() * 100.0f, skipped_frames, inferred_frames + skipped_frames,
+		last_difference
+	);
+}
+
+tl::expected<SceneChangeDetector, InvalidSceneChangeConfig>
+SceneChangeDetector::create(
+	const SceneChangeConfig& config,
+	int width,
+	int height
+) {
+	if (config.thumbnail_width <= 0 || config.thumbnail_height <= 0)
+		return tl::unexpected(
+			InvalidSceneChangeConfig("thumbnail size has to be positive")
+		);
+	if (width < config.thumbnail_width || height < config.thumbnail_height) {
+		return tl::unexpected(InvalidSceneChangeConfig(std::format(
+			"frame size {}x{} is smaller than the thumbnail size {}x{}", width,
+			height, config.thumbnail_width, config.thumbnail_height
+		)));
+	}
+	if (config.change_threshold < 0.0f)
+		return tl::unexpected(
+			InvalidSceneChangeConfig("change threshold must not be negative")
+		);
+	if (config.max_result_age < frame_clock::duration::zero())
+		return tl::unexpected(
+			InvalidSceneChangeConfig("max result age must not be negative")
+		);
+
+	return SceneChangeDetector(config, width, height);
+}
+
+SceneChangeDetector::SceneChangeDetector(
+	const SceneChangeConfig& config,
+	int width,
+	int height
+)
+	: config(config), width(width), height(height),
+	  thumbnail_plan(BoxDownsamplePlan::create(
+		  width, height, config.thumbnail_width, config.thumbnail_height, 3
+	  )),
+	  thumbnail(
+		  static_cast<size_t>(config.thumbnail_width) * config.thumbnail_height
+	  ),
+	  reference_thumbnail(thumbnail.size()) {}
+
+/// mean absolute difference of a and b, which have the same size
+static float mean_absolute_difference(
+	std::span<const float> a,
+	std::span<const float> b
+) {
+	Float4 sum = Float4::broadcast(0.0f);
+	size_t i = 0;
+	for (; i + 4 <= a.size(); i += 4)
+		sum = sum + Float4::abs(Float4::load(&a[i]) - Float4::load(&b[i]));
+	float tail_sum = 0.0f;
+	for (; i < a.size(); i++)
+		tail_sum += std::abs(a[i] - b[i]);
+	return (sum.horizontal_sum() + tail_sum) / static_cast<float>(a.size());
+}
+
+tl::expected<SceneChange, ImageBufferSizeMismatch> SceneChangeDetector::check(
+	std::span<const float> rgb,
+	frame_clock::time_point capture_time
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (const auto error =
+			downsample_rgb_floats_to_luma(rgb, thumbnail, thumbnail_plan))
+		return tl::unexpected(*error);
+	thumbnail_capture_time = capture_time;
+
+	if (!reference_capture_time) {
+		stats.last_difference = 1.0f;
+		return SceneChange();
+	}
+
+	const float difference =
+		mean_absolute_difference(thumbnail, reference_thumbnail);
+	stats.last_difference = difference;
+	const bool result_too_old =
+		capture_time - *reference_capture_time > config.max_result_age;
+	if (difference >= config.change_threshold || result_too_old)
+		return SceneChange(difference, true);
+
+	stats.skipped_frames++;
+	return SceneChange(difference, false);
+}
+
+void SceneChangeDetector::mark_inferred() {
+	std::swap(reference_thumbnail, thumbnail);
+	reference_capture_time = thumbnail_capture_time;
+	stats.inferred_frames++;
+}
+
+void SceneChangeDetector::reset() { reference_capture_time.reset(); }
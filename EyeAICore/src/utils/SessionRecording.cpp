@@ -0,0 +1,430 @@
+#include "EyeAICore/utils/SessionRecording.hpp"
+#include "EyeAICore/utils/Float16.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// the file format is little endian, it is written with plain memory copies
+static_assert(std::endian::native == std::endian::little);
+
+constexpr std::array<char, 8> SESSION_MAGIC = {'E', 'Y', 'E', 'A',
+											   'I', 'R', 'E', 'C'};
+constexpr uint32_t SESSION_VERSION = 1;
+/// "FRME"
+constexpr uint32_t FRAME_RECORD_MAGIC = 0x454d5246;
+constexpr uint32_t KEYFRAME_FLAG = 1;
+
+/// followed by the model token, padded to 8 bytes
+struct SessionFileHeader {
+	std::array<char, 8> magic;
+	uint32_t version;
+	uint32_t input_width;
+	uint32_t input_height;
+	uint32_t depth_width;
+	uint32_t depth_height;
+	uint8_t depth_encoding;
+	uint8_t depth_delta;
+	uint16_t reserved;
+	uint32_t keyframe_interval;
+	uint32_t model_token_size;
+};
+static_assert(sizeof(SessionFileHeader) == 40);
+
+/// followed by the rgb pixels and the encoded depth, both padded to 8 bytes
+struct FrameRecordHeader {
+	uint32_t magic;
+	uint32_t flags;
+	uint64_t frame_index;
+	int64_t capture_timestamp_nanos;
+	uint32_t input_size;
+	uint32_t depth_size;
+};
+static_assert(sizeof(FrameRecordHeader) == 32);
+
+static size_t align_to_8(size_t size) { return (size + 7) & ~size_t(7); }
+
+template<typename T>
+static std::span<const uint8_t> as_byte_span(const T& value) {
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	return {reinterpret_cast<const uint8_t*>(&value), sizeof(T)};
+}
+
+static void encode_depth_codes(
+	std::span<const float> depth,
+	DepthEncoding encoding,
+	std::span<uint16_t> out_codes
+) {
+	if (encoding == DepthEncoding::Float16) {
+		std::ranges::transform(depth, out_codes.begin(), float_to_half_bits);
+		return;
+	}
+	std::ranges::transform(depth, out_codes.begin(), [](float value) {
+		return static_cast<uint16_t>(
+			std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f
+		);
+	});
+}
+
+static float decode_depth_code(uint16_t code, DepthEncoding encoding) {
+	if (encoding == DepthEncoding::Float16)
+		return half_bits_to_float(code);
+	return static_cast<float>(code) / 65535.0f;
+}
+
+/// small positive and negative differences both become small numbers
+static uint16_t zigzag_encode(uint16_t difference) {
+	const auto value = static_cast<int16_t>(difference);
+	return static_cast<uint16_t>(
+		static_cast<uint16_t>(value << 1) ^ static_cast<uint16_t>(value >> 15)
+	);
+}
+
+static uint16_t zigzag_decode(uint16_t value) {
+	return static_cast<uint16_t>((value >> 1) ^ (0u - (value & 1u)));
+}
+
+/// little endian base 128, 1 byte for values < 128, at most 3 bytes
+static void append_varint(std::vector<uint8_t>& bytes, uint16_t value) {
+	while (value >= 0x80u) {
+		bytes.push_back(static_cast<uint8_t>(value | 0x80u));
+		value >>= 7;
+	}
+	bytes.push_back(static_cast<uint8_t>(value));
+}
+
+static std::optional<uint16_t>
+read_varint(std::span<const uint8_t> bytes, size_t& position) {
+	uint32_t value = 0;
+	for (int shift = 0; shift < 21; shift += 7) {
+		if (position >= bytes.size())
+			return std::nullopt;
+		const uint8_t byte = bytes[position++];
+		value |= static_cast<uint32_t>(byte & 0x7fu) << shift;
+		if ((byte & 0x80u) == 0) {
+			// 3 bytes hold 21 bits, more than a code has
+			if (value > UINT16_MAX)
+				return std::nullopt;
+			return static_cast<uint16_t>(value);
+		}
+	}
+	return std::nullopt;
+}
+
+tl::expected<std::unique_ptr<SessionRecorder>, SessionRecordingError>
+SessionRecorder::create(const std::string& path, SessionInfo info) {
+	if (info.input_size() == 0 || info.depth_size() == 0)
+		return tl::unexpected(SessionFormatError("frame sizes must not be 0"));
+	info.keyframe_interval = std::max(info.keyframe_interval, 1u);
+	if (!info.depth_delta)
+		info.keyframe_interval = 1;
+
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	if (file == nullptr)
+		return tl::unexpected(SessionFileError(path, std::strerror(errno)));
+
+	// NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+	auto recorder = std::unique_ptr<SessionRecorder>(
+		new SessionRecorder(file, path, std::move(info))
+	);
+	const auto& recorder_info = recorder->info;
+
+	SessionFileHeader header{};
+	header.magic = SESSION_MAGIC;
+	header.version = SESSION_VERSION;
+	header.input_width = static_cast<uint32_t>(recorder_info.input_width);
+	header.input_height = static_cast<uint32_t>(recorder_info.input_height);
+	header.depth_width = static_cast<uint32_t>(recorder_info.depth_width);
+	header.depth_height = static_cast<uint32_t>(recorder_info.depth_height);
+	header.depth_encoding =
+		static_cast<uint8_t>(recorder_info.depth_encoding);
+	header.depth_delta = recorder_info.depth_delta ? 1 : 0;
+	header.keyframe_interval = recorder_info.keyframe_interval;
+	header.model_token_size =
+		static_cast<uint32_t>(recorder_info.model_token.size());
+
+	std::vector<uint8_t> header_bytes(align_to_8(
+		sizeof(SessionFileHeader) + recorder_info.model_token.size()
+	));
+	std::memcpy(header_bytes.data(), &header, sizeof(header));
+	std::memcpy(
+		header_bytes.data() + sizeof(header),
+		recorder_info.model_token.data(), recorder_info.model_token.size()
+	);
+	if (auto error = recorder->write_bytes(header_bytes))
+		return tl::unexpected(std::move(*error));
+
+	return recorder;
+}
+
+SessionRecorder::~SessionRecorder() { (void)finish(); }
+
+std::optional<SessionRecordingError>
+SessionRecorder::write_bytes(std::span<const uint8_t> bytes) {
+	if (file == nullptr)
+		return SessionFileError(path, "already finished");
+	if (std::fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+		return SessionFileError(path, std::strerror(errno));
+	return std::nullopt;
+}
+
+std::optional<SessionRecordingError> SessionRecorder::write_frame(
+	int64_t capture_timestamp_nanos,
+	std::span<const uint8_t> rgb_pixels,
+	std::span<const float> depth
+) {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (rgb_pixels.size() != info.input_size())
+		return SessionFrameSizeMismatch(
+			"input", info.input_size(), rgb_pixels.size()
+		);
+	if (depth.size() != info.depth_size())
+		return SessionFrameSizeMismatch(
+			"depth", info.depth_size(), depth.size()
+		);
+
+	depth_codes.resize(depth.size());
+	encode_depth_codes(depth, info.depth_encoding, depth_codes);
+
+	const bool keyframe = frame_count % info.keyframe_interval == 0;
+	depth_payload.clear();
+	if (keyframe) {
+		const auto code_bytes = std::as_bytes(std::span(depth_codes));
+		depth_payload.resize(code_bytes.size());
+		std::memcpy(depth_payload.data(), code_bytes.data(), code_bytes.size());
+	} else {
+		for (size_t i = 0; i < depth_codes.size(); i++) {
+			const auto difference =
+				static_cast<uint16_t>(depth_codes[i] - previous_depth_codes[i]);
+			append_varint(depth_payload, zigzag_encode(difference));
+		}
+	}
+	std::swap(previous_depth_codes, depth_codes);
+
+	FrameRecordHeader header{};
+	header.magic = FRAME_RECORD_MAGIC;
+	header.flags = keyframe ? KEYFRAME_FLAG : 0;
+	header.frame_index = frame_count;
+	header.capture_timestamp_nanos = capture_timestamp_nanos;
+	header.input_size = static_cast<uint32_t>(rgb_pixels.size());
+	header.depth_size = static_cast<uint32_t>(depth_payload.size());
+
+	constexpr std::array<uint8_t, 8> padding{};
+	const auto padding_of = [&padding](size_t size) {
+		return std::span(padding).first(align_to_8(size) - size);
+	};
+	for (const auto bytes :
+		 {as_byte_span(header), rgb_pixels, padding_of(rgb_pixels.size()),
+		  std::span<const uint8_t>(depth_payload),
+		  padding_of(depth_payload.size())}) {
+		if (auto error = write_bytes(bytes))
+			return error;
+	}
+
+	frame_count++;
+	return std::nullopt;
+}
+
+std::optional<SessionRecordingError> SessionRecorder::finish() {
+	if (file == nullptr)
+		return std::nullopt;
+	const bool failed = std::fclose(file) != 0;
+	file = nullptr;
+	if (failed)
+		return SessionFileError(path, std::strerror(errno));
+	return std::nullopt;
+}
+
+tl::expected<std::unique_ptr<SessionReader>, SessionRecordingError>
+SessionReader::open(const std::string& path) {
+	const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return tl::unexpected(SessionFileError(path, std::strerror(errno)));
+
+	struct stat file_stat {};
+	if (fstat(fd, &file_stat) != 0) {
+		const int fstat_errno = errno;
+		close(fd);
+		return tl::unexpected(SessionFileError(path, std::strerror(fstat_errno))
+		);
+	}
+	const auto size = static_cast<size_t>(file_stat.st_size);
+	if (size < sizeof(SessionFileHeader)) {
+		close(fd);
+		return tl::unexpected(SessionFormatError("file is too small"));
+	}
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	const int mmap_errno = errno;
+	// the mapping stays valid after closing the file
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		return tl::unexpected(SessionFileError(path, std::strerror(mmap_errno))
+		);
+	}
+	const auto* data = static_cast<const uint8_t*>(mapping);
+	const auto unmap_with_error = [&](std::string reason) {
+		munmap(mapping, size);
+		return tl::unexpected(SessionFormatError(std::move(reason)));
+	};
+
+	SessionFileHeader header{};
+	std::memcpy(&header, data, sizeof(header));
+	if (header.magic != SESSION_MAGIC)
+		return unmap_with_error("not a recorded session");
+	if (header.version != SESSION_VERSION)
+		return unmap_with_error(
+			std::format("unsupported version {}", header.version)
+		);
+	if (header.depth_encoding > static_cast<uint8_t>(DepthEncoding::UInt16))
+		return unmap_with_error("unknown depth encoding");
+	const size_t frames_offset =
+		align_to_8(sizeof(SessionFileHeader) + header.model_token_size);
+	if (frames_offset > size)
+		return unmap_with_error("truncated header");
+
+	SessionInfo info(
+		std::string(
+			// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+			reinterpret_cast<const char*>(data + sizeof(header)),
+			header.model_token_size
+		),
+		static_cast<int>(header.input_width),
+		static_cast<int>(header.input_height),
+		static_cast<int>(header.depth_width),
+		static_cast<int>(header.depth_height),
+		static_cast<DepthEncoding>(header.depth_encoding),
+		header.depth_delta != 0, std::max(header.keyframe_interval, 1u)
+	);
+
+	// index all complete frame records, a truncated record at the end comes
+	// from an interrupted recording and is skipped
+	std::vector<size_t> frame_offsets;
+	size_t offset = frames_offset;
+	while (offset + sizeof(FrameRecordHeader) <= size) {
+		FrameRecordHeader record{};
+		std::memcpy(&record, data + offset, sizeof(record));
+		if (record.magic != FRAME_RECORD_MAGIC)
+			return unmap_with_error(
+				std::format("invalid frame record at byte {}", offset)
+			);
+		if (record.input_size != info.input_size())
+			return unmap_with_error(std::format(
+				"frame {} has {} input bytes, but {} were expected",
+				record.frame_index, record.input_size, info.input_size()
+			));
+		const size_t record_size = sizeof(FrameRecordHeader) +
+								   align_to_8(record.input_size) +
+								   align_to_8(record.depth_size);
+		if (offset + record_size > size)
+			break;
+		frame_offsets.push_back(offset);
+		offset += record_size;
+	}
+
+	// NOLINTNEXTLINE(cppcoreguidelines-owning-memory)
+	return std::unique_ptr<SessionReader>(new SessionReader(
+		data, size, std::move(info), std::move(frame_offsets)
+	));
+}
+
+SessionReader::~SessionReader() {
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
+	munmap(const_cast<uint8_t*>(data), size);
+}
+
+void SessionReader::rewind() { next_frame = 0; }
+
+tl::expected<std::optional<RecordedFrame>, SessionFormatError>
+SessionReader::read_next_frame() {
+	PROFILE_DEPTH_FUNCTION()
+
+	if (next_frame >= frame_offsets.size())
+		return std::nullopt;
+	const size_t offset = frame_offsets[next_frame];
+
+	FrameRecordHeader record{};
+	std::memcpy(&record, data + offset, sizeof(record));
+	const size_t input_offset = offset + sizeof(FrameRecordHeader);
+	const size_t depth_offset = input_offset + align_to_8(record.input_size);
+	const std::span depth_payload(data + depth_offset, record.depth_size);
+
+	const size_t depth_size = info.depth_size();
+	const bool keyframe = (record.flags & KEYFRAME_FLAG) != 0;
+	if (keyframe) {
+		if (depth_payload.size() != depth_size * sizeof(uint16_t)) {
+			return tl::unexpected(SessionFormatError(std::format(
+				"keyframe {} has {} depth bytes, but {} were expected",
+				record.frame_index, depth_payload.size(),
+				depth_size * sizeof(uint16_t)
+			)));
+		}
+		depth_codes.resize(depth_size);
+		std::memcpy(
+			depth_codes.data(), depth_payload.data(), depth_payload.size()
+		);
+	} else {
+		if (depth_codes.size() != depth_size) {
+			return tl::unexpected(SessionFormatError(std::format(
+				"frame {} has no preceding keyframe", record.frame_index
+			)));
+		}
+		size_t position = 0;
+		for (uint16_t& code : depth_codes) {
+			const auto difference = read_varint(depth_payload, position);
+			if (!difference) {
+				return tl::unexpected(SessionFormatError(std::format(
+					"frame {} has truncated or invalid depth deltas",
+					record.frame_index
+				)));
+			}
+			code = static_cast<uint16_t>(code + zigzag_decode(*difference));
+		}
+		// the record size is padded, but the deltas of a valid frame end
+		// exactly at its depth size
+		if (position != depth_payload.size()) {
+			return tl::unexpected(SessionFormatError(std::format(
+				"frame {} has {} depth bytes, but its deltas end after {}",
+				record.frame_index, depth_payload.size(), position
+			)));
+		}
+	}
+
+	RecordedFrame frame;
+	frame.frame_index = record.frame_index;
+	frame.capture_timestamp_nanos = record.capture_timestamp_nanos;
+	frame.rgb_pixels = std::span(data + input_offset, record.input_size);
+	frame.depth.resize(depth_size);
+	std::ranges::transform(
+		depth_codes, frame.depth.begin(),
+		[encoding = info.depth_encoding](uint16_t code) {
+			return decode_depth_code(code, encoding);
+		}
+	);
+
+	next_frame++;
+	return frame;
+}
+
+std::string SessionFileError::to_string() const {
+	return std::format("recorded session {}: {}", path, reason);
+}
+
+std::string SessionFormatError::to_string() const {
+	return std::format("invalid recorded session: {}", reason);
+}
+
+std::string SessionFrameSizeMismatch::to_string() const {
+	return std::format(
+		"{} has {} values, but the recorded session expects {}", buffer_name,
+		actual_size, expected_size
+	);
+}
@@ -0,0 +1,61 @@
+#include "AudioIo.hpp"
+#include "ToolUtils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/// little endian, like every field of a wav file
+template<typename T>
+static void append_le(std::vector<std::byte>& bytes, T value) {
+	for (size_t i = 0; i < sizeof(T); i++) {
+		bytes.push_back(static_cast<std::byte>(
+			(static_cast<uint64_t>(value) >> (8 * i)) & 0xFF
+		));
+	}
+}
+
+static void append_tag(std::vector<std::byte>& bytes, std::string_view tag) {
+	for (const char c : tag)
+		bytes.push_back(static_cast<std::byte>(c));
+}
+
+std::optional<std::string> write_wav16(
+	const std::string& path,
+	std::span<const float> samples,
+	int channels,
+	int sample_rate
+) {
+	constexpr uint16_t BITS_PER_SAMPLE = 16;
+	constexpr uint16_t PCM_FORMAT = 1;
+	constexpr uint32_t FORMAT_CHUNK_SIZE = 16;
+	const auto data_size =
+		static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+	const auto block_align =
+		static_cast<uint16_t>(channels * BITS_PER_SAMPLE / 8);
+
+	std::vector<std::byte> bytes;
+	bytes.reserve(44 + data_size);
+	append_tag(bytes, "RIFF");
+	append_le(bytes, static_cast<uint32_t>(36 + data_size));
+	append_tag(bytes, "WAVE");
+	append_tag(bytes, "fmt ");
+	append_le(bytes, FORMAT_CHUNK_SIZE);
+	append_le(bytes, PCM_FORMAT);
+	append_le(bytes, static_cast<uint16_t>(channels));
+	append_le(bytes, static_cast<uint32_t>(sample_rate));
+	append_le(bytes, static_cast<uint32_t>(sample_rate) * block_align);
+	append_le(bytes, block_align);
+	append_le(bytes, BITS_PER_SAMPLE);
+	append_tag(bytes, "data");
+	append_le(bytes, data_size);
+	for (const float sample : samples) {
+		const auto value = static_cast<int16_t>(
+			std::lround(std::clamp(sample, -1.0f, 1.0f) * 32767.0f)
+		);
+		append_le(bytes, static_cast<uint16_t>(value));
+	}
+	return write_file_bytes(path, bytes);
+}
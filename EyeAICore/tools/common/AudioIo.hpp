@@ -0,0 +1,14 @@
+#pragma once
+
+#include <optional>
+#include <span>
+#include <string>
+
+/// writes interleaved samples in [-1, 1] as a 16 bit pcm wav, values outside
+/// are clamped
+[[nodiscard]] std::optional<std::string> write_wav16(
+	const std::string& path,
+	std::span<const float> samples,
+	int channels,
+	int sample_rate
+);
@@ -0,0 +1,75 @@
+#include "FrameSource.hpp"
+
+#include <filesystem>
+
+tl::expected<std::optional<RgbImage>, std::string>
+ImageDirectoryFrameSource::next_frame() {
+	if (next_index >= paths.size())
+		return std::nullopt;
+	return read_ppm(paths[next_index++]);
+}
+
+tl::expected<std::optional<RgbImage>, std::string>
+RawVideoFrameSource::next_frame() {
+	RgbImage image(width, height, {});
+	image.pixels.resize(
+		static_cast<size_t>(width) * static_cast<size_t>(height) * 3
+	);
+	file.read(
+		// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+		reinterpret_cast<char*>(image.pixels.data()),
+		static_cast<std::streamsize>(image.pixels.size())
+	);
+
+	const auto read_bytes = static_cast<size_t>(file.gcount());
+	if (read_bytes == 0 && file.eof())
+		return std::nullopt;
+	if (read_bytes != image.pixels.size()) {
+		return tl::unexpected_fmt(
+			"{} ends with an incomplete frame ({} of {} bytes)", path,
+			read_bytes, image.pixels.size()
+		);
+	}
+	return image;
+}
+
+tl::expected<std::unique_ptr<FrameSource>, std::string>
+create_frame_source(const CommandLine& command_line) {
+	const auto image_dir = command_line.get_string("image-dir", "");
+	const auto raw_video = command_line.get_string("raw-video", "");
+	if (image_dir.empty() == raw_video.empty())
+		return tl::unexpected("either --image-dir or --raw-video is required");
+
+	if (!image_dir.empty()) {
+		auto paths = list_files_with_extension(image_dir, ".ppm");
+		if (!paths)
+			return tl::unexpected(paths.error());
+		if (paths->empty())
+			return tl::unexpected_fmt("{} contains no .ppm files", image_dir);
+		return std::make_unique<ImageDirectoryFrameSource>(std::move(*paths));
+	}
+
+	const auto width = command_line.get_int("width", 0);
+	const auto height = command_line.get_int("height", 0);
+	if (!width)
+		return tl::unexpected(width.error());
+	if (!height)
+		return tl::unexpected(height.error());
+	if (*width <= 0 || *height <= 0)
+		return tl::unexpected(
+			"--raw-video needs a positive --width and --height"
+		);
+
+	std::ifstream file(raw_video, std::ios::binary);
+	if (!file)
+		return tl::unexpected_fmt("failed to open {}", raw_video);
+
+	std::error_code error;
+	const auto file_size = std::filesystem::file_size(raw_video, error);
+	const auto frame_size =
+		static_cast<size_t>(*width) * static_cast<size_t>(*height) * 3;
+	return std::make_unique<RawVideoFrameSource>(
+		std::move(file), raw_video, *width, *height,
+		error ? 0 : static_cast<size_t>(file_size) / frame_size
+	);
+}
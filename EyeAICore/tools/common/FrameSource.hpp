@@ -0,0 +1,84 @@
+#pragma once
+
+#include "ImageIo.hpp"
+#include "ToolUtils.hpp"
+#include <fstream>
+#include <memory>
+#include <optional>
+
+/// command line options understood by create_frame_source
+constexpr std::string_view FRAME_SOURCE_USAGE =
+	R"(  --image-dir <dir>          binary ppm (P6) frames, processed in file name
+                             order
+  --raw-video <path>         raw rgb24 video (ffmpeg -f rawvideo -pix_fmt
+                             rgb24), needs --width and --height
+  --width <n>, --height <n>  frame size of --raw-video
+)";
+
+/** Sequential source of rgb frames for the offline tools */
+class FrameSource {
+  public:
+	FrameSource() = default;
+	FrameSource(const FrameSource&) = delete;
+	FrameSource(FrameSource&&) = delete;
+	FrameSource& operator=(const FrameSource&) = delete;
+	FrameSource& operator=(FrameSource&&) = delete;
+	virtual ~FrameSource() = default;
+
+	/// nullopt once all frames were read
+	[[nodiscard]] virtual tl::expected<std::optional<RgbImage>, std::string>
+	next_frame() = 0;
+
+	/// total number of frames, if known in advance
+	[[nodiscard]] virtual std::optional<size_t> get_frame_count() const = 0;
+};
+
+/// every ppm file of a directory is a frame
+class ImageDirectoryFrameSource : public FrameSource {
+  public:
+	explicit ImageDirectoryFrameSource(std::vector<std::string>&& paths)
+		: paths(std::move(paths)) {}
+
+	[[nodiscard]] tl::expected<std::optional<RgbImage>, std::string>
+	next_frame() override;
+
+	[[nodiscard]] std::optional<size_t> get_frame_count() const override {
+		return paths.size();
+	}
+
+  private:
+	std::vector<std::string> paths;
+	size_t next_index = 0;
+};
+
+/// headerless file of consecutive rgb24 frames
+class RawVideoFrameSource : public FrameSource {
+  public:
+	RawVideoFrameSource(
+		std::ifstream&& file,
+		std::string path,
+		int width,
+		int height,
+		size_t frame_count
+	)
+		: file(std::move(file)), path(std::move(path)), width(width),
+		  height(height), frame_count(frame_count) {}
+
+	[[nodiscard]] tl::expected<std::optional<RgbImage>, std::string>
+	next_frame() override;
+
+	[[nodiscard]] std::optional<size_t> get_frame_count() const override {
+		return frame_count;
+	}
+
+  private:
+	std::ifstream file;
+	std::string path;
+	int width;
+	int height;
+	size_t frame_count;
+};
+
+/// creates the frame source given by the FRAME_SOURCE_USAGE options
+[[nodiscard]] tl::expected<std::unique_ptr<FrameSource>, std::string>
+create_frame_source(const CommandLine& command_line);
@@ -0,0 +1,166 @@
+#include "ImageIo.hpp"
+#include "EyeAICore/utils/ImageUtils.hpp"
+#include "ToolUtils.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <format>
+
+/// skips whitespace and # comments of a pnm header
+static size_t
+skip_pnm_whitespace(std::span<const int8_t> bytes, size_t position) {
+	while (position < bytes.size()) {
+		const char c = static_cast<char>(bytes[position]);
+		if (c == '#') {
+			while (position < bytes.size() &&
+				   static_cast<char>(bytes[position]) != '\n')
+				position++;
+		} else if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+			position++;
+		} else {
+			break;
+		}
+	}
+	return position;
+}
+
+static std::optional<int>
+read_pnm_header_value(std::span<const int8_t> bytes, size_t& position) {
+	position = skip_pnm_whitespace(bytes, position);
+	int value = 0;
+	bool has_digits = false;
+	while (position < bytes.size()) {
+		const char c = static_cast<char>(bytes[position]);
+		if (c < '0' || c > '9')
+			break;
+		value = value * 10 + (c - '0');
+		has_digits = true;
+		position++;
+		if (value > 1 << 16)
+			return std::nullopt;
+	}
+	if (!has_digits)
+		return std::nullopt;
+	return value;
+}
+
+tl::expected<RgbImage, std::string> read_ppm(const std::string& path) {
+	const auto bytes = read_file_bytes(path);
+	if (!bytes)
+		return tl::unexpected(bytes.error());
+
+	if (bytes->size() < 2 || (*bytes)[0] != 'P' || (*bytes)[1] != '6')
+		return tl::unexpected_fmt("{} is not a binary ppm (P6) file", path);
+
+	size_t position = 2;
+	const auto width = read_pnm_header_value(*bytes, position);
+	const auto height = read_pnm_header_value(*bytes, position);
+	const auto max_value = read_pnm_header_value(*bytes, position);
+	if (!width || !height || !max_value || *width == 0 || *height == 0)
+		return tl::unexpected_fmt("{} has an invalid ppm header", path);
+	if (*max_value != 255) {
+		return tl::unexpected_fmt(
+			"{} has a max value of {}, only 255 is supported", path, *max_value
+		);
+	}
+	// exactly one whitespace character separates the header from the pixels
+	position++;
+
+	RgbImage image(*width, *height, {});
+	image.pixels.resize(
+		static_cast<size_t>(*width) * static_cast<size_t>(*height) * 3
+	);
+	if (bytes->size() < position + image.pixels.size()) {
+		return tl::unexpected_fmt(
+			"{} is truncated ({} of {} pixel bytes)", path,
+			bytes->size() - std::min(position, bytes->size()),
+			image.pixels.size()
+		);
+	}
+	std::memcpy(
+		image.pixels.data(), bytes->data() + position, image.pixels.size()
+	);
+	return image;
+}
+
+static std::optional<std::string> write_pnm(
+	const std::string& path,
+	std::string_view header,
+	std::span<const uint8_t> pixel_bytes
+) {
+	std::vector<std::byte> bytes;
+	bytes.reserve(header.size() + pixel_bytes.size());
+	for (const char c : header)
+		bytes.push_back(static_cast<std::byte>(c));
+	for (const uint8_t byte : pixel_bytes)
+		bytes.push_back(static_cast<std::byte>(byte));
+	return write_file_bytes(path, bytes);
+}
+
+std::optional<std::string>
+write_ppm(const std::string& path, const RgbImage& image) {
+	return write_pnm(
+		path, std::format("P6\n{} {}\n255\n", image.width, image.height),
+		image.pixels
+	);
+}
+
+std::optional<std::string> write_argb_as_ppm(
+	const std::string& path,
+	std::span<const int> argb_pixels,
+	int width,
+	int height
+) {
+	std::vector<uint8_t> rgb;
+	rgb.reserve(argb_pixels.size() * 3);
+	for (const int color : argb_pixels) {
+		rgb.push_back(red_channel_from_argb_color(color));
+		rgb.push_back(green_channel_from_argb_color(color));
+		rgb.push_back(blue_channel_from_argb_color(color));
+	}
+	return write_pnm(path, std::format("P6\n{} {}\n255\n", width, height), rgb);
+}
+
+std::optional<std::string> write_pgm16(
+	const std::string& path,
+	std::span<const float> values,
+	int width,
+	int height
+) {
+	// pgm stores 16 bit values big endian
+	std::vector<uint8_t> pixel_bytes;
+	pixel_bytes.reserve(values.size() * 2);
+	for (const float value : values) {
+		const auto quantized = static_cast<uint16_t>(
+			std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f
+		);
+		pixel_bytes.push_back(static_cast<uint8_t>(quantized >> 8));
+		pixel_bytes.push_back(static_cast<uint8_t>(quantized & 255));
+	}
+	return write_pnm(
+		path, std::format("P5\n{} {}\n65535\n", width, height), pixel_bytes
+	);
+}
+
+tl::expected<std::vector<std::string>, std::string> list_files_with_extension(
+	const std::string& directory,
+	std::string_view extension
+) {
+	std::error_code error;
+	std::filesystem::directory_iterator iter(directory, error);
+	if (error) {
+		return tl::unexpected_fmt(
+			"failed to open directory {}: {}", directory, error.message()
+		);
+	}
+
+	std::vector<std::string> paths;
+	for (const auto& entry : iter) {
+		if (entry.is_regular_file() &&
+			entry.path().extension().string() == extension)
+			paths.push_back(entry.path().string());
+	}
+	std::ranges::sort(paths);
+	return paths;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "EyeAICore/utils/Errors.hpp"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// 8 bit rgb image, 3 bytes per pixel, row-major
+struct RgbImage {
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> pixels;
+};
+
+/// reads a binary ppm (P6) with a max value of 255
+[[nodiscard]] tl::expected<RgbImage, std::string>
+read_ppm(const std::string& path);
+
+[[nodiscard]] std::optional<std::string>
+write_ppm(const std::string& path, const RgbImage& image);
+
+/// writes argb 8888 pixels (as returned by depth_colormap) as a ppm
+[[nodiscard]] std::optional<std::string> write_argb_as_ppm(
+	const std::string& path,
+	std::span<const int> argb_pixels,
+	int width,
+	int height
+);
+
+/// writes values in [0, 1] as a 16 bit grayscale pgm (P5), values outside are
+/// clamped
+[[nodiscard]] std::optional<std::string> write_pgm16(
+	const std::string& path,
+	std::span<const float> values,
+	int width,
+	int height
+);
+
+/// sorted paths of all regular files in directory ending with extension
+[[nodiscard]] tl::expected<std::vector<std::string>, std::string>
+list_files_with_extension(
+	const std::string& directory,
+	std::string_view extension
+);
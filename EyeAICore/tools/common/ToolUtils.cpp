@@ -0,0 +1,337 @@
+#include "ToolUtils.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <sys/resource.h>
+
+tl::expected<CommandLine, std::string> CommandLine::parse(
+	int argc,
+	char** argv,
+	std::span<const std::string_view> flag_names
+) {
+	CommandLine command_line;
+	const std::span<char*> args(argv, static_cast<size_t>(argc));
+
+	for (size_t i = 1; i < args.size(); i++) {
+		const std::string_view arg = args[i];
+		if (!arg.starts_with("--")) {
+			command_line.positional.emplace_back(arg);
+			continue;
+		}
+
+		const std::string name(arg.substr(2));
+		if (std::ranges::find(flag_names, name) != flag_names.end()) {
+			command_line.options.emplace(name, "");
+			continue;
+		}
+		if (i + 1 >= args.size())
+			return tl::unexpected_fmt("missing value for option --{}", name);
+		command_line.options.emplace(name, args[++i]);
+	}
+
+	return command_line;
+}
+
+bool CommandLine::has(std::string_view name) const {
+	return options.contains(name);
+}
+
+std::string CommandLine::get_string(
+	std::string_view name,
+	std::string_view default_value
+) const {
+	const auto iter = options.find(name);
+	if (iter == options.end())
+		return std::string(default_value);
+	return iter->second;
+}
+
+std::vector<std::string> CommandLine::get_strings(std::string_view name
+) const {
+	std::vector<std::string> values;
+	const auto [begin, end] = options.equal_range(name);
+	for (auto iter = begin; iter != end; iter++)
+		values.push_back(iter->second);
+	return values;
+}
+
+tl::expected<int, std::string>
+CommandLine::get_int(std::string_view name, int default_value) const {
+	const auto iter = options.find(name);
+	if (iter == options.end())
+		return default_value;
+
+	int value = 0;
+	const auto& string = iter->second;
+	const auto [ptr, error] =
+		std::from_chars(string.data(), string.data() + string.size(), value);
+	if (error != std::errc() || ptr != string.data() + string.size())
+		return tl::unexpected_fmt("--{} expects an integer: {}", name, string);
+	return value;
+}
+
+tl::expected<float, std::string>
+CommandLine::get_float(std::string_view name, float default_value) const {
+	const auto iter = options.find(name);
+	if (iter == options.end())
+		return default_value;
+
+	try {
+		size_t parsed_chars = 0;
+		const float value = std::stof(iter->second, &parsed_chars);
+		if (parsed_chars == iter->second.size())
+			return value;
+	} catch (const std::exception&) {
+	}
+	return tl::unexpected_fmt("--{} expects a number: {}", name, iter->second);
+}
+
+tl::expected<std::vector<int8_t>, std::string>
+read_file_bytes(const std::string& path) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file)
+		return tl::unexpected_fmt("failed to open {}", path);
+
+	const auto size = static_cast<size_t>(file.tellg());
+	std::vector<int8_t> bytes(size);
+	file.seekg(0);
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	if (!file.read(reinterpret_cast<char*>(bytes.data()), size))
+		return tl::unexpected_fmt("failed to read {}", path);
+	return bytes;
+}
+
+std::optional<std::string>
+write_file_bytes(const std::string& path, std::span<const std::byte> bytes) {
+	std::ofstream file(path, std::ios::binary);
+	// NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+	file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	if (!file)
+		return std::format("failed to write {}", path);
+	return std::nullopt;
+}
+
+size_t get_peak_rss_bytes() {
+	rusage usage{};
+	getrusage(RUSAGE_SELF, &usage);
+	// ru_maxrss is in kilobytes on linux
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+tl::expected<std::unique_ptr<Operator>, std::string>
+create_operator_by_name(std::string_view name) {
+	if (name == "rgb-normalize")
+		return std::make_unique<RgbNormalizeOperator>();
+	if (name == "min-max")
+		return std::make_unique<MinMaxOperator>();
+	if (name == "temporal-filter")
+		return std::make_unique<TemporalFilterOperator>();
+	if (name == "scale-shift-align")
+		return std::make_unique<ScaleShiftAlignOperator>();
+	return tl::unexpected_fmt("unknown operator: {}", name);
+}
+
+void log_warning_to_stderr(std::string msg) {
+	std::cerr << "[warning] " << msg << '\n';
+}
+
+void log_error_to_stderr(std::string msg) {
+	std::cerr << "[error] " << msg << '\n';
+}
+
+tl::expected<std::unique_ptr<TfLiteRuntime>, std::string>
+create_depth_runtime(
+	std::vector<int8_t>&& model_data,
+	std::string_view model_token,
+	int num_threads,
+	bool use_xnnpack,
+	int batch_size
+) {
+	TfLiteRuntimeBuilder builder(
+		std::move(model_data), "", model_token, log_warning_to_stderr,
+		log_error_to_stderr
+	);
+	builder.add_input_operator(std::make_unique<RgbNormalizeOperator>())
+		.add_output_operator(std::make_unique<MinMaxOperator>())
+		.set_num_threads(num_threads)
+		.set_use_gpu_delegate(false)
+		.set_use_xnnpack(use_xnnpack)
+		.set_batch_size(batch_size);
+
+	auto runtime = builder.build();
+	if (!runtime) {
+		return tl::unexpected_fmt(
+			"failed to create runtime: {}", runtime.error().to_string()
+		);
+	}
+	return std::move(*runtime);
+}
+
+tl::expected<DepthModelDimensions, std::string>
+get_depth_model_dimensions(const TfLiteRuntime& runtime) {
+	const auto input_shape = runtime.get_input_shape();
+	if (input_shape.size() != 4 || input_shape[0] != 1 || input_shape[3] != 3)
+		return tl::unexpected("model input has to be [1, height, width, 3]");
+
+	const auto output_shape = runtime.get_output_shape();
+	if (output_shape.size() < 3 || output_shape.size() > 4 ||
+		output_shape[0] != 1 ||
+		(output_shape.size() == 4 && output_shape[3] != 1)) {
+		return tl::unexpected(
+			"model output has to be [1, height, width] or [1, height, width, 1]"
+		);
+	}
+
+	return DepthModelDimensions(
+		input_shape[2], input_shape[1], output_shape[2], output_shape[1]
+	);
+}
+
+double percentile_of_sorted(
+	std::span<const double> sorted_values,
+	double percentile
+) {
+	if (sorted_values.empty())
+		return 0.0;
+	const auto rank = static_cast<size_t>(std::ceil(
+		percentile / 100.0 * static_cast<double>(sorted_values.size())
+	));
+	return sorted_values[std::clamp<size_t>(rank, 1, sorted_values.size()) - 1];
+}
+
+static std::string escape_json(std::string_view string) {
+	std::string escaped;
+	escaped.reserve(string.size());
+	for (const char c : string) {
+		switch (c) {
+		case '"':
+			escaped += "\\\"";
+			break;
+		case '\\':
+			escaped += "\\\\";
+			break;
+		case '\n':
+			escaped += "\\n";
+			break;
+		case '\t':
+			escaped += "\\t";
+			break;
+		default:
+			escaped += c;
+		}
+	}
+	return escaped;
+}
+
+void JsonWriter::begin_value(std::string_view key) {
+	if (!has_elements.empty()) {
+		if (has_elements.back())
+			json += ',';
+		has_elements.back() = true;
+	}
+	if (!key.empty())
+		json += std::format("\"{}\":", escape_json(key));
+}
+
+JsonWriter& JsonWriter::begin_object(std::string_view key) {
+	begin_value(key);
+	json += '{';
+	has_elements.push_back(false);
+	return *this;
+}
+
+JsonWriter& JsonWriter::end_object() {
+	json += '}';
+	has_elements.pop_back();
+	return *this;
+}
+
+JsonWriter& JsonWriter::begin_array(std::string_view key) {
+	begin_value(key);
+	json += '[';
+	has_elements.push_back(false);
+	return *this;
+}
+
+JsonWriter& JsonWriter::end_array() {
+	json += ']';
+	has_elements.pop_back();
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view key, std::string_view value) {
+	begin_value(key);
+	json += std::format("\"{}\"", escape_json(value));
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view key, const char* value) {
+	return this->value(key, std::string_view(value));
+}
+
+JsonWriter& JsonWriter::value(std::string_view key, double value) {
+	begin_value(key);
+	if (std::isfinite(value))
+		json += std::format("{:.6g}", value);
+	else
+		json += "null";
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view key, int64_t value) {
+	begin_value(key);
+	json += std::format("{}", value);
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view key, uint64_t value) {
+	begin_value(key);
+	json += std::format("{}", value);
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view key, int value) {
+	return this->value(key, static_cast<int64_t>(value));
+}
+
+JsonWriter& JsonWriter::value(std::string_view key, bool value) {
+	begin_value(key);
+	json += value ? "true" : "false";
+	return *this;
+}
+
+void write_distribution(
+	JsonWriter& json,
+	std::string_view key,
+	std::vector<double> values
+) {
+	std::ranges::sort(values);
+	const double sum = std::accumulate(values.begin(), values.end(), 0.0);
+	const double mean =
+		values.empty() ? 0.0 : sum / static_cast<double>(values.size());
+	double squared_deviation_sum = 0.0;
+	for (const double value : values)
+		squared_deviation_sum += (value - mean) * (value - mean);
+	const double stddev =
+		values.size() > 1 ? std::sqrt(
+								squared_deviation_sum /
+								static_cast<double>(values.size() - 1)
+							)
+						  : 0.0;
+
+	json.begin_object(key)
+		.value("min", values.empty() ? 0.0 : values.front())
+		.value("mean", mean)
+		.value("stddev", stddev)
+		.value("p50", percentile_of_sorted(values, 50.0))
+		.value("p90", percentile_of_sorted(values, 90.0))
+		.value("p95", percentile_of_sorted(values, 95.0))
+		.value("p99", percentile_of_sorted(values, 99.0))
+		.value("max", values.empty() ? 0.0 : values.back())
+		.end_object();
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "EyeAICore/Operators.hpp"
+#include "EyeAICore/tflite/TfLiteRuntime.hpp"
+#include "EyeAICore/utils/Errors.hpp"
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// minimal "--name value" / "--flag" command line parser shared by all tools
+class CommandLine {
+  public:
+	/// flag_names are options that do not take a value
+	[[nodiscard]] static tl::expected<CommandLine, std::string>
+	parse(int argc, char** argv, std::span<const std::string_view> flag_names);
+
+	[[nodiscard]] bool has(std::string_view name) const;
+
+	[[nodiscard]] std::string
+	get_string(std::string_view name, std::string_view default_value) const;
+
+	/// all values of an option that can be given multiple times
+	[[nodiscard]] std::vector<std::string> get_strings(std::string_view name
+	) const;
+
+	[[nodiscard]] tl::expected<int, std::string>
+	get_int(std::string_view name, int default_value) const;
+
+	[[nodiscard]] tl::expected<float, std::string>
+	get_float(std::string_view name, float default_value) const;
+
+	[[nodiscard]] const std::vector<std::string>& get_positional() const {
+		return positional;
+	}
+
+  private:
+	std::multimap<std::string, std::string, std::less<>> options;
+	std::vector<std::string> positional;
+};
+
+[[nodiscard]] tl::expected<std::vector<int8_t>, std::string>
+read_file_bytes(const std::string& path);
+
+[[nodiscard]] std::optional<std::string>
+write_file_bytes(const std::string& path, std::span<const std::byte> bytes);
+
+/// peak resident set size of this process
+[[nodiscard]] size_t get_peak_rss_bytes();
+
+/// creates operators by their command line name ("rgb-normalize", "min-max",
+/// "temporal-filter", "scale-shift-align")
+[[nodiscard]] tl::expected<std::unique_ptr<Operator>, std::string>
+create_operator_by_name(std::string_view name);
+
+/// log callbacks for TfLiteRuntime that print to stderr
+void log_warning_to_stderr(std::string msg);
+void log_error_to_stderr(std::string msg);
+
+/// cpu only runtime with the operators of DepthModel (rgb normalize, min max)
+[[nodiscard]] tl::expected<std::unique_ptr<TfLiteRuntime>, std::string>
+create_depth_runtime(
+	std::vector<int8_t>&& model_data,
+	std::string_view model_token,
+	int num_threads,
+	bool use_xnnpack,
+	int batch_size = 1
+);
+
+/// input and output size of a depth model, the input has to be
+/// [1, height, width, 3] and the output [1, height, width(, 1)]
+struct DepthModelDimensions {
+	int input_width = 0;
+	int input_height = 0;
+	int output_width = 0;
+	int output_height = 0;
+};
+
+[[nodiscard]] tl::expected<DepthModelDimensions, std::string>
+get_depth_model_dimensions(const TfLiteRuntime& runtime);
+
+/// nearest-rank percentile (0..100) of already sorted values
+[[nodiscard]] double
+percentile_of_sorted(std::span<const double> sorted_values, double percentile);
+
+/// builds a json document, takes care of commas and escaping
+class JsonWriter {
+  public:
+	JsonWriter& begin_object(std::string_view key = {});
+	JsonWriter& end_object();
+	JsonWriter& begin_array(std::string_view key = {});
+	JsonWriter& end_array();
+
+	JsonWriter& value(std::string_view key, std::string_view value);
+	JsonWriter& value(std::string_view key, const char* value);
+	JsonWriter& value(std::string_view key, double value);
+	JsonWriter& value(std::string_view key, int64_t value);
+	JsonWriter& value(std::string_view key, uint64_t value);
+	JsonWriter& value(std::string_view key, int value);
+	JsonWriter& value(std::string_view key, bool value);
+
+	[[nodiscard]] const std::string& str() const { return json; }
+
+  private:
+	void begin_value(std::string_view key);
+
+	std::string json;
+	/// true if the current object/array already has an element
+	std::vector<bool> has_elements;
+};
+
+/// writes min, mean, stddev, percentiles and max of values as an object
+void write_distribution(
+	JsonWriter& json,
+	std::string_view key,
+	std::vector<double> values
+);
@@ -0,0 +1,197 @@
+#include "AudioIo.hpp"
+#include "EyeAICore/audio/SpatialAudio.hpp"
+#include "ToolUtils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <iostream>
+#include <numbers>
+#include <vector>
+
+constexpr std::string_view USAGE = R"(usage: eyeai-audio <scenario> [options]
+
+renders the spatial audio cues of a synthetic obstacle scenario to a stereo
+wav and measures the render time of every block
+
+scenarios:
+  sweep       one obstacle moving from left to right and back
+  approach    an obstacle approaching from the right, a static one on the left
+  crowd       every voice busy with a moving obstacle
+
+options:
+  --output <path>            wav file to write (default: <scenario>.wav)
+  --seconds <x>              length of the scenario (default: 8)
+  --sample-rate <n>          (default: 48000)
+  --block-frames <n>         frames per rendered block (default: 128)
+  --update-rate <x>          cue updates per second, like the depth output
+                             (default: 30)
+  --report <path>            write the render times as json
+)";
+
+constexpr std::array<std::string_view, 1> FLAG_NAMES = {"help"};
+
+/// cues of the scenario at a time in seconds
+static std::vector<AudioCue>
+scenario_cues(std::string_view scenario, float seconds, int voices) {
+	const float pi = std::numbers::pi_v<float>;
+	std::vector<AudioCue> cues;
+	if (scenario == "sweep") {
+		cues.push_back(AudioCue(
+			1, 80.0f * std::sin(2.0f * pi * seconds / 8.0f),
+			0.5f + 0.4f * std::sin(2.0f * pi * seconds / 3.0f), 1.0f
+		));
+	} else if (scenario == "approach") {
+		cues.push_back(AudioCue(
+			1, 30.0f, std::min(std::fmod(seconds, 8.0f) / 8.0f, 1.0f), 1.0f
+		));
+		cues.push_back(AudioCue(2, -45.0f, 0.3f, 0.7f));
+	} else if (scenario == "crowd") {
+		for (int i = 0; i < voices; i++) {
+			const float offset =
+				static_cast<float>(i) / static_cast<float>(voices);
+			cues.push_back(AudioCue(
+				static_cast<uint32_t>(i + 1),
+				90.0f * std::sin(2.0f * pi * (seconds / 5.0f + offset)),
+				0.5f + 0.5f * std::sin(2.0f * pi * (seconds / 2.0f + offset)),
+				0.5f
+			));
+		}
+	}
+	return cues;
+}
+
+int main(int argc, char** argv) {
+	const auto command_line = CommandLine::parse(argc, argv, FLAG_NAMES);
+	if (!command_line) {
+		std::cerr << command_line.error() << '\n' << USAGE;
+		return 1;
+	}
+	const auto& positional = command_line->get_positional();
+	if (command_line->has("help") || positional.size() != 1) {
+		std::cerr << USAGE;
+		return command_line->has("help") ? 0 : 1;
+	}
+	const std::string& scenario = positional[0];
+	if (scenario != "sweep" && scenario != "approach" && scenario != "crowd") {
+		std::cerr << std::format("unknown scenario: {}\n", scenario) << USAGE;
+		return 1;
+	}
+
+	const auto seconds = command_line->get_float("seconds", 8.0f);
+	const auto update_rate = command_line->get_float("update-rate", 30.0f);
+	for (const auto* result : {&seconds, &update_rate}) {
+		if (!result->has_value()) {
+			std::cerr << result->error() << '\n';
+			return 1;
+		}
+	}
+	const auto sample_rate = command_line->get_int("sample-rate", 48000);
+	const auto block_frames = command_line->get_int("block-frames", 128);
+	for (const auto* result : {&sample_rate, &block_frames}) {
+		if (!result->has_value()) {
+			std::cerr << result->error() << '\n';
+			return 1;
+		}
+	}
+	if (*seconds <= 0.0f || *block_frames <= 0 || *update_rate <= 0.0f) {
+		std::cerr << "seconds, block frames and update rate have to be "
+					 "positive\n";
+		return 1;
+	}
+
+	SpatialAudioConfig config;
+	config.sample_rate = *sample_rate;
+	config.max_block_frames = *block_frames;
+	auto synth = SpatialAudioSynth::create(config);
+	if (!synth) {
+		std::cerr << synth.error().to_string() << '\n';
+		return 1;
+	}
+
+	const auto total_frames = static_cast<size_t>(
+		std::lround(*seconds * static_cast<float>(*sample_rate))
+	);
+	const auto frames_per_update = std::max(
+		static_cast<size_t>(
+			std::lround(static_cast<float>(*sample_rate) / *update_rate)
+		),
+		size_t{1}
+	);
+	std::vector<float> samples(total_frames * 2);
+	std::vector<double> render_micros;
+	size_t next_update = 0;
+	for (size_t frame = 0; frame < total_frames;
+		 frame += static_cast<size_t>(*block_frames)) {
+		if (frame >= next_update) {
+			const float time =
+				static_cast<float>(frame) / static_cast<float>(*sample_rate);
+			synth->set_cues(scenario_cues(scenario, time, config.voices));
+			next_update += frames_per_update;
+		}
+
+		const size_t frames = std::min(
+			static_cast<size_t>(*block_frames), total_frames - frame
+		);
+		const auto block = std::span(samples).subspan(frame * 2, frames * 2);
+		const auto start = std::chrono::steady_clock::now();
+		const auto error = synth->render(block);
+		const auto end = std::chrono::steady_clock::now();
+		if (error) {
+			std::cerr << error->to_string() << '\n';
+			return 1;
+		}
+		render_micros.push_back(
+			std::chrono::duration<double, std::micro>(end - start).count()
+		);
+	}
+
+	const std::string output_path = command_line->get_string(
+		"output", std::format("{}.wav", scenario)
+	);
+	if (const auto error =
+			write_wav16(output_path, samples, 2, *sample_rate)) {
+		std::cerr << *error << '\n';
+		return 1;
+	}
+
+	std::vector<double> sorted_micros = render_micros;
+	std::ranges::sort(sorted_micros);
+	double total_micros = 0.0;
+	for (const double micros : render_micros)
+		total_micros += micros;
+	const double mean_micros =
+		total_micros / static_cast<double>(render_micros.size());
+	const double block_micros =
+		1e6 * *block_frames / static_cast<double>(*sample_rate);
+
+	const std::string report_path = command_line->get_string("report", "");
+	if (!report_path.empty()) {
+		JsonWriter json;
+		json.begin_object()
+			.value("scenario", scenario)
+			.value("sample_rate", *sample_rate)
+			.value("block_frames", *block_frames)
+			.value("blocks", static_cast<uint64_t>(render_micros.size()))
+			.value("block_duration_us", block_micros);
+		write_distribution(json, "render_us", render_micros);
+		json.end_object();
+		if (const auto error = write_file_bytes(
+				report_path, std::as_bytes(std::span(json.str()))
+			)) {
+			std::cerr << *error << '\n';
+			return 1;
+		}
+	}
+
+	std::cerr << std::format(
+		"{}: {} blocks of {} frames, render {:.2f} us mean, {:.2f} us p99, "
+		"{:.2f} us max ({:.0f} us of audio per block)\n",
+		output_path, render_micros.size(), *block_frames, mean_micros,
+		percentile_of_sorted(sorted_micros, 99.0), sorted_micros.back(),
+		block_micros
+	);
+	return 0;
+}
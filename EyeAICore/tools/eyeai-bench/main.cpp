@@ -0,0 +1,333 @@
+#include "EyeAICore/tflite/TfLiteRuntime.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "ToolUtils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+constexpr std::string_view USAGE = R"(usage: eyeai-bench <model.tflite> [options]
+
+runs warm-up and timed inferences of a tflite model through TfLiteRuntime and
+prints the results as json to stdout
+
+options:
+  --threads <n>              interpreter threads (default: 4)
+  --xnnpack                  apply an explicitly configured xnnpack delegate
+  --gpu                      try to use the gpu delegate
+  --batch <n>                batch size of the input tensor (default: 1)
+  --warmup <n>               untimed warm-up iterations (default: 5)
+  --iterations <n>           timed iterations (default: 50)
+  --input-operator <name>    can be repeated: rgb-normalize, min-max,
+                             temporal-filter, scale-shift-align
+  --output-operator <name>   can be repeated: rgb-normalize, min-max,
+                             temporal-filter, scale-shift-align
+  --input-file <path>        raw input values instead of synthetic input,
+                             either one batch element or the whole batch
+  --input-format <f32|u8>    element type of --input-file (default: f32)
+  --seed <n>                 seed of the synthetic input (default: 42)
+  --output <path>            write the json to a file instead of stdout
+)";
+
+constexpr std::array<std::string_view, 3> FLAG_NAMES = {
+	"xnnpack", "gpu", "help"
+};
+
+static double to_millis(std::chrono::steady_clock::duration duration) {
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/// values of a single batch element are repeated for the whole batch
+static tl::expected<std::vector<float>, std::string> load_input_file(
+	const std::string& path,
+	std::string_view format,
+	size_t input_element_count,
+	int batch_size
+) {
+	const auto bytes = read_file_bytes(path);
+	if (!bytes)
+		return tl::unexpected(bytes.error());
+
+	std::vector<float> values;
+	if (format == "f32") {
+		if (bytes->size() % sizeof(float) != 0)
+			return tl::unexpected_fmt("{} is not a float32 file", path);
+		values.resize(bytes->size() / sizeof(float));
+		std::memcpy(values.data(), bytes->data(), bytes->size());
+	} else if (format == "u8") {
+		values.reserve(bytes->size());
+		for (const int8_t byte : *bytes)
+			values.push_back(static_cast<float>(static_cast<uint8_t>(byte)));
+	} else {
+		return tl::unexpected_fmt("unknown input format: {}", format);
+	}
+
+	const size_t batch_element_count =
+		input_element_count / static_cast<size_t>(batch_size);
+	if (values.size() == batch_element_count && batch_size > 1) {
+		values.reserve(input_element_count);
+		for (int i = 1; i < batch_size; i++) {
+			values.insert(
+				values.end(), values.begin(),
+				values.begin() + static_cast<ptrdiff_t>(batch_element_count)
+			);
+		}
+	}
+	if (values.size() != input_element_count) {
+		return tl::unexpected_fmt(
+			"{} has {} values, but the model expects {} ({} per batch element)",
+			path, values.size(), input_element_count, batch_element_count
+		);
+	}
+	return values;
+}
+
+static void write_shape(
+	JsonWriter& json,
+	std::string_view key,
+	const std::vector<int>& shape
+) {
+	json.begin_array(key);
+	for (const int dim : shape)
+		json.value({}, dim);
+	json.end_array();
+}
+
+static int run(const CommandLine& command_line) {
+	if (command_line.has("help") || command_line.get_positional().size() != 1) {
+		std::cerr << USAGE;
+		return command_line.has("help") ? 0 : 1;
+	}
+	const std::string& model_path = command_line.get_positional()[0];
+
+	const auto threads = command_line.get_int("threads", 4);
+	const auto batch_size = command_line.get_int("batch", 1);
+	const auto warmup_iterations = command_line.get_int("warmup", 5);
+	const auto iterations = command_line.get_int("iterations", 50);
+	const auto seed = command_line.get_int("seed", 42);
+	for (const auto* result :
+		 {&threads, &batch_size, &warmup_iterations, &iterations, &seed}) {
+		if (!result->has_value()) {
+			std::cerr << result->error() << '\n';
+			return 1;
+		}
+	}
+	if (*batch_size < 1 || *iterations < 1 || *warmup_iterations < 0) {
+		std::cerr << "--batch and --iterations must be at least 1, --warmup "
+					 "must not be negative\n";
+		return 1;
+	}
+
+	const auto file_read_start = std::chrono::steady_clock::now();
+	auto model_data = read_file_bytes(model_path);
+	if (!model_data) {
+		std::cerr << model_data.error() << '\n';
+		return 1;
+	}
+	const auto file_read_duration =
+		std::chrono::steady_clock::now() - file_read_start;
+	const size_t model_size_bytes = model_data->size();
+
+	TfLiteRuntimeBuilder builder(
+		std::move(*model_data), "", "eyeai-bench", log_warning_to_stderr,
+		log_error_to_stderr
+	);
+	builder.set_num_threads(*threads)
+		.set_use_xnnpack(command_line.has("xnnpack"))
+		.set_use_gpu_delegate(command_line.has("gpu"))
+		.set_batch_size(*batch_size);
+
+	const auto input_operator_names =
+		command_line.get_strings("input-operator");
+	const auto output_operator_names =
+		command_line.get_strings("output-operator");
+	for (const auto& name : input_operator_names) {
+		auto input_operator = create_operator_by_name(name);
+		if (!input_operator) {
+			std::cerr << input_operator.error() << '\n';
+			return 1;
+		}
+		builder.add_input_operator(std::move(*input_operator));
+	}
+	for (const auto& name : output_operator_names) {
+		auto output_operator = create_operator_by_name(name);
+		if (!output_operator) {
+			std::cerr << output_operator.error() << '\n';
+			return 1;
+		}
+		builder.add_output_operator(std::move(*output_operator));
+	}
+
+	auto runtime = builder.build();
+	if (!runtime) {
+		std::cerr << std::format(
+			"failed to create runtime: {}\n", runtime.error().to_string()
+		);
+		return 1;
+	}
+	const size_t peak_rss_after_startup = get_peak_rss_bytes();
+
+	const size_t input_element_count = (*runtime)->get_input_element_count();
+	const size_t output_element_count = (*runtime)->get_output_element_count();
+
+	std::vector<float> pristine_input;
+	const std::string input_file = command_line.get_string("input-file", "");
+	if (!input_file.empty()) {
+		auto file_input = load_input_file(
+			input_file, command_line.get_string("input-format", "f32"),
+			input_element_count, *batch_size
+		);
+		if (!file_input) {
+			std::cerr << file_input.error() << '\n';
+			return 1;
+		}
+		pristine_input = std::move(*file_input);
+	} else {
+		std::mt19937 random_engine(static_cast<uint32_t>(*seed));
+		std::uniform_real_distribution<float> distribution(0.0f, 255.0f);
+		pristine_input.resize(input_element_count);
+		for (float& value : pristine_input)
+			value = distribution(random_engine);
+	}
+
+	// input operators modify the input in place, so every iteration starts
+	// from a fresh copy
+	std::vector<float> input(input_element_count);
+	std::vector<float> output(output_element_count);
+
+	const auto run_iteration =
+		[&]() -> tl::expected<FrameTrace, TfLiteRunInferenceError> {
+		std::ranges::copy(pristine_input, input.begin());
+		// drains the profiling records, they would pile up otherwise
+		(void)get_depth_profiling_frame().finish();
+
+		FrameTrace trace;
+		trace.dequeue_time = frame_clock::now();
+		if (const auto error = (*runtime)->run_inference(input, output, trace))
+			return tl::unexpected(*error);
+		return trace;
+	};
+
+	for (int i = 0; i < *warmup_iterations; i++) {
+		if (const auto result = run_iteration(); !result) {
+			std::cerr << std::format(
+				"inference failed: {}\n", result.error().to_string()
+			);
+			return 1;
+		}
+	}
+
+	std::vector<double> latencies;
+	std::vector<double> preprocess_durations;
+	std::vector<double> inference_durations;
+	std::vector<double> postprocess_durations;
+	for (int i = 0; i < *iterations; i++) {
+		const auto trace = run_iteration();
+		if (!trace) {
+			std::cerr << std::format(
+				"inference failed: {}\n", trace.error().to_string()
+			);
+			return 1;
+		}
+		latencies.push_back(
+			to_millis(trace->postprocess_end_time - trace->dequeue_time)
+		);
+		preprocess_durations.push_back(to_millis(trace->preprocess_duration()));
+		inference_durations.push_back(to_millis(trace->inference_duration()));
+		postprocess_durations.push_back(to_millis(trace->postprocess_duration()
+		));
+	}
+
+	const double mean_latency =
+		std::accumulate(latencies.begin(), latencies.end(), 0.0) /
+		static_cast<double>(latencies.size());
+	const auto& startup_timings = (*runtime)->get_startup_timings();
+
+	JsonWriter json;
+	json.begin_object()
+		.value("model", model_path)
+		.value("model_size_bytes", static_cast<uint64_t>(model_size_bytes));
+
+	json.begin_object("config")
+		.value("threads", *threads)
+		.value("xnnpack", command_line.has("xnnpack"))
+		.value("gpu", command_line.has("gpu"))
+		.value("batch_size", *batch_size)
+		.value("warmup_iterations", *warmup_iterations)
+		.value("iterations", *iterations)
+		.value("input", input_file.empty() ? "synthetic" : input_file);
+	json.begin_array("input_operators");
+	for (const auto& name : input_operator_names)
+		json.value({}, name);
+	json.end_array().begin_array("output_operators");
+	for (const auto& name : output_operator_names)
+		json.value({}, name);
+	json.end_array().end_object();
+
+	write_shape(json, "input_shape", (*runtime)->get_input_shape());
+	write_shape(json, "output_shape", (*runtime)->get_output_shape());
+
+	json.begin_object("startup_ms")
+		.value("file_read", to_millis(file_read_duration))
+		.value("model_load", to_millis(startup_timings.model_load))
+		.value(
+			"interpreter_create", to_millis(startup_timings.interpreter_create)
+		)
+		.value("allocate_tensors", to_millis(startup_timings.allocate_tensors))
+		.value("total", to_millis(file_read_duration + startup_timings.total()))
+		.end_object();
+
+	write_distribution(json, "latency_ms", latencies);
+	json.begin_object("stages_ms");
+	write_distribution(json, "preprocess", preprocess_durations);
+	write_distribution(json, "inference", inference_durations);
+	write_distribution(json, "postprocess", postprocess_durations);
+	json.end_object();
+
+	json.begin_object("throughput")
+		.value("inferences_per_second", 1000.0 / mean_latency)
+		.value(
+			"frames_per_second",
+			1000.0 / mean_latency * static_cast<double>(*batch_size)
+		)
+		.end_object();
+
+	json.begin_object("memory")
+		.value(
+			"peak_rss_after_startup_bytes",
+			static_cast<uint64_t>(peak_rss_after_startup)
+		)
+		.value("peak_rss_bytes", static_cast<uint64_t>(get_peak_rss_bytes()))
+		.end_object();
+	json.end_object();
+
+	const std::string output_path = command_line.get_string("output", "");
+	if (output_path.empty()) {
+		std::cout << json.str() << '\n';
+	} else if (const auto error = write_file_bytes(
+				   output_path, std::as_bytes(std::span(json.str()))
+			   )) {
+		std::cerr << *error << '\n';
+		return 1;
+	}
+
+	std::cerr << std::format(
+		"{}: {:.2f} ms mean latency over {} iterations (batch {})\n",
+		model_path, mean_latency, *iterations, *batch_size
+	);
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	const auto command_line = CommandLine::parse(argc, argv, FLAG_NAMES);
+	if (!command_line) {
+		std::cerr << command_line.error() << '\n' << USAGE;
+		return 1;
+	}
+	return run(*command_line);
+}
@@ -0,0 +1,522 @@
+#include "EyeAICore/tflite/TfLiteRuntime.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "EyeAICore/utils/SessionRecording.hpp"
+#include "FrameSource.hpp"
+#include "ToolUtils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <thread>
+
+constexpr std::string_view USAGE = R"(usage:
+  eyeai-session record <model.tflite> <frame source> --output <session>
+  eyeai-session replay <model.tflite> <session>
+  eyeai-session info <session>
+
+record: runs the model on every frame and stores the input frames, their
+capture timestamps and the depth outputs in a recorded session
+
+replay: feeds the recorded frames through the model again, compares the depth
+with the recorded depth and measures the latency of every frame, exits with 2
+if any frame differs by more than --tolerance
+
+frame source:
+)";
+
+constexpr std::string_view OPTIONS_USAGE = R"(
+record options:
+  --output <path>            recorded session to write
+  --fps <n>                  capture rate used for the timestamps (default: 30)
+  --depth-encoding <enc>     u16 (default, values in [0, 1]) or f16
+  --no-delta                 store every depth map completely
+  --keyframe-interval <n>    frames between complete depth maps (default: 30)
+  --max-frames <n>           stop after n frames
+
+replay options:
+  --realtime                 feed frames with their original timing instead of
+                             as fast as possible
+  --tolerance <x>            max allowed absolute depth difference
+                             (default: 0.01)
+  --loops <n>                replay the session n times (default: 1)
+  --report <path>            write the results as json
+
+common options:
+  --threads <n>              interpreter threads (default: 4)
+  --xnnpack                  apply an explicitly configured xnnpack delegate
+)";
+
+constexpr std::array<std::string_view, 4> FLAG_NAMES = {
+	"no-delta", "realtime", "xnnpack", "help"
+};
+
+static double to_millis(std::chrono::steady_clock::duration duration) {
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+/// tools use the model file name as model token, like the app
+static std::string model_token_from_path(const std::string& model_path) {
+	return std::filesystem::path(model_path).stem().string();
+}
+
+static tl::expected<std::unique_ptr<TfLiteRuntime>, std::string>
+create_runtime_from_command_line(
+	const CommandLine& command_line,
+	const std::string& model_path,
+	std::string_view model_token
+) {
+	const auto threads = command_line.get_int("threads", 4);
+	if (!threads)
+		return tl::unexpected(threads.error());
+	auto model_data = read_file_bytes(model_path);
+	if (!model_data)
+		return tl::unexpected(model_data.error());
+	return create_depth_runtime(
+		std::move(*model_data), model_token, *threads,
+		command_line.has("xnnpack")
+	);
+}
+
+/// preprocessing and inference of one frame, writes the result to depth
+static tl::expected<void, std::string> estimate_depth(
+	TfLiteRuntime& runtime,
+	const DepthModelDimensions& dimensions,
+	std::span<const uint8_t> rgb_pixels,
+	int width,
+	int height,
+	std::vector<float>& input,
+	std::vector<float>& depth
+) {
+	if (const auto error = resize_rgb8_to_floats(
+			rgb_pixels, width, height, input, dimensions.input_width,
+			dimensions.input_height
+		))
+		return tl::unexpected(error->to_string());
+	if (const auto error = runtime.run_inference(input, depth))
+		return tl::unexpected(error->to_string());
+	// only this thread records profiling scopes, they are not needed here
+	(void)get_depth_profiling_frame().finish();
+	return {};
+}
+
+static int record(const CommandLine& command_line) {
+	const auto& positional = command_line.get_positional();
+	const std::string output_path = command_line.get_string("output", "");
+	if (positional.size() != 2 || output_path.empty()) {
+		std::cerr << USAGE << FRAME_SOURCE_USAGE << OPTIONS_USAGE;
+		return 1;
+	}
+	const std::string& model_path = positional[1];
+	const std::string model_token = model_token_from_path(model_path);
+
+	const auto fps = command_line.get_float("fps", 30.0f);
+	const auto keyframe_interval =
+		command_line.get_int("keyframe-interval", 30);
+	const auto max_frames = command_line.get_int("max-frames", 0);
+	if (!fps || !keyframe_interval || !max_frames) {
+		std::cerr << (!fps ? fps.error()
+					  : !keyframe_interval ? keyframe_interval.error()
+										   : max_frames.error())
+				  << '\n';
+		return 1;
+	}
+	if (*fps <= 0.0f || *keyframe_interval < 1 || *max_frames < 0) {
+		std::cerr << "--fps and --keyframe-interval must be positive\n";
+		return 1;
+	}
+	const auto depth_encoding_name =
+		command_line.get_string("depth-encoding", "u16");
+	if (depth_encoding_name != "u16" && depth_encoding_name != "f16") {
+		std::cerr << std::format(
+			"unknown depth encoding: {}\n", depth_encoding_name
+		);
+		return 1;
+	}
+
+	auto source = create_frame_source(command_line);
+	if (!source) {
+		std::cerr << source.error() << '\n';
+		return 1;
+	}
+	auto runtime =
+		create_runtime_from_command_line(command_line, model_path, model_token);
+	if (!runtime) {
+		std::cerr << runtime.error() << '\n';
+		return 1;
+	}
+	const auto dimensions = get_depth_model_dimensions(**runtime);
+	if (!dimensions) {
+		std::cerr << dimensions.error() << '\n';
+		return 1;
+	}
+
+	std::vector<float> input((*runtime)->get_input_element_count());
+	std::vector<float> depth((*runtime)->get_output_element_count());
+	std::unique_ptr<SessionRecorder> recorder;
+	const auto frame_interval = std::chrono::duration<double, std::nano>(
+		1e9 / static_cast<double>(*fps)
+	);
+
+	for (size_t index = 0;
+		 *max_frames == 0 || index < static_cast<size_t>(*max_frames);
+		 index++) {
+		auto frame = (*source)->next_frame();
+		if (!frame) {
+			std::cerr << frame.error() << '\n';
+			return 1;
+		}
+		if (!frame->has_value())
+			break;
+		const RgbImage& image = **frame;
+
+		// the session gets the size of the first frame
+		if (!recorder) {
+			SessionInfo info;
+			info.model_token = model_token;
+			info.input_width = image.width;
+			info.input_height = image.height;
+			info.depth_width = dimensions->output_width;
+			info.depth_height = dimensions->output_height;
+			info.depth_encoding = depth_encoding_name == "f16"
+									  ? DepthEncoding::Float16
+									  : DepthEncoding::UInt16;
+			info.depth_delta = !command_line.has("no-delta");
+			info.keyframe_interval = static_cast<uint32_t>(*keyframe_interval);
+
+			auto created_recorder =
+				SessionRecorder::create(output_path, std::move(info));
+			if (!created_recorder) {
+				std::cerr << created_recorder.error().to_string() << '\n';
+				return 1;
+			}
+			recorder = std::move(*created_recorder);
+		}
+
+		if (const auto result = estimate_depth(
+				**runtime, *dimensions, image.pixels, image.width, image.height,
+				input, depth
+			);
+			!result) {
+			std::cerr << std::format("frame {}: {}\n", index, result.error());
+			return 1;
+		}
+
+		const auto timestamp_nanos = static_cast<int64_t>(
+			frame_interval.count() * static_cast<double>(index)
+		);
+		if (const auto error =
+				recorder->write_frame(timestamp_nanos, image.pixels, depth)) {
+			std::cerr << std::format(
+				"frame {}: {}\n", index, error->to_string()
+			);
+			return 1;
+		}
+	}
+
+	if (!recorder) {
+		std::cerr << "frame source has no frames\n";
+		return 1;
+	}
+	if (const auto error = recorder->finish()) {
+		std::cerr << error->to_string() << '\n';
+		return 1;
+	}
+	std::cerr << std::format(
+		"recorded {} frames to {}\n", recorder->get_frame_count(), output_path
+	);
+	return 0;
+}
+
+/// difference between the replayed and the recorded depth of a frame
+struct DepthComparison {
+	float max_abs_error = 0.0f;
+	double abs_error_sum = 0.0;
+	size_t pixels_over_tolerance = 0;
+};
+
+static DepthComparison compare_depth(
+	std::span<const float> depth,
+	std::span<const float> recorded_depth,
+	float tolerance
+) {
+	DepthComparison comparison;
+	for (size_t i = 0; i < depth.size(); i++) {
+		const float abs_error = std::abs(depth[i] - recorded_depth[i]);
+		comparison.max_abs_error = std::max(comparison.max_abs_error, abs_error);
+		comparison.abs_error_sum += abs_error;
+		if (abs_error > tolerance)
+			comparison.pixels_over_tolerance++;
+	}
+	return comparison;
+}
+
+static int replay(const CommandLine& command_line) {
+	const auto& positional = command_line.get_positional();
+	if (positional.size() != 3) {
+		std::cerr << USAGE << FRAME_SOURCE_USAGE << OPTIONS_USAGE;
+		return 1;
+	}
+	const std::string& model_path = positional[1];
+	const std::string& session_path = positional[2];
+	const std::string model_token = model_token_from_path(model_path);
+
+	const auto tolerance = command_line.get_float("tolerance", 0.01f);
+	const auto loops = command_line.get_int("loops", 1);
+	if (!tolerance || !loops) {
+		std::cerr << (!tolerance ? tolerance.error() : loops.error()) << '\n';
+		return 1;
+	}
+	const bool realtime = command_line.has("realtime");
+
+	auto reader = SessionReader::open(session_path);
+	if (!reader) {
+		std::cerr << reader.error().to_string() << '\n';
+		return 1;
+	}
+	const SessionInfo& info = (*reader)->get_info();
+	if (info.model_token != model_token) {
+		log_warning_to_stderr(std::format(
+			"session was recorded with model {}, replaying with {}",
+			info.model_token, model_token
+		));
+	}
+
+	auto runtime =
+		create_runtime_from_command_line(command_line, model_path, model_token);
+	if (!runtime) {
+		std::cerr << runtime.error() << '\n';
+		return 1;
+	}
+	const auto dimensions = get_depth_model_dimensions(**runtime);
+	if (!dimensions) {
+		std::cerr << dimensions.error() << '\n';
+		return 1;
+	}
+	if (static_cast<size_t>(dimensions->output_width) *
+			static_cast<size_t>(dimensions->output_height) !=
+		info.depth_size()) {
+		std::cerr << std::format(
+			"model outputs {}x{} depth maps, but the session has {}x{}\n",
+			dimensions->output_width, dimensions->output_height,
+			info.depth_width, info.depth_height
+		);
+		return 1;
+	}
+
+	std::vector<float> input((*runtime)->get_input_element_count());
+	std::vector<float> depth((*runtime)->get_output_element_count());
+
+	std::vector<double> latencies;
+	std::vector<double> lateness;
+	size_t late_frames = 0;
+	size_t mismatched_frames = 0;
+	float max_abs_error = 0.0f;
+	double abs_error_sum = 0.0;
+	size_t compared_pixels = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int loop = 0; loop < std::max(*loops, 1); loop++) {
+		(*reader)->rewind();
+		const auto loop_start = std::chrono::steady_clock::now();
+		std::optional<int64_t> first_timestamp_nanos;
+
+		while (true) {
+			auto frame = (*reader)->read_next_frame();
+			if (!frame) {
+				std::cerr << frame.error().to_string() << '\n';
+				return 1;
+			}
+			if (!frame->has_value())
+				break;
+			const RecordedFrame& recorded = **frame;
+
+			// in realtime mode a frame becomes available at its capture time,
+			// otherwise as soon as the previous one is done
+			auto available_time = std::chrono::steady_clock::now();
+			if (realtime) {
+				if (!first_timestamp_nanos)
+					first_timestamp_nanos = recorded.capture_timestamp_nanos;
+				available_time =
+					loop_start +
+					std::chrono::duration_cast<
+						std::chrono::steady_clock::duration>(
+						std::chrono::nanoseconds(
+							recorded.capture_timestamp_nanos -
+							*first_timestamp_nanos
+						)
+					);
+				std::this_thread::sleep_until(available_time);
+				const auto start_delay =
+					std::chrono::steady_clock::now() - available_time;
+				lateness.push_back(to_millis(start_delay));
+				// the previous frame took longer than the frame interval
+				if (start_delay > std::chrono::milliseconds(1))
+					late_frames++;
+			}
+
+			if (const auto result = estimate_depth(
+					**runtime, *dimensions, recorded.rgb_pixels,
+					info.input_width, info.input_height, input, depth
+				);
+				!result) {
+				std::cerr << std::format(
+					"frame {}: {}\n", recorded.frame_index, result.error()
+				);
+				return 1;
+			}
+			latencies.push_back(
+				to_millis(std::chrono::steady_clock::now() - available_time)
+			);
+
+			const auto comparison =
+				compare_depth(depth, recorded.depth, *tolerance);
+			max_abs_error = std::max(max_abs_error, comparison.max_abs_error);
+			abs_error_sum += comparison.abs_error_sum;
+			compared_pixels += depth.size();
+			if (comparison.pixels_over_tolerance > 0) {
+				mismatched_frames++;
+				log_warning_to_stderr(std::format(
+					"frame {}: {} pixels differ by more than {} (max {})",
+					recorded.frame_index, comparison.pixels_over_tolerance,
+					*tolerance, comparison.max_abs_error
+				));
+			}
+		}
+	}
+	const double wall_seconds =
+		std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+			.count();
+
+	JsonWriter json;
+	json.begin_object()
+		.value("session", session_path)
+		.value("model", model_path)
+		.value("recorded_model_token", info.model_token)
+		.value("realtime", realtime)
+		.value("frames", static_cast<uint64_t>(latencies.size()))
+		.value("wall_seconds", wall_seconds)
+		.value(
+			"frames_per_second",
+			static_cast<double>(latencies.size()) / wall_seconds
+		);
+	write_distribution(json, "latency_ms", latencies);
+	if (realtime) {
+		write_distribution(json, "start_delay_ms", lateness);
+		json.value("late_frames", static_cast<uint64_t>(late_frames));
+	}
+	json.begin_object("depth_comparison")
+		.value("tolerance", static_cast<double>(*tolerance))
+		.value("mismatched_frames", static_cast<uint64_t>(mismatched_frames))
+		.value("max_abs_error", static_cast<double>(max_abs_error))
+		.value(
+			"mean_abs_error",
+			compared_pixels > 0
+				? abs_error_sum / static_cast<double>(compared_pixels)
+				: 0.0
+		)
+		.end_object();
+	json.end_object();
+
+	const auto report_path = command_line.get_string("report", "");
+	if (report_path.empty()) {
+		std::cout << json.str() << '\n';
+	} else if (const auto error = write_file_bytes(
+				   report_path, std::as_bytes(std::span(json.str()))
+			   )) {
+		std::cerr << *error << '\n';
+		return 1;
+	}
+
+	std::cerr << std::format(
+		"{} frames replayed, {} differ by more than {}\n", latencies.size(),
+		mismatched_frames, *tolerance
+	);
+	return mismatched_frames > 0 ? 2 : 0;
+}
+
+static int info(const CommandLine& command_line) {
+	const auto& positional = command_line.get_positional();
+	if (positional.size() != 2) {
+		std::cerr << USAGE << FRAME_SOURCE_USAGE << OPTIONS_USAGE;
+		return 1;
+	}
+	const std::string& session_path = positional[1];
+
+	auto reader = SessionReader::open(session_path);
+	if (!reader) {
+		std::cerr << reader.error().to_string() << '\n';
+		return 1;
+	}
+	const SessionInfo& info = (*reader)->get_info();
+
+	int64_t first_timestamp_nanos = 0;
+	int64_t last_timestamp_nanos = 0;
+	for (size_t i = 0;; i++) {
+		auto frame = (*reader)->read_next_frame();
+		if (!frame) {
+			std::cerr << frame.error().to_string() << '\n';
+			return 1;
+		}
+		if (!frame->has_value())
+			break;
+		if (i == 0)
+			first_timestamp_nanos = (*frame)->capture_timestamp_nanos;
+		last_timestamp_nanos = (*frame)->capture_timestamp_nanos;
+	}
+
+	std::error_code error;
+	const auto file_size = std::filesystem::file_size(session_path, error);
+
+	JsonWriter json;
+	json.begin_object()
+		.value("session", session_path)
+		.value("model_token", info.model_token)
+		.value("frames", static_cast<uint64_t>((*reader)->get_frame_count()))
+		.value(
+			"duration_seconds",
+			static_cast<double>(last_timestamp_nanos - first_timestamp_nanos) /
+				1e9
+		)
+		.value("input_width", info.input_width)
+		.value("input_height", info.input_height)
+		.value("depth_width", info.depth_width)
+		.value("depth_height", info.depth_height)
+		.value(
+			"depth_encoding",
+			info.depth_encoding == DepthEncoding::Float16 ? "f16" : "u16"
+		)
+		.value("depth_delta", info.depth_delta)
+		.value("keyframe_interval", static_cast<int64_t>(info.keyframe_interval))
+		.value("file_size_bytes", static_cast<uint64_t>(error ? 0 : file_size))
+		.end_object();
+	std::cout << json.str() << '\n';
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	const auto command_line = CommandLine::parse(argc, argv, FLAG_NAMES);
+	if (!command_line) {
+		std::cerr << command_line.error() << '\n' << USAGE;
+		return 1;
+	}
+	const auto& positional = command_line->get_positional();
+	if (command_line->has("help") || positional.empty()) {
+		std::cerr << USAGE << FRAME_SOURCE_USAGE << OPTIONS_USAGE;
+		return command_line->has("help") ? 0 : 1;
+	}
+
+	if (positional[0] == "record")
+		return record(*command_line);
+	if (positional[0] == "replay")
+		return replay(*command_line);
+	if (positional[0] == "info")
+		return info(*command_line);
+
+	std::cerr << std::format("unknown command: {}\n", positional[0]) << USAGE;
+	return 1;
+}
@@ -0,0 +1,689 @@
+#include "EyeAICore/tflite/TfLiteRuntime.hpp"
+#include "EyeAICore/tflite/TiledInference.hpp"
+#include "EyeAICore/utils/BoundedQueue.hpp"
+#include "EyeAICore/utils/DepthColormap.hpp"
+#include "EyeAICore/utils/ImageProcessing.hpp"
+#include "EyeAICore/utils/MutexGuard.hpp"
+#include "EyeAICore/utils/PipelineWatchdog.hpp"
+#include "EyeAICore/utils/Profiling.hpp"
+#include "FrameSource.hpp"
+#include "ToolUtils.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <thread>
+
+constexpr std::string_view USAGE =
+	R"(usage: eyeai-stream <model.tflite> <frame source> --output-dir <dir> [options]
+
+streams frames through a pipeline of decode -> preprocess + inference ->
+colormap + encode stages connected by bounded queues and writes the depth maps
+to --output-dir, every inference worker owns its own interpreter so throughput
+scales with the number of cores
+
+frame source:
+)";
+
+constexpr std::string_view OPTIONS_USAGE = R"(
+options:
+  --output-dir <dir>         where depth maps are written (created if missing)
+  --workers <n>              inference workers (default: hardware threads
+                             divided by --threads)
+  --threads <n>              interpreter threads per worker (default: 1)
+  --encoders <n>             colormap/encode threads (default: 2)
+  --queue-size <n>           capacity of the queues between the stages
+                             (default: 2 * workers)
+  --depth-format <format>    pgm16 (default), f32 (raw floats) or none
+  --colormap                 also write inferno colormapped ppm images
+  --xnnpack                  apply an explicitly configured xnnpack delegate
+  --tiled                    infer at the frame resolution by splitting the
+                             frames into overlapping tiles of the model input
+                             size instead of downscaling them
+  --tile-overlap <fraction>  overlap of neighbouring tiles relative to the
+                             tile size (default: 0.25)
+  --tile-batch <n>           tiles per inference (default: 1)
+  --max-frames <n>           stop after n frames
+  --report <path>            write throughput and stage timings as json
+  --stall-deadline-ms <ms>   watch the stages and warn on stderr when one is
+                             busy with a frame or no frame is finished for
+                             longer than this (default: 0, not watched)
+  --inject-stall-ms <ms>     make the inference of some frames this much
+                             slower to test the stall warnings (default: 0)
+  --inject-stall-every <n>   which frames are slowed down (default: 10)
+)";
+
+constexpr std::array<std::string_view, 4> FLAG_NAMES = {
+	"colormap", "xnnpack", "tiled", "help"
+};
+
+/// output of the decode stage
+struct DecodedFrame {
+	size_t index = 0;
+	RgbImage image;
+};
+
+/// output of the inference stage, depth is relative inverse depth in [0, 1]
+struct DepthFrame {
+	size_t index = 0;
+	int width = 0;
+	int height = 0;
+	std::vector<float> depth;
+};
+
+/// time all threads of a stage spent working (not waiting on queues)
+struct StageTime {
+	std::atomic<int64_t> busy_nanos = 0;
+
+	void add(std::chrono::steady_clock::duration duration) {
+		busy_nanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+						  duration
+		)
+						  .count();
+	}
+
+	[[nodiscard]] double busy_millis() const {
+		return static_cast<double>(busy_nanos.load()) / 1e6;
+	}
+};
+
+struct StreamConfig {
+	int workers = 1;
+	int threads = 1;
+	int encoders = 2;
+	int queue_size = 2;
+	std::string depth_format = "pgm16";
+	bool colormap = false;
+	/// tiled frames are inferred at their own resolution
+	bool tiled = false;
+	TiledInferenceConfig tiling;
+	int tile_batch = 1;
+	size_t max_frames = 0;
+	/// 0 if the pipeline is not watched
+	std::chrono::milliseconds stall_deadline{0};
+	/// added to the inference of every inject_stall_every-th frame
+	std::chrono::milliseconds inject_stall{0};
+	size_t inject_stall_every = 10;
+	std::filesystem::path output_dir;
+	DepthModelDimensions dimensions;
+};
+
+/** State shared by all stages of the stream */
+class StreamPipeline {
+  public:
+	StreamPipeline(
+		StreamConfig config,
+		std::unique_ptr<FrameSource>&& source,
+		std::vector<std::unique_ptr<TfLiteRuntime>>&& runtimes
+	)
+		: config(std::move(config)), source(std::move(source)),
+		  runtimes(std::move(runtimes)),
+		  decoded_frames(static_cast<size_t>(this->config.queue_size)),
+		  depth_frames(static_cast<size_t>(this->config.queue_size)) {}
+
+	/// runs all stages until the source is exhausted or an error occurred
+	[[nodiscard]] std::optional<std::string> run();
+
+	[[nodiscard]] size_t get_encoded_frame_count() const {
+		return encoded_frame_count;
+	}
+
+	void write_report(JsonWriter& json, double wall_seconds) const;
+
+  private:
+	/// watchdog stages: decode, then one per worker, then one per encoder
+	static constexpr size_t DECODE_WATCHDOG_STAGE = 0;
+	[[nodiscard]] size_t inference_watchdog_stage(size_t worker) const {
+		return 1 + worker;
+	}
+	[[nodiscard]] size_t encode_watchdog_stage(size_t encoder) const {
+		return 1 + runtimes.size() + encoder;
+	}
+	/// starts the watchdog if a stall deadline is configured
+	void start_watchdog(frame_clock::time_point start);
+
+	void decode_stage();
+	void inference_stage(TfLiteRuntime& runtime, size_t worker);
+
+	[[nodiscard]] tl::expected<DepthFrame, std::string> infer_frame(
+		TfLiteRuntime& runtime,
+		const DecodedFrame& frame,
+		std::vector<float>& input
+	);
+	/// tiled is recreated when the frame size changes
+	[[nodiscard]] tl::expected<DepthFrame, std::string> infer_tiled_frame(
+		TfLiteRuntime& runtime,
+		const DecodedFrame& frame,
+		std::optional<TiledDepthInference>& tiled
+	);
+	void encode_stage(size_t encoder);
+
+	[[nodiscard]] std::optional<std::string>
+	encode_depth_frame(const DepthFrame& frame, std::vector<int>& colormapped);
+
+	/// stores the first error and shuts down all stages
+	void abort(std::string error);
+
+	StreamConfig config;
+	std::unique_ptr<FrameSource> source;
+	std::vector<std::unique_ptr<TfLiteRuntime>> runtimes;
+
+	BoundedQueue<DecodedFrame> decoded_frames;
+	BoundedQueue<DepthFrame> depth_frames;
+
+	std::atomic_int running_workers = 0;
+	std::atomic_int running_encoders = 0;
+	std::atomic<size_t> decoded_frame_count = 0;
+	std::atomic<size_t> encoded_frame_count = 0;
+
+	StageTime decode_time;
+	StageTime preprocess_time;
+	StageTime inference_time;
+	StageTime encode_time;
+
+	std::unique_ptr<PipelineWatchdog> watchdog;
+
+	MutexGuard<std::optional<std::string>> first_error{std::nullopt};
+};
+
+void StreamPipeline::abort(std::string error) {
+	{
+		auto first_error_scope = first_error.lock();
+		if (!first_error_scope->has_value())
+			*first_error_scope = std::move(error);
+	}
+	decoded_frames.close();
+	depth_frames.close();
+}
+
+void StreamPipeline::start_watchdog(frame_clock::time_point start) {
+	if (config.stall_deadline.count() == 0)
+		return;
+
+	PipelineWatchdogConfig watchdog_config;
+	watchdog_config.result_deadline = config.stall_deadline;
+	watchdog_config.stages.emplace_back("decode", config.stall_deadline);
+	for (size_t i = 0; i < runtimes.size(); i++)
+		watchdog_config.stages.emplace_back(
+			std::format("inference {}", i), config.stall_deadline
+		);
+	for (int i = 0; i < config.encoders; i++)
+		watchdog_config.stages.emplace_back(
+			std::format("encode {}", i), config.stall_deadline
+		);
+
+	auto created = PipelineWatchdog::create(std::move(watchdog_config));
+	if (!created) {
+		abort(created.error().to_string());
+		return;
+	}
+	watchdog = std::move(*created);
+	watchdog->start([this, start](const PipelineWatchdogStatus& status) {
+		const double seconds =
+			std::chrono::duration<double>(frame_clock::now() - start).count();
+		std::cerr << std::format(
+			"[{:.3f} s] {}\n", seconds, status.formatted(watchdog->get_config())
+		);
+	});
+}
+
+void StreamPipeline::decode_stage() {
+	for (size_t index = 0;
+		 config.max_frames == 0 || index < config.max_frames; index++) {
+		const auto start = std::chrono::steady_clock::now();
+		PipelineStageScope watchdog_scope(
+			watchdog.get(), DECODE_WATCHDOG_STAGE
+		);
+		auto image = source->next_frame();
+		watchdog_scope.end();
+		decode_time.add(std::chrono::steady_clock::now() - start);
+
+		if (!image) {
+			abort(image.error());
+			return;
+		}
+		if (!image->has_value())
+			break;
+
+		decoded_frame_count++;
+		if (watchdog)
+			watchdog->frame_submitted();
+		if (!decoded_frames.push(DecodedFrame(index, std::move(**image))))
+			return;
+	}
+	decoded_frames.close();
+}
+
+tl::expected<DepthFrame, std::string> StreamPipeline::infer_frame(
+	TfLiteRuntime& runtime,
+	const DecodedFrame& frame,
+	std::vector<float>& input
+) {
+	const auto& dimensions = config.dimensions;
+	const auto start = std::chrono::steady_clock::now();
+	if (const auto error = resize_rgb8_to_floats(
+			frame.image.pixels, frame.image.width, frame.image.height, input,
+			dimensions.input_width, dimensions.input_height
+		))
+		return tl::unexpected_fmt(
+			"preprocessing failed: {}", error->to_string()
+		);
+	FrameTrace trace;
+	trace.dequeue_time = std::chrono::steady_clock::now();
+	preprocess_time.add(trace.dequeue_time - start);
+
+	DepthFrame depth_frame(
+		frame.index, dimensions.output_width, dimensions.output_height,
+		std::vector<float>(runtime.get_output_element_count())
+	);
+	if (const auto error =
+			runtime.run_inference(input, depth_frame.depth, trace))
+		return tl::unexpected_fmt("inference failed: {}", error->to_string());
+	inference_time.add(trace.postprocess_end_time - trace.dequeue_time);
+	return depth_frame;
+}
+
+tl::expected<DepthFrame, std::string> StreamPipeline::infer_tiled_frame(
+	TfLiteRuntime& runtime,
+	const DecodedFrame& frame,
+	std::optional<TiledDepthInference>& tiled
+) {
+	const auto& image = frame.image;
+	if (!tiled || tiled->get_width() != image.width ||
+		tiled->get_height() != image.height) {
+		auto created = TiledDepthInference::create(
+			config.tiling, runtime, image.width, image.height
+		);
+		if (!created)
+			return tl::unexpected(created.error().to_string());
+		tiled.emplace(std::move(*created));
+	}
+
+	// the tiles are loaded as part of the inference
+	const auto start = std::chrono::steady_clock::now();
+	DepthFrame depth_frame(
+		frame.index, image.width, image.height,
+		std::vector<float>(static_cast<size_t>(image.width) * image.height)
+	);
+	if (const auto error =
+			tiled->run(runtime, image.pixels, depth_frame.depth))
+		return tl::unexpected_fmt(
+			"tiled inference failed: {}", error->to_string()
+		);
+	inference_time.add(std::chrono::steady_clock::now() - start);
+	return depth_frame;
+}
+
+void StreamPipeline::inference_stage(TfLiteRuntime& runtime, size_t worker) {
+	std::vector<float> input(runtime.get_input_element_count());
+	std::optional<TiledDepthInference> tiled;
+	const size_t watchdog_stage = inference_watchdog_stage(worker);
+
+	while (auto frame = decoded_frames.pop()) {
+		PipelineStageScope watchdog_scope(watchdog.get(), watchdog_stage);
+		auto depth_frame = config.tiled
+							   ? infer_tiled_frame(runtime, *frame, tiled)
+							   : infer_frame(runtime, *frame, input);
+		if (config.inject_stall.count() > 0 &&
+			frame->index % config.inject_stall_every ==
+				config.inject_stall_every - 1)
+			std::this_thread::sleep_for(config.inject_stall);
+		watchdog_scope.end();
+		if (!depth_frame) {
+			abort(std::format("frame {}: {}", frame->index, depth_frame.error())
+			);
+			break;
+		}
+
+		if (!depth_frames.push(std::move(*depth_frame)))
+			break;
+	}
+
+	// the last worker finishes the encode stage
+	if (--running_workers == 0)
+		depth_frames.close();
+}
+
+std::optional<std::string> StreamPipeline::encode_depth_frame(
+	const DepthFrame& frame,
+	std::vector<int>& colormapped
+) {
+	const auto base_path =
+		config.output_dir / std::format("depth_{:06}", frame.index);
+
+	if (config.depth_format == "pgm16") {
+		if (auto error = write_pgm16(
+				base_path.string() + ".pgm", frame.depth, frame.width,
+				frame.height
+			))
+			return error;
+	} else if (config.depth_format == "f32") {
+		const auto depth_bytes = std::as_bytes(std::span(frame.depth));
+		if (auto error =
+				write_file_bytes(base_path.string() + ".f32", depth_bytes))
+			return error;
+	}
+
+	if (config.colormap) {
+		colormapped.resize(frame.depth.size());
+		if (const auto error = depth_colormap(frame.depth, colormapped))
+			return error->to_string();
+		if (auto error = write_argb_as_ppm(
+				base_path.string() + "_colormap.ppm", colormapped, frame.width,
+				frame.height
+			))
+			return error;
+	}
+	return std::nullopt;
+}
+
+void StreamPipeline::encode_stage(size_t encoder) {
+	std::vector<int> colormapped;
+	const size_t watchdog_stage = encode_watchdog_stage(encoder);
+
+	while (const auto frame = depth_frames.pop()) {
+		const auto start = std::chrono::steady_clock::now();
+		PipelineStageScope watchdog_scope(watchdog.get(), watchdog_stage);
+		auto error = encode_depth_frame(*frame, colormapped);
+		watchdog_scope.end();
+		if (error) {
+			abort(std::format("frame {}: {}", frame->index, *error));
+			break;
+		}
+		encode_time.add(std::chrono::steady_clock::now() - start);
+		encoded_frame_count++;
+		if (watchdog)
+			watchdog->result_ready();
+	}
+	running_encoders--;
+}
+
+std::optional<std::string> StreamPipeline::run() {
+	const auto start = std::chrono::steady_clock::now();
+	const auto expected_frames = source->get_frame_count();
+
+	running_workers = static_cast<int>(runtimes.size());
+	running_encoders = config.encoders;
+	start_watchdog(start);
+
+	std::vector<std::jthread> threads;
+	threads.emplace_back([this] { decode_stage(); });
+	for (size_t i = 0; i < runtimes.size(); i++)
+		threads.emplace_back([this, i] { inference_stage(*runtimes[i], i); });
+	for (int i = 0; i < config.encoders; i++)
+		threads.emplace_back([this, i] {
+			encode_stage(static_cast<size_t>(i));
+		});
+
+	// profiling records of all workers end up in the global depth profiling
+	// frame, only this thread clears it so it does not grow for the whole run
+	auto last_progress_time = start;
+	while (running_encoders > 0) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		(void)get_depth_profiling_frame().finish();
+
+		const auto now = std::chrono::steady_clock::now();
+		if (now - last_progress_time >= std::chrono::seconds(1)) {
+			last_progress_time = now;
+			const double seconds =
+				std::chrono::duration<double>(now - start).count();
+			std::cerr << std::format(
+				"{} / {} frames, {:.1f} fps\n", encoded_frame_count.load(),
+				expected_frames ? std::to_string(*expected_frames) : "?",
+				static_cast<double>(encoded_frame_count) / seconds
+			);
+		}
+	}
+	threads.clear();
+	if (watchdog)
+		watchdog->stop();
+
+	return *first_error.lock();
+}
+
+void StreamPipeline::write_report(JsonWriter& json, double wall_seconds) const {
+	const auto frames = static_cast<double>(encoded_frame_count.load());
+	const auto per_frame = [frames](const StageTime& stage_time) {
+		return frames > 0.0 ? stage_time.busy_millis() / frames : 0.0;
+	};
+
+	json.begin_object()
+		.value("frames", static_cast<uint64_t>(encoded_frame_count.load()))
+		.value("wall_seconds", wall_seconds)
+		.value("frames_per_second", frames / wall_seconds);
+
+	json.begin_object("config")
+		.value("workers", config.workers)
+		.value("threads_per_worker", config.threads)
+		.value("encoders", config.encoders)
+		.value("queue_size", config.queue_size)
+		.value("depth_format", config.depth_format)
+		.value("colormap", config.colormap)
+		.value("tiled", config.tiled)
+		.value("tile_batch", config.tile_batch)
+		.end_object();
+
+	// busy time per frame of each stage, summed over all threads of the stage
+	json.begin_object("stage_ms_per_frame")
+		.value("decode", per_frame(decode_time))
+		.value("preprocess", per_frame(preprocess_time))
+		.value("inference", per_frame(inference_time))
+		.value("encode", per_frame(encode_time))
+		.end_object();
+
+	// a stage that often waits on a full output queue is faster than the next
+	// one, a stage that often waits on an empty input queue is starved
+	json.begin_object("queue_waits")
+		.value("decode_full", decoded_frames.get_full_waits())
+		.value("inference_empty", decoded_frames.get_empty_waits())
+		.value("inference_full", depth_frames.get_full_waits())
+		.value("encode_empty", depth_frames.get_empty_waits())
+		.end_object();
+
+	if (watchdog) {
+		const auto stats = watchdog->get_stats();
+		json.begin_object("watchdog")
+			.value(
+				"stall_deadline_ms",
+				static_cast<int64_t>(config.stall_deadline.count())
+			)
+			.value(
+				"inject_stall_ms",
+				static_cast<int64_t>(config.inject_stall.count())
+			)
+			.value("checks", stats.checks)
+			.value("stalled_events", stats.stalled_events)
+			.value("lagging_events", stats.lagging_events)
+			.value(
+				"max_detection_delay_ms",
+				std::chrono::duration<double, std::milli>(
+					stats.max_detection_delay
+				)
+					.count()
+			)
+			.end_object();
+	}
+
+	json.end_object();
+}
+
+static int run(const CommandLine& command_line) {
+	if (command_line.has("help") || command_line.get_positional().size() != 1) {
+		std::cerr << USAGE << FRAME_SOURCE_USAGE << OPTIONS_USAGE;
+		return command_line.has("help") ? 0 : 1;
+	}
+	const std::string& model_path = command_line.get_positional()[0];
+
+	StreamConfig config;
+	const auto threads = command_line.get_int("threads", 1);
+	if (!threads) {
+		std::cerr << threads.error() << '\n';
+		return 1;
+	}
+	const int hardware_threads =
+		std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+	const auto workers = command_line.get_int(
+		"workers", std::max(hardware_threads / std::max(*threads, 1), 1)
+	);
+	const auto encoders = command_line.get_int("encoders", 2);
+	const auto max_frames = command_line.get_int("max-frames", 0);
+	const auto tile_batch = command_line.get_int("tile-batch", 1);
+	const auto stall_deadline = command_line.get_int("stall-deadline-ms", 0);
+	const auto inject_stall = command_line.get_int("inject-stall-ms", 0);
+	const auto inject_stall_every =
+		command_line.get_int("inject-stall-every", 10);
+	for (const auto* result :
+		 {&workers, &encoders, &max_frames, &tile_batch, &stall_deadline,
+		  &inject_stall, &inject_stall_every}) {
+		if (!result->has_value()) {
+			std::cerr << result->error() << '\n';
+			return 1;
+		}
+	}
+	const auto queue_size = command_line.get_int("queue-size", 2 * *workers);
+	if (!queue_size) {
+		std::cerr << queue_size.error() << '\n';
+		return 1;
+	}
+	if (*threads < 1 || *workers < 1 || *encoders < 1 || *queue_size < 1 ||
+		*tile_batch < 1 || *max_frames < 0) {
+		std::cerr << "--threads, --workers, --encoders, --queue-size and "
+					 "--tile-batch must be at least 1\n";
+		return 1;
+	}
+	if (*stall_deadline < 0 || *inject_stall < 0 || *inject_stall_every < 1) {
+		std::cerr << "--stall-deadline-ms and --inject-stall-ms must not be "
+					 "negative, --inject-stall-every must be at least 1\n";
+		return 1;
+	}
+	const auto tile_overlap = command_line.get_float(
+		"tile-overlap", TiledInferenceConfig().overlap_fraction
+	);
+	if (!tile_overlap) {
+		std::cerr << tile_overlap.error() << '\n';
+		return 1;
+	}
+	config.threads = *threads;
+	config.workers = *workers;
+	config.encoders = *encoders;
+	config.queue_size = *queue_size;
+	config.max_frames = static_cast<size_t>(*max_frames);
+	config.colormap = command_line.has("colormap");
+	config.tiled = command_line.has("tiled");
+	config.tiling.overlap_fraction = *tile_overlap;
+	config.tile_batch = *tile_batch;
+	config.stall_deadline = std::chrono::milliseconds(*stall_deadline);
+	config.inject_stall = std::chrono::milliseconds(*inject_stall);
+	config.inject_stall_every = static_cast<size_t>(*inject_stall_every);
+	config.depth_format = command_line.get_string("depth-format", "pgm16");
+	if (config.depth_format != "pgm16" && config.depth_format != "f32" &&
+		config.depth_format != "none") {
+		std::cerr << std::format(
+			"unknown depth format: {}\n", config.depth_format
+		);
+		return 1;
+	}
+
+	config.output_dir = command_line.get_string("output-dir", "");
+	if (config.output_dir.empty()) {
+		std::cerr << "--output-dir is required\n";
+		return 1;
+	}
+	std::error_code filesystem_error;
+	std::filesystem::create_directories(config.output_dir, filesystem_error);
+	if (filesystem_error) {
+		std::cerr << std::format(
+			"failed to create {}: {}\n", config.output_dir.string(),
+			filesystem_error.message()
+		);
+		return 1;
+	}
+
+	auto source = create_frame_source(command_line);
+	if (!source) {
+		std::cerr << source.error() << '\n';
+		return 1;
+	}
+
+	const auto model_data = read_file_bytes(model_path);
+	if (!model_data) {
+		std::cerr << model_data.error() << '\n';
+		return 1;
+	}
+
+	// interpreters are not thread-safe, every worker gets its own
+	std::vector<std::unique_ptr<TfLiteRuntime>> runtimes;
+	for (int i = 0; i < config.workers; i++) {
+		auto runtime = create_depth_runtime(
+			std::vector<int8_t>(*model_data), "eyeai-stream", config.threads,
+			command_line.has("xnnpack"), config.tiled ? config.tile_batch : 1
+		);
+		if (!runtime) {
+			std::cerr << runtime.error() << '\n';
+			return 1;
+		}
+		runtimes.push_back(std::move(*runtime));
+	}
+	if (config.tiled) {
+		// the frame size is only known per frame, this checks the shapes
+		const auto tiled = TiledDepthInference::create(
+			config.tiling, *runtimes.front(), 1, 1
+		);
+		if (!tiled) {
+			std::cerr << tiled.error().to_string() << '\n';
+			return 1;
+		}
+	} else {
+		const auto dimensions = get_depth_model_dimensions(*runtimes.front());
+		if (!dimensions) {
+			std::cerr << dimensions.error() << '\n';
+			return 1;
+		}
+		config.dimensions = *dimensions;
+	}
+
+	StreamPipeline pipeline(
+		std::move(config), std::move(*source), std::move(runtimes)
+	);
+	const auto start = std::chrono::steady_clock::now();
+	const auto error = pipeline.run();
+	const double wall_seconds =
+		std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+			.count();
+	if (error) {
+		std::cerr << *error << '\n';
+		return 1;
+	}
+
+	std::cerr << std::format(
+		"{} frames in {:.2f} s ({:.1f} fps)\n",
+		pipeline.get_encoded_frame_count(), wall_seconds,
+		static_cast<double>(pipeline.get_encoded_frame_count()) / wall_seconds
+	);
+
+	const auto report_path = command_line.get_string("report", "");
+	if (!report_path.empty()) {
+		JsonWriter json;
+		pipeline.write_report(json, wall_seconds);
+		if (const auto write_error = write_file_bytes(
+				report_path, std::as_bytes(std::span(json.str()))
+			)) {
+			std::cerr << *write_error << '\n';
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	const auto command_line = CommandLine::parse(argc, argv, FLAG_NAMES);
+	if (!command_line) {
+		std::cerr << command_line.error() << '\n' << USAGE;
+		return 1;
+	}
+	return run(*command_line);
+}